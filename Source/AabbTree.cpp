@@ -0,0 +1,389 @@
+#include "AabbTree.h"
+
+namespace
+{
+	constexpr fixed MARGIN = toFixed(AABB_TREE_MARGIN);
+
+	Aabb combine(const Aabb& a, const Aabb& b)
+	{
+		Aabb box;
+		box.left = a.left < b.left ? a.left : b.left;
+		box.top = a.top < b.top ? a.top : b.top;
+		box.right = a.right > b.right ? a.right : b.right;
+		box.bottom = a.bottom > b.bottom ? a.bottom : b.bottom;
+		return box;
+	}
+
+	bool contains(const Aabb& outer, const Aabb& inner)
+	{
+		return outer.left <= inner.left && outer.top <= inner.top &&
+			inner.right <= outer.right && inner.bottom <= outer.bottom;
+	}
+
+	int64_t perimeter(const Aabb& box)
+	{
+		return 2 * ((int64_t)box.right - box.left + (int64_t)box.bottom - box.top);
+	}
+
+	int64_t magnitude(int64_t value)
+	{
+		return value < 0 ? -value : value;
+	}
+
+	/**
+	*  Grows a box by the margin and stretches it along its motion.
+	*/
+	Aabb fatten(const Aabb& box, fixed dx, fixed dy)
+	{
+		Aabb fat = box;
+		fat.left -= MARGIN;
+		fat.top -= MARGIN;
+		fat.right += MARGIN;
+		fat.bottom += MARGIN;
+
+		fixed ahead_x = dx * AABB_TREE_LOOKAHEAD;
+		fixed ahead_y = dy * AABB_TREE_LOOKAHEAD;
+		if (ahead_x < 0)
+		{
+			fat.left += ahead_x;
+		}
+		else
+		{
+			fat.right += ahead_x;
+		}
+		if (ahead_y < 0)
+		{
+			fat.top += ahead_y;
+		}
+		else
+		{
+			fat.bottom += ahead_y;
+		}
+		return fat;
+	}
+}
+
+int AabbTree::createProxy(const Aabb& box, int user_data)
+{
+	int proxy = allocateNode();
+	nodes[proxy].box = fatten(box, 0, 0);
+	nodes[proxy].user_data = user_data;
+	nodes[proxy].height = 0;
+	insertLeaf(proxy);
+	proxy_count++;
+	return proxy;
+}
+
+void AabbTree::destroyProxy(int proxy)
+{
+	removeLeaf(proxy);
+	freeNode(proxy);
+	proxy_count--;
+}
+
+/**
+*   @brief   Moves a proxy.
+*   @details Nothing happens while the box stays inside its fat box,
+             unless the fat box has grown far bigger than the box needs
+             (after a fast move ends), in which case it is refitted so
+             queries stay tight.
+*   @return  true if the leaf was reinserted.
+*/
+bool AabbTree::moveProxy(int proxy, const Aabb& box, fixed dx, fixed dy)
+{
+	Aabb fat = fatten(box, dx, dy);
+	const Aabb& current = nodes[proxy].box;
+	if (contains(current, box))
+	{
+		Aabb huge = fat;
+		huge.left -= 4 * MARGIN;
+		huge.top -= 4 * MARGIN;
+		huge.right += 4 * MARGIN;
+		huge.bottom += 4 * MARGIN;
+		if (contains(huge, current))
+		{
+			return false;
+		}
+	}
+
+	removeLeaf(proxy);
+	nodes[proxy].box = fat;
+	insertLeaf(proxy);
+	return true;
+}
+
+int AabbTree::getUserData(int proxy) const
+{
+	return nodes[proxy].user_data;
+}
+
+const Aabb& AabbTree::getFatAabb(int proxy) const
+{
+	return nodes[proxy].box;
+}
+
+int AabbTree::getHeight() const
+{
+	return root == NULL_NODE ? 0 : nodes[root].height;
+}
+
+int AabbTree::getProxyCount() const
+{
+	return proxy_count;
+}
+
+Aabb AabbTree::segmentBounds(fixed x1, fixed y1, fixed x2, fixed y2)
+{
+	Aabb bounds;
+	bounds.left = x1 < x2 ? x1 : x2;
+	bounds.right = x1 < x2 ? x2 : x1;
+	bounds.top = y1 < y2 ? y1 : y2;
+	bounds.bottom = y1 < y2 ? y2 : y1;
+	return bounds;
+}
+
+/**
+*   @brief   Segment against box
+*   @details Separating axis test on the segment's normal: the segment's
+             line misses the box if the box centre is further from it
+             than the box's extent along the normal. Worked in doubled
+             coordinates so nothing is halved.
+*   @return  false if the segment's line misses the box.
+*/
+bool AabbTree::segmentHits(const Aabb& box, fixed x1, fixed y1, fixed dx, fixed dy)
+{
+	int64_t centre_x = 2 * (int64_t)x1 - box.left - box.right;
+	int64_t centre_y = 2 * (int64_t)y1 - box.top - box.bottom;
+	int64_t extent_x = (int64_t)box.right - box.left;
+	int64_t extent_y = (int64_t)box.bottom - box.top;
+
+	int64_t distance = magnitude(-(int64_t)dy * centre_x + (int64_t)dx * centre_y);
+	int64_t extent = magnitude(dy) * extent_x + magnitude(dx) * extent_y;
+	return distance <= extent;
+}
+
+int AabbTree::allocateNode()
+{
+	if (free_list == NULL_NODE)
+	{
+		nodes.emplace_back();
+		return (int)nodes.size() - 1;
+	}
+
+	int index = free_list;
+	free_list = nodes[index].next;
+	nodes[index] = Node();
+	return index;
+}
+
+void AabbTree::freeNode(int index)
+{
+	nodes[index].next = free_list;
+	nodes[index].height = -1;
+	free_list = index;
+}
+
+/**
+*   @brief   Inserts a leaf.
+*   @details Walks down from the root towards whichever child grows the
+             total perimeter least, stopping where pairing with the
+             current node is cheaper than descending, then splices a
+             new parent in over that sibling.
+*   @return  void
+*/
+void AabbTree::insertLeaf(int leaf)
+{
+	if (root == NULL_NODE)
+	{
+		root = leaf;
+		nodes[root].parent = NULL_NODE;
+		return;
+	}
+
+	Aabb leaf_box = nodes[leaf].box;
+	int index = root;
+	while (nodes[index].child1 != NULL_NODE)
+	{
+		int child1 = nodes[index].child1;
+		int child2 = nodes[index].child2;
+
+		int64_t area = perimeter(nodes[index].box);
+		int64_t combined_area = perimeter(combine(nodes[index].box, leaf_box));
+
+		// pairing here, versus pushing the leaf further down
+		int64_t cost = 2 * combined_area;
+		int64_t inheritance_cost = 2 * (combined_area - area);
+
+		int64_t cost1 = perimeter(combine(leaf_box, nodes[child1].box)) + inheritance_cost;
+		if (nodes[child1].child1 != NULL_NODE)
+		{
+			cost1 -= perimeter(nodes[child1].box);
+		}
+		int64_t cost2 = perimeter(combine(leaf_box, nodes[child2].box)) + inheritance_cost;
+		if (nodes[child2].child1 != NULL_NODE)
+		{
+			cost2 -= perimeter(nodes[child2].box);
+		}
+
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
+		index = cost1 < cost2 ? child1 : child2;
+	}
+
+	int sibling = index;
+	int old_parent = nodes[sibling].parent;
+	int new_parent = allocateNode();
+	nodes[new_parent].parent = old_parent;
+	nodes[new_parent].box = combine(leaf_box, nodes[sibling].box);
+	nodes[new_parent].height = nodes[sibling].height + 1;
+	nodes[new_parent].child1 = sibling;
+	nodes[new_parent].child2 = leaf;
+	nodes[sibling].parent = new_parent;
+	nodes[leaf].parent = new_parent;
+
+	if (old_parent == NULL_NODE)
+	{
+		root = new_parent;
+	}
+	else if (nodes[old_parent].child1 == sibling)
+	{
+		nodes[old_parent].child1 = new_parent;
+	}
+	else
+	{
+		nodes[old_parent].child2 = new_parent;
+	}
+
+	refit(new_parent);
+}
+
+/**
+*   @brief   Removes a leaf.
+*   @details Its parent goes too and the sibling takes the parent's
+             place; the leaf node itself is kept for reinsertion.
+*   @return  void
+*/
+void AabbTree::removeLeaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = NULL_NODE;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandparent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+	nodes[sibling].parent = grandparent;
+	freeNode(parent);
+	if (grandparent == NULL_NODE)
+	{
+		root = sibling;
+		return;
+	}
+
+	if (nodes[grandparent].child1 == parent)
+	{
+		nodes[grandparent].child1 = sibling;
+	}
+	else
+	{
+		nodes[grandparent].child2 = sibling;
+	}
+	refit(grandparent);
+}
+
+/**
+*   @brief   Refits from a node to the root.
+*   @details Rebalances each ancestor, then recomputes its box and
+             height from its children.
+*   @return  void
+*/
+void AabbTree::refit(int index)
+{
+	while (index != NULL_NODE)
+	{
+		index = balance(index);
+
+		Node& node = nodes[index];
+		const Node& child1 = nodes[node.child1];
+		const Node& child2 = nodes[node.child2];
+		node.height = 1 + (child1.height > child2.height ? child1.height : child2.height);
+		node.box = combine(child1.box, child2.box);
+
+		index = node.parent;
+	}
+}
+
+/**
+*   @brief   Rebalances a node.
+*   @details If one child is more than one level taller than the other
+             it is rotated up into the node's place, taking the node as
+             a child along with the shorter of its own children.
+*   @return  The node now in index's place.
+*/
+int AabbTree::balance(int a)
+{
+	if (nodes[a].child1 == NULL_NODE || nodes[a].height < 2)
+	{
+		return a;
+	}
+
+	int b = nodes[a].child1;
+	int c = nodes[a].child2;
+	int difference = nodes[c].height - nodes[b].height;
+	if (difference >= -1 && difference <= 1)
+	{
+		return a;
+	}
+
+	// rotate the taller child up; short is the child a keeps
+	bool left = difference < -1;
+	int up = left ? b : c;
+	int keep = left ? c : b;
+	int f = nodes[up].child1;
+	int g = nodes[up].child2;
+
+	nodes[up].child1 = a;
+	nodes[up].parent = nodes[a].parent;
+	nodes[a].parent = up;
+
+	int parent = nodes[up].parent;
+	if (parent == NULL_NODE)
+	{
+		root = up;
+	}
+	else if (nodes[parent].child1 == a)
+	{
+		nodes[parent].child1 = up;
+	}
+	else
+	{
+		nodes[parent].child2 = up;
+	}
+
+	// the taller grandchild stays with up, the shorter moves under a
+	int tall = nodes[f].height > nodes[g].height ? f : g;
+	int moved = tall == f ? g : f;
+	nodes[up].child2 = tall;
+	if (left)
+	{
+		nodes[a].child1 = moved;
+	}
+	else
+	{
+		nodes[a].child2 = moved;
+	}
+	nodes[moved].parent = a;
+
+	nodes[a].box = combine(nodes[keep].box, nodes[moved].box);
+	nodes[a].height = 1 + (nodes[keep].height > nodes[moved].height ?
+		nodes[keep].height : nodes[moved].height);
+	nodes[up].box = combine(nodes[a].box, nodes[tall].box);
+	nodes[up].height = 1 + (nodes[a].height > nodes[tall].height ?
+		nodes[a].height : nodes[tall].height);
+	return up;
+}
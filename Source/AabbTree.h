@@ -0,0 +1,190 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Constants.h"
+#include "Fixed.h"
+
+/**
+*  An axis aligned box in logical playfield units, y pointing down.
+*/
+struct Aabb
+{
+	fixed left = 0;
+	fixed top = 0;
+	fixed right = 0;
+	fixed bottom = 0;
+};
+
+/**
+*  Dynamic bounding volume hierarchy for moving boxes.
+*  Each leaf stores a fat box: the real box grown by AABB_TREE_MARGIN and
+*  stretched along its motion. While a moving box stays inside its fat
+*  box, moving it costs one containment test and the tree is untouched.
+*  A box that escapes is removed, refattened and reinserted under the
+*  sibling that grows the tree's perimeter least, and only its ancestors
+*  are refitted and rebalanced on the way back up.
+*  Queries cull against fat boxes, so callers still test the real box.
+*  Coordinates must stay within +-8192 units so the segment test fits in
+*  64-bit integers.
+*/
+class AabbTree
+{
+public:
+	static constexpr int NULL_NODE = -1;
+
+	AabbTree() = default;
+
+	/**
+	*  Adds a box.
+	*  @param [in] box The box's current bounds.
+	*  @param [in] user_data Returned by getUserData, e.g. a block index.
+	*  @return The proxy id the box is moved and reported by.
+	*/
+	int createProxy(const Aabb& box, int user_data);
+	void destroyProxy(int proxy);
+
+	/**
+	*  Moves a box.
+	*  @param [in] proxy The box's proxy.
+	*  @param [in] box The box's new bounds.
+	*  @param [in] dx,dy How far it moved this tick, used to stretch the
+	*              fat box ahead of it.
+	*  @return true if the box left its fat box and was reinserted.
+	*/
+	bool moveProxy(int proxy, const Aabb& box, fixed dx, fixed dy);
+
+	int getUserData(int proxy) const;
+	const Aabb& getFatAabb(int proxy) const;
+
+	/**
+	*  Height of the tree, 0 for a single leaf.
+	*/
+	int getHeight() const;
+	int getProxyCount() const;
+
+	/**
+	*  Calls callback(proxy) for every fat box overlapping box.
+	*  The callback returns false to stop the query.
+	*/
+	template <typename Callback>
+	void query(const Aabb& box, Callback callback) const
+	{
+		int stack[STACK_SIZE];
+		int count = 0;
+		if (root != NULL_NODE)
+		{
+			stack[count++] = root;
+		}
+
+		while (count > 0)
+		{
+			int index = stack[--count];
+			const Node& node = nodes[index];
+			if (!overlaps(node.box, box))
+			{
+				continue;
+			}
+			if (node.child1 == NULL_NODE)
+			{
+				if (!callback(index))
+				{
+					return;
+				}
+			}
+			else
+			{
+				stack[count++] = node.child1;
+				stack[count++] = node.child2;
+			}
+		}
+	}
+
+	/**
+	*  Calls callback(proxy) for every fat box the segment from (x1, y1)
+	*  to (x2, y2) passes through.
+	*  The callback returns how much of the segment is still worth
+	*  searching as a 16.16 fraction: FIXED_ONE to keep all of it, the
+	*  hit's fraction to only look for closer hits, or 0 to stop.
+	*/
+	template <typename Callback>
+	void rayCast(fixed x1, fixed y1, fixed x2, fixed y2, Callback callback) const
+	{
+		fixed dx = x2 - x1;
+		fixed dy = y2 - y1;
+		fixed max_fraction = FIXED_ONE;
+		Aabb bounds = segmentBounds(x1, y1, x1 + dx, y1 + dy);
+
+		int stack[STACK_SIZE];
+		int count = 0;
+		if (root != NULL_NODE)
+		{
+			stack[count++] = root;
+		}
+
+		while (count > 0)
+		{
+			int index = stack[--count];
+			const Node& node = nodes[index];
+			if (!overlaps(node.box, bounds) || !segmentHits(node.box, x1, y1, dx, dy))
+			{
+				continue;
+			}
+			if (node.child1 == NULL_NODE)
+			{
+				fixed fraction = callback(index);
+				if (fraction == 0)
+				{
+					return;
+				}
+				if (fraction < max_fraction)
+				{
+					max_fraction = fraction;
+					bounds = segmentBounds(x1, y1, x1 + fixedMul(dx, max_fraction),
+						y1 + fixedMul(dy, max_fraction));
+				}
+			}
+			else
+			{
+				stack[count++] = node.child1;
+				stack[count++] = node.child2;
+			}
+		}
+	}
+
+private:
+	// a balanced tree of a million leaves is under 30 deep
+	static constexpr int STACK_SIZE = 128;
+
+	struct Node
+	{
+		Aabb box;
+		int parent = NULL_NODE;
+		int child1 = NULL_NODE;
+		int child2 = NULL_NODE;
+		int height = 0;        /**< 0 for leaves, -1 while on the free list. */
+		int user_data = -1;
+		int next = NULL_NODE;  /**< Free list link. */
+	};
+
+	static bool overlaps(const Aabb& a, const Aabb& b)
+	{
+		return a.left <= b.right && b.left <= a.right &&
+			a.top <= b.bottom && b.top <= a.bottom;
+	}
+
+	static Aabb segmentBounds(fixed x1, fixed y1, fixed x2, fixed y2);
+	static bool segmentHits(const Aabb& box, fixed x1, fixed y1, fixed dx, fixed dy);
+
+	int allocateNode();
+	void freeNode(int index);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	void refit(int index);
+	int balance(int index);
+
+	std::vector<Node> nodes;
+	int root = NULL_NODE;
+	int free_list = NULL_NODE;
+	int proxy_count = 0;
+};
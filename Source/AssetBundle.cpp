@@ -0,0 +1,368 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "AssetBundle.h"
+
+namespace
+{
+	const char MAGIC[4] = { 'B', 'K', 'P', 'K' };
+	constexpr uint32_t VERSION = 1;
+	constexpr size_t DATA_ALIGNMENT = 16;
+
+	struct BundleHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t count;
+		uint32_t reserved;
+	};
+
+	struct BundleEntry
+	{
+		uint64_t hash;
+		uint32_t name_offset;
+		uint32_t name_size;
+		uint64_t data_offset;
+		uint64_t data_size;
+	};
+
+	static_assert(sizeof(BundleHeader) == 16, "bundle header is 16 bytes");
+	static_assert(sizeof(BundleEntry) == 32, "bundle entries are 32 bytes");
+
+	uint64_t hashName(const char* name, size_t length)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < length; i++)
+		{
+			hash ^= (uint8_t)name[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	BundleEntry entryAt(const uint8_t* base, uint32_t index)
+	{
+		BundleEntry entry;
+		std::memcpy(&entry, base + sizeof(BundleHeader) + index * sizeof(BundleEntry),
+			sizeof(entry));
+		return entry;
+	}
+
+	size_t alignUp(size_t value)
+	{
+		return (value + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+	}
+}
+
+AssetBundle::~AssetBundle()
+{
+	close();
+}
+
+/**
+*   @brief   Opens a bundle.
+*   @details Maps the whole file read-only. The OS pages it in as assets
+             are touched, so opening costs the same however big it is.
+*   @return  true if the bundle is mapped and valid.
+*/
+bool AssetBundle::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	file = handle;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		close();
+		return false;
+	}
+	base = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	size = (size_t)file_size.QuadPart;
+#else
+	int descriptor = ::open(path.c_str(), O_RDONLY);
+	if (descriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+	{
+		::close(descriptor);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	// the mapping keeps the file alive on its own
+	::close(descriptor);
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+	base = static_cast<const uint8_t*>(view);
+	size = (size_t)info.st_size;
+#endif
+
+	if (!base || !validate())
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void AssetBundle::close()
+{
+#ifdef _WIN32
+	if (base)
+	{
+		UnmapViewOfFile(base);
+	}
+	if (mapping)
+	{
+		CloseHandle(mapping);
+	}
+	if (file)
+	{
+		CloseHandle(file);
+	}
+	mapping = nullptr;
+	file = nullptr;
+#else
+	if (base)
+	{
+		munmap(const_cast<uint8_t*>(base), size);
+	}
+#endif
+	base = nullptr;
+	size = 0;
+	count = 0;
+}
+
+bool AssetBundle::isOpen() const
+{
+	return base != nullptr;
+}
+
+/**
+*   @brief   Finds an asset.
+*   @details Binary searches the index by name hash, then compares names
+             in case two hash the same.
+*   @return  true if found.
+*/
+bool AssetBundle::find(const char* name, AssetView& view) const
+{
+	if (!base)
+	{
+		return false;
+	}
+
+	size_t length = std::strlen(name);
+	uint64_t hash = hashName(name, length);
+
+	uint32_t low = 0;
+	uint32_t high = count;
+	while (low < high)
+	{
+		uint32_t middle = low + (high - low) / 2;
+		if (entryAt(base, middle).hash < hash)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	for (uint32_t i = low; i < count; i++)
+	{
+		BundleEntry entry = entryAt(base, i);
+		if (entry.hash != hash)
+		{
+			break;
+		}
+		if (entry.name_size == length &&
+			std::memcmp(base + entry.name_offset, name, length) == 0)
+		{
+			view.data = base + entry.data_offset;
+			view.size = (size_t)entry.data_size;
+			return true;
+		}
+	}
+	return false;
+}
+
+int AssetBundle::getAssetCount() const
+{
+	return (int)count;
+}
+
+size_t AssetBundle::getMappedSize() const
+{
+	return size;
+}
+
+/**
+*   @brief   Checks a freshly mapped bundle.
+*   @details Every offset is bounds checked once here so lookups can trust
+             the index.
+*   @return  false if the file is not a bundle this build can read.
+*/
+bool AssetBundle::validate()
+{
+	if (size < sizeof(BundleHeader))
+	{
+		return false;
+	}
+
+	BundleHeader header;
+	std::memcpy(&header, base, sizeof(header));
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+		header.version != VERSION ||
+		header.count > (size - sizeof(BundleHeader)) / sizeof(BundleEntry))
+	{
+		return false;
+	}
+
+	uint64_t previous_hash = 0;
+	for (uint32_t i = 0; i < header.count; i++)
+	{
+		BundleEntry entry = entryAt(base, i);
+		if (entry.name_offset > size || entry.name_size > size - entry.name_offset ||
+			entry.data_offset > size || entry.data_size > size - entry.data_offset ||
+			(i > 0 && entry.hash < previous_hash))
+		{
+			return false;
+		}
+		previous_hash = entry.hash;
+	}
+
+	count = header.count;
+	return true;
+}
+
+bool readAsset(const AssetBundle& bundle, const char* name, std::vector<uint8_t>& bytes)
+{
+	AssetView view;
+	if (bundle.find(name, view))
+	{
+		bytes.assign(view.data, view.data + view.size);
+		return true;
+	}
+
+	std::string path = assetPath(name);
+	std::ifstream in(path, std::ios::binary);
+	if (path.empty() || in.fail())
+	{
+		return false;
+	}
+	bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	return true;
+}
+
+bool packAssets(const std::string& resource_dir, const AssetEntry* entries,
+	int count, const std::string& bundle_path, std::string& error)
+{
+	struct Packed
+	{
+		const AssetEntry* asset;
+		std::vector<char> bytes;
+		BundleEntry entry;
+	};
+
+	std::vector<Packed> packed(count);
+	for (int i = 0; i < count; i++)
+	{
+		std::string source = resource_dir + "/" + entries[i].source;
+		std::ifstream in(source, std::ios::binary);
+		if (in.fail())
+		{
+			error = "could not read " + source;
+			return false;
+		}
+		packed[i].asset = &entries[i];
+		packed[i].bytes.assign(std::istreambuf_iterator<char>(in),
+			std::istreambuf_iterator<char>());
+		packed[i].entry.hash = hashName(entries[i].name, std::strlen(entries[i].name));
+	}
+
+	std::sort(packed.begin(), packed.end(), [](const Packed& a, const Packed& b)
+	{
+		return a.entry.hash < b.entry.hash;
+	});
+
+	// lay out the names after the index, then the data
+	size_t offset = sizeof(BundleHeader) + count * sizeof(BundleEntry);
+	for (Packed& asset : packed)
+	{
+		asset.entry.name_offset = (uint32_t)offset;
+		asset.entry.name_size = (uint32_t)std::strlen(asset.asset->name);
+		offset += asset.entry.name_size;
+	}
+	for (Packed& asset : packed)
+	{
+		offset = alignUp(offset);
+		asset.entry.data_offset = offset;
+		asset.entry.data_size = asset.bytes.size();
+		offset += asset.bytes.size();
+	}
+
+	std::vector<char> bundle(offset, 0);
+	BundleHeader header = {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.count = (uint32_t)count;
+	std::memcpy(bundle.data(), &header, sizeof(header));
+
+	for (int i = 0; i < count; i++)
+	{
+		const Packed& asset = packed[i];
+		std::memcpy(&bundle[sizeof(BundleHeader) + i * sizeof(BundleEntry)],
+			&asset.entry, sizeof(BundleEntry));
+		std::memcpy(&bundle[asset.entry.name_offset], asset.asset->name,
+			asset.entry.name_size);
+		if (!asset.bytes.empty())
+		{
+			std::memcpy(&bundle[(size_t)asset.entry.data_offset], asset.bytes.data(),
+				asset.bytes.size());
+		}
+	}
+
+	std::ofstream out(bundle_path, std::ios::binary | std::ios::trunc);
+	out.write(bundle.data(), bundle.size());
+	if (out.fail())
+	{
+		error = "could not write " + bundle_path;
+		return false;
+	}
+	return true;
+}
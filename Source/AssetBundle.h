@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Assets.h"
+
+/*! \file AssetBundle.h
+@brief   Packed asset bundle and the virtual file system that reads it.
+@details A bundle is a single file: a 16 byte header ("BKPK", version,
+         asset count), an index of 32 byte entries sorted by the FNV-1a
+         hash of the asset's logical name, the names, and then each
+         asset's bytes aligned to 16 bytes. All integers are little endian.
+*/
+
+/**
+*  A read-only view of an asset's bytes.
+*  Points straight into the mapped bundle, so it is only valid while the
+*  bundle stays open.
+*/
+struct AssetView
+{
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+};
+
+/**
+*  Serves assets out of a memory mapped bundle.
+*  Opening the bundle is one file open and one mapping; after that a
+*  lookup is a binary search of the index and returns a pointer into the
+*  mapping, so nothing is read or copied until the bytes are touched.
+*/
+class AssetBundle
+{
+public:
+	AssetBundle() = default;
+	~AssetBundle();
+
+	AssetBundle(const AssetBundle&) = delete;
+	AssetBundle& operator=(const AssetBundle&) = delete;
+
+	/**
+	*  Maps a bundle and checks its index.
+	*  @param [in] path The bundle file.
+	*  @return false if it could not be mapped or is not a valid bundle.
+	*/
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const;
+
+	/**
+	*  Finds an asset by logical name.
+	*  @param [in] name The asset's logical name.
+	*  @param [out] view Receives the asset's bytes.
+	*  @return false if the bundle has no such asset.
+	*/
+	bool find(const char* name, AssetView& view) const;
+
+	int getAssetCount() const;
+	size_t getMappedSize() const;
+
+private:
+	bool validate();
+
+	const uint8_t* base = nullptr;
+	size_t size = 0;
+	uint32_t count = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
+
+/**
+*   @brief   Reads an asset's bytes.
+*   @details For code that decodes assets itself. ASGE's loader can only
+             open files, so the GL game never comes through here.
+*   @param   [in] bundle Searched first, if it is open.
+*   @param   [in] name The asset's logical name.
+*   @param   [out] bytes Receives the asset.
+*   @return  false if neither the bundle nor the asset's source file
+             could supply it.
+*/
+bool readAsset(const AssetBundle& bundle, const char* name, std::vector<uint8_t>& bytes);
+
+/**
+*   @brief   Writes a bundle from the manifest.
+*   @details This is the offline packer. Only the listed assets are read,
+             so sources and files the game never uses are left out.
+*   @param   [in] resource_dir Directory the entries' sources are under.
+*   @param   [in] entries The assets to pack.
+*   @param   [in] count How many entries there are.
+*   @param   [in] bundle_path The bundle file to write.
+*   @param   [out] error Describes what went wrong on failure.
+*   @return  true if the bundle was written.
+*/
+bool packAssets(const std::string& resource_dir, const AssetEntry* entries,
+	int count, const std::string& bundle_path, std::string& error);
@@ -0,0 +1,196 @@
+#include <fstream>
+
+#include "AssetBundle.h"
+#include "AssetLoader.h"
+
+AssetLoader::~AssetLoader()
+{
+	stop();
+	if (reloader.joinable())
+	{
+		reloader.join();
+	}
+}
+
+void AssetLoader::start(int worker_count)
+{
+	stop();
+	bundle = nullptr;
+	begin(worker_count);
+}
+
+void AssetLoader::startDecoding(int worker_count, const AssetBundle& source)
+{
+	stop();
+	bundle = &source;
+	begin(worker_count);
+}
+
+void AssetLoader::begin(int worker_count)
+{
+	next_asset = 0;
+	fetched = 0;
+	for (int i = 0; i < NUM_ASSETS; i++)
+	{
+		status[i] = PENDING;
+		images[i] = Image();
+	}
+
+	if (worker_count <= 0)
+	{
+		int cores = (int)std::thread::hardware_concurrency();
+		worker_count = cores > 1 ? cores - 1 : 1;
+	}
+	if (worker_count > NUM_ASSETS)
+	{
+		worker_count = NUM_ASSETS;
+	}
+
+	for (int i = 0; i < worker_count; i++)
+	{
+		workers.emplace_back(&AssetLoader::work, this);
+	}
+}
+
+void AssetLoader::stop()
+{
+	// stop workers picking up anything new; they finish what they hold
+	next_asset = NUM_ASSETS;
+	finish();
+}
+
+void AssetLoader::finish()
+{
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	workers.clear();
+}
+
+bool AssetLoader::isFetched(int asset) const
+{
+	return status[asset].load(std::memory_order_acquire) != PENDING;
+}
+
+bool AssetLoader::hasFailed(int asset) const
+{
+	return status[asset].load(std::memory_order_acquire) == FAILED;
+}
+
+int AssetLoader::getFetchedCount() const
+{
+	return fetched.load(std::memory_order_relaxed);
+}
+
+bool AssetLoader::takeImage(int asset, Image& image)
+{
+	if (!bundle || status[asset].load(std::memory_order_acquire) != FETCHED)
+	{
+		return false;
+	}
+	image = std::move(images[asset]);
+	images[asset] = Image();
+	return true;
+}
+
+void AssetLoader::fetch(int asset)
+{
+	std::lock_guard<std::mutex> lock(reload_mutex);
+	status[asset].store(PENDING, std::memory_order_release);
+	reload_queue.push_back(asset);
+	if (!reloading)
+	{
+		// the last reloader has let go of the lock for good
+		if (reloader.joinable())
+		{
+			reloader.join();
+		}
+		reloading = true;
+		reloader = std::thread(&AssetLoader::reload, this);
+	}
+}
+
+/**
+*   @brief   Worker loop
+*   @details Claims assets in manifest order until there are none left.
+*   @return  void
+*/
+void AssetLoader::work()
+{
+	for (int asset = next_asset++; asset < NUM_ASSETS; asset = next_asset++)
+	{
+		fetchAsset(asset);
+		fetched++;
+	}
+}
+
+/**
+*   @brief   Reloader loop
+*   @details Reads queued assets until the queue is empty, then marks
+			 itself finished under the same lock fetch queues under, so
+			 no request is left waiting for a thread that has gone.
+*   @return  void
+*/
+void AssetLoader::reload()
+{
+	for (;;)
+	{
+		int asset = 0;
+		{
+			std::lock_guard<std::mutex> lock(reload_mutex);
+			if (reload_queue.empty())
+			{
+				reloading = false;
+				return;
+			}
+			asset = reload_queue.back();
+			reload_queue.pop_back();
+		}
+		fetchAsset(asset);
+	}
+}
+
+void AssetLoader::fetchAsset(int asset)
+{
+	if (bundle)
+	{
+		decodeAsset(asset);
+	}
+	else
+	{
+		prefetchAsset(asset);
+	}
+}
+
+/**
+*   @brief   Reads an asset's file through
+*   @details The bytes are thrown away: the point is that the engine's
+			 loader then finds the file in the OS cache instead of
+			 waiting on the disk on the main thread.
+*   @return  void
+*/
+void AssetLoader::prefetchAsset(int asset)
+{
+	std::ifstream in(assetPath(ASSETS[asset].name), std::ios::binary);
+	bool read = !in.fail();
+
+	char buffer[64 * 1024];
+	while (read && in.read(buffer, sizeof(buffer)))
+	{
+	}
+	read = read && in.eof();
+
+	status[asset].store(read ? FETCHED : FAILED, std::memory_order_release);
+}
+
+void AssetLoader::decodeAsset(int asset)
+{
+	std::vector<uint8_t> bytes;
+	Image image;
+	std::string error;
+	bool decoded = readAsset(*bundle, ASSETS[asset].name, bytes) && decodePng(bytes, image, error);
+	images[asset] = std::move(image);
+
+	status[asset].store(decoded ? FETCHED : FAILED, std::memory_order_release);
+}
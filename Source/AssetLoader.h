@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Assets.h"
+#include "Png.h"
+
+class AssetBundle;
+
+/**
+*  Fetches the manifest's assets on a pool of worker threads.
+*  For the GL game this is only a prefetch. ASGE opens, decodes and
+*  uploads a texture in one call that has to run on the thread owning
+*  the GL context, so all the workers can do is read each file through
+*  once, leaving it in the OS file cache for the engine's loader. The
+*  main thread polls isFetched and loads whatever has arrived a few at a
+*  time per frame, so the window keeps drawing while the disk is busy.
+*  Code that decodes textures itself starts the loader with
+*  startDecoding instead, and the workers hand back the pixels.
+*/
+class AssetLoader
+{
+public:
+	AssetLoader() = default;
+	~AssetLoader();
+
+	/**
+	*  Starts prefetching every asset in the manifest from its file.
+	*  @param [in] workers Threads to use, 0 picks one per spare core.
+	*/
+	void start(int workers);
+
+	/**
+	*  Starts decoding every asset in the manifest.
+	*  @param [in] workers Threads to use, 0 picks one per spare core.
+	*  @param [in] bundle Read first, if open; it must outlive the loader.
+	*/
+	void startDecoding(int workers, const AssetBundle& bundle);
+
+	/**
+	*  Stops the workers taking anything new, waits for what they hold
+	*  and releases them.
+	*/
+	void stop();
+
+	/**
+	*  Waits for every asset to be fetched and releases the workers.
+	*/
+	void finish();
+
+	/**
+	*  Checks whether an asset has been read.
+	*  @param [in] asset Index into ASSETS.
+	*  @return true once the asset's bytes have been read, or its read
+	*          failed; hasFailed tells which.
+	*/
+	bool isFetched(int asset) const;
+	bool hasFailed(int asset) const;
+	int getFetchedCount() const;
+
+	/**
+	*  Hands over a decoded asset's pixels, once it is fetched. Only
+	*  once: the loader keeps nothing afterwards.
+	*  @return false if the loader is not decoding, or the asset failed.
+	*/
+	bool takeImage(int asset, Image& image);
+
+	/**
+	*  Reads an asset again, for a texture that was evicted.
+	*  Reloads queue up for a single thread of their own, which is
+	*  started when one is asked for and exits once they are done, so
+	*  the loader can be stopped after startup and still serve them.
+	*  isFetched is false from here until the read finishes.
+	*/
+	void fetch(int asset);
+
+private:
+	enum Status
+	{
+		PENDING = 0,
+		FETCHED = 1,
+		FAILED = 2
+	};
+
+	void begin(int workers);
+	void work();
+	void reload();
+	void fetchAsset(int asset);
+	void prefetchAsset(int asset);
+	void decodeAsset(int asset);
+
+	std::vector<std::thread> workers;
+	std::atomic<int> next_asset{ 0 };
+	std::atomic<int> fetched{ 0 };
+	std::atomic<int> status[NUM_ASSETS] = {};
+	const AssetBundle* bundle = nullptr;  /**< Set when decoding. */
+	Image images[NUM_ASSETS];             /**< Decoded pixels, each written by one worker before its status. */
+
+	std::mutex reload_mutex;
+	std::vector<int> reload_queue;
+	std::thread reloader;
+	bool reloading = false;  /**< The reloader is running; guarded by reload_mutex. */
+};
@@ -0,0 +1,39 @@
+#include <cstring>
+
+#include "Assets.h"
+#include "LevelGenerator.h"
+
+const AssetEntry* findAsset(const char* name)
+{
+	for (const AssetEntry& entry : ASSETS)
+	{
+		if (std::strcmp(entry.name, name) == 0)
+		{
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+std::string assetPath(const char* name)
+{
+	const AssetEntry* entry = findAsset(name);
+	if (!entry)
+	{
+		return std::string();
+	}
+	return std::string(RESOURCE_DIR) + "/" + entry->source;
+}
+
+const char* blockAsset(uint8_t type)
+{
+	switch ((BlockType)type)
+	{
+	case BlockType::POWER_UP:
+		return "block_power_up";
+	case BlockType::BLUE:
+		return "block_blue";
+	default:
+		return "block_red";
+	}
+}
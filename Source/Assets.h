@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/*! \file Assets.h
+@brief   The game's asset manifest.
+@details Every asset the game uses is listed here under a logical name,
+         along with where its source file lives under the resources
+         directory. Code asks for assets by logical name only. The packer
+         bundles exactly these files and nothing else, and source paths
+         always use '/' so they work on every platform.
+*/
+
+struct AssetEntry
+{
+	const char* name;     /**< Logical name the game looks the asset up by. */
+	const char* source;   /**< Path of the source file under RESOURCE_DIR. */
+};
+
+constexpr AssetEntry ASSETS[] =
+{
+	{ "background",     "Textures/puzzlepack/png/background.png" },
+	{ "ball",           "Textures/puzzlepack/png/ballBlue.png" },
+	{ "paddle",         "Textures/puzzlepack/png/paddleBlue.png" },
+	{ "heart",          "Textures/puzzlepack/png/heart.png" },
+	{ "block_power_up", "Textures/puzzlepack/png/element_purple_rectangle.png" },
+	{ "block_red",      "Textures/puzzlepack/png/element_red_rectangle.png" },
+	{ "block_blue",     "Textures/puzzlepack/png/element_blue_rectangle.png" },
+	{ "gem",            "Textures/puzzlepack/png/element_grey_polygon.png" },
+	{ "power_up",       "Textures/puzzlepack/png/element_purple_polygon.png" },
+	{ "laser",          "Textures/puzzlepack/png/element_red_square.png" },
+};
+constexpr int NUM_ASSETS = sizeof(ASSETS) / sizeof(ASSETS[0]);
+
+/**< Directory the asset sources are read from, relative to the executable. */
+constexpr const char* RESOURCE_DIR = "Resources";
+
+/**< The packed bundle, relative to the executable. */
+constexpr const char* ASSET_BUNDLE = "Assets.pak";
+
+/**< The texture atlas index, under RESOURCE_DIR; its pages are written beside it. */
+constexpr const char* ATLAS_INDEX = "Textures/atlas.txt";
+
+/**
+*   @brief   Looks up an asset in the manifest.
+*   @return  The entry, or nullptr if no asset has that name.
+*/
+const AssetEntry* findAsset(const char* name);
+
+/**
+*   @brief   Path of an asset's source file.
+*   @details For loaders that can only read from disk.
+*   @return  The path under RESOURCE_DIR, or an empty string if no asset
+             has that name.
+*/
+std::string assetPath(const char* name);
+
+/**
+*   @return  The asset a block of the given BlockType is drawn with.
+*/
+const char* blockAsset(uint8_t type);
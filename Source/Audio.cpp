@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "Audio.h"
+#include "AudioKernels.h"
+
+namespace
+{
+	constexpr float PI = 3.14159265f;
+	constexpr uint32_t QUEUE_MASK = AUDIO_COMMAND_QUEUE - 1;
+	static_assert((AUDIO_COMMAND_QUEUE & QUEUE_MASK) == 0,
+		"the audio command queue must be a power of two");
+
+	enum CommandType : uint8_t
+	{
+		PLAY = 0,
+		STOP_ALL = 1
+	};
+
+	// how far the limiter lets the gain back up each block
+	constexpr float LIMITER_RELEASE = 0.02f;
+
+	/**
+	*  Builds a clip from a tone generator: seconds long, with a short
+	*  fade in to avoid a click and an exponential decay.
+	*/
+	template <typename Tone>
+	std::vector<float> synthesise(float seconds, float decay, Tone tone)
+	{
+		int length = (int)(seconds * AUDIO_SAMPLE_RATE);
+		int fade = AUDIO_SAMPLE_RATE / 500;
+		std::vector<float> clip((size_t)length);
+		for (int i = 0; i < length; i++)
+		{
+			float t = (float)i / AUDIO_SAMPLE_RATE;
+			float envelope = std::exp(-decay * t) * (i < fade ? (float)i / fade : 1.0f);
+			clip[i] = tone(t) * envelope;
+		}
+		return clip;
+	}
+
+	/**
+	*  A sine whose frequency slides linearly from start to end.
+	*/
+	float sweep(float t, float seconds, float start, float end)
+	{
+		float rate = (end - start) / seconds;
+		return std::sin(2.0f * PI * (start * t + 0.5f * rate * t * t));
+	}
+
+	std::vector<std::vector<float>> makeSounds()
+	{
+		std::vector<std::vector<float>> sounds((size_t)SoundEffect::NUM_SOUNDS);
+		sounds[(int)SoundEffect::PADDLE_HIT] = synthesise(0.08f, 40.0f, [](float t)
+		{
+			return std::sin(2.0f * PI * 660.0f * t);
+		});
+
+		uint32_t noise = 0x12345678u;
+		sounds[(int)SoundEffect::BLOCK_BREAK] = synthesise(0.12f, 30.0f, [&noise](float t)
+		{
+			noise = noise * 1664525u + 1013904223u;
+			float crackle = (float)(noise >> 8) / (float)(1u << 24) * 2.0f - 1.0f;
+			return 0.5f * crackle + 0.5f * std::sin(2.0f * PI * 440.0f * t);
+		});
+		sounds[(int)SoundEffect::GEM_CAUGHT] = synthesise(0.35f, 9.0f, [](float t)
+		{
+			return 0.5f * std::sin(2.0f * PI * 1318.5f * t) + 0.5f * std::sin(2.0f * PI * 1760.0f * t);
+		});
+		sounds[(int)SoundEffect::LASER] = synthesise(0.18f, 12.0f, [](float t)
+		{
+			return sweep(t, 0.18f, 1800.0f, 300.0f);
+		});
+		sounds[(int)SoundEffect::POWER_UP] = synthesise(0.44f, 3.0f, [](float t)
+		{
+			const float notes[] = { 523.3f, 659.3f, 784.0f, 1046.5f };
+			int note = (int)(t / 0.11f);
+			return std::sin(2.0f * PI * notes[note < 4 ? note : 3] * t);
+		});
+		sounds[(int)SoundEffect::LIFE_LOST] = synthesise(0.6f, 4.0f, [](float t)
+		{
+			float tone = sweep(t, 0.6f, 400.0f, 100.0f);
+			return tone > 0.0f ? 0.6f : -0.6f;
+		});
+		return sounds;
+	}
+}
+
+AudioEngine::AudioEngine() : sounds(makeSounds()), queue(new CommandQueue())
+{
+	voices.reserve(AUDIO_MAX_VOICES);
+}
+
+AudioEngine::~AudioEngine()
+{
+	stop();
+}
+
+bool AudioEngine::start(std::unique_ptr<AudioOutput> device)
+{
+	stop();
+	if (!device || !device->open(AUDIO_SAMPLE_RATE, AUDIO_BLOCK_FRAMES))
+	{
+		return false;
+	}
+
+	output = std::move(device);
+	running = true;
+	mixer = std::thread(&AudioEngine::run, this);
+	return true;
+}
+
+void AudioEngine::stop()
+{
+	running = false;
+	if (mixer.joinable())
+	{
+		mixer.join();
+	}
+	if (output)
+	{
+		output->close();
+	}
+}
+
+bool AudioEngine::isRunning() const
+{
+	return running;
+}
+
+void AudioEngine::play(SoundEffect sound, float gain, float pan)
+{
+	Command command;
+	command.type = PLAY;
+	command.sound = (uint8_t)sound;
+	command.gain = gain;
+	command.pan = pan < -1.0f ? -1.0f : pan > 1.0f ? 1.0f : pan;
+	push(command);
+}
+
+void AudioEngine::stopAll()
+{
+	Command command = {};
+	command.type = STOP_ALL;
+	push(command);
+}
+
+/**
+*   @brief   Queues a command
+*   @details The producer only rereads the mixer's tail when its cached
+			 copy says the ring is full, so a trigger is normally a store
+			 and a release store.
+*   @return  void
+*/
+void AudioEngine::push(const Command& command)
+{
+	uint32_t head = queue->head.load(std::memory_order_relaxed);
+	if (head - queue->cached_tail >= AUDIO_COMMAND_QUEUE)
+	{
+		queue->cached_tail = queue->tail.load(std::memory_order_acquire);
+		if (head - queue->cached_tail >= AUDIO_COMMAND_QUEUE)
+		{
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+	}
+	queue->commands[head & QUEUE_MASK] = command;
+	queue->head.store(head + 1, std::memory_order_release);
+}
+
+/**
+*   @brief   Drains the command queue
+*   @details Only what follows the last stop matters. If the new voices
+			 will not all fit, the oldest playing ones are found with one
+			 partial sort and cut together, rather than searching for
+			 the oldest once per trigger in a chain reaction.
+*   @return  void
+*/
+void AudioEngine::drainCommands()
+{
+	uint32_t tail = queue->tail.load(std::memory_order_relaxed);
+	uint32_t head = queue->head.load(std::memory_order_acquire);
+
+	uint32_t first = tail;
+	for (uint32_t i = tail; i != head; i++)
+	{
+		if (queue->commands[i & QUEUE_MASK].type == STOP_ALL)
+		{
+			voices.clear();
+			first = i + 1;
+		}
+	}
+
+	// of more triggers than there are voices, only the newest can play
+	uint32_t plays = head - first;
+	if (plays > (uint32_t)AUDIO_MAX_VOICES)
+	{
+		stolen.fetch_add(plays - AUDIO_MAX_VOICES, std::memory_order_relaxed);
+		first = head - AUDIO_MAX_VOICES;
+		plays = AUDIO_MAX_VOICES;
+	}
+	int excess = (int)voices.size() + (int)plays - AUDIO_MAX_VOICES;
+	if (excess > 0)
+	{
+		std::nth_element(voices.begin(), voices.begin() + (excess - 1), voices.end(),
+			[](const Voice& a, const Voice& b) { return a.started < b.started; });
+		voices.erase(voices.begin(), voices.begin() + excess);
+		stolen.fetch_add(excess, std::memory_order_relaxed);
+	}
+
+	for (uint32_t i = first; i != head; i++)
+	{
+		const Command& command = queue->commands[i & QUEUE_MASK];
+		if (command.sound < sounds.size())
+		{
+			startVoice(command.sound, command.gain, command.pan);
+		}
+	}
+	queue->tail.store(head, std::memory_order_release);
+}
+
+/**
+*   @brief   Starts a voice
+*   @details Pans with a constant power law so a sound keeps its
+			 loudness across the field.
+*   @return  void
+*/
+void AudioEngine::startVoice(int sound, float gain, float pan)
+{
+	float angle = (pan + 1.0f) * PI / 4.0f;
+	Voice voice;
+	voice.sound = sound;
+	voice.position = 0;
+	voice.left = gain * std::cos(angle);
+	voice.right = gain * std::sin(angle);
+	voice.started = voices_started++;
+	voices.push_back(voice);
+}
+
+/**
+*   @brief   Mixes a block
+*   @details Every voice is added into a cleared block, finished voices
+			 are swapped out, then a peak limiter pulls the block's gain
+			 down at once when the sum would clip and lets it recover
+			 slowly, so a pile of simultaneous effects gets quieter
+			 instead of distorting.
+*   @return  void
+*/
+void AudioEngine::render(float* samples)
+{
+	auto start = std::chrono::steady_clock::now();
+	drainCommands();
+
+	const int count = AUDIO_BLOCK_FRAMES * 2;
+	std::memset(samples, 0, count * sizeof(float));
+	for (size_t i = 0; i < voices.size();)
+	{
+		Voice& voice = voices[i];
+		const std::vector<float>& clip = sounds[voice.sound];
+		int left = (int)clip.size() - voice.position;
+		int frames = left < AUDIO_BLOCK_FRAMES ? left : AUDIO_BLOCK_FRAMES;
+		if (scalar_mixing)
+		{
+			mixMonoToStereoScalar(samples, clip.data() + voice.position, frames, voice.left, voice.right);
+		}
+		else
+		{
+			mixMonoToStereo(samples, clip.data() + voice.position, frames, voice.left, voice.right);
+		}
+
+		voice.position += frames;
+		if (voice.position >= (int)clip.size())
+		{
+			voice = voices.back();
+			voices.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	float peak = scalar_mixing ? peakLevelScalar(samples, count) : peakLevel(samples, count);
+	float target = peak > 1.0f ? 1.0f / peak : 1.0f;
+	limiter_gain = target < limiter_gain ? target :
+		limiter_gain + (target - limiter_gain) * LIMITER_RELEASE;
+	if (scalar_mixing)
+	{
+		applyGainScalar(samples, count, limiter_gain);
+	}
+	else
+	{
+		applyGain(samples, count, limiter_gain);
+	}
+
+	int playing = (int)voices.size();
+	voice_count.store(playing, std::memory_order_relaxed);
+	if (playing > peak_voices.load(std::memory_order_relaxed))
+	{
+		peak_voices.store(playing, std::memory_order_relaxed);
+	}
+	blocks.fetch_add(1, std::memory_order_relaxed);
+
+	// a running average over roughly the last 32 blocks
+	int ns = (int)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	int average = mix_ns.load(std::memory_order_relaxed);
+	mix_ns.store(average + (ns - average) / 32, std::memory_order_relaxed);
+}
+
+void AudioEngine::setScalarMixing(bool scalar)
+{
+	scalar_mixing = scalar;
+}
+
+AudioStats AudioEngine::getStats() const
+{
+	AudioStats stats;
+	stats.voices = voice_count.load(std::memory_order_relaxed);
+	stats.peak_voices = peak_voices.load(std::memory_order_relaxed);
+	stats.blocks = blocks.load(std::memory_order_relaxed);
+	stats.mix_us = mix_ns.load(std::memory_order_relaxed) / 1000.0;
+	stats.block_us = AUDIO_BLOCK_FRAMES * 1000000.0 / AUDIO_SAMPLE_RATE;
+	stats.stolen = stolen.load(std::memory_order_relaxed);
+	stats.dropped = dropped.load(std::memory_order_relaxed);
+	stats.underruns = underruns.load(std::memory_order_relaxed);
+	return stats;
+}
+
+const char* AudioEngine::getOutputName() const
+{
+	return output && running ? output->getName() : "off";
+}
+
+/**
+*   @brief   Mixer thread
+*   @details Mixes a block and hands it to the output, whose write
+			 blocks until the device wants more.
+*   @return  void
+*/
+void AudioEngine::run()
+{
+	std::vector<float> block((size_t)AUDIO_BLOCK_FRAMES * 2);
+	while (running)
+	{
+		render(block.data());
+		output->write(block.data());
+		underruns.store(output->getUnderruns(), std::memory_order_relaxed);
+	}
+}
+
+/**
+*   @brief   Times the mixer.
+*   @details Both runs use the same trigger sequence, so they mix the
+			 same voices and only the kernels differ.
+*   @return  The timings.
+*/
+AudioBenchReport runAudioBenchmark(int seconds, int voices, AudioOutput& output)
+{
+	AudioBenchReport report;
+	report.voices = voices;
+	report.blocks = (long long)seconds * AUDIO_SAMPLE_RATE / AUDIO_BLOCK_FRAMES;
+	report.block_us = AUDIO_BLOCK_FRAMES * 1000000.0 / AUDIO_SAMPLE_RATE;
+	report.vectorised = audioKernelsVectorised();
+
+	std::vector<float> block((size_t)AUDIO_BLOCK_FRAMES * 2);
+	bool opened = output.open(AUDIO_SAMPLE_RATE, AUDIO_BLOCK_FRAMES);
+	for (int pass = 0; pass < 2; pass++)
+	{
+		bool scalar = pass == 1;
+		AudioEngine engine;
+		engine.setScalarMixing(scalar);
+
+		uint32_t random = 1;
+		double total_us = 0.0;
+		for (long long i = 0; i < report.blocks; i++)
+		{
+			// top the voices back up, at most a queue's worth per block
+			int missing = voices - engine.getStats().voices;
+			for (int j = 0; j < missing && j < AUDIO_COMMAND_QUEUE; j++)
+			{
+				random = random * 1664525u + 1013904223u;
+				SoundEffect sound = (SoundEffect)((random >> 16) % (uint32_t)SoundEffect::NUM_SOUNDS);
+				float pan = (float)((random >> 8) & 0xff) / 127.5f - 1.0f;
+				engine.play(sound, 0.3f, pan);
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			engine.render(block.data());
+			total_us += std::chrono::duration<double, std::micro>(
+				std::chrono::steady_clock::now() - start).count();
+			if (!scalar && opened)
+			{
+				output.write(block.data());
+			}
+		}
+
+		AudioStats stats = engine.getStats();
+		(scalar ? report.scalar_us : report.vector_us) = report.blocks ? total_us / report.blocks : 0.0;
+		if (!scalar)
+		{
+			report.stolen = stats.stolen;
+			report.dropped = stats.dropped;
+		}
+	}
+	if (opened)
+	{
+		output.close();
+	}
+	return report;
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "AudioOutput.h"
+#include "Constants.h"
+
+/**
+*  The game's sound effects.
+*/
+enum class SoundEffect : uint8_t
+{
+	PADDLE_HIT = 0,
+	BLOCK_BREAK,
+	GEM_CAUGHT,
+	LASER,
+	POWER_UP,
+	LIFE_LOST,
+	NUM_SOUNDS
+};
+
+/**
+*  What the mixer thread has been doing.
+*/
+struct AudioStats
+{
+	int voices = 0;            /**< Playing after the last block. */
+	int peak_voices = 0;
+	long long blocks = 0;
+	double mix_us = 0.0;       /**< Recent average time to mix a block. */
+	double block_us = 0.0;     /**< How much sound a block holds. */
+	long long stolen = 0;      /**< Voices cut short to make room. */
+	long long dropped = 0;     /**< Triggers lost to a full command queue. */
+	long long underruns = 0;
+};
+
+/**
+*  Software mixer for the game's sound effects.
+*  Effects are short mono clips synthesised at start up. A dedicated
+*  thread mixes every playing voice into a float block with the
+*  vectorised kernels, limits it and hands it to the output device,
+*  whose write paces the thread. The game thread never waits on it:
+*  play() only pushes a small command onto a single producer, single
+*  consumer ring that the mixer drains before each block, and a full
+*  ring drops the trigger rather than blocking. When every voice is
+*  taken the oldest one is stolen, so a chain reaction costs at most
+*  AUDIO_MAX_VOICES voices of mixing.
+*/
+class AudioEngine
+{
+public:
+	AudioEngine();
+	~AudioEngine();
+
+	AudioEngine(const AudioEngine&) = delete;
+	AudioEngine& operator=(const AudioEngine&) = delete;
+
+	/**
+	*  Opens the output and starts the mixer thread.
+	*  @param [in] device Where the mix goes; the engine keeps it.
+	*  @return false if the device would not open.
+	*/
+	bool start(std::unique_ptr<AudioOutput> device);
+	void stop();
+	bool isRunning() const;
+
+	/**
+	*  Starts an effect. Only one thread may call this.
+	*  @param [in] sound Which effect.
+	*  @param [in] gain 1 for full volume.
+	*  @param [in] pan -1 hard left to 1 hard right.
+	*/
+	void play(SoundEffect sound, float gain, float pan);
+
+	/**
+	*  Cuts every voice.
+	*/
+	void stopAll();
+
+	/**
+	*  Mixes the next block on the calling thread, for running the
+	*  engine without its thread, e.g. to benchmark it.
+	*  @param [out] samples AUDIO_BLOCK_FRAMES * 2 interleaved samples.
+	*/
+	void render(float* samples);
+
+	/**
+	*  Uses the scalar kernels instead of the vectorised ones.
+	*/
+	void setScalarMixing(bool scalar);
+
+	AudioStats getStats() const;
+	const char* getOutputName() const;
+
+private:
+	struct Command
+	{
+		uint8_t type;
+		uint8_t sound;
+		float gain;
+		float pan;
+	};
+
+	struct Voice
+	{
+		int sound;
+		int position;
+		float left;
+		float right;
+		uint64_t started;
+	};
+
+	/**
+	*  Commands from the game thread. head is only written by the
+	*  producer and tail only by the mixer, each on its own cache line.
+	*/
+	struct CommandQueue
+	{
+		Command commands[AUDIO_COMMAND_QUEUE];
+		std::atomic<uint32_t> head{ 0 };
+		uint32_t cached_tail = 0;
+		char padding[64];
+		std::atomic<uint32_t> tail{ 0 };
+	};
+
+	void run();
+	void push(const Command& command);
+	void drainCommands();
+	void startVoice(int sound, float gain, float pan);
+
+	std::vector<std::vector<float>> sounds;
+	std::vector<Voice> voices;
+	uint64_t voices_started = 0;
+	float limiter_gain = 1.0f;
+	bool scalar_mixing = false;
+
+	std::unique_ptr<CommandQueue> queue;
+	std::unique_ptr<AudioOutput> output;
+	std::thread mixer;
+	std::atomic<bool> running{ false };
+
+	// written by whichever thread mixes, read by anyone
+	std::atomic<int> voice_count{ 0 };
+	std::atomic<int> peak_voices{ 0 };
+	std::atomic<long long> blocks{ 0 };
+	std::atomic<int> mix_ns{ 0 };
+	std::atomic<long long> stolen{ 0 };
+	std::atomic<long long> dropped{ 0 };
+	std::atomic<long long> underruns{ 0 };
+};
+
+/**
+*  Results of mixing flat out with a steady number of voices.
+*/
+struct AudioBenchReport
+{
+	int voices = 0;
+	long long blocks = 0;
+	double vector_us = 0.0;   /**< Per block with the vectorised kernels. */
+	double scalar_us = 0.0;   /**< Per block with the scalar kernels. */
+	double block_us = 0.0;    /**< Sound held in a block, the real time budget. */
+	long long stolen = 0;
+	long long dropped = 0;
+	bool vectorised = false;  /**< The vectorised kernels are compiled in. */
+};
+
+/**
+*   @brief   Times the mixer.
+*   @details Mixes the given amount of sound twice, once with each set
+             of kernels, keeping the given number of voices playing by
+             retriggering effects through the command queue before every
+             block, and hands every block to the output.
+*   @param   [in] seconds Sound to mix per run.
+*   @param   [in] voices Voices kept playing.
+*   @param   [in] output Receives the vectorised run's blocks; opened
+             and closed here.
+*   @return  The timings.
+*/
+AudioBenchReport runAudioBenchmark(int seconds, int voices, AudioOutput& output);
@@ -0,0 +1,150 @@
+#include "AudioKernels.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_SSE 1
+#include <emmintrin.h>
+#else
+#define AUDIO_SSE 0
+#endif
+
+void mixMonoToStereoScalar(float* mix, const float* source, int frames, float left, float right)
+{
+	for (int i = 0; i < frames; i++)
+	{
+		mix[2 * i] += source[i] * left;
+		mix[2 * i + 1] += source[i] * right;
+	}
+}
+
+float peakLevelScalar(const float* samples, int count)
+{
+	float peak = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		float magnitude = samples[i] < 0.0f ? -samples[i] : samples[i];
+		peak = magnitude > peak ? magnitude : peak;
+	}
+	return peak;
+}
+
+void applyGainScalar(float* samples, int count, float gain)
+{
+	for (int i = 0; i < count; i++)
+	{
+		float sample = samples[i] * gain;
+		samples[i] = sample < -1.0f ? -1.0f : sample > 1.0f ? 1.0f : sample;
+	}
+}
+
+#if AUDIO_SSE
+
+/**
+*   @brief   Adds a mono source into a stereo mix.
+*   @details Four source samples are duplicated into two registers of
+			 left/right pairs and multiplied by the gains, so every
+			 instruction works on four output samples.
+*   @return  void
+*/
+void mixMonoToStereo(float* mix, const float* source, int frames, float left, float right)
+{
+	const __m128 gains = _mm_setr_ps(left, right, left, right);
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+	{
+		__m128 in = _mm_loadu_ps(source + i);
+		__m128 low = _mm_mul_ps(_mm_unpacklo_ps(in, in), gains);
+		__m128 high = _mm_mul_ps(_mm_unpackhi_ps(in, in), gains);
+		_mm_storeu_ps(mix + 2 * i, _mm_add_ps(_mm_loadu_ps(mix + 2 * i), low));
+		_mm_storeu_ps(mix + 2 * i + 4, _mm_add_ps(_mm_loadu_ps(mix + 2 * i + 4), high));
+	}
+	mixMonoToStereoScalar(mix + 2 * i, source + i, frames - i, left, right);
+}
+
+float peakLevel(const float* samples, int count)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 peaks = _mm_setzero_ps();
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		peaks = _mm_max_ps(peaks, _mm_andnot_ps(sign, _mm_loadu_ps(samples + i)));
+	}
+
+	float lanes[4];
+	_mm_storeu_ps(lanes, peaks);
+	float peak = peakLevelScalar(samples + i, count - i);
+	for (float lane : lanes)
+	{
+		peak = lane > peak ? lane : peak;
+	}
+	return peak;
+}
+
+void applyGain(float* samples, int count, float gain)
+{
+	const __m128 scale = _mm_set1_ps(gain);
+	const __m128 low = _mm_set1_ps(-1.0f);
+	const __m128 high = _mm_set1_ps(1.0f);
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 scaled = _mm_mul_ps(_mm_loadu_ps(samples + i), scale);
+		_mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(scaled, low), high));
+	}
+	applyGainScalar(samples + i, count - i, gain);
+}
+
+void floatToPcm16(const float* samples, int16_t* pcm, int count)
+{
+	const __m128 scale = _mm_set1_ps(32767.0f);
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i low = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(samples + i), scale));
+		__m128i high = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(samples + i + 4), scale));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pcm + i), _mm_packs_epi32(low, high));
+	}
+	for (; i < count; i++)
+	{
+		float sample = samples[i] * 32767.0f;
+		pcm[i] = (int16_t)(sample < 0.0f ? sample - 0.5f : sample + 0.5f);
+	}
+}
+
+bool audioKernelsVectorised()
+{
+	return true;
+}
+
+#else
+
+void mixMonoToStereo(float* mix, const float* source, int frames, float left, float right)
+{
+	mixMonoToStereoScalar(mix, source, frames, left, right);
+}
+
+float peakLevel(const float* samples, int count)
+{
+	return peakLevelScalar(samples, count);
+}
+
+void applyGain(float* samples, int count, float gain)
+{
+	applyGainScalar(samples, count, gain);
+}
+
+void floatToPcm16(const float* samples, int16_t* pcm, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		float sample = samples[i] * 32767.0f;
+		pcm[i] = (int16_t)(sample < 0.0f ? sample - 0.5f : sample + 0.5f);
+	}
+}
+
+bool audioKernelsVectorised()
+{
+	return false;
+}
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+
+/*! \file AudioKernels.h
+@brief   Inner loops of the audio mixer.
+@details Every kernel works on float samples, with stereo interleaved
+         left then right. The SSE versions are used wherever the build
+         targets SSE2, which every x64 build does; the scalar versions
+         are kept for other targets and so the benchmark can compare
+         the two.
+*/
+
+/**
+*   @brief   Adds a mono source into a stereo mix.
+*   @param   [in,out] mix Interleaved stereo, frames * 2 samples.
+*   @param   [in] source Mono, frames samples.
+*   @param   [in] frames How many frames.
+*   @param   [in] left,right Gain applied to each channel.
+*   @return  void
+*/
+void mixMonoToStereo(float* mix, const float* source, int frames, float left, float right);
+void mixMonoToStereoScalar(float* mix, const float* source, int frames, float left, float right);
+
+/**
+*   @brief   Finds a block's loudest sample.
+*   @return  The largest magnitude in samples.
+*/
+float peakLevel(const float* samples, int count);
+float peakLevelScalar(const float* samples, int count);
+
+/**
+*   @brief   Scales a block and clamps it to -1 to 1.
+*   @return  void
+*/
+void applyGain(float* samples, int count, float gain);
+void applyGainScalar(float* samples, int count, float gain);
+
+/**
+*   @brief   Converts float samples to 16-bit PCM.
+*   @details Input is expected to already be within -1 to 1.
+*   @return  void
+*/
+void floatToPcm16(const float* samples, int16_t* pcm, int count);
+
+/**
+*   @return  True when the SSE kernels are compiled in.
+*/
+bool audioKernelsVectorised();
@@ -0,0 +1,296 @@
+#include <cstring>
+#include <thread>
+
+#include "AudioKernels.h"
+#include "AudioOutput.h"
+#include "Constants.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <mmsystem.h>
+#endif
+
+namespace
+{
+	/**
+	*  The 44 byte header of a PCM WAV file, little endian like the rest
+	*  of the game's files.
+	*/
+#pragma pack(push, 1)
+	struct WavHeader
+	{
+		char riff[4];
+		uint32_t riff_size;
+		char wave[4];
+		char fmt[4];
+		uint32_t fmt_size;
+		uint16_t format;
+		uint16_t channels;
+		uint32_t sample_rate;
+		uint32_t byte_rate;
+		uint16_t block_align;
+		uint16_t bits;
+		char data[4];
+		uint32_t data_size;
+	};
+#pragma pack(pop)
+	static_assert(sizeof(WavHeader) == 44, "WAV header is 44 bytes");
+
+	WavHeader wavHeader(int sample_rate, uint32_t data_bytes)
+	{
+		WavHeader header;
+		std::memcpy(header.riff, "RIFF", 4);
+		header.riff_size = 36 + data_bytes;
+		std::memcpy(header.wave, "WAVE", 4);
+		std::memcpy(header.fmt, "fmt ", 4);
+		header.fmt_size = 16;
+		header.format = 1;
+		header.channels = 2;
+		header.sample_rate = (uint32_t)sample_rate;
+		header.byte_rate = (uint32_t)sample_rate * 4;
+		header.block_align = 4;
+		header.bits = 16;
+		std::memcpy(header.data, "data", 4);
+		header.data_size = data_bytes;
+		return header;
+	}
+}
+
+NullAudioOutput::NullAudioOutput(bool keep_real_time) : real_time(keep_real_time)
+{
+}
+
+bool NullAudioOutput::open(int sample_rate, int block_frames)
+{
+	block_time = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::nanoseconds(1000000000ll * block_frames / sample_rate));
+	next_block = std::chrono::steady_clock::now();
+	return true;
+}
+
+void NullAudioOutput::write(const float*)
+{
+	if (!real_time)
+	{
+		return;
+	}
+
+	// a device holds a few blocks, so the mixer may run that far ahead
+	next_block += block_time;
+	auto now = std::chrono::steady_clock::now();
+	if (next_block < now)
+	{
+		next_block = now;
+	}
+	std::this_thread::sleep_until(next_block - block_time * (AUDIO_DEVICE_BLOCKS - 1));
+}
+
+void NullAudioOutput::close()
+{
+}
+
+const char* NullAudioOutput::getName() const
+{
+	return real_time ? "null" : "null (flat out)";
+}
+
+WavFileOutput::WavFileOutput(const std::string& file_path) : path(file_path)
+{
+}
+
+WavFileOutput::~WavFileOutput()
+{
+	close();
+}
+
+bool WavFileOutput::open(int rate, int frames)
+{
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (file.fail())
+	{
+		return false;
+	}
+
+	// written again with the real sizes on close
+	WavHeader header = wavHeader(rate, 0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	sample_rate = rate;
+	block_frames = frames;
+	pcm.resize((size_t)frames * 2);
+	data_bytes = 0;
+	return true;
+}
+
+void WavFileOutput::write(const float* samples)
+{
+	if (!file.is_open())
+	{
+		return;
+	}
+	floatToPcm16(samples, pcm.data(), block_frames * 2);
+	file.write(reinterpret_cast<const char*>(pcm.data()), pcm.size() * sizeof(int16_t));
+	data_bytes += (uint32_t)(pcm.size() * sizeof(int16_t));
+}
+
+void WavFileOutput::close()
+{
+	if (!file.is_open())
+	{
+		return;
+	}
+	WavHeader header = wavHeader(sample_rate, data_bytes);
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.close();
+}
+
+const char* WavFileOutput::getName() const
+{
+	return "WAV file";
+}
+
+#ifdef _WIN32
+
+namespace
+{
+	/**
+	*  Plays through waveOut.
+	*  AUDIO_DEVICE_BLOCKS buffers are handed to the driver in turn;
+	*  writing a block waits on the driver's event until the oldest one
+	*  has finished playing and can be refilled.
+	*/
+	class WaveOutOutput : public AudioOutput
+	{
+	public:
+		~WaveOutOutput() override
+		{
+			close();
+		}
+
+		bool open(int sample_rate, int frames) override
+		{
+			done = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+			if (!done)
+			{
+				return false;
+			}
+
+			WAVEFORMATEX format = {};
+			format.wFormatTag = WAVE_FORMAT_PCM;
+			format.nChannels = 2;
+			format.nSamplesPerSec = (DWORD)sample_rate;
+			format.wBitsPerSample = 16;
+			format.nBlockAlign = 4;
+			format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+			if (waveOutOpen(&device, WAVE_MAPPER, &format, (DWORD_PTR)done, 0,
+				CALLBACK_EVENT) != MMSYSERR_NOERROR)
+			{
+				device = nullptr;
+				close();
+				return false;
+			}
+
+			block_frames = frames;
+			buffers.resize(AUDIO_DEVICE_BLOCKS);
+			headers.resize(AUDIO_DEVICE_BLOCKS);
+			queued.assign(AUDIO_DEVICE_BLOCKS, false);
+			for (int i = 0; i < AUDIO_DEVICE_BLOCKS; i++)
+			{
+				buffers[i].resize((size_t)frames * 2);
+				WAVEHDR& header = headers[i];
+				std::memset(&header, 0, sizeof(header));
+				header.lpData = reinterpret_cast<LPSTR>(buffers[i].data());
+				header.dwBufferLength = (DWORD)(buffers[i].size() * sizeof(int16_t));
+				waveOutPrepareHeader(device, &header, sizeof(header));
+			}
+			next = 0;
+			return true;
+		}
+
+		void write(const float* samples) override
+		{
+			if (!device)
+			{
+				return;
+			}
+
+			WAVEHDR& header = headers[next];
+			while (queued[next] && !(header.dwFlags & WHDR_DONE))
+			{
+				WaitForSingleObject(done, 100);
+			}
+
+			// every buffer finished means the driver had nothing left to play
+			bool starved = true;
+			for (int i = 0; i < AUDIO_DEVICE_BLOCKS; i++)
+			{
+				starved = starved && (!queued[i] || (headers[i].dwFlags & WHDR_DONE));
+			}
+			if (starved && any_written)
+			{
+				underruns++;
+			}
+
+			floatToPcm16(samples, buffers[next].data(), block_frames * 2);
+			header.dwFlags &= ~WHDR_DONE;
+			waveOutWrite(device, &header, sizeof(header));
+			queued[next] = true;
+			any_written = true;
+			next = (next + 1) % AUDIO_DEVICE_BLOCKS;
+		}
+
+		void close() override
+		{
+			if (device)
+			{
+				waveOutReset(device);
+				for (WAVEHDR& header : headers)
+				{
+					waveOutUnprepareHeader(device, &header, sizeof(header));
+				}
+				waveOutClose(device);
+				device = nullptr;
+			}
+			if (done)
+			{
+				CloseHandle(done);
+				done = nullptr;
+			}
+		}
+
+		const char* getName() const override
+		{
+			return "waveOut";
+		}
+
+		long long getUnderruns() const override
+		{
+			return underruns;
+		}
+
+	private:
+		HWAVEOUT device = nullptr;
+		HANDLE done = nullptr;
+		int block_frames = 0;
+		std::vector<std::vector<int16_t>> buffers;
+		std::vector<WAVEHDR> headers;
+		std::vector<bool> queued;
+		int next = 0;
+		bool any_written = false;
+		long long underruns = 0;
+	};
+}
+
+std::unique_ptr<AudioOutput> createDeviceOutput()
+{
+	return std::unique_ptr<AudioOutput>(new WaveOutOutput());
+}
+
+#else
+
+std::unique_ptr<AudioOutput> createDeviceOutput()
+{
+	return nullptr;
+}
+
+#endif
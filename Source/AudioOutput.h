@@ -0,0 +1,93 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+*  Where mixed audio goes.
+*  The mixer hands over one block of interleaved stereo floats at a
+*  time; write blocks until the device can take it, which is what
+*  paces the mixer thread.
+*/
+class AudioOutput
+{
+public:
+	virtual ~AudioOutput() = default;
+
+	/**
+	*  Opens the device.
+	*  @param [in] sample_rate Frames per second.
+	*  @param [in] block_frames Frames in every block written.
+	*  @return false if the device could not be opened.
+	*/
+	virtual bool open(int sample_rate, int block_frames) = 0;
+
+	/**
+	*  Plays a block, waiting for room first if the device is full.
+	*  @param [in] samples block_frames * 2 samples, each within -1 to 1.
+	*/
+	virtual void write(const float* samples) = 0;
+
+	virtual void close() = 0;
+	virtual const char* getName() const = 0;
+
+	/**
+	*  Blocks the device ran dry before the next one arrived.
+	*/
+	virtual long long getUnderruns() const { return 0; }
+};
+
+/**
+*  Discards everything. Either keeps real time, so the mixer runs at
+*  the pace a sound card would set, or returns at once so mixing can be
+*  timed flat out.
+*/
+class NullAudioOutput : public AudioOutput
+{
+public:
+	explicit NullAudioOutput(bool real_time);
+
+	bool open(int sample_rate, int block_frames) override;
+	void write(const float* samples) override;
+	void close() override;
+	const char* getName() const override;
+
+private:
+	bool real_time = false;
+	std::chrono::steady_clock::duration block_time{ 0 };
+	std::chrono::steady_clock::time_point next_block;
+};
+
+/**
+*  Writes a 16-bit stereo WAV file as fast as blocks arrive.
+*/
+class WavFileOutput : public AudioOutput
+{
+public:
+	explicit WavFileOutput(const std::string& path);
+	~WavFileOutput() override;
+
+	bool open(int sample_rate, int block_frames) override;
+	void write(const float* samples) override;
+	void close() override;
+	const char* getName() const override;
+
+private:
+	std::string path;
+	std::ofstream file;
+	int sample_rate = 0;
+	int block_frames = 0;
+	std::vector<int16_t> pcm;
+	uint32_t data_bytes = 0;
+};
+
+/**
+*   @brief   Opens the platform's sound output.
+*   @details waveOut on Windows, which every version has and which
+             needs nothing beyond winmm; nullptr elsewhere.
+*   @return  The device, not yet opened, or nullptr.
+*/
+std::unique_ptr<AudioOutput> createDeviceOutput();
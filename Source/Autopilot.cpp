@@ -0,0 +1,416 @@
+#include <chrono>
+
+#include "Autopilot.h"
+
+namespace
+{
+	constexpr fixed FIELD_WIDTH = toFixed(PLAYFIELD_WIDTH);
+
+	// longest flight that is predicted in one go; a ball at the slowest
+	// angle crosses the field and back well within this
+	constexpr size_t MAX_PREDICTION_TICKS = 4096;
+
+	// how far each aim is followed looking for its first block hit
+	constexpr int AIM_LOOKAHEAD_TICKS = 480;
+
+	// aims that hit a block within this many ticks of the best one are
+	// picked between at random, so seeds lead to different games
+	constexpr int AIM_SLACK_TICKS = 12;
+
+	// an aim the paddle can not get to in time scores worse than any it can
+	constexpr int UNREACHABLE = 1 << 20;
+
+	/**
+	*  Where along the paddle to take the ball, as a fraction of its width
+	*  from the left. One point in the middle of each deflection band and
+	*  one on the right hand corner.
+	*/
+	constexpr fixed AIM_POINTS[] =
+	{
+		fixedRatio(7, 100),
+		fixedRatio(21, 100),
+		fixedRatio(36, 100),
+		fixedRatio(50, 100),
+		fixedRatio(64, 100),
+		fixedRatio(80, 100),
+		fixedRatio(95, 100),
+	};
+	constexpr int NUM_AIM_POINTS = sizeof(AIM_POINTS) / sizeof(AIM_POINTS[0]);
+
+	fixed clampPaddle(fixed x)
+	{
+		fixed right = FIELD_WIDTH - Simulation::PADDLE_WIDTH;
+		return x < 0 ? 0 : x > right ? right : x;
+	}
+
+	fixed distance(fixed a, fixed b)
+	{
+		return a > b ? a - b : b - a;
+	}
+
+	bool sameBody(const SimBody& a, const SimBody& b)
+	{
+		return a.x == b.x && a.y == b.y && a.vx == b.vx && a.vy == b.vy;
+	}
+}
+
+Autopilot::Autopilot(uint32_t seed)
+{
+	reset(seed);
+}
+
+void Autopilot::reset(uint32_t seed)
+{
+	path.clear();
+	path_start = 0;
+	target_x = 0;
+	rng = seed ? seed : 1;
+}
+
+/**
+*   @brief   Decides the next tick's input.
+*   @details Re-predicts only if the ball has left the predicted path, i.e.
+             after it has come off the paddle or a laser has changed
+             what it will hit. Steers with a proportional axis so the
+             paddle settles on its target instead of overshooting it.
+*   @return  The input for the next tick.
+*/
+SimInput Autopilot::think(const Simulation& simulation)
+{
+	const SimState& state = simulation.getState();
+	SimInput input;
+	if (state.status != SimStatus::PLAYING)
+	{
+		return input;
+	}
+
+	input.fire = state.power_up_active && blockAbovePaddle(simulation);
+
+	// the paddle deflects the ball for as long as they overlap, so hold
+	// still until it is clear rather than knock it onto a new course
+	if (state.ball.y + Simulation::BALL_SIZE > state.paddle.y)
+	{
+		return input;
+	}
+
+	if (!onPath(state))
+	{
+		predict(simulation);
+	}
+
+	fixed target = pickupTarget(state, target_x);
+	fixed axis = fixedDiv(target - state.paddle.x, Simulation::PADDLE_SPEED);
+	input.paddle_axis = axis > FIXED_ONE ? FIXED_ONE : axis < -FIXED_ONE ? -FIXED_ONE : axis;
+	return input;
+}
+
+/**
+*   @brief   Counts the ticks the input will hold for.
+*   @details Only vouches for a paddle at rest on its target with nothing
+             to fire and no pickup to chase, while the ball is on the
+             predicted path. Until something is hit then, nothing think
+             looks at can change: the path was predicted with this same
+             input. The end of the path is as far as it goes, as the
+             next prediction draws the aim at random.
+*   @return  Ticks from now, 1 when it can not say.
+*/
+uint32_t Autopilot::holdTicks(const Simulation& simulation, const SimInput& input) const
+{
+	const SimState& state = simulation.getState();
+	if (state.status != SimStatus::PLAYING || input.fire || input.paddle_axis != 0 ||
+		input.paddle_tracking || state.power_up_visible || !onPath(state))
+	{
+		return 1;
+	}
+	for (int i = 0; i < MAX_GEMS; i++)
+	{
+		if (state.gem_visible[i])
+		{
+			return 1;
+		}
+	}
+	return (uint32_t)(path_start + path.size() - state.tick);
+}
+
+bool Autopilot::onPath(const SimState& state) const
+{
+	if (state.tick < path_start || state.tick - path_start >= path.size())
+	{
+		return false;
+	}
+
+	const PathPoint& point = path[state.tick - path_start];
+	return point.no_hit == state.no_hit && sameBody(point.ball, state.ball);
+}
+
+/**
+*   @brief   Predicts the ball's flight down to the paddle.
+*   @details Runs a copy of the game with no input until the ball reaches
+             the paddle line, recording where it is on each tick. The
+             copy coasts from contact to contact; the ball goes in a
+             straight line in between, so the ticks coasted over are
+             filled in along it. The last point is the tick the paddle
+             has to be in place for.
+*   @return  void
+*/
+void Autopilot::predict(const Simulation& simulation)
+{
+	const SimState& state = simulation.getState();
+	scratch = simulation;
+	path.clear();
+	path_start = state.tick;
+
+	for (;;)
+	{
+		const SimState& ahead = scratch.getState();
+		PathPoint point;
+		point.ball = ahead.ball;
+		point.no_hit = ahead.no_hit;
+		path.push_back(point);
+
+		if (ahead.ball.y + Simulation::BALL_SIZE > state.paddle.y ||
+			ahead.status != SimStatus::PLAYING ||
+			path.size() >= MAX_PREDICTION_TICKS)
+		{
+			break;
+		}
+
+		uint32_t ticks = scratch.coast(SimInput(), (uint32_t)(MAX_PREDICTION_TICKS - path.size()));
+		if (ticks == 0)
+		{
+			scratch.step(SimInput());
+			continue;
+		}
+		const SimBody& to = scratch.getState().ball;
+		fixed step_x = (to.x - point.ball.x) / (fixed)ticks;
+		fixed step_y = (to.y - point.ball.y) / (fixed)ticks;
+		for (uint32_t i = 1; i < ticks; i++)
+		{
+			PathPoint between = point;
+			between.ball.x += step_x * (fixed)i;
+			between.ball.y += step_y * (fixed)i;
+			path.push_back(between);
+		}
+	}
+
+	chooseAim(state);
+}
+
+/**
+*   @brief   Chooses where on the paddle to take the ball.
+*   @details Each aim point is tried on a copy of the predicted landing and
+             followed until the ball hits a block or comes back down,
+             coasting between contacts since nothing can be hit or lost
+             before the next one.
+             Aims the paddle can reach in time that hit a block soonest
+             win, with near ties broken at random.
+*   @return  void
+*/
+void Autopilot::chooseAim(const SimState& state)
+{
+	const SimState& landing = scratch.getState();
+	fixed centre = landing.ball.x + Simulation::BALL_SIZE / 2;
+	fixed reach = (fixed)(path.size() - 1) * Simulation::PADDLE_SPEED;
+
+	fixed aims[NUM_AIM_POINTS];
+	int scores[NUM_AIM_POINTS];
+	int best = UNREACHABLE * 2;
+
+	trial = scratch;
+	for (int i = 0; i < NUM_AIM_POINTS; i++)
+	{
+		aims[i] = clampPaddle(centre - fixedMul(Simulation::PADDLE_WIDTH, AIM_POINTS[i]));
+
+		SimState attempt = landing;
+		attempt.paddle.x = aims[i];
+		attempt.paddle.vx = 0;
+		trial.setState(attempt);
+		trial.step(SimInput());
+
+		int score = AIM_LOOKAHEAD_TICKS;
+		if (trial.getState().lives != landing.lives || trial.getState().ball.vy > 0)
+		{
+			score = UNREACHABLE - 1;
+		}
+		for (int tick = 1; tick < AIM_LOOKAHEAD_TICKS && score == AIM_LOOKAHEAD_TICKS; )
+		{
+			const SimState& after = trial.getState();
+			if (after.no_hit != landing.no_hit || after.status != SimStatus::PLAYING)
+			{
+				score = tick;
+				break;
+			}
+			if (after.ball.vy > 0 && after.ball.y + Simulation::BALL_SIZE > after.paddle.y)
+			{
+				break;
+			}
+
+			int ticks = (int)trial.coast(SimInput(), (uint32_t)(AIM_LOOKAHEAD_TICKS - tick));
+			if (ticks == 0)
+			{
+				trial.step(SimInput());
+				ticks = 1;
+			}
+			tick += ticks;
+		}
+
+		if (distance(aims[i], state.paddle.x) > reach)
+		{
+			// still head for the nearest if nothing is reachable
+			score = UNREACHABLE + distance(aims[i], state.paddle.x) / FIXED_ONE;
+		}
+		scores[i] = score;
+		if (score < best)
+		{
+			best = score;
+		}
+	}
+
+	int choices = 0;
+	for (int i = 0; i < NUM_AIM_POINTS; i++)
+	{
+		if (scores[i] <= best + AIM_SLACK_TICKS)
+		{
+			choices++;
+		}
+	}
+
+	int pick = (int)(random() % (uint32_t)choices);
+	for (int i = 0; i < NUM_AIM_POINTS; i++)
+	{
+		if (scores[i] <= best + AIM_SLACK_TICKS && pick-- == 0)
+		{
+			target_x = aims[i];
+			break;
+		}
+	}
+}
+
+/**
+*   @brief   Detours to catch a falling pickup.
+*   @details A pickup is only chased if it lands before the ball and the
+             paddle can get under it and still be back at the ball's
+             target in time. The power up is preferred over gems.
+*   @return  The paddle x to head for this tick.
+*/
+fixed Autopilot::pickupTarget(const SimState& state, fixed ball_target) const
+{
+	int ball_ticks = (int)(path_start + path.size() - 1 - state.tick);
+	fixed target = ball_target;
+	int soonest = ball_ticks + 1;
+
+	auto consider = [&](const SimBody& pickup, bool preferred)
+	{
+		fixed drop = fixedMul(pickup.vy, Simulation::DROP_SPEED);
+		fixed gap = state.paddle.y - (pickup.y + Simulation::GEM_SIZE);
+		if (drop <= 0 || pickup.y > state.paddle.y)
+		{
+			return;
+		}
+
+		int ticks = gap >= 0 ? gap / drop + 1 : 0;
+		fixed x = clampPaddle(pickup.x + Simulation::GEM_SIZE / 2 - Simulation::PADDLE_WIDTH / 2);
+		if (ticks > ball_ticks ||
+			distance(x, state.paddle.x) > ticks * Simulation::PADDLE_SPEED ||
+			distance(x, ball_target) > (ball_ticks - ticks) * Simulation::PADDLE_SPEED)
+		{
+			return;
+		}
+		if (preferred || ticks < soonest)
+		{
+			target = x;
+			soonest = preferred ? -1 : ticks;
+		}
+	};
+
+	for (int i = 0; i < MAX_GEMS; i++)
+	{
+		if (state.gem_visible[i])
+		{
+			consider(state.gems[i], false);
+		}
+	}
+	if (state.power_up_visible)
+	{
+		consider(state.power_up, true);
+	}
+	return target;
+}
+
+/**
+*   @brief   Checks the laser's line of fire.
+*   @details A laser goes up the column it was fired under, so it will
+             hit something if that column has any live block left.
+*   @return  true if a laser fired now would hit something.
+*/
+bool Autopilot::blockAbovePaddle(const Simulation& simulation) const
+{
+	const SimState& state = simulation.getState();
+	fixed laser_x = state.paddle.x + Simulation::PADDLE_WIDTH / 2 - Simulation::LASER_WIDTH / 2;
+
+	int column = Simulation::laserColumn(laser_x);
+	return column >= 0 && simulation.getBlockGrid().lowestRow(column) >= 0;
+}
+
+uint32_t Autopilot::random()
+{
+	// xorshift32
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+	return rng;
+}
+
+SoakReport runSoak(int games, uint32_t seed, uint32_t max_ticks)
+{
+	SoakReport report;
+	auto start = std::chrono::steady_clock::now();
+
+	Simulation simulation;
+	Autopilot autopilot;
+	for (int game = 0; game < games; game++)
+	{
+		simulation.newGame();
+		autopilot.reset(seed + (uint32_t)game);
+		bool full_lasers = false;
+
+		while (simulation.getState().status == SimStatus::PLAYING &&
+			simulation.getState().tick < max_ticks)
+		{
+			SimInput input = autopilot.think(simulation);
+			uint32_t hold = autopilot.holdTicks(simulation, input);
+			uint32_t left = max_ticks - simulation.getState().tick;
+			if (hold < 2 || simulation.coast(input, hold < left ? hold : left) == 0)
+			{
+				simulation.step(input);
+			}
+
+			const SimState& state = simulation.getState();
+			if (!full_lasers && state.power_up_shots == MAX_LASERS)
+			{
+				int in_flight = 0;
+				for (int i = 0; i < MAX_LASERS; i++)
+				{
+					in_flight += state.laser_visible[i];
+				}
+				full_lasers = in_flight == MAX_LASERS;
+			}
+		}
+
+		const SimState& state = simulation.getState();
+		report.games++;
+		report.ticks += state.tick;
+		report.won += state.status == SimStatus::WON;
+		report.lost += state.status == SimStatus::LOST;
+		report.timed_out += state.status == SimStatus::PLAYING;
+		report.full_laser_games += full_lasers;
+		if (state.game_speed > report.top_game_speed)
+		{
+			report.top_game_speed = state.game_speed;
+		}
+	}
+
+	report.seconds = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+	return report;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Simulation.h"
+
+/**
+*  Plays the fixed point simulation on its own for soak and performance runs.
+*  Every tick it looks at the state and answers with the SimInput a player
+*  would give. Where the ball will cross the paddle line is found by running
+*  a scratch copy of the simulation forward, so wall bounces, block hits and
+*  speed ups are predicted by the same rules that will play them out. The
+*  landing spot on the paddle is then chosen by trying each deflection band
+*  and keeping the one that reaches a block soonest. Time to spare before
+*  the ball arrives is spent catching gems and the power up, and lasers are
+*  fired whenever there is a block above the paddle.
+*  The prediction is only redone when the real game stops following it.
+*/
+class Autopilot
+{
+public:
+	/**
+	*  Constructor.
+	*  @param [in] seed Varies the choice between equally good aims so
+	*              that different seeds play different games.
+	*/
+	explicit Autopilot(uint32_t seed = 1);
+
+	/**
+	*  Forgets the current prediction and reseeds.
+	*  @param [in] seed The new seed.
+	*/
+	void reset(uint32_t seed);
+
+	/**
+	*  Decides the input for the next tick.
+	*  @param [in] simulation The game being played.
+	*  @return The input to step the simulation with.
+	*/
+	SimInput think(const Simulation& simulation);
+
+	/**
+	*  How many ticks think will keep giving an input it just gave, as
+	*  long as nothing is hit meanwhile; what Simulation::coast needs to
+	*  know to take them in one go.
+	*  @param [in] simulation The game, as think saw it.
+	*  @param [in] input What think answered.
+	*  @return Ticks from now, at least 1.
+	*/
+	uint32_t holdTicks(const Simulation& simulation, const SimInput& input) const;
+
+private:
+	struct PathPoint
+	{
+		SimBody ball;
+		int32_t no_hit = 0;
+	};
+
+	bool onPath(const SimState& state) const;
+	void predict(const Simulation& simulation);
+	void chooseAim(const SimState& state);
+	fixed pickupTarget(const SimState& state, fixed ball_target) const;
+	bool blockAbovePaddle(const Simulation& simulation) const;
+	uint32_t random();
+
+	Simulation scratch;               /**< Runs the ball forward to the paddle. */
+	Simulation trial;                 /**< Tries out each aim from there. */
+	std::vector<PathPoint> path;      /**< Predicted ball per tick to the paddle. */
+	uint32_t path_start = 0;          /**< Tick of the state path[0] should match. */
+	fixed target_x = 0;               /**< Paddle x to be at when the ball lands. */
+	uint32_t rng = 1;
+};
+
+/**
+*  Totals from a batch of autopilot games.
+*/
+struct SoakReport
+{
+	int games = 0;
+	int won = 0;
+	int lost = 0;
+	int timed_out = 0;
+	uint64_t ticks = 0;
+	fixed top_game_speed = 0;    /**< Highest game speed any game reached. */
+	int full_laser_games = 0;    /**< Games that had every laser in flight at once. */
+	double seconds = 0.0;        /**< Wall clock time taken. */
+};
+
+/**
+*   @brief   Plays a batch of games headless.
+*   @details No window or renderer is created; the simulation is stepped
+             as fast as it will go, and coasted from contact to contact
+             while the autopilot's input stays the same.
+*   @param   [in] games How many games to play.
+*   @param   [in] seed Seed of the first game, each game after adds one.
+*   @param   [in] max_ticks Games still going after this many ticks are
+             abandoned and counted as timed out.
+*   @return  The batch totals.
+*/
+SoakReport runSoak(int games, uint32_t seed, uint32_t max_ticks);
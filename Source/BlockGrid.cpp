@@ -0,0 +1,105 @@
+#include "BlockGrid.h"
+
+namespace
+{
+	constexpr uint16_t FULL_ROW = (uint16_t)((1u << BLOCKS_PER_ROW) - 1);
+}
+
+BlockGrid::BlockGrid()
+{
+	clear();
+}
+
+void BlockGrid::fill()
+{
+	for (uint16_t& row : rows)
+	{
+		row = FULL_ROW;
+	}
+	for (int8_t& row : lowest)
+	{
+		row = (int8_t)(BLOCK_ROWS - 1);
+	}
+	live = MAX_BLOCKS;
+}
+
+void BlockGrid::clear()
+{
+	for (uint16_t& row : rows)
+	{
+		row = 0;
+	}
+	for (int8_t& row : lowest)
+	{
+		row = -1;
+	}
+	live = 0;
+}
+
+void BlockGrid::build(const uint8_t* visible)
+{
+	clear();
+	for (int i = 0; i < MAX_BLOCKS; i++)
+	{
+		if (visible[i])
+		{
+			int row = i / BLOCKS_PER_ROW;
+			int column = i % BLOCKS_PER_ROW;
+			rows[row] |= (uint16_t)(1u << column);
+			// rows are visited top down, so the last one seen is the lowest
+			lowest[column] = (int8_t)row;
+			live++;
+		}
+	}
+}
+
+/**
+*   @brief   Removes a block.
+*   @details If the block was the lowest in its column the rows above
+             are walked until a live one turns up, at most the height
+             of the grid and usually one step.
+*   @return  void
+*/
+void BlockGrid::kill(int index)
+{
+	int row = index / BLOCKS_PER_ROW;
+	int column = index % BLOCKS_PER_ROW;
+	uint16_t bit = (uint16_t)(1u << column);
+	if (!(rows[row] & bit))
+	{
+		return;
+	}
+
+	rows[row] &= (uint16_t)~bit;
+	live--;
+
+	if (lowest[column] == row)
+	{
+		int above = row - 1;
+		while (above >= 0 && !(rows[above] & bit))
+		{
+			above--;
+		}
+		lowest[column] = (int8_t)above;
+	}
+}
+
+bool BlockGrid::isLive(int index) const
+{
+	return (rows[index / BLOCKS_PER_ROW] >> (index % BLOCKS_PER_ROW)) & 1u;
+}
+
+int BlockGrid::getLiveCount() const
+{
+	return live;
+}
+
+uint32_t BlockGrid::rowMask(int row) const
+{
+	return rows[row];
+}
+
+int BlockGrid::lowestRow(int column) const
+{
+	return lowest[column];
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "Constants.h"
+
+/**
+*   @brief   Counts the zero bits below the lowest set bit.
+*   @details Compiles to a single bit scan instruction. mask must not be 0.
+*/
+inline int countTrailingZeros(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+/**
+*  Occupancy index for the block grid.
+*  One bit per block, a row to a word, plus the lowest live row of each
+*  column. Finding live blocks is then a bit scan over a handful of words
+*  instead of a test of every slot, and what a laser travelling up a
+*  column will reach first is a table lookup.
+*/
+class BlockGrid
+{
+public:
+	BlockGrid();
+
+	/**
+	*  Marks every block live, as at the start of a game.
+	*/
+	void fill();
+	void clear();
+
+	/**
+	*  Rebuilds the index from per-block visibility flags.
+	*  @param [in] visible MAX_BLOCKS flags, non-zero for a live block.
+	*/
+	void build(const uint8_t* visible);
+
+	/**
+	*  Marks a block destroyed.
+	*  Only the block's column is rescanned, and only if it was the
+	*  column's lowest.
+	*  @param [in] index The block.
+	*/
+	void kill(int index);
+
+	bool isLive(int index) const;
+	int getLiveCount() const;
+
+	/**
+	*  Returns a row's live blocks.
+	*  @param [in] row The row, 0 at the top.
+	*  @return A mask with bit n set if column n is live.
+	*/
+	uint32_t rowMask(int row) const;
+
+	/**
+	*  Returns the lowest live row of a column.
+	*  @param [in] column The column, 0 on the left.
+	*  @return The row, or -1 if the column is empty.
+	*/
+	int lowestRow(int column) const;
+
+	/**
+	*  Calls function(index) for every live block in index order.
+	*/
+	template <typename Function>
+	void forEachLive(Function function) const
+	{
+		for (int row = 0; row < BLOCK_ROWS; row++)
+		{
+			for (uint32_t mask = rows[row]; mask; mask &= mask - 1)
+			{
+				function(row * BLOCKS_PER_ROW + countTrailingZeros(mask));
+			}
+		}
+	}
+
+private:
+	static_assert(BLOCKS_PER_ROW <= 16, "a grid row has to fit in 16 bits");
+
+	uint16_t rows[BLOCK_ROWS] = {};
+	int8_t lowest[BLOCKS_PER_ROW] = {};
+	int live = 0;
+};
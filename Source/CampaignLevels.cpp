@@ -0,0 +1,278 @@
+#include "CampaignLevels.h"
+#include "Constants.h"
+
+namespace
+{
+	// ends a list of drops
+	constexpr int END = -1;
+
+	/**
+	*  A level as it is written: one character a cell, row by row from
+	*  the top left, and the cells that drop something listed by index.
+	*    .  empty     R  red block     B  blue block
+	*  A cell dropping a power up becomes the power up block whatever
+	*  colour it was drawn.
+	*/
+	struct LevelSource
+	{
+		const char* art;
+		int columns;
+		int rows;
+		int gem_interval;      /**< As Level::gem_interval; 0 to use the gem list. */
+		const int* power_ups;  /**< Cells dropping a power up, ending with END. */
+		const int* gems;       /**< Cells dropping a gem, ending with END. */
+	};
+
+	/**
+	*  A level's cells as the simulation reads them.
+	*/
+	template <int Cells>
+	struct BakedCells
+	{
+		uint8_t types[Cells];
+		uint8_t drops[Cells];
+		int blocks;
+		int power_ups;
+	};
+
+	constexpr int cellCount(const LevelSource& source)
+	{
+		return source.columns * source.rows;
+	}
+
+	constexpr int length(const char* art)
+	{
+		int count = 0;
+		while (art[count] != '\0')
+		{
+			count++;
+		}
+		return count;
+	}
+
+	constexpr int dropCount(const int* drops)
+	{
+		int count = 0;
+		while (drops[count] != END)
+		{
+			count++;
+		}
+		return count;
+	}
+
+	constexpr int timesListed(const int* drops, int cell)
+	{
+		int count = 0;
+		for (const int* drop = drops; *drop != END; drop++)
+		{
+			count += *drop == cell;
+		}
+		return count;
+	}
+
+	constexpr int blockCount(const LevelSource& source)
+	{
+		int count = 0;
+		for (int i = 0; i < cellCount(source); i++)
+		{
+			count += source.art[i] != '.';
+		}
+		return count;
+	}
+
+	/**
+	*  Bounds: the grid fits the playfield and the art fills it exactly.
+	*/
+	constexpr bool fitsPlayfield(const LevelSource& source)
+	{
+		return source.columns > 0 && source.rows > 0 &&
+			source.columns <= BLOCKS_PER_ROW && source.rows <= BLOCK_ROWS &&
+			length(source.art) == cellCount(source);
+	}
+
+	constexpr bool knownCells(const LevelSource& source)
+	{
+		for (int i = 0; i < cellCount(source); i++)
+		{
+			char cell = source.art[i];
+			if (cell != '.' && cell != 'R' && cell != 'B')
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	*  Every drop in a list is inside the grid and on a block.
+	*/
+	constexpr bool dropsOnBlocks(const LevelSource& source, const int* drops)
+	{
+		for (const int* drop = drops; *drop != END; drop++)
+		{
+			if (*drop < 0 || *drop >= cellCount(source) || source.art[*drop] == '.')
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	*  Overlaps: no cell is listed twice, in one list or across both.
+	*/
+	constexpr bool noOverlaps(const LevelSource& source)
+	{
+		for (int i = 0; i < cellCount(source); i++)
+		{
+			if (timesListed(source.power_ups, i) + timesListed(source.gems, i) > 1)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	*  The drop table: gems come from the interval or the list, never
+	*  both; power ups stay within the generator's cap; and there is
+	*  something to break.
+	*/
+	constexpr bool sensibleDrops(const LevelSource& source)
+	{
+		int cap = cellCount(source) * LEVEL_POWER_UP_PERCENT / 100;
+		return source.gem_interval >= 0 &&
+			!(source.gem_interval > 0 && dropCount(source.gems) > 0) &&
+			dropCount(source.power_ups) <= (cap > 1 ? cap : 1) &&
+			blockCount(source) > 0;
+	}
+
+	template <int Cells>
+	constexpr BakedCells<Cells> bake(const LevelSource& source)
+	{
+		BakedCells<Cells> baked = {};
+		for (int i = 0; i < Cells; i++)
+		{
+			char cell = source.art[i];
+			baked.types[i] = (uint8_t)(cell == 'R' ? BlockType::RED :
+				cell == 'B' ? BlockType::BLUE : BlockType::EMPTY);
+			baked.blocks += cell != '.';
+		}
+		for (const int* drop = source.power_ups; *drop != END; drop++)
+		{
+			baked.types[*drop] = (uint8_t)BlockType::POWER_UP;
+			baked.drops[*drop] = (uint8_t)BlockDrop::POWER_UP;
+			baked.power_ups++;
+		}
+		for (const int* drop = source.gems; *drop != END; drop++)
+		{
+			baked.drops[*drop] = (uint8_t)BlockDrop::GEM;
+		}
+		return baked;
+	}
+
+	constexpr int NO_DROPS[] = { END };
+
+	/* The original layout: alternating red and blue, the power up in six
+	fixed places and a gem every fifth block */
+	constexpr char CLASSIC_ART[] =
+		"RBRBRBRBRBRBRBR"
+		"BRBRBRBRBRBRBRB"
+		"RBRBRBRBRBRBRBR"
+		"BRBRBRBRBRBRBRB"
+		"RBRBRBRBRBRBRBR"
+		"BRBRBRBRBRBRBRB"
+		"RBRBRBRBRBRBRBR"
+		"BRBRBRBRBRBRBRB"
+		"RBRBRBRBRBRBRBR"
+		"BRBRBRBRBRBRBRB";
+	constexpr int CLASSIC_POWER_UPS[] = { 32, 42, 80, 84, 106, 118, END };
+	constexpr LevelSource CLASSIC = { CLASSIC_ART, 15, 10, 5, CLASSIC_POWER_UPS, NO_DROPS };
+
+	static_assert(fitsPlayfield(CLASSIC), "classic: grid does not fit the playfield");
+	static_assert(knownCells(CLASSIC), "classic: unknown cell");
+	static_assert(dropsOnBlocks(CLASSIC, CLASSIC.power_ups) && dropsOnBlocks(CLASSIC, CLASSIC.gems),
+		"classic: a drop is off the grid or on an empty cell");
+	static_assert(noOverlaps(CLASSIC), "classic: a cell drops twice");
+	static_assert(sensibleDrops(CLASSIC), "classic: drop table makes no sense");
+	// BreakoutGame's own update still lays the classic level across
+	// every block
+	static_assert(cellCount(CLASSIC) == MAX_BLOCKS && CLASSIC.columns == BLOCKS_PER_ROW,
+		"classic: must fill the whole grid");
+
+	constexpr BakedCells<cellCount(CLASSIC)> CLASSIC_CELLS = bake<cellCount(CLASSIC)>(CLASSIC);
+
+	/* Eight rows stepping out from a single block, the bottom two rows
+	of the playfield left open */
+	constexpr char PYRAMID_ART[] =
+		".......R......."
+		"......BBB......"
+		".....RRRRR....."
+		"....BBBBBBB...."
+		"...RRRRRRRRR..."
+		"..BBBBBBBBBBB.."
+		".RRRRRRRRRRRRR."
+		"BBBBBBBBBBBBBBB";
+	constexpr int PYRAMID_POWER_UPS[] = { 63, 71, 105, 119, END };
+	constexpr int PYRAMID_GEMS[] = { 7, 37, 50, 54, 79, 85, 91, 103, 112, END };
+	constexpr LevelSource PYRAMID = { PYRAMID_ART, 15, 8, 0, PYRAMID_POWER_UPS, PYRAMID_GEMS };
+
+	static_assert(fitsPlayfield(PYRAMID), "pyramid: grid does not fit the playfield");
+	static_assert(knownCells(PYRAMID), "pyramid: unknown cell");
+	static_assert(dropsOnBlocks(PYRAMID, PYRAMID.power_ups) && dropsOnBlocks(PYRAMID, PYRAMID.gems),
+		"pyramid: a drop is off the grid or on an empty cell");
+	static_assert(noOverlaps(PYRAMID), "pyramid: a cell drops twice");
+	static_assert(sensibleDrops(PYRAMID), "pyramid: drop table makes no sense");
+
+	constexpr BakedCells<cellCount(PYRAMID)> PYRAMID_CELLS = bake<cellCount(PYRAMID)>(PYRAMID);
+
+	/* Two walled rooms with a red ring in each, split by an open column
+	and underlined by a loose row */
+	constexpr char GATES_ART[] =
+		"RRRRRRR.RRRRRRR"
+		"B.....B.B.....B"
+		"B.RRR.B.B.RRR.B"
+		"B.R.R.B.B.R.R.B"
+		"B.RRR.B.B.RRR.B"
+		"B.....B.B.....B"
+		"BBBBBBB.BBBBBBB"
+		"..............."
+		"RBRBRBRBRBRBRBR";
+	constexpr int GATES_POWER_UPS[] = { 0, 14, 47, 57, 127, END };
+	constexpr int GATES_GEMS[] = { 15, 29, 34, 40, 93, 101, 120, 134, END };
+	constexpr LevelSource GATES = { GATES_ART, 15, 9, 0, GATES_POWER_UPS, GATES_GEMS };
+
+	static_assert(fitsPlayfield(GATES), "gates: grid does not fit the playfield");
+	static_assert(knownCells(GATES), "gates: unknown cell");
+	static_assert(dropsOnBlocks(GATES, GATES.power_ups) && dropsOnBlocks(GATES, GATES.gems),
+		"gates: a drop is off the grid or on an empty cell");
+	static_assert(noOverlaps(GATES), "gates: a cell drops twice");
+	static_assert(sensibleDrops(GATES), "gates: drop table makes no sense");
+
+	constexpr BakedCells<cellCount(GATES)> GATES_CELLS = bake<cellCount(GATES)>(GATES);
+
+	template <int Cells>
+	constexpr LevelLayout bakedLayout(const LevelSource& source, const BakedCells<Cells>& cells)
+	{
+		return { source.columns, source.rows, source.gem_interval, cells.blocks,
+			cells.power_ups, cells.types, cells.drops };
+	}
+
+	constexpr LevelLayout CAMPAIGN[] =
+	{
+		bakedLayout(CLASSIC, CLASSIC_CELLS),
+		bakedLayout(PYRAMID, PYRAMID_CELLS),
+		bakedLayout(GATES, GATES_CELLS),
+	};
+	static_assert(sizeof(CAMPAIGN) / sizeof(CAMPAIGN[0]) == CAMPAIGN_LEVELS,
+		"CAMPAIGN_LEVELS is out of step with the table");
+}
+
+const LevelLayout& campaignLevel(int number)
+{
+	if (number < 0)
+	{
+		number = 0;
+	}
+	return CAMPAIGN[number < CAMPAIGN_LEVELS ? number : CAMPAIGN_LEVELS - 1];
+}
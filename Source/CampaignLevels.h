@@ -0,0 +1,24 @@
+#pragma once
+#include "LevelGenerator.h"
+
+/*! \file CampaignLevels.h
+@brief   The hand made levels.
+@details Written out in CampaignLevels.cpp as constexpr data, checked by
+         static_assert and baked into the binary as read only tables,
+         so a broken layout fails the build and loading one at run time
+         is only a matter of pointing at it: no parsing, no allocation
+         and no files.
+*/
+
+/**
+*  Levels in the campaign, the classic layout first.
+*/
+constexpr int CAMPAIGN_LEVELS = 3;
+
+/**
+*   @brief   One of the campaign's levels
+*   @param   [in] number 0 for the classic layout; past the end gives
+             the last level.
+*   @return  A layout that lives as long as the program.
+*/
+const LevelLayout& campaignLevel(int number);
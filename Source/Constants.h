@@ -13,4 +13,128 @@ constexpr float GAMEPLAY_HEIGHT = 0.8f;
 constexpr int MAX_BLOCKS = 150;
 constexpr int MAX_LASERS = 10;
 constexpr int MAX_GEMS = 3;
-constexpr int NUM_HIGH_SCORES = 10;
\ No newline at end of file
+constexpr int NUM_HIGH_SCORES = 10;
+
+/* block grid layout */
+constexpr int BLOCKS_PER_ROW = 15;
+constexpr int BLOCK_ROWS = MAX_BLOCKS / BLOCKS_PER_ROW;
+
+/**< Frame pacer target in frames per second. 0 leaves the game loop uncapped. */
+constexpr int TARGET_FRAME_RATE = 120;
+
+/**< Runs gameplay on the deterministic fixed point simulation. False uses the float sprite update. */
+constexpr bool FIXED_POINT_SIM = true;
+
+/* fixed point simulation: logical playfield size and tick rate */
+constexpr int PLAYFIELD_WIDTH = 1000;
+constexpr int PLAYFIELD_HEIGHT = 800;
+constexpr int SIM_TICK_RATE = 120;
+constexpr int MAX_SIM_TICKS_PER_FRAME = 8;
+
+/* rewind history: seconds kept, ticks between full snapshots, scrub speed multiplier */
+constexpr int REWIND_SECONDS = 60;
+constexpr int REWIND_KEYFRAME_INTERVAL = 120;
+constexpr int REWIND_SCRUB_SPEED = 2;
+
+/* spectator stream: loopback port (0 disables), ticks between keyframes,
+   bytes a viewer may fall behind before it is resynced, ticks before a stuck viewer is dropped */
+constexpr int SPECTATOR_PORT = 27960;
+constexpr int SPECTATOR_KEYFRAME_INTERVAL = 120;
+constexpr int SPECTATOR_MAX_BACKLOG = 16 * 1024;
+constexpr int SPECTATOR_STALL_TICKS = 600;
+
+/* autopilot soak runs (-soak N): games when N is not given, ticks before a game is abandoned */
+constexpr int SOAK_GAMES = 1000;
+constexpr int SOAK_MAX_TICKS = 30 * 60 * SIM_TICK_RATE;
+
+/**< Milliseconds per frame spent loading sprites, at startup and as released textures come back. */
+constexpr int ASSET_UPLOAD_BUDGET_MS = 4;
+
+/* kilobytes of texture files the sprite cache holds sprites for before the least recently drawn are released
+   (-spritebudget N overrides); this caps sprite objects, the engine keeps every texture's video memory */
+constexpr int SPRITE_BUDGET_KB = 64 * 1024;
+
+/* texture atlas (-atlas): width and height of the largest page the packer makes, a power of two, and the
+   pixels around each packed texture, filled with its own edge so filtering never samples a neighbour */
+constexpr int ATLAS_PAGE_SIZE = 2048;
+constexpr int ATLAS_PADDING = 2;
+
+/* software renderer: pixels a side of the tiles a frame is split into, one job each, and the
+   screen pixels a font pixel covers at a text scale of 1 */
+constexpr int RASTER_TILE_SIZE = 64;
+constexpr float RASTER_GLYPH_SCALE = 1.5f;
+
+/**< Frames timed per configuration by -rasterbench N, at the benchmark's resolution. */
+constexpr int RASTER_BENCH_FRAMES = 300;
+constexpr int RASTER_BENCH_WIDTH = 1920;
+constexpr int RASTER_BENCH_HEIGHT = 1080;
+
+/* frame capture: frames held at once, queued or being encoded (the newest is kept as the next one's
+   reference), threads encoding and writing them, and a -record run's frame rate and resolution */
+constexpr int CAPTURE_BUFFERS = 8;
+constexpr int CAPTURE_WORKERS = 2;
+constexpr int CAPTURE_FRAME_RATE = 60;
+constexpr int CAPTURE_WIDTH = 1280;
+constexpr int CAPTURE_HEIGHT = 720;
+
+/**< Frames -record N captures when N is not given. */
+constexpr int RECORD_FRAMES = 600;
+
+/* gameplay telemetry: records each thread's ring holds (a power of two), milliseconds between drains,
+   bytes per file and files kept before the oldest is overwritten */
+constexpr int TELEMETRY_RING_RECORDS = 4096;
+constexpr int TELEMETRY_DRAIN_MS = 50;
+constexpr int TELEMETRY_FILE_BYTES = 1024 * 1024;
+constexpr int TELEMETRY_FILES = 4;
+
+/* dynamic AABB tree: fat box margin in logical units, ticks of motion a fat box is stretched to cover,
+   ticks each size is run for by -treebench */
+constexpr int AABB_TREE_MARGIN = 2;
+constexpr int AABB_TREE_LOOKAHEAD = 4;
+constexpr int TREE_BENCH_TICKS = 600;
+
+/* job system: most worker threads started, fewest work items a graph needs before it is spread across the
+   workers rather than run inline */
+constexpr int JOB_MAX_WORKERS = 8;
+constexpr int JOB_INLINE_THRESHOLD = 256;
+
+/* input latency histograms: bucket width in microseconds, buckets before the overflow bucket, input events
+   tracked between arrival and presentation (a power of two) */
+constexpr int LATENCY_BUCKET_US = 250;
+constexpr int LATENCY_BUCKETS = 400;
+constexpr int LATENCY_PENDING = 64;
+
+/* gamepad paddle control: controller polled, its left stick's x axis, the fraction of the stick's travel
+   ignored around the centre, and the button that fires */
+constexpr int GAMEPAD_INDEX = 0;
+constexpr int GAMEPAD_AXIS_X = 0;
+constexpr float GAMEPAD_DEADZONE = 0.2f;
+constexpr int GAMEPAD_FIRE_BUTTON = 0;
+
+/* procedural levels: most of a level's cells that may carry the power up, fewest that must hold a block
+   (both percentages), levels a -levelgen run builds when no count is given */
+constexpr int LEVEL_POWER_UP_PERCENT = 4;
+constexpr int LEVEL_MIN_BLOCK_PERCENT = 25;
+constexpr int LEVEL_BATCH_COUNT = 1000000;
+
+/* audio: mixer sample rate, frames mixed per block, blocks queued on the output device, voices mixed at once
+   (the oldest is stolen beyond that), trigger commands the game can queue between blocks (a power of two),
+   seconds and voices a -audiobench run mixes */
+constexpr int AUDIO_SAMPLE_RATE = 48000;
+constexpr int AUDIO_BLOCK_FRAMES = 256;
+constexpr int AUDIO_DEVICE_BLOCKS = 4;
+constexpr int AUDIO_MAX_VOICES = 512;
+constexpr int AUDIO_COMMAND_QUEUE = 1024;
+constexpr int AUDIO_BENCH_SECONDS = 20;
+constexpr int AUDIO_BENCH_VOICES = 400;
+
+/* leaderboard: records appended since the last compaction that trigger the next one when the log is opened,
+   scores a -leaderbench run ranks when no count is given */
+constexpr long long LEADERBOARD_COMPACT_RECORDS = 100000;
+constexpr long long LEADERBOARD_BENCH_ENTRIES = 10000000;
+
+/* entity component system: bytes in a chunk of an archetype's entities, entities and ticks a -ecsbench run
+   moves when no count is given */
+constexpr int ENTITY_CHUNK_BYTES = 16384;
+constexpr int ENTITY_BENCH_ENTITIES = 100000;
+constexpr int ENTITY_BENCH_TICKS = 600;
@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+
+/**
+*  Priority queue of the tick each mover next makes contact on.
+*  Every mover always has exactly one entry, so instead of pushing a new
+*  event and leaving the old one to be skipped, rescheduling a mover moves
+*  its entry up or down the heap in place. The heap is a few fixed arrays,
+*  so the queue copies with the simulation that owns it and never
+*  allocates.
+*/
+template <int Capacity>
+class ContactQueue
+{
+public:
+	static constexpr uint32_t NEVER = UINT32_MAX;
+
+	ContactQueue()
+	{
+		clear();
+	}
+
+	/**
+	*  Schedules nothing for any mover.
+	*/
+	void clear()
+	{
+		for (int i = 0; i < Capacity; i++)
+		{
+			heap[i] = (uint8_t)i;
+			position[i] = (uint8_t)i;
+			ticks[i] = NEVER;
+		}
+	}
+
+	/**
+	*  Replaces a mover's contact.
+	*  @param [in] mover 0 to Capacity - 1.
+	*  @param [in] tick When it makes contact, NEVER if it will not.
+	*/
+	void schedule(int mover, uint32_t tick)
+	{
+		uint32_t old = ticks[mover];
+		ticks[mover] = tick;
+		if (tick < old)
+		{
+			siftUp(position[mover]);
+		}
+		else
+		{
+			siftDown(position[mover]);
+		}
+	}
+
+	uint32_t tickOf(int mover) const
+	{
+		return ticks[mover];
+	}
+
+	/**
+	*  The soonest contact of any mover.
+	*/
+	uint32_t nextTick() const
+	{
+		return ticks[heap[0]];
+	}
+
+	int nextMover() const
+	{
+		return heap[0];
+	}
+
+private:
+	static_assert(Capacity > 0 && Capacity <= 256, "movers are numbered in a byte");
+
+	void place(int slot, uint8_t mover)
+	{
+		heap[slot] = mover;
+		position[mover] = (uint8_t)slot;
+	}
+
+	void siftUp(int slot)
+	{
+		uint8_t mover = heap[slot];
+		while (slot > 0)
+		{
+			int parent = (slot - 1) / 2;
+			if (ticks[heap[parent]] <= ticks[mover])
+			{
+				break;
+			}
+			place(slot, heap[parent]);
+			slot = parent;
+		}
+		place(slot, mover);
+	}
+
+	void siftDown(int slot)
+	{
+		uint8_t mover = heap[slot];
+		for (;;)
+		{
+			int child = slot * 2 + 1;
+			if (child >= Capacity)
+			{
+				break;
+			}
+			if (child + 1 < Capacity && ticks[heap[child + 1]] < ticks[heap[child]])
+			{
+				child++;
+			}
+			if (ticks[mover] <= ticks[heap[child]])
+			{
+				break;
+			}
+			place(slot, heap[child]);
+			slot = child;
+		}
+		place(slot, mover);
+	}
+
+	uint8_t heap[Capacity];      /**< Movers, soonest first at the root. */
+	uint8_t position[Capacity];  /**< Where each mover is in the heap. */
+	uint32_t ticks[Capacity];
+};
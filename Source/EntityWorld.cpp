@@ -0,0 +1,258 @@
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "EntityWorld.h"
+
+namespace
+{
+	constexpr size_t CACHE_LINE = 64;
+	constexpr size_t CHUNK_BYTES = ENTITY_CHUNK_BYTES;
+
+	const size_t COMPONENT_SIZES[COMPONENT_COUNT] =
+	{
+		sizeof(Transform), sizeof(Velocity), sizeof(Collider),
+		sizeof(Drawable), sizeof(Pickup), sizeof(Lifetime)
+	};
+
+	size_t alignUp(size_t value)
+	{
+		return (value + CACHE_LINE - 1) & ~(CACHE_LINE - 1);
+	}
+
+	/**
+	*   @brief   Lays out a chunk
+	*   @details The entity handles come first, then each component's
+				 array, every one starting on a cache line.
+	*   @return  The bytes used by capacity entities.
+	*/
+	size_t chunkLayout(uint32_t mask, size_t capacity, uint32_t* offsets)
+	{
+		size_t end = alignUp(capacity * sizeof(Entity));
+		for (int i = 0; i < COMPONENT_COUNT; i++)
+		{
+			offsets[i] = 0;
+			if (mask & (1u << i))
+			{
+				offsets[i] = (uint32_t)end;
+				end = alignUp(end + capacity * COMPONENT_SIZES[i]);
+			}
+		}
+		return end;
+	}
+
+	void construct(int component, void* at)
+	{
+		switch (component)
+		{
+		case ComponentId<Transform>::index:
+			new (at) Transform();
+			break;
+		case ComponentId<Velocity>::index:
+			new (at) Velocity();
+			break;
+		case ComponentId<Collider>::index:
+			new (at) Collider();
+			break;
+		case ComponentId<Drawable>::index:
+			new (at) Drawable();
+			break;
+		case ComponentId<Pickup>::index:
+			new (at) Pickup();
+			break;
+		case ComponentId<Lifetime>::index:
+			new (at) Lifetime();
+			break;
+		}
+	}
+}
+
+EntityWorld::~EntityWorld()
+{
+	clear();
+}
+
+/**
+*   @brief   Finds an archetype
+*   @details There are only ever a handful, so they are searched in
+			 order. A new one fits as many entities into a chunk as its
+			 component arrays allow.
+*   @return  The archetype's index.
+*/
+uint32_t EntityWorld::archetypeFor(uint32_t mask)
+{
+	for (size_t i = 0; i < archetypes.size(); i++)
+	{
+		if (archetypes[i].mask == mask)
+		{
+			return (uint32_t)i;
+		}
+	}
+
+	Archetype archetype;
+	archetype.mask = mask;
+	size_t row_bytes = sizeof(Entity);
+	for (int i = 0; i < COMPONENT_COUNT; i++)
+	{
+		row_bytes += mask & (1u << i) ? COMPONENT_SIZES[i] : 0;
+	}
+	size_t capacity = CHUNK_BYTES / row_bytes;
+	while (capacity > 1 && chunkLayout(mask, capacity, archetype.offsets) > CHUNK_BYTES)
+	{
+		capacity--;
+	}
+	chunkLayout(mask, capacity, archetype.offsets);
+	archetype.capacity = (uint32_t)capacity;
+	archetypes.push_back(archetype);
+	return (uint32_t)(archetypes.size() - 1);
+}
+
+Entity EntityWorld::create(uint32_t mask)
+{
+	uint32_t index = archetypeFor(mask);
+	Archetype& archetype = archetypes[index];
+	if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.capacity)
+	{
+		Chunk chunk;
+		chunk.allocation = std::malloc(CHUNK_BYTES + CACHE_LINE);
+		chunk.data = reinterpret_cast<uint8_t*>(
+			alignUp(reinterpret_cast<uintptr_t>(chunk.allocation)));
+		archetype.chunks.push_back(chunk);
+	}
+	Chunk& chunk = archetype.chunks.back();
+	uint32_t row = chunk.count++;
+
+	Entity entity;
+	if (free_slots.empty())
+	{
+		entity.index = (uint32_t)slots.size();
+		slots.emplace_back();
+	}
+	else
+	{
+		entity.index = free_slots.back();
+		free_slots.pop_back();
+	}
+	Slot& slot = slots[entity.index];
+	slot.archetype = index;
+	slot.chunk = (uint32_t)(archetype.chunks.size() - 1);
+	slot.row = row;
+	slot.alive = true;
+	entity.generation = slot.generation;
+
+	chunk.entities()[row] = entity;
+	for (int i = 0; i < COMPONENT_COUNT; i++)
+	{
+		if (mask & (1u << i))
+		{
+			construct(i, chunk.data + archetype.offsets[i] + row * COMPONENT_SIZES[i]);
+		}
+	}
+	alive++;
+	return entity;
+}
+
+/**
+*   @brief   Destroys an entity
+*   @details The archetype's last entity is moved into its row, keeping
+			 the chunks packed, and an emptied chunk is freed. The slot
+			 moves on a generation before it is reused.
+*   @return  void
+*/
+void EntityWorld::destroy(Entity entity)
+{
+	if (!isAlive(entity))
+	{
+		return;
+	}
+
+	Slot& slot = slots[entity.index];
+	Archetype& archetype = archetypes[slot.archetype];
+	Chunk& last = archetype.chunks.back();
+	uint32_t last_row = last.count - 1;
+	Chunk& chunk = archetype.chunks[slot.chunk];
+	if (&chunk != &last || slot.row != last_row)
+	{
+		Entity moved = last.entities()[last_row];
+		chunk.entities()[slot.row] = moved;
+		for (int i = 0; i < COMPONENT_COUNT; i++)
+		{
+			if (archetype.mask & (1u << i))
+			{
+				std::memcpy(chunk.data + archetype.offsets[i] + slot.row * COMPONENT_SIZES[i],
+					last.data + archetype.offsets[i] + last_row * COMPONENT_SIZES[i],
+					COMPONENT_SIZES[i]);
+			}
+		}
+		slots[moved.index].chunk = slot.chunk;
+		slots[moved.index].row = slot.row;
+	}
+
+	last.count--;
+	if (last.count == 0)
+	{
+		freeChunk(last);
+		archetype.chunks.pop_back();
+	}
+
+	slot.alive = false;
+	slot.generation++;
+	free_slots.push_back(entity.index);
+	alive--;
+}
+
+void EntityWorld::clear()
+{
+	for (Archetype& archetype : archetypes)
+	{
+		for (Chunk& chunk : archetype.chunks)
+		{
+			freeChunk(chunk);
+		}
+	}
+	archetypes.clear();
+
+	// keep the generations, so old handles stay dead
+	free_slots.clear();
+	for (size_t i = slots.size(); i > 0; i--)
+	{
+		slots[i - 1].alive = false;
+		slots[i - 1].generation++;
+		free_slots.push_back((uint32_t)(i - 1));
+	}
+	alive = 0;
+}
+
+void EntityWorld::freeChunk(Chunk& chunk)
+{
+	std::free(chunk.allocation);
+	chunk.allocation = nullptr;
+	chunk.data = nullptr;
+	chunk.count = 0;
+}
+
+bool EntityWorld::isAlive(Entity entity) const
+{
+	return entity.index < slots.size() && slots[entity.index].alive &&
+		slots[entity.index].generation == entity.generation;
+}
+
+size_t EntityWorld::size() const
+{
+	return alive;
+}
+
+int EntityWorld::getArchetypeCount() const
+{
+	return (int)archetypes.size();
+}
+
+size_t EntityWorld::memoryUsage() const
+{
+	size_t chunks = 0;
+	for (const Archetype& archetype : archetypes)
+	{
+		chunks += archetype.chunks.size();
+	}
+	return chunks * (CHUNK_BYTES + CACHE_LINE);
+}
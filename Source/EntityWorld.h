@@ -0,0 +1,362 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "Constants.h"
+
+namespace ASGE
+{
+	class Sprite;
+}
+
+/*! \file EntityWorld.h
+@brief   Archetype entity component system.
+@details Every entity with the same set of components belongs to one
+         archetype, whose entities are packed into fixed size chunks.
+         Inside a chunk each component has its own cache line aligned
+         array, so a system that reads two components walks two arrays
+         front to back and never touches the others. Components are
+         plain data and are moved with memcpy.
+*/
+
+/**
+*  Where an entity is and how big, in screen pixels.
+*/
+struct Transform
+{
+	float x = 0.f;
+	float y = 0.f;
+	float width = 0.f;
+	float height = 0.f;
+};
+
+/**
+*  A direction and the pixels a second travelled per unit of it, so the
+*  direction can be reflected or snapped to set angles without touching
+*  how fast the entity goes.
+*/
+struct Velocity
+{
+	float x = 0.f;
+	float y = 0.f;
+	float speed = 0.f;
+};
+
+enum class CollisionLayer : uint8_t
+{
+	PADDLE,
+	BALL,
+	BLOCK,
+	PICKUP,
+	LASER
+};
+
+/**
+*  Takes part in collisions; its box is the entity's Transform.
+*/
+struct Collider
+{
+	CollisionLayer layer = CollisionLayer::BLOCK;
+};
+
+/**
+*  Drawn as a sprite, which the game creates and frees.
+*/
+struct Drawable
+{
+	ASGE::Sprite* sprite = nullptr;  /**< nullptr while its texture is evicted. */
+	int texture = -1;                /**< Index into ASSETS, -1 for none. */
+	bool visible = true;
+};
+
+enum class PickupKind : uint8_t
+{
+	GEM,
+	POWER_UP
+};
+
+/**
+*  Caught with the paddle.
+*/
+struct Pickup
+{
+	PickupKind kind = PickupKind::GEM;
+	int score = 0;  /**< Added when caught. */
+};
+
+/**
+*  Seconds until the entity is destroyed.
+*/
+struct Lifetime
+{
+	float seconds = 0.f;
+};
+
+/**
+*  Component ids, which are also their bits in an archetype's mask.
+*/
+template <typename Component>
+struct ComponentId;
+
+template <>
+struct ComponentId<Transform>
+{
+	static constexpr int index = 0;
+	static constexpr uint32_t bit = 1u << index;
+};
+template <>
+struct ComponentId<Velocity>
+{
+	static constexpr int index = 1;
+	static constexpr uint32_t bit = 1u << index;
+};
+template <>
+struct ComponentId<Collider>
+{
+	static constexpr int index = 2;
+	static constexpr uint32_t bit = 1u << index;
+};
+template <>
+struct ComponentId<Drawable>
+{
+	static constexpr int index = 3;
+	static constexpr uint32_t bit = 1u << index;
+};
+template <>
+struct ComponentId<Pickup>
+{
+	static constexpr int index = 4;
+	static constexpr uint32_t bit = 1u << index;
+};
+template <>
+struct ComponentId<Lifetime>
+{
+	static constexpr int index = 5;
+	static constexpr uint32_t bit = 1u << index;
+};
+
+constexpr int COMPONENT_COUNT = 6;
+
+static_assert(std::is_trivially_copyable<Transform>::value && std::is_trivially_copyable<Velocity>::value &&
+	std::is_trivially_copyable<Collider>::value && std::is_trivially_copyable<Drawable>::value &&
+	std::is_trivially_copyable<Pickup>::value && std::is_trivially_copyable<Lifetime>::value,
+	"components are moved with memcpy");
+
+/**
+*  The mask of a set of components.
+*/
+template <typename... Components>
+constexpr uint32_t componentMask()
+{
+	uint32_t bits[] = { 0u, ComponentId<Components>::bit... };
+	uint32_t mask = 0;
+	for (uint32_t bit : bits)
+	{
+		mask |= bit;
+	}
+	return mask;
+}
+
+/**
+*  Handle to an entity. Handles to destroyed entities are recognised by
+*  their generation, so a stale one is never mistaken for whatever
+*  reused its slot.
+*/
+struct Entity
+{
+	uint32_t index = 0xffffffffu;
+	uint32_t generation = 0;
+};
+
+/**
+*  Entities and their components.
+*  Only the last chunk of an archetype is ever partly full: destroying an
+*  entity moves the archetype's last entity into the hole. Iteration is
+*  in archetype order, then chunk and row, so archetypes are visited in
+*  the order their first entity was created.
+*/
+class EntityWorld
+{
+public:
+	EntityWorld() = default;
+	~EntityWorld();
+
+	EntityWorld(const EntityWorld&) = delete;
+	EntityWorld& operator=(const EntityWorld&) = delete;
+
+	/**
+	*  Creates an entity with default valued components.
+	*  @param [in] mask Its components, from componentMask.
+	*/
+	Entity create(uint32_t mask);
+	void destroy(Entity entity);
+	void clear();
+
+	bool isAlive(Entity entity) const;
+	size_t size() const;
+
+	/**
+	*  One of an entity's components.
+	*  @return nullptr if the entity is dead or has no such component.
+	*          Valid until the next create or destroy.
+	*/
+	template <typename Component>
+	Component* find(Entity entity)
+	{
+		if (!isAlive(entity))
+		{
+			return nullptr;
+		}
+		const Slot& slot = slots[entity.index];
+		const Archetype& archetype = archetypes[slot.archetype];
+		if (!(archetype.mask & ComponentId<Component>::bit))
+		{
+			return nullptr;
+		}
+		return column<Component>(archetype, archetype.chunks[slot.chunk]) + slot.row;
+	}
+
+	/**
+	*  One of an entity's components, which it must have.
+	*/
+	template <typename Component>
+	Component& get(Entity entity)
+	{
+		return *find<Component>(entity);
+	}
+
+	/**
+	*  Calls function(Components&...) for every entity with at least
+	*  those components.
+	*/
+	template <typename... Components, typename Function>
+	void forEach(Function function)
+	{
+		forEachIn<Components...>(0, 0x7fffffff, function);
+	}
+
+	/**
+	*  As forEach, but only over some of the matching chunks, so a system
+	*  can be split across jobs a chunk range at a time.
+	*  @param [in] first_chunk The first, counting across every matching
+	*              archetype in order.
+	*  @param [in] end_chunk One past the last.
+	*/
+	template <typename... Components, typename Function>
+	void forEachIn(int first_chunk, int end_chunk, Function function)
+	{
+		const uint32_t required = componentMask<Components...>();
+		int index = 0;
+		for (Archetype& archetype : archetypes)
+		{
+			if ((archetype.mask & required) != required)
+			{
+				continue;
+			}
+			for (Chunk& chunk : archetype.chunks)
+			{
+				if (index >= end_chunk)
+				{
+					return;
+				}
+				if (index++ < first_chunk)
+				{
+					continue;
+				}
+				for (uint32_t row = 0; row < chunk.count; row++)
+				{
+					function(column<Components>(archetype, chunk)[row]...);
+				}
+			}
+		}
+	}
+
+	/**
+	*  As forEach, with the entity's handle first.
+	*/
+	template <typename... Components, typename Function>
+	void forEachEntity(Function function)
+	{
+		const uint32_t required = componentMask<Components...>();
+		for (Archetype& archetype : archetypes)
+		{
+			if ((archetype.mask & required) != required)
+			{
+				continue;
+			}
+			for (Chunk& chunk : archetype.chunks)
+			{
+				for (uint32_t row = 0; row < chunk.count; row++)
+				{
+					function(chunk.entities()[row], column<Components>(archetype, chunk)[row]...);
+				}
+			}
+		}
+	}
+
+	/**
+	*  Chunks holding entities with at least these components, for
+	*  forEachIn.
+	*/
+	template <typename... Components>
+	int countChunks() const
+	{
+		const uint32_t required = componentMask<Components...>();
+		size_t chunks = 0;
+		for (const Archetype& archetype : archetypes)
+		{
+			chunks += (archetype.mask & required) == required ? archetype.chunks.size() : 0;
+		}
+		return (int)chunks;
+	}
+
+	int getArchetypeCount() const;
+	size_t memoryUsage() const;  /**< Bytes held by chunks. */
+
+private:
+	struct Chunk
+	{
+		uint8_t* data = nullptr;    /**< ENTITY_CHUNK_BYTES, cache line aligned. */
+		void* allocation = nullptr;
+		uint32_t count = 0;
+
+		Entity* entities() const
+		{
+			return reinterpret_cast<Entity*>(data);
+		}
+	};
+
+	struct Archetype
+	{
+		uint32_t mask = 0;
+		uint32_t capacity = 0;              /**< Entities per chunk. */
+		uint32_t offsets[COMPONENT_COUNT];  /**< Each component's array in a chunk. */
+		std::vector<Chunk> chunks;
+	};
+
+	struct Slot
+	{
+		uint32_t archetype = 0;
+		uint32_t chunk = 0;
+		uint32_t row = 0;
+		uint32_t generation = 0;
+		bool alive = false;
+	};
+
+	template <typename Component>
+	static Component* column(const Archetype& archetype, const Chunk& chunk)
+	{
+		return reinterpret_cast<Component*>(chunk.data +
+			archetype.offsets[ComponentId<Component>::index]);
+	}
+
+	uint32_t archetypeFor(uint32_t mask);
+	static void freeChunk(Chunk& chunk);
+
+	std::vector<Archetype> archetypes;
+	std::vector<Slot> slots;
+	std::vector<uint32_t> free_slots;
+	size_t alive = 0;
+};
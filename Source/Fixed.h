@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+
+/*! \file Fixed.h
+@brief   16.16 fixed point numbers.
+@details Used by the simulation so that every platform, compiler and
+         optimisation level produces bit-identical results. Values are
+         plain integers: addition, subtraction and comparison need no
+         helpers, only multiplication and division do.
+*/
+
+using fixed = int32_t;
+
+constexpr int   FIXED_SHIFT = 16;
+constexpr fixed FIXED_ONE   = 1 << FIXED_SHIFT;
+constexpr fixed FIXED_HALF  = FIXED_ONE >> 1;
+
+/**
+*   @brief   Converts a whole number to fixed point.
+*/
+constexpr fixed toFixed(int value)
+{
+	return (fixed)(value * FIXED_ONE);
+}
+
+/**
+*   @brief   Converts the ratio num/den to fixed point.
+*   @details Lets constants such as 0.707 be written as (707, 1000)
+             without going through a float.
+*/
+constexpr fixed fixedRatio(int num, int den)
+{
+	return (fixed)((int64_t)num * FIXED_ONE / den);
+}
+
+/**
+*   @brief   Multiplies two fixed point numbers.
+*/
+constexpr fixed fixedMul(fixed a, fixed b)
+{
+	return (fixed)(((int64_t)a * b) >> FIXED_SHIFT);
+}
+
+/**
+*   @brief   Divides two fixed point numbers.
+*/
+constexpr fixed fixedDiv(fixed a, fixed b)
+{
+	return (fixed)((int64_t)a * FIXED_ONE / b);
+}
+
+/**
+*   @brief   Converts to float. Only for presentation, never feed it back.
+*/
+constexpr float fixedToFloat(fixed value)
+{
+	return value / (float)FIXED_ONE;
+}
@@ -0,0 +1,620 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <Engine/Sprite.h>
+
+#include "AssetBundle.h"
+#include "Assets.h"
+#include "Autopilot.h"
+#include "CampaignLevels.h"
+#include "Constants.h"
+#include "FrameCapture.h"
+#include "FramePacer.h"
+#include "Simulation.h"
+#include "SoftwareRenderer.h"
+
+namespace
+{
+	const char MAGIC[4] = { 'B', 'K', 'F', 'C' };
+	constexpr uint32_t VERSION = 1;
+
+	struct CaptureHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	struct RecordHeader
+	{
+		uint32_t frame;
+		uint32_t bytes;
+	};
+
+	static_assert(sizeof(CaptureHeader) == 16, "capture header is 16 bytes");
+	static_assert(sizeof(RecordHeader) == 8, "capture records start with 8 bytes");
+
+	inline uint32_t loadPixel(const uint8_t* pixels, size_t index)
+	{
+		uint32_t pixel;
+		std::memcpy(&pixel, pixels + index * 4, 4);
+		return pixel;
+	}
+
+	inline void appendCount(std::vector<uint8_t>& out, size_t count)
+	{
+		uint32_t value = (uint32_t)count;
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		out.insert(out.end(), bytes, bytes + 4);
+	}
+}
+
+FrameCapture::~FrameCapture()
+{
+	stop();
+}
+
+/**
+*   @brief   Starts capturing.
+*   @details Everything a frame needs is allocated here: the pool, the
+             queue, and room in each worker's scratch space for a frame
+             that compares with nothing, which is as large as one gets
+             but for noise.
+*   @return  false if the file could not be opened.
+*/
+bool FrameCapture::start(const std::string& path, int width, int height, int worker_count, int buffer_count)
+{
+	stop();
+
+	if (width <= 0 || height <= 0)
+	{
+		return false;
+	}
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (file.fail())
+	{
+		return false;
+	}
+	CaptureHeader header;
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.width = (uint32_t)width;
+	header.height = (uint32_t)height;
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	frame_width = width;
+	frame_height = height;
+	size_t frame_bytes = (size_t)width * height * 4;
+	buffer_count = buffer_count < 2 ? 2 : buffer_count;
+	worker_count = worker_count < 1 ? 1 : worker_count;
+
+	buffers.assign(buffer_count, std::vector<uint8_t>(frame_bytes));
+	holds.assign(buffer_count, 0);
+	free_buffers.clear();
+	for (int i = buffer_count - 1; i >= 0; i--)
+	{
+		free_buffers.push_back(i);
+	}
+	newest = -1;
+	queue.assign(buffer_count, Job());
+	queue_head = 0;
+	queue_count = 0;
+	next_sequence = 0;
+	next_write = 0;
+
+	scratch.assign(worker_count, Scratch());
+	for (Scratch& space : scratch)
+	{
+		space.runs.reserve(frame_bytes + 8);
+		space.compressed.reserve(frame_bytes + frame_bytes / 8 + 64);
+	}
+
+	submitted = 0;
+	written = 0;
+	dropped = 0;
+	failed = 0;
+	bytes_written = 0;
+
+	running.store(true, std::memory_order_release);
+	for (int i = 0; i < worker_count; i++)
+	{
+		workers.push_back(std::thread(&FrameCapture::run, this, i));
+	}
+	return true;
+}
+
+void FrameCapture::stop()
+{
+	if (workers.empty())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	workers.clear();
+	newest = -1;
+	file.close();
+}
+
+bool FrameCapture::isRunning() const
+{
+	return running.load(std::memory_order_relaxed);
+}
+
+/**
+*   @brief   Hands a frame to the workers.
+*   @details The lock is only held to take a buffer and to queue the
+             job, never while a worker encodes or writes, so the wait is
+             for a handful of instructions at most. The frame becomes the
+             newest, and the hold the last newest had passes to this
+             frame's job, which compares against it.
+*   @return  false if it was dropped.
+*/
+bool FrameCapture::submit(const Image& frame)
+{
+	if (!running.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	uint32_t number = (uint32_t)submitted.fetch_add(1, std::memory_order_relaxed);
+	if (frame.width != frame_width || frame.height != frame_height)
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	int buffer = -1;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!free_buffers.empty())
+		{
+			buffer = free_buffers.back();
+			free_buffers.pop_back();
+		}
+	}
+	if (buffer < 0)
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// the buffer is ours alone until it is queued
+	std::memcpy(buffers[buffer].data(), frame.pixels.data(), buffers[buffer].size());
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Job& job = queue[(queue_head + queue_count) % queue.size()];
+		job.buffer = buffer;
+		job.reference = newest;
+		job.frame = number;
+		job.sequence = next_sequence++;
+		queue_count++;
+		holds[buffer] = 2;
+		newest = buffer;
+	}
+	wake.notify_one();
+	return true;
+}
+
+uint64_t FrameCapture::getSubmittedCount() const
+{
+	return submitted.load(std::memory_order_relaxed);
+}
+
+uint64_t FrameCapture::getWrittenCount() const
+{
+	return written.load(std::memory_order_relaxed);
+}
+
+uint64_t FrameCapture::getDroppedCount() const
+{
+	return dropped.load(std::memory_order_relaxed);
+}
+
+uint64_t FrameCapture::getFailedCount() const
+{
+	return failed.load(std::memory_order_relaxed);
+}
+
+uint64_t FrameCapture::getBytesWritten() const
+{
+	return bytes_written.load(std::memory_order_relaxed);
+}
+
+/**
+*   @brief   A worker's loop
+*   @details Jobs are taken in the order they were queued, so the worker
+             with the oldest one never waits for its turn to write and
+             the others cannot wait on each other for ever. Stopping
+             lets the queue empty first.
+*   @return  void
+*/
+void FrameCapture::run(int worker)
+{
+	Scratch& space = scratch[worker];
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		wake.wait(lock, [this] { return queue_count > 0 || !running; });
+		if (queue_count == 0)
+		{
+			return;
+		}
+		Job job = queue[queue_head];
+		queue_head = (queue_head + 1) % queue.size();
+		queue_count--;
+		lock.unlock();
+
+		encode(job, space);
+
+		lock.lock();
+		turn.wait(lock, [this, &job] { return next_write == job.sequence; });
+		lock.unlock();
+
+		// only the worker whose turn it is touches the file
+		RecordHeader record;
+		record.frame = job.frame;
+		record.bytes = (uint32_t)space.compressed.size();
+		file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+		file.write(reinterpret_cast<const char*>(space.compressed.data()), space.compressed.size());
+		if (file.fail())
+		{
+			failed.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			written.fetch_add(1, std::memory_order_relaxed);
+			bytes_written.fetch_add(sizeof(record) + space.compressed.size(), std::memory_order_relaxed);
+		}
+
+		lock.lock();
+		next_write++;
+		release(job.buffer);
+		if (job.reference >= 0)
+		{
+			release(job.reference);
+		}
+		turn.notify_all();
+	}
+}
+
+/**
+*   @brief   Encodes a frame against its reference
+*   @details Gameplay mostly redraws what was there, so the runs of
+             unchanged pixels are long and the changed ones few; what is
+             left compresses well.
+*   @return  void
+*/
+void FrameCapture::encode(const Job& job, Scratch& space)
+{
+	const uint8_t* pixels = buffers[job.buffer].data();
+	const uint8_t* reference = job.reference >= 0 ? buffers[job.reference].data() : nullptr;
+	auto before = [reference](size_t i)
+	{
+		return reference ? loadPixel(reference, i) : 0u;
+	};
+
+	size_t count = (size_t)frame_width * frame_height;
+	space.runs.clear();
+	for (size_t i = 0; i < count; )
+	{
+		size_t same = i;
+		while (i < count && loadPixel(pixels, i) == before(i))
+		{
+			i++;
+		}
+		size_t changed = i;
+		while (i < count && loadPixel(pixels, i) != before(i))
+		{
+			i++;
+		}
+		appendCount(space.runs, changed - same);
+		appendCount(space.runs, i - changed);
+		space.runs.insert(space.runs.end(), pixels + changed * 4, pixels + i * 4);
+	}
+	deflateZlib(space.runs.data(), space.runs.size(), space.compressed, space.head);
+}
+
+void FrameCapture::release(int buffer)
+{
+	if (--holds[buffer] == 0)
+	{
+		free_buffers.push_back(buffer);
+	}
+}
+
+/**
+*   @brief   Turns a capture into a PNG sequence
+*   @details Every record is unpacked onto the frame before it, and
+             checked as it goes: a damaged record ends the export rather
+             than drawing garbage over the rest of the clip.
+*   @return  true if every frame was written.
+*/
+bool exportCapture(const std::string& path, const std::string& directory, CaptureExportReport& report,
+	std::string& error)
+{
+	report = CaptureExportReport();
+
+	std::ifstream in(path, std::ios::binary);
+	CaptureHeader header;
+	if (in.fail() || !in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+	{
+		error = "could not read " + path;
+		return false;
+	}
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+		header.width == 0 || header.height == 0 || header.width > 16384 || header.height > 16384)
+	{
+		error = path + " is not a capture";
+		return false;
+	}
+	report.width = (int)header.width;
+	report.height = (int)header.height;
+
+	Image image;
+	image.width = report.width;
+	image.height = report.height;
+	image.pixels.assign((size_t)image.width * image.height * 4, 0);
+	size_t count = (size_t)image.width * image.height;
+
+	std::vector<uint8_t> compressed;
+	std::vector<uint8_t> runs;
+	std::vector<uint8_t> png;
+	auto writeImage = [&]()
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "/frame_%06d.png", report.images);
+		encodePng(image, png);
+		std::ofstream out(directory + name, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(png.data()), png.size());
+		if (out.fail())
+		{
+			error = "could not write " + directory + name;
+			return false;
+		}
+		report.images++;
+		return true;
+	};
+
+	RecordHeader record;
+	while (in.read(reinterpret_cast<char*>(&record), sizeof(record)))
+	{
+		std::string where = path + " frame " + std::to_string(record.frame);
+		if (record.frame < (uint32_t)report.images)
+		{
+			error = where + " is out of order";
+			return false;
+		}
+		compressed.resize(record.bytes);
+		if (!in.read(reinterpret_cast<char*>(compressed.data()), compressed.size()))
+		{
+			error = where + " is cut short";
+			return false;
+		}
+		if (!inflateZlib(compressed.data(), compressed.size(), runs))
+		{
+			error = where + " is damaged";
+			return false;
+		}
+
+		while ((uint32_t)report.images < record.frame)
+		{
+			if (!writeImage())
+			{
+				return false;
+			}
+			report.filled++;
+		}
+
+		size_t pixel = 0;
+		size_t offset = 0;
+		while (offset + 8 <= runs.size())
+		{
+			uint32_t same, changed;
+			std::memcpy(&same, &runs[offset], 4);
+			std::memcpy(&changed, &runs[offset + 4], 4);
+			offset += 8;
+			if (same > count - pixel || changed > count - pixel - same ||
+				(size_t)changed * 4 > runs.size() - offset)
+			{
+				break;
+			}
+			pixel += same;
+			std::memcpy(&image.pixels[pixel * 4], &runs[offset], (size_t)changed * 4);
+			pixel += changed;
+			offset += (size_t)changed * 4;
+		}
+		if (pixel != count || offset != runs.size())
+		{
+			error = where + " does not cover the frame";
+			return false;
+		}
+
+		if (!writeImage())
+		{
+			return false;
+		}
+		report.records++;
+	}
+	return true;
+}
+
+/**
+*   @brief   Records the autopilot playing
+*   @details The playfield is laid out as layoutSprites lays it out and
+             the simulation's state drawn onto it the way syncSprites
+             maps it, two ticks a frame. A cleared level moves on to the
+             next campaign level and a lost game starts again.
+*   @return  The counts and timings.
+*/
+RecordReport recordGameplay(int frames, const std::string& path, JobSystem& jobs)
+{
+	using clock = std::chrono::steady_clock;
+
+	RecordReport report;
+	report.width = CAPTURE_WIDTH;
+	report.height = CAPTURE_HEIGHT;
+	report.frames = frames;
+	report.textures_loaded = true;
+
+	SoftwareRenderer renderer;
+	if (frames <= 0 || !renderer.init(CAPTURE_WIDTH, CAPTURE_HEIGHT, ASGE::Renderer::WindowMode::WINDOWED))
+	{
+		return report;
+	}
+	renderer.setClearColour(ASGE::COLOURS::BLACK);
+	renderer.setJobSystem(&jobs);
+
+	AssetBundle bundle;
+	bundle.open(ASSET_BUNDLE);
+	report.textures_loaded = renderer.loadAssets(bundle);
+
+	FrameCapture capture;
+	if (!capture.start(path, CAPTURE_WIDTH, CAPTURE_HEIGHT, CAPTURE_WORKERS, CAPTURE_BUFFERS))
+	{
+		return report;
+	}
+	renderer.setCapture(&capture);
+
+	std::map<std::string, std::unique_ptr<ASGE::Sprite>> sprites;
+	auto sprite = [&](const char* asset) -> ASGE::Sprite&
+	{
+		std::unique_ptr<ASGE::Sprite>& loaded = sprites[asset];
+		if (!loaded)
+		{
+			loaded = renderer.createUniqueSprite();
+			if (!loaded->loadTexture(assetPath(asset)))
+			{
+				report.textures_loaded = false;
+			}
+		}
+		return *loaded;
+	};
+
+	float area_h = CAPTURE_HEIGHT * GAMEPLAY_HEIGHT;
+	float area_w = area_h * 1.25f;
+	float area_x = (CAPTURE_WIDTH - area_w) * 0.5f;
+	float area_y = CAPTURE_HEIGHT * 0.09f;
+	float scale = area_h / PLAYFIELD_HEIGHT;
+	auto draw = [&](const char* asset, float x, float y, float width, float height)
+	{
+		ASGE::Sprite& shown = sprite(asset);
+		shown.xPos(x);
+		shown.yPos(y);
+		shown.width(width);
+		shown.height(height);
+		renderer.renderSprite(shown);
+	};
+	auto drawBody = [&](const char* asset, fixed x, fixed y, fixed width, fixed height)
+	{
+		draw(asset, area_x + fixedToFloat(x) * scale, area_y + fixedToFloat(y) * scale,
+			fixedToFloat(width) * scale, fixedToFloat(height) * scale);
+	};
+
+	Simulation simulation;
+	Autopilot autopilot;
+	int level = 0;
+	simulation.newGame(campaignLevel(level));
+	autopilot.reset(1);
+
+	FramePacer pacer;
+	pacer.setTargetRate(CAPTURE_FRAME_RATE);
+	clock::duration drawing = clock::duration::zero();
+	clock::duration submitting = clock::duration::zero();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		pacer.waitForNextFrame();
+		auto start = clock::now();
+
+		for (int tick = 0; tick < SIM_TICK_RATE / CAPTURE_FRAME_RATE; tick++)
+		{
+			SimStatus status = simulation.getState().status;
+			if (status == SimStatus::WON)
+			{
+				level++;
+				simulation.nextLevel(campaignLevel(level % CAMPAIGN_LEVELS));
+			}
+			else if (status == SimStatus::LOST)
+			{
+				level = 0;
+				simulation.newGame(campaignLevel(level));
+				autopilot.reset(frame + 1);
+			}
+			simulation.step(autopilot.think(simulation));
+		}
+
+		const SimState& state = simulation.getState();
+		renderer.preRender();
+		draw("background", area_x, area_y, area_w, area_h);
+		for (int i = 0; i < MAX_BLOCKS; i++)
+		{
+			if (state.block_visible[i])
+			{
+				drawBody(blockAsset(state.block_type[i]), simulation.blockX(i), simulation.blockY(i),
+					Simulation::BLOCK_WIDTH, Simulation::BLOCK_HEIGHT);
+			}
+		}
+		drawBody("paddle", state.paddle.x, state.paddle.y, Simulation::PADDLE_WIDTH, Simulation::PADDLE_HEIGHT);
+		drawBody("ball", state.ball.x, state.ball.y, Simulation::BALL_SIZE, Simulation::BALL_SIZE);
+		if (state.power_up_visible)
+		{
+			drawBody("power_up", state.power_up.x, state.power_up.y, Simulation::GEM_SIZE, Simulation::GEM_SIZE);
+		}
+		for (int i = 0; i < MAX_GEMS; i++)
+		{
+			if (state.gem_visible[i])
+			{
+				drawBody("gem", state.gems[i].x, state.gems[i].y, Simulation::GEM_SIZE, Simulation::GEM_SIZE);
+			}
+		}
+		for (int i = 0; i < MAX_LASERS; i++)
+		{
+			if (state.laser_visible[i])
+			{
+				drawBody("laser", state.lasers[i].x, state.lasers[i].y, Simulation::LASER_WIDTH,
+					Simulation::LASER_HEIGHT);
+			}
+		}
+		for (int i = 0; i < state.lives; i++)
+		{
+			draw("heart", area_x + i * CAPTURE_HEIGHT * 0.045f, CAPTURE_HEIGHT * 0.04f,
+				CAPTURE_HEIGHT * 0.04f, CAPTURE_HEIGHT * 0.04f);
+		}
+		renderer.renderText("Score: " + std::to_string(state.score), (int)(area_x + area_w * 0.75f),
+			(int)(CAPTURE_HEIGHT * 0.07f), CAPTURE_HEIGHT * 0.0012f, ASGE::COLOURS::WHITE);
+		renderer.postRender();
+
+		auto drawn = clock::now();
+		renderer.swapBuffers();
+		clock::duration handover = clock::now() - drawn;
+		drawing += drawn - start;
+		submitting += handover;
+		report.worst_submit_ms = std::max(report.worst_submit_ms,
+			std::chrono::duration<double, std::milli>(handover).count());
+	}
+
+	auto finish = clock::now();
+	capture.stop();
+	report.drain_ms = std::chrono::duration<double, std::milli>(clock::now() - finish).count();
+	report.frame_ms = std::chrono::duration<double, std::milli>(drawing).count() / frames;
+	report.submit_ms = std::chrono::duration<double, std::milli>(submitting).count() / frames;
+	report.submitted = capture.getSubmittedCount();
+	report.written = capture.getWrittenCount();
+	report.dropped = capture.getDroppedCount();
+	report.failed = capture.getFailedCount();
+	report.bytes = capture.getBytesWritten();
+	return report;
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Png.h"
+
+/*! \file FrameCapture.h
+@brief   Records frames to disk in the background.
+@details A capture file is a 16 byte header ("BKFC", version, width,
+         height) followed by a record per frame kept: its frame number,
+         the size of its data, then the data, a zlib stream. Frame
+         numbers count every frame offered, so the gaps show the frames
+         dropped. Unpacked, the data is a run of pairs: how many pixels
+         are the same as in the frame before, then how many are not,
+         each a 32 bit count, followed by those pixels. The first frame
+         is compared with black. All integers are little endian.
+*/
+
+/**
+*  Captures frames without holding up whoever draws them.
+*  Frames are copied into a fixed pool of buffers and queued; workers
+*  encode them against the frame before and append them to the file in
+*  order. Nothing is allocated per frame once the pool and the workers'
+*  scratch space have grown to size. If every buffer is taken because
+*  the workers have fallen behind, the frame is dropped and counted
+*  rather than waited for.
+*/
+class FrameCapture
+{
+public:
+	FrameCapture() = default;
+	~FrameCapture();
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	/**
+	*  Opens the file and starts the workers.
+	*  @param [in] path The file to write.
+	*  @param [in] width,height The size of every frame.
+	*  @param [in] worker_count Encoding threads.
+	*  @param [in] buffer_count Frames held at once, at least two.
+	*  @return false if the file could not be opened.
+	*/
+	bool start(const std::string& path, int width, int height, int worker_count, int buffer_count);
+
+	/**
+	*  Writes out every frame queued so far and stops the workers.
+	*/
+	void stop();
+
+	bool isRunning() const;
+
+	/**
+	*  Offers a frame. Copies it and returns without waiting on the
+	*  workers.
+	*  @param [in] frame Must be the size the capture was started with.
+	*  @return false if it was dropped.
+	*/
+	bool submit(const Image& frame);
+
+	uint64_t getSubmittedCount() const;
+	uint64_t getWrittenCount() const;
+	uint64_t getDroppedCount() const;
+	uint64_t getFailedCount() const;  /**< Frames that could not be written. */
+	uint64_t getBytesWritten() const;
+
+private:
+	/**
+	*  A frame waiting to be encoded. The reference is the frame it is
+	*  compared with, -1 for black.
+	*/
+	struct Job
+	{
+		int buffer;
+		int reference;
+		uint32_t frame;
+		uint64_t sequence;
+	};
+
+	/**
+	*  What a worker reuses from frame to frame.
+	*/
+	struct Scratch
+	{
+		std::vector<uint8_t> runs;
+		std::vector<uint8_t> compressed;
+		std::vector<int> head;
+	};
+
+	void run(int worker);
+	void encode(const Job& job, Scratch& scratch);
+	void release(int buffer);
+
+	int frame_width = 0;
+	int frame_height = 0;
+	std::ofstream file;
+
+	std::vector<std::vector<uint8_t>> buffers;
+	std::vector<int> holds;        /**< Per buffer, jobs and the newest frame still needing it. */
+	std::vector<int> free_buffers;
+	int newest = -1;               /**< Buffer of the last frame accepted. */
+
+	std::vector<Job> queue;        /**< A ring, as long as the pool so it can never overflow. */
+	size_t queue_head = 0;
+	size_t queue_count = 0;
+	uint64_t next_sequence = 0;    /**< Of the next frame accepted. */
+	uint64_t next_write = 0;       /**< Of the next frame due in the file. */
+
+	std::vector<std::thread> workers;
+	std::vector<Scratch> scratch;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable turn;
+	std::atomic<bool> running{ false };
+
+	std::atomic<uint64_t> submitted{ 0 };
+	std::atomic<uint64_t> written{ 0 };
+	std::atomic<uint64_t> dropped{ 0 };
+	std::atomic<uint64_t> failed{ 0 };
+	std::atomic<uint64_t> bytes_written{ 0 };
+};
+
+/**
+*  What an export found.
+*/
+struct CaptureExportReport
+{
+	int width = 0;
+	int height = 0;
+	int records = 0;  /**< Frames in the file. */
+	int images = 0;   /**< PNGs written, counting the dropped frames filled in. */
+	int filled = 0;
+};
+
+/**
+*   @brief   Turns a capture into a PNG sequence.
+*   @details Writes frame_000000.png onwards into the directory. A frame
+             that was dropped repeats the one before, so the sequence
+             plays back at the rate it was captured.
+*   @param   [in] path The capture.
+*   @param   [in] directory Where the images go; it must exist.
+*   @param   [out] report What was found.
+*   @param   [out] error Describes what went wrong on failure.
+*   @return  true if every frame was written.
+*/
+bool exportCapture(const std::string& path, const std::string& directory, CaptureExportReport& report,
+	std::string& error);
+
+/**
+*  Results of a recorded run.
+*/
+struct RecordReport
+{
+	int width = 0;
+	int height = 0;
+	int frames = 0;
+	uint64_t submitted = 0;
+	uint64_t written = 0;
+	uint64_t dropped = 0;
+	uint64_t failed = 0;
+	uint64_t bytes = 0;
+	double frame_ms = 0.0;      /**< Mean time to draw a frame. */
+	double submit_ms = 0.0;     /**< Mean time swapBuffers spent handing it over. */
+	double worst_submit_ms = 0.0;
+	double drain_ms = 0.0;      /**< Time to finish writing once the last frame was drawn. */
+	bool textures_loaded = false;
+};
+
+/**
+*   @brief   Records the autopilot playing.
+*   @details Runs the simulation headless, drawing it with the software
+             renderer at CAPTURE_WIDTH by CAPTURE_HEIGHT and capturing
+             every frame at CAPTURE_FRAME_RATE.
+*   @param   [in] frames Frames to draw.
+*   @param   [in] path The capture file to write.
+*   @param   [in] jobs Workers to share the renderer's tiles across.
+*   @return  The counts and timings.
+*/
+RecordReport recordGameplay(int frames, const std::string& path, JobSystem& jobs);
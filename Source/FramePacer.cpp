@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include "FramePacer.h"
+
+namespace
+{
+	// bounds for the adaptive spin window
+	constexpr std::chrono::microseconds MIN_SPIN(200);
+	constexpr std::chrono::microseconds MAX_SPIN(4000);
+}
+
+/**
+*   @brief   Constructor.
+*   @details Windows defaults to a ~15ms scheduler tick which makes short
+             sleeps useless for pacing, so a 1ms period is requested for
+             the lifetime of the pacer.
+*/
+FramePacer::FramePacer()
+	: spin_threshold(std::chrono::duration_cast<clock::duration>(MAX_SPIN))
+{
+#ifdef _WIN32
+	timeBeginPeriod(1);
+#endif
+}
+
+/**
+*   @brief   Destructor.
+*   @details Releases the timer resolution requested on construction.
+*/
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::setTargetRate(int frames_per_second)
+{
+	if (frames_per_second <= 0)
+	{
+		period = clock::duration::zero();
+	}
+	else
+	{
+		period = std::chrono::duration_cast<clock::duration>(
+			std::chrono::duration<double>(1.0 / frames_per_second));
+	}
+	started = false;
+}
+
+int FramePacer::getTargetRate() const
+{
+	if (period == clock::duration::zero())
+	{
+		return 0;
+	}
+	return (int)std::lround(1.0 / std::chrono::duration<double>(period).count());
+}
+
+/**
+*   @brief   Waits for the next frame deadline.
+*   @details Sleeps in chunks until the deadline is within the spin
+             threshold, learning from each wake-up how far the OS
+             overshot, then yields in a tight loop until the deadline.
+*   @return  void
+*/
+void FramePacer::waitForNextFrame()
+{
+	clock::time_point now = clock::now();
+
+	if (period != clock::duration::zero() && started)
+	{
+		if (now > next_deadline)
+		{
+			missed_deadlines++;
+			if (now - next_deadline > period)
+			{
+				next_deadline = now;
+			}
+		}
+		else
+		{
+			while (next_deadline - now > spin_threshold)
+			{
+				clock::duration requested = next_deadline - now - spin_threshold;
+				clock::time_point before = now;
+				std::this_thread::sleep_for(requested);
+				now = clock::now();
+				learnOversleep((now - before) - requested);
+			}
+			while (now < next_deadline)
+			{
+				std::this_thread::yield();
+				now = clock::now();
+			}
+		}
+	}
+
+	recordFrame(now);
+
+	if (!started)
+	{
+		next_deadline = now;
+		started = true;
+	}
+	next_deadline += period;
+}
+
+/**
+*   @brief   Adapts the spin threshold.
+*   @details Keeps a smoothed estimate of how late sleeps return and spins
+             for a little more than that, within fixed bounds.
+*   @return  void
+*/
+void FramePacer::learnOversleep(clock::duration overshoot)
+{
+	clock::duration target = std::max(overshoot, clock::duration::zero()) * 2;
+	spin_threshold = (spin_threshold * 7 + target) / 8;
+	spin_threshold = std::max<clock::duration>(spin_threshold, MIN_SPIN);
+	spin_threshold = std::min<clock::duration>(spin_threshold, MAX_SPIN);
+}
+
+void FramePacer::recordFrame(clock::time_point frame_start)
+{
+	if (last_frame_start != clock::time_point())
+	{
+		double frame_ms = std::chrono::duration<double, std::milli>(
+			frame_start - last_frame_start).count();
+
+		frame_count++;
+		double delta = frame_ms - mean_ms;
+		mean_ms += delta / frame_count;
+		m2_ms += delta * (frame_ms - mean_ms);
+	}
+	last_frame_start = frame_start;
+}
+
+void FramePacer::resetStats()
+{
+	frame_count = 0;
+	mean_ms = 0.0;
+	m2_ms = 0.0;
+	missed_deadlines = 0;
+}
+
+int FramePacer::getMissedDeadlines() const
+{
+	return missed_deadlines;
+}
+
+long long FramePacer::getFrameCount() const
+{
+	return frame_count;
+}
+
+double FramePacer::getMeanFrameTime() const
+{
+	return mean_ms;
+}
+
+double FramePacer::getFrameTimeVariance() const
+{
+	return frame_count > 1 ? m2_ms / (frame_count - 1) : 0.0;
+}
+
+double FramePacer::getFrameTimeStdDev() const
+{
+	return std::sqrt(getFrameTimeVariance());
+}
+
+double FramePacer::getSpinThreshold() const
+{
+	return std::chrono::duration<double, std::milli>(spin_threshold).count();
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <chrono>
+
+/**
+*  Paces the game loop to a target frame rate.
+*  ASGE's run loop spins as fast as the driver allows, so the pacer is
+*  called once at the start of every update and blocks until the next
+*  frame deadline. The bulk of the wait is spent asleep and only the last
+*  stretch is spun, which keeps jitter below a millisecond without burning
+*  a whole core. How long to spin adapts to how late the OS wakes us up.
+*/
+class FramePacer
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	/**
+	*  Default constructor.
+	*  Requests a 1ms system timer resolution where the platform needs it.
+	*/
+	FramePacer();
+
+	/**
+	*  Destructor. Restores the system timer resolution.
+	*/
+	~FramePacer();
+
+	/**
+	*  Sets the target frame rate.
+	*  @param [in] frames_per_second The rate to pace to. 0 disables pacing.
+	*/
+	void setTargetRate(int frames_per_second);
+
+	/**
+	*  Returns the target frame rate.
+	*  @return The rate being paced to, 0 if uncapped.
+	*/
+	int getTargetRate() const;
+
+	/**
+	*  Blocks until the next frame is due.
+	*  Sleeps while the deadline is comfortably far away and spins for the
+	*  remainder. A frame that starts after its deadline is counted as
+	*  missed; if it is more than a whole period late the schedule is
+	*  re-synced rather than rushing several frames to catch up.
+	*/
+	void waitForNextFrame();
+
+	/**
+	*  Clears the frame time statistics and missed deadline count.
+	*/
+	void resetStats();
+
+	int getMissedDeadlines() const;
+	long long getFrameCount() const;
+
+	/**
+	*  Mean time between frame starts.
+	*  @return The mean frame time in milliseconds.
+	*/
+	double getMeanFrameTime() const;
+
+	/**
+	*  Variance of the time between frame starts.
+	*  @return The frame time variance in milliseconds squared.
+	*/
+	double getFrameTimeVariance() const;
+
+	/**
+	*  Standard deviation of the time between frame starts.
+	*  @return The frame time jitter in milliseconds.
+	*/
+	double getFrameTimeStdDev() const;
+
+	/**
+	*  How close to the deadline the pacer stops sleeping and starts spinning.
+	*  @return The current spin threshold in milliseconds.
+	*/
+	double getSpinThreshold() const;
+
+private:
+	void recordFrame(clock::time_point frame_start);
+	void learnOversleep(clock::duration overshoot);
+
+	clock::duration period = clock::duration::zero();
+	clock::duration spin_threshold;
+	clock::time_point next_deadline;
+	clock::time_point last_frame_start;
+	bool started = false;
+
+	// running frame time statistics (Welford's method)
+	long long frame_count = 0;
+	double mean_ms = 0.0;
+	double m2_ms = 0.0;
+	int missed_deadlines = 0;
+};
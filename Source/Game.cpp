@@ -1,3 +1,4 @@
+#include <ctime>
 #include <string>
 #include <Windows.h>
 
@@ -5,7 +6,9 @@
 #include <Engine/Input.h>
 #include <Engine/InputEvents.h>
 #include <Engine/Sprite.h>
+#include <Engine/Texture.h>
 
+#include "CampaignLevels.h"
 #include "Game.h"
 
 /**
@@ -14,7 +17,9 @@
              and even seeding the random number generator.
 */
 BreakoutGame::BreakoutGame()
+	: startup_time(FramePacer::clock::now())
 {
+	sprite_cache.setBudget((size_t)SPRITE_BUDGET_KB * 1024);
 }
 
 /**
@@ -23,35 +28,32 @@ BreakoutGame::BreakoutGame()
 */
 BreakoutGame::~BreakoutGame()
 {
+	// the simulation thread publishes to the spectator server and logs
+	// to telemetry, so it has to stop before either goes
+	sim_thread.stop();
+	audio.stop();
+	logLatency();
+
 	this->inputs->unregisterCallback(key_callback_id);
 	this->inputs->unregisterCallback(mouse_callback_id);
+	this->inputs->unregisterCallback(move_callback_id);
 
-	gameplay_area.spriteComponent()->freeSprite();
-	paddle.spriteComponent()->freeSprite();
-	ball.spriteComponent()->freeSprite();
-	power_up.spriteComponent()->freeSprite();
-	heart.spriteComponent()->freeSprite();
-
-	for (int i = 0; i < MAX_BLOCKS; i++)
-	{
-			blocks[i].spriteComponent()->freeSprite();
-	}
-	for (int i = 0; i < MAX_GEMS; i++)
+	// some sprites may never have been loaded if the game is closed
+	// while it is still starting up
+	asset_loader.stop();
+	world.forEach<Drawable>([](Drawable& drawable)
 	{
-		gems[i].spriteComponent()->freeSprite();
-	}
-	for (int i = 0; i < MAX_LASERS; i++)
-	{
-		lasers[i].spriteComponent()->freeSprite();
-	}
-
+		delete drawable.sprite;
+		drawable.sprite = nullptr;
+	});
 }
 
 /**
 *   @brief   Initialises the game.
-*   @details The game window is created and all assets required to
-			 run the game are loaded. The keyHandler and clickHandler
-			 callback should also be set in the initialise function.
+*   @details The game window is created and the assets required to
+			 run the game are queued to load in the background. The
+			 keyHandler and clickHandler callback should also be set in
+			 the initialise function.
 *   @return  True if the game initialised correctly.
 */
 bool BreakoutGame::init()
@@ -62,6 +64,13 @@ bool BreakoutGame::init()
 		return false;
 	}
 	renderer->setWindowTitle("Breakout!");
+	frame_pacer.setTargetRate(TARGET_FRAME_RATE);
+	jobs.start(-1);
+	if (!audio.start(createDeviceOutput()))
+	{
+		// no sound card: keep mixing in real time so the stats still mean something
+		audio.start(std::unique_ptr<AudioOutput>(new NullAudioOutput(true)));
+	}
 
 	// input handling functions
 	inputs->use_threads = false;
@@ -72,131 +81,447 @@ bool BreakoutGame::init()
 	mouse_callback_id =inputs->addCallbackFnc(
 		ASGE::E_MOUSE_CLICK, &BreakoutGame::clickHandler, this);
 
-	clearArrays();
+	move_callback_id = inputs->addCallbackFnc(
+		ASGE::E_MOUSE_MOVE, &BreakoutGame::moveHandler, this);
+
+	// with no atlas packed every texture loads from its own file; the
+	// bundle is left to the tools that decode their own textures, as the
+	// engine's loader can only open files
+	atlas.load(RESOURCE_DIR);
+
+	// a page is one texture to the engine however many it holds, so the
+	// textures on it are counted once and released together
+	for (int i = 0; i < NUM_ASSETS; i++)
+	{
+		AtlasRegion region;
+		AtlasRegion first;
+		for (int owner = 0; owner < i && atlas.find(ASSETS[i].name, region); owner++)
+		{
+			if (atlas.find(ASSETS[owner].name, first) && first.page == region.page)
+			{
+				sprite_cache.shareFile(i, owner);
+				break;
+			}
+		}
+	}
+
+	// block positions come from the layout, only their state is stepped
+	// on the simulation thread or streamed
+	simulation.newGame();
+	if (!spectating)
+	{
+		if (SPECTATOR_PORT)
+		{
+			spectator_server.start(SPECTATOR_PORT);
+		}
+
+		// a log that cannot be opened just leaves telemetry off
+		telemetry.start("Telemetry");
+		sim_thread.start(&telemetry, &spectator_server);
+	}
+
 	loadFiles();
+	createEntities();
+
+	// textures stream in from here on; the menu is usable meanwhile
+	queueSpriteLoad(gameplay_area, "background");
+	queueSpriteLoad(ball, "ball");
+	queueSpriteLoad(paddle, "paddle");
+	queueSpriteLoad(heart, "heart");
+	const LevelLayout& classic = campaignLevel(0);
+	for (int i = 0; i < MAX_BLOCKS; i++)
+	{
+		block_types_shown[i] = classic.types[i];
+		queueSpriteLoad(blocks[i], blockAsset(classic.types[i]));
+	}
+	for (int i = 0; i < MAX_GEMS; i++)
+	{
+		queueSpriteLoad(gems[i], "gem");
+	}
+	queueSpriteLoad(power_up, "power_up");
+	for (int i = 0; i < MAX_LASERS; i++)
+	{
+		queueSpriteLoad(lasers[i], "laser");
+	}
+	asset_loader.start(0);
+
+	return true;
+}
 
-	if (!gameplay_area.addSpriteComponent(renderer.get(),
-		".\\Resources\\Textures\\puzzlepack\\png\\background.png"))
+/**
+*   @brief   Creates the game's entities
+*   @details Archetypes are drawn in the order their first entity was
+			 created, so the background comes first. Pickups and lasers
+			 start hidden until they are released.
+*   @return  void
+*/
+void BreakoutGame::createEntities()
+{
+	gameplay_area = world.create(componentMask<Transform, Drawable>());
+	heart = world.create(componentMask<Transform, Drawable>());
+
+	const uint32_t moving = componentMask<Transform, Velocity, Collider, Drawable>();
+	paddle = world.create(moving);
+	world.get<Collider>(paddle).layer = CollisionLayer::PADDLE;
+	ball = world.create(moving);
+	world.get<Collider>(ball).layer = CollisionLayer::BALL;
+	for (int i = 0; i < MAX_LASERS; i++)
 	{
-		return false;
+		lasers[i] = world.create(moving);
+		world.get<Collider>(lasers[i]).layer = CollisionLayer::LASER;
+		world.get<Drawable>(lasers[i]).visible = false;
 	}
-	if (!ball.addSpriteComponent(renderer.get(),
-		".\\Resources\\Textures\\puzzlepack\\png\\ballBlue.png"))
+
+	for (int i = 0; i < MAX_BLOCKS; i++)
 	{
-		return false;
+		blocks[i] = world.create(componentMask<Transform, Collider, Drawable>());
 	}
-	if (!paddle.addSpriteComponent(renderer.get(),
-		".\\Resources\\Textures\\puzzlepack\\png\\paddleBlue.png"))
+
+	const uint32_t pickup = componentMask<Transform, Velocity, Collider, Drawable, Pickup>();
+	for (int i = 0; i < MAX_GEMS; i++)
+	{
+		gems[i] = world.create(pickup);
+		world.get<Collider>(gems[i]).layer = CollisionLayer::PICKUP;
+		world.get<Drawable>(gems[i]).visible = false;
+		world.get<Pickup>(gems[i]).score = 100;
+	}
+	power_up = world.create(pickup);
+	world.get<Collider>(power_up).layer = CollisionLayer::PICKUP;
+	world.get<Drawable>(power_up).visible = false;
+	world.get<Pickup>(power_up).kind = PickupKind::POWER_UP;
+}
+
+/**
+*   @brief   Loads an entity's sprite
+*   @details Textures are asked for by their logical name in the asset
+			 manifest rather than by path, and are counted against the
+			 texture budget once loaded.
+*   @param   entity The entity to give a sprite.
+*   @param   asset The texture's logical name.
+*   @return  True if the texture loaded.
+*/
+bool BreakoutGame::loadSprite(Entity entity, const char* asset)
+{
+	ASGE::Sprite* sprite = renderer->createRawSprite();
+	size_t bytes = 0;
+	if (!bindTexture(sprite, -1, asset, bytes))
 	{
+		delete sprite;
 		return false;
 	}
-	if (!heart.addSpriteComponent(renderer.get(),
-		".\\Resources\\Textures\\puzzlepack\\png\\heart.png"))
+	Drawable& drawable = world.get<Drawable>(entity);
+	delete drawable.sprite;
+	drawable.sprite = sprite;
+	drawable.texture = (int)(findAsset(asset) - ASSETS);
+	sprite_cache.loaded(drawable.texture, bytes);
+	return true;
+}
+
+/**
+*   @brief   Points a sprite at a texture
+*   @details A texture in the atlas is a rectangle of one of its pages:
+			 the sprite shows the page, cut down to the rectangle, so
+			 everything on a page draws from the same texture. Moving to
+			 another rectangle of the page the sprite already shows only
+			 changes the rectangle. Anything the atlas does not hold is
+			 loaded from its own file.
+*   @param   sprite The sprite.
+*   @param   shown Index into ASSETS of what it shows now, -1 for none.
+*   @param   asset The texture's logical name.
+*   @param   bytes Receives the size of the texture the sprite shows,
+			 the whole page for one in the atlas.
+*   @return  True if the texture loaded.
+*/
+bool BreakoutGame::bindTexture(ASGE::Sprite* sprite, int shown, const char* asset, size_t& bytes)
+{
+	AtlasRegion region;
+	if (!atlas.find(asset, region))
+	{
+		std::string path = assetPath(asset);
+		if (path.empty() || !sprite->loadTexture(path))
+		{
+			return false;
+		}
+		bytes = textureBytes(sprite);
+		return true;
+	}
+
+	AtlasRegion current;
+	bool same_page = shown >= 0 && sprite->getTexture() &&
+		atlas.find(ASSETS[shown].name, current) && current.page == region.page;
+	if (!same_page && !sprite->loadTexture(atlas.getPagePath(region.page)))
 	{
 		return false;
 	}
 
-	ASGE::Sprite* background_sprite = gameplay_area.spriteComponent()->getSprite();
-	background_sprite->height(game_height * GAMEPLAY_HEIGHT);
-	background_sprite->width(background_sprite->height() * 1.25f);
-	background_sprite->yPos(game_height * .09f);
-	background_sprite->xPos((game_width - background_sprite->width()) * 0.5f);
+	float* source = sprite->srcRect();
+	source[0] = (float)region.x;
+	source[1] = (float)region.y;
+	source[2] = (float)region.width;
+	source[3] = (float)region.height;
+	bytes = textureBytes(sprite);
+	return true;
+}
 
+size_t BreakoutGame::textureBytes(const ASGE::Sprite* sprite)
+{
+	// the format is the texture's channels, a byte each
+	const ASGE::Texture2D* texture = sprite->getTexture();
+	return texture ? (size_t)texture->getWidth() * texture->getHeight() * texture->getFormat() : 0;
+}
 
-	ASGE::Sprite* paddle_sprite = paddle.spriteComponent()->getSprite();
-	paddle_sprite->height(background_sprite->height() * .03f);
-	paddle_sprite->width(background_sprite->height() * .15f);
-	paddle_sprite->yPos(background_sprite->yPos() + background_sprite->height()
-		- paddle_sprite->height());
-	paddle_sprite->xPos(background_sprite->xPos() + (background_sprite->width()
-		* 0.5f) - (paddle_sprite->width() * 0.5f));
+void BreakoutGame::queueSpriteLoad(Entity entity, const char* asset)
+{
+	SpriteLoad load;
+	load.entity = entity;
+	load.asset = (int)(findAsset(asset) - ASSETS);
+	sprite_loads.push_back(load);
+}
 
-	ASGE::Sprite* ball_sprite = ball.spriteComponent()->getSprite();
-	ball_sprite->height(background_sprite->height() * .03f);
-	ball_sprite->width(background_sprite->height() * .03f);
-	ball_sprite->yPos(background_sprite->yPos() + background_sprite->height()
-		- (paddle_sprite->height() + ball_sprite->height()) );
-	ball_sprite->xPos(background_sprite->xPos() + (background_sprite->width() 
-		* 0.5f) - (ball_sprite->width() * 0.5f));
+/**
+*   @brief   Uploads fetched textures
+*   @details Loads the sprites whose files the workers have read, until
+			 this frame's ASSET_UPLOAD_BUDGET_MS is used up. Once every
+			 sprite is loaded they are laid out and the game becomes
+			 playable. A texture that fails to load quits the game, as
+			 it always has.
+*   @return  void
+*/
+void BreakoutGame::uploadAssets()
+{
+	auto deadline = FramePacer::clock::now() +
+		std::chrono::milliseconds(ASSET_UPLOAD_BUDGET_MS);
 
+	for (SpriteLoad& load : sprite_loads)
+	{
+		if (load.loaded || !asset_loader.isFetched(load.asset))
+		{
+			continue;
+		}
+		if (asset_loader.hasFailed(load.asset) ||
+			!loadSprite(load.entity, ASSETS[load.asset].name))
+		{
+			signalExit();
+			return;
+		}
+		load.loaded = true;
+		sprites_loaded++;
 
-	ASGE::Sprite* heart_sprite = heart.spriteComponent()->getSprite();
-	heart_sprite->height(game_height * 0.04f);
-	heart_sprite->width(game_height * 0.04f);
-	heart_sprite->yPos(game_height * 0.05f);
-	heart_sprite->xPos(background_sprite->xPos());
+		if (FramePacer::clock::now() >= deadline)
+		{
+			break;
+		}
+	}
 
+	if (sprites_loaded == (int)sprite_loads.size())
+	{
+		asset_loader.stop();
+		layoutSprites();
+		assets_resident = true;
+		interactive_ms = std::chrono::duration<double, std::milli>(
+			FramePacer::clock::now() - startup_time).count();
+	}
+}
 
-	for (int i = 0; i < MAX_BLOCKS; i++)
+/**
+*   @brief   Keeps textures within their budget
+*   @details Has the loader prefetch whatever was drawn while evicted,
+			 gives a sprite back to everything showing a texture once
+			 its file has been read again, then evicts down to the
+			 budget by releasing every sprite that shows a victim. An
+			 atlas page is not in the manifest for the loader to read,
+			 and the engine still holds it, so its sprites come back
+			 straight away. Sprites are loaded on this thread, so like
+			 uploadAssets it stops for the frame once
+			 ASSET_UPLOAD_BUDGET_MS is spent. Runs once every sprite
+			 has been loaded the first time.
+*   @return  void
+*/
+void BreakoutGame::manageTextures()
+{
+	AtlasRegion region;
+	sprite_cache.takeReloads(texture_reloads);
+	for (int asset : texture_reloads)
 	{
-		if (i == 32 || i == 42 || i == 80 || i == 84 || i == 106 || i == 118)
+		if (!atlas.find(ASSETS[asset].name, region))
 		{
-			if (!blocks[i].addSpriteComponent(renderer.get(),
-				".\\Resources\\Textures\\puzzlepack\\png\\element_purple_rectangle.png"))
-			{
-				return false;
-			}
+			asset_loader.fetch(asset);
+		}
+	}
 
+	auto deadline = FramePacer::clock::now() +
+		std::chrono::milliseconds(ASSET_UPLOAD_BUDGET_MS);
+	bool failed = false;
+	bool out_of_time = false;
+	world.forEachEntity<Drawable>([&](Entity entity, Drawable& drawable)
+	{
+		int asset = drawable.texture;
+		if (drawable.sprite || asset < 0 || failed || out_of_time)
+		{
+			return;
 		}
-		else if (i % 2 == 0)
+		int file = sprite_cache.fileOf(asset);
+		bool paged = atlas.find(ASSETS[asset].name, region);
+		bool ready = sprite_cache.isHeld(asset) ||
+			(sprite_cache.isReloading(asset) && (paged || asset_loader.isFetched(file)));
+		if (!ready)
 		{
-			if (!blocks[i].addSpriteComponent(renderer.get(),
-				".\\Resources\\Textures\\puzzlepack\\png\\element_red_rectangle.png"))
-			{
-				return false;
-			}
-
+			return;
 		}
-		else
+		if ((!paged && asset_loader.hasFailed(file)) || !loadSprite(entity, ASSETS[asset].name))
 		{
-			if (!blocks[i].addSpriteComponent(renderer.get(),
-				".\\Resources\\Textures\\puzzlepack\\png\\element_blue_rectangle.png"))
+			failed = true;
+		}
+		out_of_time = FramePacer::clock::now() >= deadline;
+	});
+	if (failed)
+	{
+		// as at startup, a texture that will not load ends the game
+		signalExit();
+		return;
+	}
+
+	if (sprite_cache.evict(texture_victims) == 0)
+	{
+		return;
+	}
+	world.forEach<Drawable>([this](Drawable& drawable)
+	{
+		for (int asset : texture_victims)
+		{
+			if (drawable.texture == asset)
 			{
-				return false;
+				delete drawable.sprite;
+				drawable.sprite = nullptr;
 			}
 		}
-		ASGE::Sprite* block = blocks[i].spriteComponent()->getSprite();
-		block->height((game_height * GAMEPLAY_HEIGHT) * .035f);
-		block->width((((game_height * GAMEPLAY_HEIGHT) * 1.25f)) * .066f);
+	});
+}
+
+/**
+*   @brief   Logs startup times
+*   @details Appends time to first frame and time to interactive, both
+			 from the game being created, to Startup.log so that startup
+			 regressions show up across runs.
+*   @return  void
+*/
+void BreakoutGame::logStartupTimes()
+{
+	std::ofstream outFile;
+	outFile.open("Startup.log", std::ios::app);
+	if (!outFile.fail())
+	{
+		outFile << "first frame: " << (int)first_frame_ms << " ms  interactive: " <<
+			(int)interactive_ms << " ms  sprites: " << sprite_loads.size() << std::endl;
+		outFile.close();
 	}
+}
 
-	for (int i = 0; i < MAX_GEMS; i++)
+/**
+*   @brief   Logs input latency
+*   @details Appends the session's event to sim and sim to present
+			 histograms to Latency.log, so changes aimed at latency can
+			 be compared across runs.
+*   @return  void
+*/
+void BreakoutGame::logLatency()
+{
+	if (input_latency.getEventToSim().getCount() == 0)
 	{
-		if (!gems[i].addSpriteComponent(renderer.get(),
-			".\\Resources\\Textures\\puzzlepack\\png\\element_grey_polygon.png"))
-		{
-			return false;
-		}	
-		gems[i].setVisible(false);
-		ASGE::Sprite* gem = gems[i].spriteComponent()->getSprite();
-		gem->height((game_height * GAMEPLAY_HEIGHT) * .035f);
-		gem->width((game_height * GAMEPLAY_HEIGHT) * .035f);
+		return;
 	}
 
-	if (!power_up.addSpriteComponent(renderer.get(),
-		".\\Resources\\Textures\\puzzlepack\\png\\element_purple_polygon.png"))
+	std::ofstream outFile;
+	outFile.open("Latency.log", std::ios::app);
+	if (!outFile.fail())
 	{
-		return false;
+		outFile << "input to sim: ";
+		input_latency.getEventToSim().write(outFile);
+		outFile << "sim to present: ";
+		input_latency.getSimToPresent().write(outFile);
+		outFile.close();
 	}
-	power_up.setVisible(false);
-	ASGE::Sprite* power_up_sprite = power_up.spriteComponent()->getSprite();
-	power_up_sprite->height((game_height * GAMEPLAY_HEIGHT) * .035f);
-	power_up_sprite->width((game_height * GAMEPLAY_HEIGHT) * .035f);
+}
+
+/**
+*   @brief   Sizes and places the entities
+*   @details Called once every texture has loaded. The sprites are
+			 sized and moved to match as they are drawn.
+*   @return  void
+*/
+void BreakoutGame::layoutSprites()
+{
+	Transform& background = world.get<Transform>(gameplay_area);
+	background.height = game_height * GAMEPLAY_HEIGHT;
+	background.width = background.height * 1.25f;
+	background.y = game_height * .09f;
+	background.x = (game_width - background.width) * 0.5f;
+	input_state.setPlayfield(background.x, background.height / PLAYFIELD_HEIGHT);
+
+	Transform& paddle_transform = world.get<Transform>(paddle);
+	paddle_transform.height = background.height * .03f;
+	paddle_transform.width = background.height * .15f;
+	paddle_transform.y = background.y + background.height - paddle_transform.height;
+	paddle_transform.x = background.x + (background.width * 0.5f) - (paddle_transform.width * 0.5f);
+	world.get<Velocity>(paddle).speed = game_height * 0.45f;
+
+	Transform& ball_transform = world.get<Transform>(ball);
+	ball_transform.height = background.height * .03f;
+	ball_transform.width = background.height * .03f;
+	ball_transform.y = background.y + background.height -
+		(paddle_transform.height + ball_transform.height);
+	ball_transform.x = background.x + (background.width * 0.5f) - (ball_transform.width * 0.5f);
+	world.get<Velocity>(ball).speed = game_height * 0.5f * game_speed;
+
+	Transform& heart_transform = world.get<Transform>(heart);
+	heart_transform.height = game_height * 0.04f;
+	heart_transform.width = game_height * 0.04f;
+	heart_transform.y = game_height * 0.05f;
+	heart_transform.x = background.x;
+
+	for (int i = 0; i < MAX_BLOCKS; i++)
+	{
+		Transform& block = world.get<Transform>(blocks[i]);
+		block.height = (game_height * GAMEPLAY_HEIGHT) * .035f;
+		block.width = ((game_height * GAMEPLAY_HEIGHT) * 1.25f) * .066f;
+	}
+
+	for (int i = 0; i < MAX_GEMS; i++)
+	{
+		Transform& gem = world.get<Transform>(gems[i]);
+		gem.height = (game_height * GAMEPLAY_HEIGHT) * .035f;
+		gem.width = (game_height * GAMEPLAY_HEIGHT) * .035f;
+		world.get<Velocity>(gems[i]).speed = game_height * 0.45f;
+	}
+
+	Transform& power_up_transform = world.get<Transform>(power_up);
+	power_up_transform.height = (game_height * GAMEPLAY_HEIGHT) * .035f;
+	power_up_transform.width = (game_height * GAMEPLAY_HEIGHT) * .035f;
+	world.get<Velocity>(power_up).speed = game_height * 0.45f;
 
 	for (int i = 0; i < MAX_LASERS; i++)
 	{
-		if (!lasers[i].addSpriteComponent(renderer.get(),
-			".\\Resources\\Textures\\puzzlepack\\png\\element_red_square.png"))
-		{
-			return false;
-		}
-		lasers[i].setVisible(false);
-		ASGE::Sprite* laser = lasers[i].spriteComponent()->getSprite();
-		laser->height((game_height * GAMEPLAY_HEIGHT) * .035f);
-		laser->width((game_height * GAMEPLAY_HEIGHT) * .01f);
+		Transform& laser = world.get<Transform>(lasers[i]);
+		laser.height = (game_height * GAMEPLAY_HEIGHT) * .035f;
+		laser.width = (game_height * GAMEPLAY_HEIGHT) * .01f;
+		world.get<Velocity>(lasers[i]).speed = game_height * 0.45f;
 	}
+}
 
-	return true;
+/**
+*   @brief   Spectator mode
+*   @details Turns this instance into a viewer of another game's
+			 spectator stream. Must be called before init.
+*   @return  void
+*/
+void BreakoutGame::spectate()
+{
+	spectating = true;
+}
+
+void BreakoutGame::setSpriteBudget(size_t bytes)
+{
+	sprite_cache.setBudget(bytes);
 }
 
 /**
@@ -238,21 +563,51 @@ void BreakoutGame::keyHandler(const ASGE::SharedEventData data)
 		signalExit();
 	}
 
-	if (key->key == ASGE::KEYS::KEY_SPACE &&
-		key->action == ASGE::KEYS::KEY_PRESSED
-		&& game_state == 1 && power_up_bool == true
-		&& power_up_shots < MAX_LASERS)
+	if (key->key == ASGE::KEYS::KEY_GRAVE_ACCENT &&
+		key->action == ASGE::KEYS::KEY_RELEASED)
+	{
+		show_frame_stats = !show_frame_stats;
+	}
+
+	// paddle and fire keys are only recorded here and read once a frame
+	input_state.keyEvent(key->key, key->action);
+
+	// gameplay keys wait for the sprites they move
+	if (spectating || (game_state == 1 && !assets_resident))
+	{
+		return;
+	}
+
+	if (game_state == 1 && key->action != ASGE::KEYS::KEY_REPEATED &&
+		(key->key == ASGE::KEYS::KEY_A || key->key == ASGE::KEYS::KEY_S ||
+		key->key == ASGE::KEYS::KEY_SPACE))
 	{
-		for (int i = 0; i < MAX_LASERS; i++)
+		input_latency.arrive();
+	}
+
+	if (key->key == ASGE::KEYS::KEY_R && game_state == 1 && fixed_point_sim)
+	{
+		if (key->action == ASGE::KEYS::KEY_PRESSED)
 		{
-			if (lasers[i].getVisible() == false)
-			{
-				shootLaser(i);
-				return;
-			}
+			rewinding = true;
+			sim_thread.setRewinding(true);
+		}
+		else if (key->action == ASGE::KEYS::KEY_RELEASED && rewinding)
+		{
+			// the simulation thread drops the future it scrubbed back over
+			rewinding = false;
+			sim_thread.setRewinding(false);
 		}
 	}
 
+	if (key->key == ASGE::KEYS::KEY_P &&
+		key->action == ASGE::KEYS::KEY_RELEASED
+		&& game_state == 1 && fixed_point_sim)
+	{
+		autopilot_enabled = !autopilot_enabled;
+		sim_thread.setAutopilot(autopilot_enabled);
+	}
+
 	if (key->key == ASGE::KEYS::KEY_UP &&
 		key->action == ASGE::KEYS::KEY_RELEASED)
 	{
@@ -261,7 +616,7 @@ void BreakoutGame::keyHandler(const ASGE::SharedEventData data)
 			menu_option--;
 			if (menu_option < 0 && game_state == 0)
 			{
-				menu_option = 2;
+				menu_option = 4;
 			}
 		}
 		else if (game_state == 4)
@@ -280,7 +635,7 @@ void BreakoutGame::keyHandler(const ASGE::SharedEventData data)
 		if (game_state == 0)
 		{
 			menu_option++;
-			if (menu_option > 2)
+			if (menu_option > 4)
 			{
 				menu_option = 0;
 			}
@@ -306,19 +661,42 @@ void BreakoutGame::keyHandler(const ASGE::SharedEventData data)
 
 				game_state = 1;
 				new_game = true;
+				level_seed = 0;
+				endless_run = false;
 			}
 			if (menu_option == 1)
 			{
-				game_state = 5;
+				std::time_t now = std::time(nullptr);
+				std::tm today = {};
+#ifdef _WIN32
+				localtime_s(&today, &now);
+#else
+				localtime_r(&now, &today);
+#endif
+				game_state = 1;
+				new_game = true;
+				level_seed = dailySeed(today.tm_year + 1900, today.tm_mon + 1, today.tm_mday);
+				endless_run = false;
 			}
 			if (menu_option == 2)
+			{
+				game_state = 1;
+				new_game = true;
+				level_seed = ((uint64_t)GetTickCount() << 32) | (uint64_t)std::time(nullptr);
+				endless_run = true;
+			}
+			if (menu_option == 3)
+			{
+				game_state = 5;
+			}
+			if (menu_option == 4)
 			{
 				signalExit();
 			}
 		}
-		else if (game_state == 2 || game_state == 3 || game_state == 5)
+		else if (game_state == 2 || game_state == 3)
 		{
-			if (updateHighScores() == true)
+			if (score_recorded && last_rank <= NUM_HIGH_SCORES)
 			{
 				game_state = 4;
 			}
@@ -327,10 +705,14 @@ void BreakoutGame::keyHandler(const ASGE::SharedEventData data)
 				game_state = 0;
 			}
 		}
+		else if (game_state == 5)
+		{
+			game_state = 0;
+		}
 		else if (game_state == 4)
 		{
-			high_scores[high_score_idx_to_update].initials = new_initials;
-			saveHighScores();
+			leaderboard.rename(last_score_id, new_initials.c_str());
+			refreshTopScores();
 
 			// reset menu variables
 			initial = 0;
@@ -341,163 +723,447 @@ void BreakoutGame::keyHandler(const ASGE::SharedEventData data)
 		}
 
 	}
-	if (key->key == ASGE::KEYS::KEY_A &&
-		key->action == ASGE::KEYS::KEY_RELEASED)
+	if (key->key == ASGE::KEYS::KEY_LEFT &&
+		key->action == ASGE::KEYS::KEY_PRESSED && game_state == 4)
+	{
+		initial -= 1;
+		if (initial < 0)
+		{
+			initial = 2;
+		}
+		new_initial = new_initials[initial];
+	}
+	if (key->key == ASGE::KEYS::KEY_RIGHT &&
+		key->action == ASGE::KEYS::KEY_PRESSED && game_state == 4)
+	{
+		initial += 1;
+		if (initial > 2)
+		{
+			initial = 0;
+		}
+		new_initial = new_initials[initial];
+	}
+}
+
+/**
+*   @brief   Processes any click inputs
+*   @details This function is added as a callback to handle the game's
+		     mouse button input. For this game, calls to this function
+             are thread safe, so you may alter the game's state as you
+             see fit.
+*   @param   data The event data relating to key input.
+*   @see     ClickEvent
+*   @return  void
+*/
+void BreakoutGame::clickHandler(const ASGE::SharedEventData data)
+{
+	auto click = static_cast<const ASGE::ClickEvent*>(data.get());
+
+	double x_pos, y_pos;
+	inputs->getCursorPos(x_pos, y_pos);
+}
+
+/**
+*   @brief   Processes mouse movement
+*   @details High polling rate mice send thousands of these a second, so
+			 this only keeps the newest position for the next input
+			 sample to pick up.
+*   @param   data The event data relating to the move.
+*   @see     MoveEvent
+*   @return  void
+*/
+void BreakoutGame::moveHandler(const ASGE::SharedEventData data)
+{
+	auto move = static_cast<const ASGE::MoveEvent*>(data.get());
+	input_state.mouseMoved(move->xpos);
+}
+
+/**
+*   @brief   Updates the scene
+*   @details Prepares the renderer subsystem before drawing the
+		     current frame. Once the current frame is has finished
+		     the buffers are swapped accordingly and the image shown.
+*   @return  void
+*/
+void BreakoutGame::update(const ASGE::GameTime& us)
+{
+	// the last frame's buffers were swapped just before this call
+	input_latency.present(InputLatency::clock::now());
+	frame_pacer.waitForNextFrame();
+	sim_thread.setActive(game_state == 1 && fixed_point_sim && assets_resident && !spectating);
+
+	input = input_state.sample(*inputs);
+	if (game_state == 1)
+	{
+		Velocity& paddle_velocity = world.get<Velocity>(paddle);
+		paddle_velocity.x = fixedToFloat(input.paddle_axis);
+		paddle_velocity.y = 0.f;
+	}
+
+	sprite_cache.beginFrame();
+	if (assets_resident)
+	{
+		manageTextures();
+	}
+
+	// nothing below can run until every sprite is loaded
+	if (!assets_resident)
+	{
+		uploadAssets();
+	}
+	else if (spectating)
+	{
+		watchStream(us);
+	}
+	else if (game_state == 1 && fixed_point_sim)
+	{
+		presentSimulation();
+	}
+	else if (game_state == 1)
+	{
+		if (new_game)
+		{
+			newGame();
+		}
+		float seconds = (float)(us.delta_time.count() / 1000.0);
+		const Transform& background = world.get<Transform>(gameplay_area);
+		Transform& paddle_transform = world.get<Transform>(paddle);
+		Velocity& paddle_velocity = world.get<Velocity>(paddle);
+
+		//make sure you use delta time in any movement calculations!
+		if ((paddle_transform.x <= background.x && paddle_velocity.x < 0.f) ||
+			((paddle_transform.x + paddle_transform.width) >= (background.x +
+				background.width) && paddle_velocity.x > 0.f))
+		{
+			paddle_velocity.x = 0.f;
+		}
+		if (input.paddle_tracking)
+		{
+			// the mouse places the paddle directly, inside the gameplay area
+			float scale = background.height / PLAYFIELD_HEIGHT;
+			float x = background.x + fixedToFloat(input.paddle_target) * scale -
+				paddle_transform.width * 0.5f;
+			float right = background.x + background.width - paddle_transform.width;
+			paddle_transform.x = x < background.x ? background.x : x > right ? right : x;
+			paddle_velocity.x = 0.f;
+		}
+		if (input.fire && power_up_bool == true && power_up_shots < MAX_LASERS)
+		{
+			for (int i = 0; i < MAX_LASERS; i++)
+			{
+				if (world.get<Drawable>(lasers[i]).visible == false)
+				{
+					shootLaser(i);
+					break;
+				}
+			}
+		}
+		input_latency.consume(input_latency.getLatest(), InputLatency::clock::now());
+
+		// collisions decide what moves where, so they finish first;
+		// everything with a velocity then moves in one pass, a chunk of
+		// entities per job
+		JobGraph frame;
+		int collide = frame.addStage(1, 1, [this](int, int)
+		{
+			blockCollision();
+			paddleCollision();
+		});
+		int move = frame.addStage(world.countChunks<Transform, Velocity>(), 1,
+			[this, seconds](int begin, int end)
+		{
+			moveEntities(world, seconds, begin, end);
+		});
+		frame.addDependency(move, collide);
+		jobs.run(frame);
+
+		if (power_up_shots == MAX_LASERS)
+		{
+			power_up_bool = false;
+		}
+	}
+
+	// a finished game's score is ranked once, for the result screen
+	if (game_state == 1)
+	{
+		score_recorded = false;
+	}
+	else if ((game_state == 2 || game_state == 3) && !score_recorded && !spectating)
+	{
+		updateHighScores();
+	}
+}
+
+/**
+*   @brief   Shows the fixed point simulation
+*   @details Passes the frame's input to the simulation thread and
+			 copies its newest snapshot into the game's counters and
+			 sprites. Snapshots still from the previous game are skipped
+			 until the thread has picked up a new game request.
+*   @return  void
+*/
+void BreakoutGame::presentSimulation()
+{
+	if (new_game)
+	{
+		sim_game = sim_thread.newGame(GetTickCount(), level_seed, endless_run);
+		level_shown = -1;
+		// the first snapshot then hides every block the new level lacks
+		block_grid.fill();
+		rewinding = false;
+		sim_thread.setRewinding(false);
+		new_game = false;
+	}
+
+	sim_thread.setPaddleAxis(input.paddle_axis);
+	sim_thread.setPaddleTarget(input.paddle_tracking, input.paddle_target);
+	if (input.fire)
+	{
+		sim_thread.fire();
+	}
+	sim_thread.setInputSequence(input_latency.getLatest());
+	if (!sim_thread.update())
+	{
+		return;
+	}
+
+	const SimSnapshot& snapshot = sim_thread.snapshot();
+	if (snapshot.game != sim_game)
+	{
+		return;
+	}
+
+	input_latency.consume(snapshot.input_sequence, snapshot.input_consumed);
+	if (!snapshot.rewinding)
 	{
-		//Main menu
-		if (game_state == 1)
-		{
+		playSounds(snapshot.state, snapshot.game);
+	}
 
-			paddle.setVelocity(0.0f, 0.0f);
-		}
+	const SimState& state = snapshot.state;
+	score = state.score;
+	lives = state.lives;
+	if (state.status == SimStatus::WON)
+	{
+		game_state = 3;
+	}
+	else if (state.status == SimStatus::LOST)
+	{
+		game_state = 2;
 	}
 
-	if (key->key == ASGE::KEYS::KEY_S &&
-		key->action == ASGE::KEYS::KEY_RELEASED)
+	syncSprites(state, snapshot.blocks);
+}
+
+/**
+*   @brief   Follows a spectator stream
+*   @details Applies whatever the watched game has published and shows
+			 it. While disconnected the main menu is shown and the
+			 connection is retried once a second.
+*   @param   us The frame's game time.
+*   @return  void
+*/
+void BreakoutGame::watchStream(const ASGE::GameTime& us)
+{
+	if (!spectator_client.isConnected())
 	{
-		//Main menu
-		if (game_state == 1)
+		game_state = 0;
+		spectator_retry_ms -= us.delta_time.count();
+		if (spectator_retry_ms <= 0.0)
 		{
-			paddle.setVelocity(0.0f, 0.0f);
+			spectator_client.connect("127.0.0.1", SPECTATOR_PORT);
+			spectator_retry_ms = 1000.0;
 		}
+		return;
 	}
 
-	if (key->key == ASGE::KEYS::KEY_S &&
-		(key->action == ASGE::KEYS::KEY_PRESSED ||
-			key->action == ASGE::KEYS::KEY_REPEATED))
+	SimState state;
+	if (spectator_client.poll(state))
 	{
-		//Main menu
-		if (game_state == 1)
-		{
-			paddle.setVelocity(1.0f, 0.0f);
-		}
+		simulation.setState(state);
+		score = state.score;
+		lives = state.lives;
+		game_state = state.status == SimStatus::WON ? 3 :
+			state.status == SimStatus::LOST ? 2 : 1;
+		playSounds(state, 1);
+		syncSprites(simulation.getState(), simulation.getBlockGrid());
 	}
+}
 
-	if (key->key == ASGE::KEYS::KEY_A &&
-		(key->action == ASGE::KEYS::KEY_PRESSED ||
-		key->action == ASGE::KEYS::KEY_REPEATED))
+/**
+*   @brief   Maps the simulation onto the sprites
+*   @details Logical playfield units are scaled to the gameplay area's
+			 screen rectangle. This is the only place the fixed point
+			 state is converted to floats. The level comes from the
+			 state too, so a rewound or watched game that moves to
+			 another level starts a new one for the sprite cache.
+*   @param   state The tick to show.
+*   @param   live The blocks still standing in it.
+*   @return  void
+*/
+void BreakoutGame::syncSprites(const SimState& state, const BlockGrid& live)
+{
+	if (state.level != level_shown)
 	{
-		//Main menu
-		if (game_state == 1)
-		{
-			paddle.setVelocity(-1.0f, 0.0f);
-		}
+		// whatever the last level drew may be evicted from now on
+		sprite_cache.startLevel();
+		level_shown = state.level;
 	}
-	if (key->key == ASGE::KEYS::KEY_LEFT &&
-		key->action == ASGE::KEYS::KEY_PRESSED && game_state == 4)
+
+	syncSprite(paddle, state.paddle, true);
+	syncSprite(ball, state.ball, true);
+	syncSprite(power_up, state.power_up, state.power_up_visible != 0);
+	for (int i = 0; i < MAX_GEMS; i++)
 	{
-		initial -= 1;
-		if (initial < 0)
+		syncSprite(gems[i], state.gems[i], state.gem_visible[i] != 0);
+	}
+	for (int i = 0; i < MAX_LASERS; i++)
+	{
+		syncSprite(lasers[i], state.lasers[i], state.laser_visible[i] != 0);
+	}
+
+	// only blocks that died since the last sync need hiding
+	for (int row = 0; row < BLOCK_ROWS; row++)
+	{
+		for (uint32_t mask = block_grid.rowMask(row) & ~live.rowMask(row); mask; mask &= mask - 1)
 		{
-			initial = 2;
+			world.get<Drawable>(blocks[row * BLOCKS_PER_ROW + countTrailingZeros(mask)]).visible = false;
 		}
-		new_initial = new_initials[initial];
 	}
-	if (key->key == ASGE::KEYS::KEY_RIGHT &&
-		key->action == ASGE::KEYS::KEY_PRESSED && game_state == 4)
+	block_grid = live;
+	block_grid.forEachLive([this, &state](int i)
 	{
-		initial += 1;
-		if (initial > 2)
+		if (state.block_type[i] != block_types_shown[i])
 		{
-			initial = 0;
+			showBlockType(i, state.block_type[i]);
 		}
-		new_initial = new_initials[initial];
-	}
+
+		SimBody block;
+		block.x = simulation.blockX(i);
+		block.y = simulation.blockY(i);
+		syncSprite(blocks[i], block, true);
+	});
 }
 
 /**
-*   @brief   Processes any click inputs
-*   @details This function is added as a callback to handle the game's
-		     mouse button input. For this game, calls to this function
-             are thread safe, so you may alter the game's state as you
-             see fit.
-*   @param   data The event data relating to key input.
-*   @see     ClickEvent
+*   @brief   Changes a block's texture
+*   @details Generated levels colour their blocks differently, so the
+			 texture is swapped when a block's type changes; with the
+			 atlas that only moves the sprite's source rectangle.
+*   @param   index The block.
+*   @param   type Its BlockType.
 *   @return  void
 */
-void BreakoutGame::clickHandler(const ASGE::SharedEventData data)
+void BreakoutGame::showBlockType(int index, uint8_t type)
 {
-	auto click = static_cast<const ASGE::ClickEvent*>(data.get());
+	Drawable& drawable = world.get<Drawable>(blocks[index]);
+	const char* asset = blockAsset(type);
+	if (!drawable.sprite)
+	{
+		// evicted; manageTextures loads the new texture instead
+		drawable.texture = (int)(findAsset(asset) - ASSETS);
+		block_types_shown[index] = type;
+		return;
+	}
 
-	double x_pos, y_pos;
-	inputs->getCursorPos(x_pos, y_pos);
+	size_t bytes = 0;
+	if (bindTexture(drawable.sprite, drawable.texture, asset, bytes))
+	{
+		drawable.texture = (int)(findAsset(asset) - ASSETS);
+		sprite_cache.loaded(drawable.texture, bytes);
+		block_types_shown[index] = type;
+	}
 }
 
 /**
-*   @brief   Updates the scene
-*   @details Prepares the renderer subsystem before drawing the
-		     current frame. Once the current frame is has finished
-		     the buffers are swapped accordingly and the image shown.
+*   @brief   Plays the sounds for what happened since the last tick heard
+*   @details Compares the tick with the last one heard, so a frame that
+			 shows several ticks plays everything in them. A new game, a
+			 jump back or a gap in a spectator stream only moves the
+			 marker on. Each effect is panned to where it happened.
+*   @param   state The tick being shown.
+*   @param   game Which game it belongs to.
 *   @return  void
 */
-void BreakoutGame::update(const ASGE::GameTime& us)
+void BreakoutGame::playSounds(const SimState& state, uint32_t game)
 {
-	if (game_state == 1)
+	const SimState& heard = heard_state;
+	bool follows = game == heard_game && state.tick > heard.tick;
+	heard_game = game;
+	if (!follows)
 	{
-		if (new_game)
-		{
-			newGame();
-		}
-		auto dt_sec = us.delta_time.count() / 1000.0;
-		vector2 paddle_velocity = paddle.getVelocity();
+		heard_state = state;
+		return;
+	}
 
-		ASGE::Sprite* background_sprite = gameplay_area.spriteComponent()->getSprite();
-		ASGE::Sprite* paddle_sprite = paddle.spriteComponent()->getSprite();
-		ASGE::Sprite* ball_sprite = ball.spriteComponent()->getSprite();
-		//make sure you use delta time in any movement calculations!
-		if ((paddle_sprite->xPos() <= background_sprite->xPos() &&
-			paddle_velocity.getX() == -1.f) || ((paddle_sprite->xPos() +
-				paddle_sprite->width()) >= (background_sprite->xPos() +
-					background_sprite->width()) && paddle_velocity.getX() == 1.f))
-		{
-			paddle_velocity.setX(0.f);
-		}
-		blockCollision();
-		paddleCollision();
-
-		
-		vector2 ball_velocity = ball.getVelocity();
-		paddle_sprite->xPos((float)(paddle_sprite->xPos() +
-			(paddle_velocity.getX()  * (game_height * 0.45f)) *
-			(us.delta_time.count() / 1000.f)));
-		ball_sprite->xPos((float)(ball_sprite->xPos() +
-			(ball_velocity.getX() * (game_height * 0.5f)) * game_speed *	
-			(us.delta_time.count() / 1000.f)));
-		ball_sprite->yPos((float)(ball_sprite->yPos() +
-			(ball_velocity.getY() * (game_height * 0.5f)) * game_speed *
-			(us.delta_time.count() / 1000.f)));
-
-		for (int i = 0; i < MAX_GEMS; i++)
+	auto pan = [](fixed x)
+	{
+		return 0.8f * (fixedToFloat(x) * 2.0f / PLAYFIELD_WIDTH - 1.0f);
+	};
+
+	int broken = 0;
+	for (int i = 0; i < MAX_BLOCKS; i++)
+	{
+		if (heard.block_visible[i] && !state.block_visible[i])
 		{
-			ASGE::Sprite* gem = gems[i].spriteComponent()->getSprite();
-			vector2 gem_velocity = gems[i].getVelocity();
-			gem->yPos((float)(gem->yPos() +
-				(gem_velocity.getY()  * (game_height * 0.45f)) *	
-				(us.delta_time.count() / 1000.f)));
+			audio.play(SoundEffect::BLOCK_BREAK, 0.4f,
+				pan(simulation.blockX(i) + Simulation::BLOCK_WIDTH / 2));
+			broken++;
 		}
+	}
 
-		ASGE::Sprite* power_up_sprite = power_up.spriteComponent()->getSprite();
-		vector2 power_up_velocity = power_up.getVelocity();
-		power_up_sprite->yPos((float)(power_up_sprite->yPos() +
-			(power_up_velocity.getY()  * (game_height * 0.45f)) *
-			(us.delta_time.count() / 1000.f)));
-		if (power_up_shots == MAX_LASERS)
+	// a caught gem scores 100, a missed one nothing
+	int caught = (state.score - heard.score - broken * 5) / 100;
+	for (int i = 0; i < MAX_GEMS && caught > 0; i++)
+	{
+		if (heard.gem_visible[i] && !state.gem_visible[i])
 		{
-			power_up_bool = false;
+			audio.play(SoundEffect::GEM_CAUGHT, 0.6f, pan(heard.gems[i].x));
+			caught--;
 		}
-		for (int i = 0; i < MAX_LASERS; i++)
+	}
+
+	for (int i = 0; i < MAX_LASERS; i++)
+	{
+		if (!heard.laser_visible[i] && state.laser_visible[i])
 		{
-			ASGE::Sprite* laser = lasers[i].spriteComponent()->getSprite();
-			vector2 laser_velocity = lasers[i].getVelocity();
-			laser->yPos((float)(laser->yPos() +
-				(laser_velocity.getY()  * (game_height * 0.45f)) *
-				(us.delta_time.count() / 1000.f)));
+			audio.play(SoundEffect::LASER, 0.5f, pan(state.lasers[i].x));
 		}
 	}
+	if (heard.ball.vy > 0 && state.ball.vy < 0 && state.ball.y > toFixed(PLAYFIELD_HEIGHT / 2))
+	{
+		audio.play(SoundEffect::PADDLE_HIT, 0.6f, pan(state.ball.x));
+	}
+	if (!heard.power_up_active && state.power_up_active)
+	{
+		audio.play(SoundEffect::POWER_UP, 0.7f, pan(state.paddle.x));
+	}
+	if (state.lives < heard.lives)
+	{
+		audio.play(SoundEffect::LIFE_LOST, 0.7f, 0.0f);
+	}
+	heard_state = state;
+}
 
+void BreakoutGame::syncSprite(Entity entity, const SimBody& body, bool visible)
+{
+	const Transform& field = world.get<Transform>(gameplay_area);
+	float scale = field.height / PLAYFIELD_HEIGHT;
 
+	Transform& transform = world.get<Transform>(entity);
+	transform.x = field.x + fixedToFloat(body.x) * scale;
+	transform.y = field.y + fixedToFloat(body.y) * scale;
+	world.get<Drawable>(entity).visible = visible;
+}
 
-
+rect BreakoutGame::bounds(Entity entity)
+{
+	const Transform& transform = world.get<Transform>(entity);
+	rect box;
+	box.x = transform.x;
+	box.y = transform.y;
+	box.length = transform.width;
+	box.height = transform.height;
+	return box;
 }
 
 /**
@@ -511,7 +1177,11 @@ void BreakoutGame::render(const ASGE::GameTime &)
 {
 	renderer->setFont(0);
 
-	if (game_state == 0)
+	if (!assets_resident && (game_state == 1 || spectating))
+	{
+		renderLoading();
+	}
+	else if (game_state == 0)
 	{
 		renderMainMenu();
 	}
@@ -537,6 +1207,37 @@ void BreakoutGame::render(const ASGE::GameTime &)
 		renderHighScores();
 	}
 
+	if (show_frame_stats)
+	{
+		renderFrameStats();
+	}
+
+	if (first_frame_ms < 0.0)
+	{
+		first_frame_ms = std::chrono::duration<double, std::milli>(
+			FramePacer::clock::now() - startup_time).count();
+	}
+	if (interactive_ms >= 0.0 && !startup_logged)
+	{
+		logStartupTimes();
+		startup_logged = true;
+	}
+}
+
+/**
+*   @brief   Loading screen
+*   @details Shown if play starts before the textures are all loaded.
+			 The game begins by itself as soon as they are.
+*   @return  void
+*/
+void BreakoutGame::renderLoading()
+{
+	renderer->setClearColour(ASGE::COLOURS::MIDNIGHTBLUE);
+
+	std::string loading_str = "LOADING " +
+		std::to_string(sprites_loaded * 100 / (int)sprite_loads.size()) + "%";
+	renderer->renderText(loading_str.c_str(), game_width * 0.2f,
+		game_height * 0.3f, game_height * 0.002f, ASGE::COLOURS::WHITESMOKE);
 }
 
 /**
@@ -558,11 +1259,25 @@ void BreakoutGame::renderMainMenu()
 	renderer->renderText(menu_option == 0 ? ">PLAY" : "PLAY", game_width * 0.2f,
 		game_height * 0.3f, game_height * 0.002f, ASGE::COLOURS::WHITESMOKE);
 
-	renderer->renderText(menu_option == 1 ? ">HIGH SCORES" : "HIGH SCORES", game_width * 0.2f,
-		game_height * 0.4f, game_height * 0.002f, ASGE::COLOURS::WHITESMOKE);
+	renderer->renderText(menu_option == 1 ? ">DAILY CHALLENGE" : "DAILY CHALLENGE", game_width * 0.2f,
+		game_height * 0.37f, game_height * 0.002f, ASGE::COLOURS::WHITESMOKE);
+
+	renderer->renderText(menu_option == 2 ? ">ENDLESS" : "ENDLESS", game_width * 0.2f,
+		game_height * 0.44f, game_height * 0.002f, ASGE::COLOURS::WHITESMOKE);
+
+	renderer->renderText(menu_option == 3 ? ">HIGH SCORES" : "HIGH SCORES", game_width * 0.2f,
+		game_height * 0.51f, game_height * 0.002f, ASGE::COLOURS::WHITESMOKE);
 
-	renderer->renderText(menu_option == 2 ? ">QUIT" : "QUIT", game_width * 0.2f,
-		game_height * 0.5f, game_height * 0.002f, ASGE::COLOURS::WHITESMOKE);
+	renderer->renderText(menu_option == 4 ? ">QUIT" : "QUIT", game_width * 0.2f,
+		game_height * 0.58f, game_height * 0.002f, ASGE::COLOURS::WHITESMOKE);
+
+	if (!assets_resident)
+	{
+		std::string loading_str = "Loading " +
+			std::to_string(sprites_loaded * 100 / (int)sprite_loads.size()) + "%";
+		renderer->renderText(loading_str.c_str(), game_width * 0.2f,
+			game_height * 0.66f, game_height * 0.0012f, ASGE::COLOURS::GREY);
+	}
 
 
 	
@@ -579,10 +1294,21 @@ void BreakoutGame::renderInGame()
 {
 	// Set Background colour
 	renderer->setClearColour(ASGE::COLOURS::MIDNIGHTBLUE);
-	renderer->renderSprite(*gameplay_area.spriteComponent()->getSprite());
-	renderer->renderSprite(*paddle.spriteComponent()->getSprite());
-	renderer->renderSprite(*ball.spriteComponent()->getSprite());
-	renderer->renderSprite(*heart.spriteComponent()->getSprite());
+
+	// every visible entity, each sprite placed and sized from its
+	// transform; one whose texture is evicted waits for the reload
+	world.forEach<Transform, Drawable>([this](const Transform& transform, const Drawable& drawable)
+	{
+		if (drawable.visible && sprite_cache.use(drawable.texture) && drawable.sprite)
+		{
+			ASGE::Sprite* sprite = drawable.sprite;
+			sprite->xPos(transform.x);
+			sprite->yPos(transform.y);
+			sprite->width(transform.width);
+			sprite->height(transform.height);
+			renderer->renderSprite(*sprite);
+		}
+	});
 
 	renderer->renderText("Score: ",
 		(game_width * 0.60f), (game_height * 0.088f),
@@ -593,42 +1319,11 @@ void BreakoutGame::renderInGame()
 		game_height * 0.002f, ASGE::COLOURS::DARKORANGE);
 
 	std::string life_string = std::to_string(lives -1);
-	rect heart_sprite = heart.spriteComponent()->getBoundingBox();
+	rect heart_sprite = bounds(heart);
 	renderer->renderText(life_string.c_str(),
 		(heart_sprite.x + (heart_sprite.length * 1.02f)),
 		(heart_sprite.y + (heart_sprite.height * 0.95f)),
 		game_height * 0.0025f, ASGE::COLOURS::DARKORANGE);
-
-
-	if (power_up.getVisible() == true)
-	{
-		renderer->renderSprite(*power_up.spriteComponent()->getSprite());
-	}
-	for (int i = 0; i < MAX_GEMS; i++)
-	{
-		if (gems[i].getVisible() == true)
-		{
-			renderer->renderSprite(*gems[i].spriteComponent()->getSprite());
-		}
-
-	}
-	for (int i = 0; i < MAX_LASERS; i++)
-	{
-		if (lasers[i].getVisible() == true)
-		{
-			renderer->renderSprite(*lasers[i].spriteComponent()->getSprite());
-		}
-
-	}
-
-	for (int i = 0; i < MAX_BLOCKS; i++)
-	{
-		if (blocks[i].getVisible() == true)
-		{
-			renderer->renderSprite(*blocks[i].spriteComponent()->getSprite());
-		}
-		
-	}
 }
 
 /**
@@ -651,6 +1346,7 @@ void BreakoutGame::renderGameOverL()
 	renderer->renderText(score_string.c_str(),
 		(game_width * 0.7f), (game_height * 0.50f),
 		game_height * 0.004f, ASGE::COLOURS::WHITESMOKE);
+	renderRanking();
 
 }
 
@@ -674,40 +1370,53 @@ void BreakoutGame::renderGameOverW()
 	renderer->renderText(score_string.c_str(),
 		(game_width * 0.7f), (game_height * 0.50f),
 		game_height * 0.004f, ASGE::COLOURS::WHITESMOKE);
+	renderRanking();
 }
 
 /**
 *   @brief   Update high scores
-*   @details This function is used to check and update if single player high
-score is higher than the current top ten
-*   @see     KeyEvent
-*   @return  bool
+*   @details Adds the finished game's score, with 500 for every life
+			 left, to the leaderboard under placeholder initials, which
+			 the new high score screen lets the player change.
+*   @return  True if it made the top NUM_HIGH_SCORES.
 */
 bool BreakoutGame::updateHighScores()
 {
-	bool update_score = false;
-	high_score_idx_to_update = 0;
-	score = (score + (lives * 500));
-	for (int i = 9; i > -1; i--)
-	{
-		if (score > high_scores[i].score)
-		{
-			high_score_idx_to_update = i;
-			update_score = true;
-		}
-	}
-	if (update_score)
-	{
-		for (int i = 9; i > high_score_idx_to_update; i--)
-		{
-			high_scores[i].score = high_scores[i - 1].score;
-			high_scores[i].initials = high_scores[i - 1].initials;
-		}
-		high_scores[high_score_idx_to_update].score = score;
+	last_score_id = leaderboard.add(score + lives * 500, "AAA");
+	last_rank = leaderboard.rank(last_score_id);
+	score_recorded = true;
+	high_score_idx_to_update = (int)last_rank - 1;
+	refreshTopScores();
+	return last_rank <= NUM_HIGH_SCORES;
+}
+
+/**
+*   @brief   Caches the top scores
+*   @details The menus redraw them every frame, so they are copied out
+			 of the leaderboard only when it changes.
+*   @return  void
+*/
+void BreakoutGame::refreshTopScores()
+{
+	leaderboard.range(1, NUM_HIGH_SCORES, top_scores);
+}
 
+/**
+*   @brief   Ranking
+*   @details Shows where the last game's score placed among every score
+			 ever set, under the final score.
+*   @return  void
+*/
+void BreakoutGame::renderRanking()
+{
+	if (!score_recorded)
+	{
+		return;
 	}
-	score = 0;
-	return update_score;
+	std::string ranking = "YOU RANKED #" + std::to_string(last_rank) + " OF " +
+		std::to_string(leaderboard.size());
+	renderer->renderText(ranking.c_str(), (game_width * 0.3f), (game_height * 0.6f),
+		game_height * 0.003f, ASGE::COLOURS::DARKORANGE);
 }
 
 /**
@@ -726,12 +1435,13 @@ void BreakoutGame::renderHighScores()
 		ASGE::COLOURS::DARKORANGE);
 	// renders the high scores
 	int j = 0;
-	for (int i = game_height * 0.25f; i < game_height * 0.75f; i = i + game_height * 0.05f)
+	for (int i = game_height * 0.25f; i < game_height * 0.75f && j < (int)top_scores.size();
+		i = i + game_height * 0.05f)
 	{
-		renderer->renderText(high_scores[j].initials.c_str(), game_width * 0.7f, i, game_height * 0.002f,
+		renderer->renderText(top_scores[j].initials, game_width * 0.7f, i, game_height * 0.002f,
 			ASGE::COLOURS::GHOSTWHITE);
 		// creates a string with the score appended
-		std::string score_str_1 = std::to_string(high_scores[j].score);
+		std::string score_str_1 = std::to_string(top_scores[j].score);
 		renderer->renderText(score_str_1.c_str(), game_width * 0.75f, i, game_height * 0.002f,
 			ASGE::COLOURS::GHOSTWHITE);
 		j++;
@@ -753,13 +1463,14 @@ void BreakoutGame::renderNewHighScore()
 	renderer->renderText("CONGRATULATIONS YOU SCORED A NEW HIGH SCORE",
 		game_width * 0.1f, game_height * 0.15f, game_height * 0.003f, ASGE::COLOURS::DARKORANGE);
 	int j = 0;
-	for (int i = game_height * 0.25f; i < game_height * 0.75f; i = i + game_height * 0.05f)
+	for (int i = game_height * 0.25f; i < game_height * 0.75f && j < (int)top_scores.size();
+		i = i + game_height * 0.05f)
 	{
 		renderer->renderText(high_score_idx_to_update == j ?
-			new_initials.c_str() : high_scores[j].initials.c_str(),
+			new_initials.c_str() : top_scores[j].initials,
 			game_width * 0.45f, i, game_height * 0.002f, high_score_idx_to_update == j ?
 			ASGE::COLOURS::GHOSTWHITE : ASGE::COLOURS::DARKORANGE);
-		std::string score_str_1 = std::to_string(high_scores[j].score);
+		std::string score_str_1 = std::to_string(top_scores[j].score);
 		renderer->renderText(score_str_1.c_str(), game_width * 0.5f, i, game_height * 0.002f,
 			high_score_idx_to_update == j ?
 			ASGE::COLOURS::GHOSTWHITE : ASGE::COLOURS::DARKORANGE);
@@ -773,6 +1484,122 @@ void BreakoutGame::renderNewHighScore()
 		game_height * 0.002f, ASGE::COLOURS::GHOSTWHITE);
 }
 
+/**
+*   @brief   Frame stats overlay
+*   @details Shows the frame pacer's target, mean frame time, jitter and
+			 missed deadlines. Toggled with the ` key.
+*   @return  void
+*/
+void BreakoutGame::renderFrameStats()
+{
+	int target = frame_pacer.getTargetRate();
+	std::string target_str = "Target: " +
+		(target ? std::to_string(target) + " fps" : std::string("uncapped"));
+	std::string frame_str = "Frame: " +
+		std::to_string((int)(frame_pacer.getMeanFrameTime() * 1000.0)) + " us  jitter: " +
+		std::to_string((int)(frame_pacer.getFrameTimeStdDev() * 1000.0)) + " us";
+	std::string missed_str = "Missed: " +
+		std::to_string(frame_pacer.getMissedDeadlines()) + " / " +
+		std::to_string(frame_pacer.getFrameCount());
+
+	renderer->renderText(target_str.c_str(), game_width * 0.01f,
+		game_height * 0.03f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+	renderer->renderText(frame_str.c_str(), game_width * 0.01f,
+		game_height * 0.05f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+	renderer->renderText(missed_str.c_str(), game_width * 0.01f,
+		game_height * 0.07f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	const SimSnapshot& sim = sim_thread.snapshot();
+	std::string rewind_str = "Rewind: " +
+		std::to_string((sim.rewind_newest - sim.rewind_oldest) / SIM_TICK_RATE) +
+		" s  " + std::to_string(sim.rewind_bytes / 1024) + " KB";
+	renderer->renderText(rewind_str.c_str(), game_width * 0.01f,
+		game_height * 0.09f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	std::string viewers_str = "Viewers: " +
+		std::to_string(sim.viewers) + "  sent: " +
+		std::to_string(sim.viewer_bytes / 1024) + " KB  resyncs: " +
+		std::to_string(sim.viewer_resyncs) + "  dropped: " +
+		std::to_string(sim.viewer_drops);
+	renderer->renderText(viewers_str.c_str(), game_width * 0.01f,
+		game_height * 0.11f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	const SimState& state = spectating ? simulation.getState() : sim.state;
+	std::string autopilot_str = std::string("Autopilot: ") +
+		(sim.autopilot ? "on" : "off") + "  tick: " +
+		std::to_string(state.tick) + "  speed: " +
+		std::to_string(fixedToFloat(state.game_speed)).substr(0, 4);
+	renderer->renderText(autopilot_str.c_str(), game_width * 0.01f,
+		game_height * 0.13f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	std::string assets_str = "Atlas: " + (atlas.isLoaded() ?
+		std::to_string(atlas.getPageCount()) + " pages" : std::string("off"));
+	renderer->renderText(assets_str.c_str(), game_width * 0.01f,
+		game_height * 0.15f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	std::string startup_str = "Startup: first frame " +
+		std::to_string((int)first_frame_ms) + " ms  interactive " +
+		(interactive_ms >= 0.0 ? std::to_string((int)interactive_ms) + " ms" :
+		std::string("loading"));
+	renderer->renderText(startup_str.c_str(), game_width * 0.01f,
+		game_height * 0.17f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	std::string telemetry_str = "Telemetry: " + (telemetry.isRunning() ?
+		std::to_string(telemetry.getRecordedCount()) + " events  written: " +
+		std::to_string(telemetry.getWrittenCount()) + "  dropped: " +
+		std::to_string(telemetry.getDroppedCount()) + "  file: " +
+		std::to_string(telemetry.getFileSequence()) : std::string("off"));
+	renderer->renderText(telemetry_str.c_str(), game_width * 0.01f,
+		game_height * 0.19f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	std::string sim_str = "Sim thread: " + std::to_string(sim.tick_rate) +
+		" ticks/s  behind: " + std::to_string(sim.backlog_drops);
+	renderer->renderText(sim_str.c_str(), game_width * 0.01f,
+		game_height * 0.21f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	std::string jobs_str = "Jobs: " + std::to_string(jobs.getWorkerCount()) +
+		" workers  graphs: " + std::to_string(jobs.getGraphCount()) + "  inline: " +
+		std::to_string(jobs.getInlineCount()) + "  stolen: " + std::to_string(jobs.getStealCount());
+	renderer->renderText(jobs_str.c_str(), game_width * 0.01f,
+		game_height * 0.23f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	const LatencyHistogram& to_sim = input_latency.getEventToSim();
+	const LatencyHistogram& to_present = input_latency.getSimToPresent();
+	std::string latency_str = "Latency: input>sim p50 " +
+		std::to_string(to_sim.getPercentile(0.5)).substr(0, 4) + " p99 " +
+		std::to_string(to_sim.getPercentile(0.99)).substr(0, 4) + " ms  sim>present p50 " +
+		std::to_string(to_present.getPercentile(0.5)).substr(0, 4) + " p99 " +
+		std::to_string(to_present.getPercentile(0.99)).substr(0, 4) + " ms  (" +
+		std::to_string(to_sim.getCount()) + " events)";
+	renderer->renderText(latency_str.c_str(), game_width * 0.01f,
+		game_height * 0.25f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	std::string input_str = std::string("Input: ") +
+		(input.paddle_tracking ? "mouse" : input.gamepad ? "keys + pad" : "keys") +
+		"  mouse moves: " + std::to_string(input_state.getMouseMoves()) + " in " +
+		std::to_string(input_state.getMouseSamples()) + " samples";
+	renderer->renderText(input_str.c_str(), game_width * 0.01f,
+		game_height * 0.27f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	AudioStats sound = audio.getStats();
+	std::string audio_str = std::string("Audio: ") + audio.getOutputName() + "  voices: " +
+		std::to_string(sound.voices) + " (peak " + std::to_string(sound.peak_voices) + ")  mix: " +
+		std::to_string((int)sound.mix_us) + " of " + std::to_string((int)sound.block_us) +
+		" us/block  stolen: " + std::to_string(sound.stolen) + "  dropped: " +
+		std::to_string(sound.dropped) + "  underruns: " + std::to_string(sound.underruns);
+	renderer->renderText(audio_str.c_str(), game_width * 0.01f,
+		game_height * 0.29f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+
+	std::string sprites_str = "Sprite cache: " + std::to_string(sprite_cache.getHeldCount()) +
+		" files  " + std::to_string(sprite_cache.getHeldBytes() / 1024) + " of " +
+		std::to_string(sprite_cache.getBudget() / 1024) + " KB  released: " +
+		std::to_string(sprite_cache.getEvictions()) + "  reloads: " +
+		std::to_string(sprite_cache.getReloads()) + "  stalls: " +
+		std::to_string(sprite_cache.getReloadStalls());
+	renderer->renderText(sprites_str.c_str(), game_width * 0.01f,
+		game_height * 0.31f, game_height * 0.0012f, ASGE::COLOURS::YELLOWGREEN);
+}
+
 /**
 *   @brief   New Game
 *   @details This function is used to reset a new game
@@ -781,6 +1608,7 @@ void BreakoutGame::renderNewHighScore()
 */
 void BreakoutGame::newGame()
 {
+	sprite_cache.startLevel();
 
 	float new_yPos = game_height * .09f + ((game_height * 0.8f) * .06f);
 	float new_xPos = ((game_width - ((game_height * GAMEPLAY_HEIGHT) * 1.25f)) * 0.506f);
@@ -788,17 +1616,18 @@ void BreakoutGame::newGame()
 	// re-initialise blocks
 	for (int i = 0; i < MAX_BLOCKS; i++)
 	{
-		blocks[i].setVisible(true);
-		ASGE::Sprite* block = blocks[i].spriteComponent()->getSprite();
-		block->yPos(new_yPos);
-		block->xPos(new_xPos);
-		new_xPos = block->xPos() + block->width();
+		world.get<Drawable>(blocks[i]).visible = true;
+		Transform& block = world.get<Transform>(blocks[i]);
+		block.y = new_yPos;
+		block.x = new_xPos;
+		new_xPos = block.x + block.width;
 		if (i % 15 == 14)
 		{
-			new_yPos += block->height();
+			new_yPos += block.height;
 			new_xPos = ((game_width - ((game_height * GAMEPLAY_HEIGHT) * 1.25f)) * 0.506f);
 		}
 	}
+	block_grid.fill();
 	// re-initialise gems
 	for (int i = 0; i <MAX_GEMS; i++)
 	{
@@ -807,15 +1636,16 @@ void BreakoutGame::newGame()
 	// re-initialise lasers
 	for (int i = 0; i <MAX_LASERS; i++)
 	{
-		resetLaser(i);
+		resetLaser(lasers[i]);
 	}
 	// re-initialise game variables
 	score = 0;
 	game_speed = 1.f;
+	world.get<Velocity>(ball).speed = game_height * 0.5f * game_speed;
 	no_gems_visible = 0;
 	no_hit = 0;
 	lives = 4;
-	paddle.setVelocity(0.f, 0.f);
+	world.get<Velocity>(paddle).x = 0.f;
 	serveBall();
 	power_up_bool = false;
 	power_up_shots = 0;
@@ -831,14 +1661,16 @@ void BreakoutGame::newGame()
 void BreakoutGame::serveBall()
 {
 	// set ball position to center of paddle and velocity to straight up
-	rect background_sprite = gameplay_area.spriteComponent()->getBoundingBox();
-	rect paddle_sprite = paddle.spriteComponent()->getBoundingBox();
-	ASGE::Sprite* ball_sprite = ball.spriteComponent()->getSprite();
-	ball_sprite->yPos(background_sprite.y + background_sprite.height
-		- (paddle_sprite.height + ball_sprite->height()));
-	ball_sprite->xPos((paddle_sprite.x  + paddle_sprite.length
-		* 0.5f) - (ball_sprite->width() * 0.5f));
-	ball.setVelocity(0.0f, -1.0f);
+	rect background_sprite = bounds(gameplay_area);
+	rect paddle_sprite = bounds(paddle);
+	Transform& ball_transform = world.get<Transform>(ball);
+	ball_transform.y = background_sprite.y + background_sprite.height
+		- (paddle_sprite.height + ball_transform.height);
+	ball_transform.x = (paddle_sprite.x + paddle_sprite.length
+		* 0.5f) - (ball_transform.width * 0.5f);
+	Velocity& ball_velocity = world.get<Velocity>(ball);
+	ball_velocity.x = 0.0f;
+	ball_velocity.y = -1.0f;
 }
 
 /**
@@ -849,111 +1681,109 @@ void BreakoutGame::serveBall()
 */
 void BreakoutGame::blockCollision()
 {
-	rect background = gameplay_area.spriteComponent()->getBoundingBox();
-	rect ball_sprite = ball.spriteComponent()->getBoundingBox();
-	vector2 ball_velocity = ball.getVelocity();
+	rect background = bounds(gameplay_area);
+	rect ball_sprite = bounds(ball);
+	Velocity& ball_velocity = world.get<Velocity>(ball);
 
 	// height and width of gameplay area deflections for ball
 	if ((ball_sprite.x <= background.x &&
-		ball_velocity.getX() < 0.f) || ((ball_sprite.x +
+		ball_velocity.x < 0.f) || ((ball_sprite.x +
 			ball_sprite.length) >= (background.x +
-				background.length) && ball_velocity.getX() > 0.f))
+				background.length) && ball_velocity.x > 0.f))
 	{
 
-		ball_velocity.setX(0 - ball_velocity.getX());
+		ball_velocity.x = 0 - ball_velocity.x;
 	}
-	if (ball_sprite.y <= background.y && ball_velocity.getY() < 0.f)
+	if (ball_sprite.y <= background.y && ball_velocity.y < 0.f)
 	{
 
-		ball_velocity.setY(0 - ball_velocity.getY());
+		ball_velocity.y = 0 - ball_velocity.y;
 	}
 
 	// edge detection for lasers
-	for (int i = 0; i < MAX_LASERS; i++)
+	world.forEachEntity<Transform, Velocity, Collider>([&](Entity entity, const Transform& laser,
+		const Velocity&, const Collider& collider)
 	{
-		rect laser_rect = lasers[i].spriteComponent()->getBoundingBox();
-		if (laser_rect.y <= background.y)
+		if (collider.layer == CollisionLayer::LASER && laser.y <= background.y)
 		{
-			resetLaser(i);
+			resetLaser(entity);
 		}
+	});
 
-	}
-
-	// block collision detection with ball and lasers
-	for (int i = 0; i < MAX_BLOCKS; i++)
+	// block collision detection with ball and lasers, live blocks only;
+	// lasers are among the moving colliders, which leaves the blocks out
+	block_grid.forEachLive([&](int i)
 	{
-		rect block = blocks[i].spriteComponent()->getBoundingBox(); 
-		if (blocks[i].getVisible())
+		rect block = bounds(blocks[i]);
+		world.forEachEntity<Transform, Velocity, Collider, Drawable>([&](Entity entity,
+			const Transform& laser_rect, const Velocity&, const Collider& collider, const Drawable& drawable)
 		{
-			for (int j = 0; j < MAX_LASERS; j++)
-			{
-
-				// laser collision check
-				rect laser_rect = lasers[j].spriteComponent()->getBoundingBox();
-				if ((laser_rect.y < block.y + block.height) && (laser_rect.x > block.x - 
-					(laser_rect.length * .5f) && laser_rect.x +
-						laser_rect.length  < block.x + block.length +
-						(laser_rect.length * .5f)) && lasers[j].getVisible())
-				{
-					resetLaser(j);
-					releaseGem(block);
-					releasePowerUp(i, block);
-					blocks[i].setVisible(false);
-					no_hit++;
-					score += 5;
-				}
-			}
 
-			// ball collision check
-			if ((ball_sprite.y < block.y + block.height &&
-				ball_sprite.y + ball_sprite.height > block.y &&
-				(ball_sprite.x + (ball_sprite.length * 0.9f) > block.x &&
-					ball_sprite.x   < block.x + block.length * .9f) &&
-				ball_velocity.getY() < 0.f) || (ball_sprite.y  < block.y  &&
-					ball_sprite.y + ball_sprite.height > block.y &&
-					(ball_sprite.x + (ball_sprite.length * 0.9f) > block.x &&
-						ball_sprite.x   < block.x + block.length * .9f) &&
-					ball_velocity.getY() > 0.f))
-			{
-				releaseGem(block);
-				ball_velocity.setY(0 - ball_velocity.getY());
-				releasePowerUp(i, block);
-				blocks[i].setVisible(false);
-				no_hit++;
-				score += 5;
-			}
-			else if ((ball_sprite.y < block.y + block.height &&
-				ball_sprite.y + (ball_sprite.height)> block.y &&
-				(ball_sprite.x + ball_sprite.length > block.x &&
-					ball_sprite.x  < block.x) && ball_velocity.getX() > 0.f) ||
-					(ball_sprite.y  < block.y + block.height &&
-						ball_sprite.y + (ball_sprite.height) > block.y &&
-						(ball_sprite.x  < block.x + block.length &&
-							ball_sprite.x + ball_sprite.length > block.x + block.length)
-						&& ball_velocity.getX() < 0.f))
+			// laser collision check
+			if (collider.layer == CollisionLayer::LASER && (laser_rect.y < block.y + block.height) &&
+				(laser_rect.x > block.x - (laser_rect.width * .5f) && laser_rect.x +
+					laser_rect.width < block.x + block.length +
+					(laser_rect.width * .5f)) && drawable.visible)
 			{
+				resetLaser(entity);
 				releaseGem(block);
-				ball_velocity.setX(0 - ball_velocity.getX());
 				releasePowerUp(i, block);
-				blocks[i].setVisible(false);
+				world.get<Drawable>(blocks[i]).visible = false;
+				block_grid.kill(i);
 				no_hit++;
 				score += 5;
 			}
+		});
+
+		// ball collision check
+		if ((ball_sprite.y < block.y + block.height &&
+			ball_sprite.y + ball_sprite.height > block.y &&
+			(ball_sprite.x + (ball_sprite.length * 0.9f) > block.x &&
+				ball_sprite.x   < block.x + block.length * .9f) &&
+			ball_velocity.y < 0.f) || (ball_sprite.y  < block.y  &&
+				ball_sprite.y + ball_sprite.height > block.y &&
+				(ball_sprite.x + (ball_sprite.length * 0.9f) > block.x &&
+					ball_sprite.x   < block.x + block.length * .9f) &&
+				ball_velocity.y > 0.f))
+		{
+			releaseGem(block);
+			ball_velocity.y = 0 - ball_velocity.y;
+			releasePowerUp(i, block);
+			world.get<Drawable>(blocks[i]).visible = false;
+			block_grid.kill(i);
+			no_hit++;
+			score += 5;
 		}
-		// game over check (win)
-		if (no_hit == MAX_BLOCKS)
+		else if ((ball_sprite.y < block.y + block.height &&
+			ball_sprite.y + (ball_sprite.height)> block.y &&
+			(ball_sprite.x + ball_sprite.length > block.x &&
+				ball_sprite.x  < block.x) && ball_velocity.x > 0.f) ||
+				(ball_sprite.y  < block.y + block.height &&
+					ball_sprite.y + (ball_sprite.height) > block.y &&
+					(ball_sprite.x  < block.x + block.length &&
+						ball_sprite.x + ball_sprite.length > block.x + block.length)
+					&& ball_velocity.x < 0.f))
 		{
-			game_state = 3;
+			releaseGem(block);
+			ball_velocity.x = 0 - ball_velocity.x;
+			releasePowerUp(i, block);
+			world.get<Drawable>(blocks[i]).visible = false;
+			block_grid.kill(i);
+			no_hit++;
+			score += 5;
 		}
+	});
 
+	// game over check (win)
+	if (no_hit == MAX_BLOCKS)
+	{
+		game_state = 3;
 	}
 	// game over check (loss)
 	if (lives == 0)
 	{
 		game_state = 2;
 	}
-	// update ball velocity
-	ball.setVelocity(ball_velocity.getX(), ball_velocity.getY());
 
 }
 
@@ -965,9 +1795,9 @@ void BreakoutGame::blockCollision()
 */
 void BreakoutGame::paddleCollision()
 {
-	rect paddle_sprite = paddle.spriteComponent()->getBoundingBox();
-	rect ball_sprite = ball.spriteComponent()->getBoundingBox();
-	vector2 ball_velocity = ball.getVelocity();
+	rect paddle_sprite = bounds(paddle);
+	rect ball_sprite = bounds(ball);
+	Velocity& ball_velocity = world.get<Velocity>(ball);
 
 	// ball/paddle collision detection
 	if (ball_sprite.y + ball_sprite.height > paddle_sprite.y)
@@ -985,92 +1815,76 @@ void BreakoutGame::paddleCollision()
 		else if (ball_sprite.x + (ball_sprite.length) >= paddle_sprite.x +
 			paddle_sprite.length)
 		{
-			ball_velocity.setX(0.707f);
-			ball_velocity.setY(-0.707f);
+			ball_velocity.x = 0.707f;
+			ball_velocity.y = -0.707f;
 		}
 		else if (ball_sprite.x + (ball_sprite.length * 0.5f) >= paddle_sprite.x +
 			(paddle_sprite.length * 0.71f))
 		{
-			ball_velocity.setX(0.5f);
-			ball_velocity.setY(-0.866f);
+			ball_velocity.x = 0.5f;
+			ball_velocity.y = -0.866f;
 		}
 		else if (ball_sprite.x + (ball_sprite.length * 0.5f) >= paddle_sprite.x +
 			(paddle_sprite.length * 0.57f))
 		{
-			ball_velocity.setX(0.259f);
-			ball_velocity.setY(-0.966f);
+			ball_velocity.x = 0.259f;
+			ball_velocity.y = -0.966f;
 		}
 		else if (ball_sprite.x + (ball_sprite.length * 0.5f) >= paddle_sprite.x +
 			(paddle_sprite.length * 0.43f))
 		{
-			ball_velocity.setX(0.f);
-			ball_velocity.setY(-1.f);
+			ball_velocity.x = 0.f;
+			ball_velocity.y = -1.f;
 		}
 		else if (ball_sprite.x + (ball_sprite.length * 0.5f) >= paddle_sprite.x +
 			(paddle_sprite.length * 0.29f))
 		{
-			ball_velocity.setX(-0.259f);
-			ball_velocity.setY(-0.966f);
+			ball_velocity.x = -0.259f;
+			ball_velocity.y = -0.966f;
 		}
 		else if (ball_sprite.x + (ball_sprite.length * 0.5f) >= paddle_sprite.x +
 			(paddle_sprite.length  * 0.14))
 		{
-			ball_velocity.setX(-0.500f);
-			ball_velocity.setY(-0.866f);
+			ball_velocity.x = -0.500f;
+			ball_velocity.y = -0.866f;
 		}
 		else if (ball_sprite.x + (ball_sprite.length) >= paddle_sprite.x)
 		{
-			ball_velocity.setX(-0.707f);
-			ball_velocity.setY(-0.707f);
+			ball_velocity.x = -0.707f;
+			ball_velocity.y = -0.707f;
 		}
 	}
-	//upadate ball velocity from collision
-	ball.setVelocity(ball_velocity.getX(), ball_velocity.getY());
 
-	// check for gem collision with paddle or bottom of gameplay area
-	for (int i = 0; i < MAX_GEMS; i++)
+	// check for gem and power up collisions with paddle or bottom of
+	// gameplay area
+	world.forEachEntity<Transform, Drawable, Pickup>([&](Entity entity,
+		const Transform& pickup, const Drawable& drawable, const Pickup& kind)
 	{
-		if (gems[i].getVisible() == true);
+		if (!drawable.visible || pickup.y + pickup.height <= paddle_sprite.y)
 		{
-			rect gem = gems[i].spriteComponent()->getBoundingBox();
-			if (gem.y + gem.height > paddle_sprite.y)
-			{
-				if (gem.x > paddle_sprite.x && gem.x + gem.length
-					< paddle_sprite.x + paddle_sprite.length)
-				{
-					score += 100;
-					resetGem(i);
-
-				}
-				else if (gem.y > paddle_sprite.y)
-				{
-					resetGem(i);
-				}
-			}
-
+			return;
 		}
-	}
-
-	// check for power up collision with paddle or bottom of gameplay area
-	if (power_up.getVisible() == true);
-	{
-		rect power_up_rect = power_up.spriteComponent()->getBoundingBox();
-		if (power_up_rect.y + power_up_rect.height > paddle_sprite.y)
+		if (pickup.x > paddle_sprite.x && pickup.x + pickup.width
+			< paddle_sprite.x + paddle_sprite.length)
 		{
-			if (power_up_rect.x > paddle_sprite.x && power_up_rect.x 
-				+ power_up_rect.length < paddle_sprite.x + paddle_sprite.length)
+			score += kind.score;
+			if (kind.kind == PickupKind::POWER_UP)
 			{
 				power_up_bool = true;
 				power_up_shots = 0;
-				resetPowerUp();
-			}
-			else if (power_up_rect.y > paddle_sprite.y)
-			{
-				resetPowerUp();
 			}
 		}
+		else if (pickup.y <= paddle_sprite.y)
+		{
+			return;
+		}
 
-	}
+		hideEntity(entity);
+		if (kind.kind == PickupKind::GEM)
+		{
+			no_gems_visible--;
+		}
+	});
 
 }
 
@@ -1086,16 +1900,19 @@ void BreakoutGame::releaseGem(rect block)
 	// for every fifth block hit release a gem from the corresponding block
 	if (no_hit % 5 == 4)
 	{
-		ASGE::Sprite* gem = gems[no_gems_visible].spriteComponent()->getSprite();
-		gem->yPos(block.y);
-		gem->xPos(block.x + ((block.length * 0.5f) - (gem->width() * 0.5f)));
-		gems[no_gems_visible].setVelocity(0.f, 0.5f);
-		gems[no_gems_visible].setVisible(true);
+		Transform& gem = world.get<Transform>(gems[no_gems_visible]);
+		gem.y = block.y;
+		gem.x = block.x + ((block.length * 0.5f) - (gem.width * 0.5f));
+		Velocity& gem_velocity = world.get<Velocity>(gems[no_gems_visible]);
+		gem_velocity.x = 0.f;
+		gem_velocity.y = 0.5f;
+		world.get<Drawable>(gems[no_gems_visible]).visible = true;
 		no_gems_visible++;
 	}
 	if (no_hit % 25 == 24)
 	{
 		game_speed += 0.1f;
+		world.get<Velocity>(ball).speed = game_height * 0.5f * game_speed;
 	}
 }
 
@@ -1108,17 +1925,17 @@ provided block co-ordinates
 */
 void BreakoutGame::releasePowerUp(int index, rect block)
 {
-	// relesae poer up from specific block locations
-	if (index == 32 || index == 42 || index == 80 || 
-		index == 84 || index == 106 || index == 118)
-	{
-		ASGE::Sprite* power_up_sprite = 
-			power_up.spriteComponent()->getSprite();
-		power_up_sprite->yPos(block.y);
-		power_up_sprite->xPos(block.x + ((block.length * 0.5f)
-			- (power_up_sprite->width() * 0.5f)));
-		power_up.setVelocity(0.f, 0.45f);
-		power_up.setVisible(true);
+	// the classic layout says which blocks hold one
+	if (campaignLevel(0).block_drops[index] == (uint8_t)BlockDrop::POWER_UP)
+	{
+		Transform& power_up_transform = world.get<Transform>(power_up);
+		power_up_transform.y = block.y;
+		power_up_transform.x = block.x + ((block.length * 0.5f)
+			- (power_up_transform.width * 0.5f));
+		Velocity& power_up_velocity = world.get<Velocity>(power_up);
+		power_up_velocity.x = 0.f;
+		power_up_velocity.y = 0.45f;
+		world.get<Drawable>(power_up).visible = true;
 	}
 	
 }
@@ -1132,12 +1949,7 @@ position and velocity
 */
 void BreakoutGame::resetGem(int index)
 {
-	// reset sprite position, velocity and visibility
-	ASGE::Sprite* gem_sprite = gems[index].spriteComponent()->getSprite();
-	gem_sprite->yPos(0.f);
-	gem_sprite->xPos(0.f);
-	gems[index].setVisible(false);
-	gems[index].setVelocity(0.f, 0.f);
+	hideEntity(gems[index]);
 	no_gems_visible--;
 }
 
@@ -1150,12 +1962,7 @@ position and velocity
 */
 void BreakoutGame::resetPowerUp()
 {
-	// reset sprite position, velocity and visibility
-	ASGE::Sprite* power_up_sprite = power_up.spriteComponent()->getSprite();
-	power_up_sprite->yPos(0.f);
-	power_up_sprite->xPos(0.f);
-	power_up.setVisible(false);
-	power_up.setVelocity(0.f, 0.f);
+	hideEntity(power_up);
 }
 
 /**
@@ -1169,14 +1976,15 @@ void BreakoutGame::shootLaser(int index)
 	// set sprite position for corresponding index to the center of the paddle,
 	// set to visible and set velocity to straight up
 	no_lasers_visible++;
-	rect background_rect = gameplay_area.spriteComponent()->getBoundingBox();
-	rect paddle_rect = paddle.spriteComponent()->getBoundingBox();
-	ASGE::Sprite* laser_sprite = lasers[index].spriteComponent()->getSprite();
-	laser_sprite->yPos(background_rect.y + background_rect.height
-		- paddle_rect.height);
-	laser_sprite->xPos((paddle_rect.x + paddle_rect.length * 0.5f) - (laser_sprite->width() * 0.5f));
-	lasers[index].setVelocity(0.0f, -1.0f);
-	lasers[index].setVisible(true);
+	rect background_rect = bounds(gameplay_area);
+	rect paddle_rect = bounds(paddle);
+	Transform& laser = world.get<Transform>(lasers[index]);
+	laser.y = background_rect.y + background_rect.height - paddle_rect.height;
+	laser.x = (paddle_rect.x + paddle_rect.length * 0.5f) - (laser.width * 0.5f);
+	Velocity& laser_velocity = world.get<Velocity>(lasers[index]);
+	laser_velocity.x = 0.0f;
+	laser_velocity.y = -1.0f;
+	world.get<Drawable>(lasers[index]).visible = true;
 	power_up_shots++;
 }
 
@@ -1187,75 +1995,66 @@ position and velocity
 *   @see     KeyEvent
 *   @return  void
 */
-void BreakoutGame::resetLaser(int index)
+void BreakoutGame::resetLaser(Entity laser)
 {
-	// reset sprite position, velocity and visibility
-	ASGE::Sprite* laser_sprite = lasers[index].spriteComponent()->getSprite();
-	laser_sprite->yPos(0.f);
-	laser_sprite->xPos(0.f);
-	lasers[index].setVisible(false);
-	lasers[index].setVelocity(0.f, 0.f);
+	hideEntity(laser);
 	no_lasers_visible--;
 }
 
+/**
+*   @brief   Hides an entity
+*   @details Parks it in the corner, stopped, until it is next
+			 released. Its speed is kept.
+*   @return  void
+*/
+void BreakoutGame::hideEntity(Entity entity)
+{
+	Transform& transform = world.get<Transform>(entity);
+	transform.x = 0.f;
+	transform.y = 0.f;
+	Velocity& velocity = world.get<Velocity>(entity);
+	velocity.x = 0.f;
+	velocity.y = 0.f;
+	world.get<Drawable>(entity).visible = false;
+}
+
 /**
 *   @brief   Load files
-*   @details This function is load the high scores and characters files
+*   @details Opens the leaderboard. The first time, the top ten kept in
+			 High_scores.txt by earlier versions are carried over.
 *   @see     KeyEvent
 *   @return  void
 */
 void BreakoutGame::loadFiles()
 {
 	// load high scores
+	leaderboard.open("High_scores.log");
 	std::ifstream inFile_one;
-	inFile_one.open("High_scores.txt");
-	if (!inFile_one.fail())
+	if (leaderboard.size() == 0)
+	{
+		inFile_one.open("High_scores.txt");
+	}
+	if (inFile_one.is_open())
 	{
+		// already in rank order, so ties keep theirs
+		leaderboard.setDurable(false);
 		for (int i = 0; i < NUM_HIGH_SCORES; i++)
 		{
+			std::string initials;
 			std::string score;
-			getline(inFile_one, high_scores[i].initials);
+			getline(inFile_one, initials);
 			getline(inFile_one, score);
-			high_scores[i].score = atoi(score.c_str());
+			if (inFile_one.fail())
+			{
+				break;
+			}
+			if (atoi(score.c_str()) > 0)
+			{
+				leaderboard.add(atoi(score.c_str()), initials.c_str());
+			}
 		}
+		leaderboard.setDurable(true);
 		inFile_one.close();
 	}
-}
-
-/**
-*   @brief   Save files
-*   @details This function is load the high scores and characters files
-*   @see     KeyEvent
-*   @return  void
-*/
-void BreakoutGame::saveHighScores()
-{
-	// save high scores array to file
-	std::ofstream outFile;
-	outFile.open("High_scores.txt");
-	if (!outFile.fail())
-	{
-		for (int i = 0; i < NUM_HIGH_SCORES; i++)
-		{
-			outFile << high_scores[i].initials << std::endl;
-			outFile << high_scores[i].score << std::endl;
-		}
-		outFile.close();
-	}
-
-}
-
-/**
-*   @brief   clear arrays
-*   @details This function is used to initialise arrays.
-*   @see     KeyEvent
-*   @return  void
-*/
-void BreakoutGame::clearArrays()
-{
-	for (int i = 0; i < NUM_HIGH_SCORES; i++)
-	{
-		high_scores[i].initials = "AAA";
-		high_scores[i].score = 0;
-	}
+	refreshTopScores();
 }
\ No newline at end of file
@@ -4,18 +4,26 @@
 #include <fstream>
 #include <iostream>
 
+#include "AssetLoader.h"
+#include "Audio.h"
+#include "BlockGrid.h"
 #include "Constants.h"
-#include "GameObject.h"
+#include "EntityWorld.h"
+#include "FramePacer.h"
+#include "InputState.h"
+#include "JobSystem.h"
+#include "Latency.h"
+#include "Leaderboard.h"
 #include "Rect.h"
+#include "SimThread.h"
+#include "Simulation.h"
+#include "Spectator.h"
+#include "SpriteCache.h"
+#include "Systems.h"
+#include "Telemetry.h"
+#include "TextureAtlas.h"
 
 
-
-struct Score
-{
-	long score = 0;
-	std::string initials;
-};
-
 /**
 *  An OpenGL Game based on ASGE.
 */
@@ -26,10 +34,22 @@ public:
 	BreakoutGame();
 	~BreakoutGame();
 	virtual bool init() override;
+	void spectate();
+	void setSpriteBudget(size_t bytes);
 
 private:
+	void createEntities();
+	bool loadSprite(Entity entity, const char* asset);
+	bool bindTexture(ASGE::Sprite* sprite, int shown, const char* asset, size_t& bytes);
+	void queueSpriteLoad(Entity entity, const char* asset);
+	void uploadAssets();
+	void manageTextures();
+	void layoutSprites();
+	void logStartupTimes();
+	void logLatency();
 	void keyHandler(const ASGE::SharedEventData data);
 	void clickHandler(const ASGE::SharedEventData data);
+	void moveHandler(const ASGE::SharedEventData data);
 	void setupResolution();
 	void renderMainMenu();
 	void renderInGame();
@@ -44,35 +64,83 @@ private:
 	void resetGem(int index);
 	void resetPowerUp();
 	void shootLaser(int index);
-	void resetLaser(int index);
+	void resetLaser(Entity laser);
+	void hideEntity(Entity entity);
+	rect bounds(Entity entity);
+	void presentSimulation();
+	void watchStream(const ASGE::GameTime& us);
+	void syncSprites(const SimState& state, const BlockGrid& live);
+	void syncSprite(Entity entity, const SimBody& body, bool visible);
+	void playSounds(const SimState& state, uint32_t game);
+	void showBlockType(int index, uint8_t type);
+	static size_t textureBytes(const ASGE::Sprite* sprite);
 
 	bool updateHighScores();
+	void refreshTopScores();
 
 	void renderHighScores();
 
 	void renderNewHighScore();
 
-	void loadFiles();
+	void renderRanking();
 
-	void saveHighScores();
+	void renderFrameStats();
 
-	void clearArrays();
+	void renderLoading();
+
+	void loadFiles();
 
 	virtual void update(const ASGE::GameTime &) override;
 	virtual void render(const ASGE::GameTime &) override;
 
 	int  key_callback_id = -1;	        /**< Key Input Callback ID. */
 	int  mouse_callback_id = -1;        /**< Mouse Input Callback ID. */
-
-	//Add your GameObjects
-	GameObject blocks[MAX_BLOCKS];
-	GameObject gems[MAX_GEMS];
-	GameObject gameplay_area;
-	GameObject paddle;
-	GameObject ball;
-	GameObject heart; 
-	GameObject power_up;
-	GameObject lasers[MAX_LASERS];
+	int  move_callback_id = -1;         /**< Mouse Move Callback ID. */
+
+	TextureAtlas atlas;                 /**< Where each texture sits on the atlas pages, if packed. */
+
+	// startup: sprites load in the background while the menu is up
+	struct SpriteLoad
+	{
+		Entity entity;
+		int asset = 0;                  /**< Index into ASSETS. */
+		bool loaded = false;
+	};
+	AssetLoader asset_loader;
+	std::vector<SpriteLoad> sprite_loads;
+	int sprites_loaded = 0;
+	bool assets_resident = false;       /**< Every sprite is loaded and laid out. */
+	FramePacer::clock::time_point startup_time;
+	double first_frame_ms = -1.0;
+	double interactive_ms = -1.0;
+	bool startup_logged = false;
+
+	// textures past startup: evicted over budget, reloaded when drawn
+	SpriteCache sprite_cache;
+	std::vector<int> texture_reloads;
+	std::vector<int> texture_victims;
+	int level_shown = -1;               /**< Level textures were last needed for, -1 for none. */
+
+	FramePacer frame_pacer;             /**< Caps and evens out the frame rate. */
+	bool show_frame_stats = false;      /**< Draws the frame pacer stats overlay. */
+	JobSystem jobs;                     /**< Runs the independent stages of a frame's update. */
+	InputLatency input_latency;         /**< Times paddle and fire keys through to the screen. */
+	InputState input_state;             /**< Held keys and the gamepad, sampled once a frame. */
+	InputSnapshot input;                /**< This frame's sample. */
+	AudioEngine audio;                  /**< Mixes the sound effects on its own thread. */
+	SimState heard_state;               /**< The tick sounds were last played up to. */
+	uint32_t heard_game = 0;
+
+	// every object in the game; the handles pick out particular ones
+	EntityWorld world;
+	Entity blocks[MAX_BLOCKS];
+	Entity gems[MAX_GEMS];
+	Entity gameplay_area;
+	Entity paddle;
+	Entity ball;
+	Entity heart;
+	Entity power_up;
+	Entity lasers[MAX_LASERS];
 
 	// menu variables
 	int menu_option = 0;
@@ -92,8 +160,42 @@ private:
 	bool power_up_bool = false;
 	float game_speed = 1.f;
 
-	// high score variables
-	Score high_scores[NUM_HIGH_SCORES];
+	// level being played: 0 for the classic layout, or a generated one's
+	// seed; an endless run generates its next level each time one clears
+	uint64_t level_seed = 0;
+	bool endless_run = false;
+	uint8_t block_types_shown[MAX_BLOCKS] = {};  /**< BlockType each block's texture shows. */
+
+	// blocks whose sprites are showing
+	BlockGrid block_grid;
+
+	// gameplay events from the simulation, drained to Telemetry_<n>.bin
+	Telemetry telemetry;
+
+	// fixed point simulation, stepped on its own thread; the game's copy
+	// holds the block layout and the state being watched when spectating
+	SimThread sim_thread;
+	uint32_t sim_game = 0;
+	Simulation simulation;
+	bool fixed_point_sim = FIXED_POINT_SIM;
+
+	// rewind scrubbed while R is held, autopilot toggled with P
+	bool rewinding = false;
+	bool autopilot_enabled = false;
+
+	// spectator stream, published by players and watched with -spectate
+	SpectatorServer spectator_server;
+	SpectatorClient spectator_client;
+	bool spectating = false;
+	double spectator_retry_ms = 0.0;
+
+	// high score variables: every score ever set, with the top ones
+	// cached for the menus, and where the last game's score ranked
+	Leaderboard leaderboard;
+	std::vector<RankEntry> top_scores;
+	bool score_recorded = false;
+	uint32_t last_score_id = 0;
+	size_t last_rank = 0;
 	char new_initial = 'A';
 	std::string new_initials = "AAA";
 	int high_score_idx_to_update = 0;
@@ -0,0 +1,129 @@
+#include <Engine/Input.h>
+#include <Engine/Keys.h>
+
+#include "InputState.h"
+
+void InputState::keyEvent(int key, int action)
+{
+	bool held = action != ASGE::KEYS::KEY_RELEASED;
+	if (key == ASGE::KEYS::KEY_A)
+	{
+		left_held = held;
+	}
+	else if (key == ASGE::KEYS::KEY_S)
+	{
+		right_held = held;
+	}
+	else if (key == ASGE::KEYS::KEY_SPACE && action == ASGE::KEYS::KEY_PRESSED)
+	{
+		fire_pressed = true;
+	}
+}
+
+void InputState::mouseMoved(double x)
+{
+	mouse_x = x;
+	mouse_moved = true;
+	mouse_moves++;
+}
+
+void InputState::setPlayfield(float left, float scale)
+{
+	playfield_left = left;
+	playfield_scale = scale > 0.0f ? scale : 1.0f;
+}
+
+void InputState::clear()
+{
+	left_held = false;
+	right_held = false;
+	fire_pressed = false;
+	mouse_moved = false;
+	tracking = false;
+}
+
+long long InputState::getMouseMoves() const
+{
+	return mouse_moves;
+}
+
+long long InputState::getMouseSamples() const
+{
+	return mouse_samples;
+}
+
+/**
+*   @brief   Samples the input
+*   @details The stick is only used while neither paddle key is held.
+			 Its fire button fires when it goes down, like the key. The
+			 mouse takes over once it moves and gives the paddle back
+			 as soon as the keys or the stick push it.
+*   @return  The merged state.
+*/
+InputSnapshot InputState::sample(const ASGE::Input& input)
+{
+	InputSnapshot snapshot;
+	snapshot.fire = fire_pressed;
+	fire_pressed = false;
+
+	float axis = (right_held ? 1.0f : 0.0f) - (left_held ? 1.0f : 0.0f);
+
+	GamePadData pad = input.getGamePad(GAMEPAD_INDEX);
+	if (pad.is_connected)
+	{
+		snapshot.gamepad = true;
+		if (axis == 0.0f && pad.no_of_axis > GAMEPAD_AXIS_X)
+		{
+			axis = applyDeadzone(pad.axis[GAMEPAD_AXIS_X], GAMEPAD_DEADZONE);
+		}
+
+		bool fire_held = pad.no_of_buttons > GAMEPAD_FIRE_BUTTON &&
+			pad.buttons[GAMEPAD_FIRE_BUTTON] != 0;
+		snapshot.fire = snapshot.fire || (fire_held && !pad_fire_held);
+		pad_fire_held = fire_held;
+	}
+	else
+	{
+		pad_fire_held = false;
+	}
+
+	if (mouse_moved)
+	{
+		tracking = true;
+		mouse_moved = false;
+		mouse_samples++;
+	}
+	if (axis != 0.0f)
+	{
+		tracking = false;
+	}
+
+	// quantised once here; the simulation only ever sees fixed point
+	snapshot.paddle_axis = (fixed)(axis * FIXED_ONE);
+	if (tracking)
+	{
+		// the simulation clamps the paddle, this only keeps the number sane
+		float target = (float)((mouse_x - playfield_left) / playfield_scale);
+		target = target < -PLAYFIELD_WIDTH ? -PLAYFIELD_WIDTH :
+			target > 2 * PLAYFIELD_WIDTH ? 2 * PLAYFIELD_WIDTH : target;
+		snapshot.paddle_tracking = true;
+		snapshot.paddle_target = (fixed)(target * FIXED_ONE);
+	}
+	return snapshot;
+}
+
+float applyDeadzone(float value, float deadzone)
+{
+	float magnitude = value < 0.0f ? -value : value;
+	if (magnitude <= deadzone)
+	{
+		return 0.0f;
+	}
+	if (magnitude > 1.0f)
+	{
+		magnitude = 1.0f;
+	}
+
+	float scaled = (magnitude - deadzone) / (1.0f - deadzone);
+	return value < 0.0f ? -scaled : scaled;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "Constants.h"
+#include "Fixed.h"
+
+namespace ASGE
+{
+	class Input;
+}
+
+/**
+*  The player's input as it stood when sampled.
+*/
+struct InputSnapshot
+{
+	fixed paddle_axis = 0;  /**< -1 full left to 1 full right, proportional on a gamepad. */
+	bool paddle_tracking = false;  /**< The paddle follows the mouse rather than paddle_axis. */
+	fixed paddle_target = 0;       /**< The mouse's x in playfield units. */
+	bool fire = false;      /**< Fire was pressed since the previous sample. */
+	bool gamepad = false;   /**< A gamepad was connected. */
+};
+
+/**
+*  Merges the keyboard and a gamepad into one polled input state.
+*  Key callbacks only record which keys are held, so holding both paddle
+*  keys and letting go of one carries on in the other's direction and
+*  key repeat timing no longer matters. The gamepad has no events and is
+*  read when sampling. Held keys win over the stick; a stick inside the
+*  deadzone reads as centred and the rest of its travel is rescaled to
+*  cover the whole range, so the paddle can still creep slowly.
+*  Moving the mouse hands the paddle to the mouse until a key or the
+*  stick pushes it again. Mouse moves arrive far faster than frames, so
+*  each one only overwrites the latest position and a sample takes
+*  whichever is newest.
+*/
+class InputState
+{
+public:
+	/**
+	*  Records a key event. Cheap enough to call for every event.
+	*  @param [in] key The ASGE key code.
+	*  @param [in] action KEY_PRESSED, KEY_REPEATED or KEY_RELEASED.
+	*/
+	void keyEvent(int key, int action);
+
+	/**
+	*  Records the mouse moving. Only the newest position is kept.
+	*  @param [in] x The cursor's x in screen space.
+	*/
+	void mouseMoved(double x);
+
+	/**
+	*  Sets how screen space maps onto the playfield for the mouse.
+	*  @param [in] left The playfield's left edge on screen.
+	*  @param [in] scale Screen pixels per playfield unit.
+	*/
+	void setPlayfield(float left, float scale);
+
+	/**
+	*  Forgets held keys and any unread fire press.
+	*/
+	void clear();
+
+	/**
+	*  Samples the input. Must be called on the thread that owns the
+	*  window, which is the only one allowed to poll the gamepad.
+	*  @param [in] input The engine's input system.
+	*  @return The merged state; a fire press is only reported once.
+	*/
+	InputSnapshot sample(const ASGE::Input& input);
+
+	long long getMouseMoves() const;    /**< Move events received. */
+	long long getMouseSamples() const;  /**< Samples that picked up a new position. */
+
+private:
+	bool left_held = false;
+	bool right_held = false;
+	bool fire_pressed = false;
+	bool pad_fire_held = false;
+
+	double mouse_x = 0.0;
+	bool mouse_moved = false;
+	bool tracking = false;
+	float playfield_left = 0.0f;
+	float playfield_scale = 1.0f;
+	long long mouse_moves = 0;
+	long long mouse_samples = 0;
+};
+
+/**
+*   @brief   Applies a deadzone to an axis.
+*   @details Values within deadzone of the centre read as 0 and the rest
+             are rescaled so the edge of the deadzone is 0 and full travel
+             is still 1.
+*   @return  The adjusted value, from -1 to 1.
+*/
+float applyDeadzone(float value, float deadzone);
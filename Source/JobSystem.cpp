@@ -0,0 +1,299 @@
+#include "JobSystem.h"
+
+int JobGraph::addStage(int count, int batch, Work work)
+{
+	stages.emplace_back();
+	Stage& stage = stages.back();
+	stage.work = std::move(work);
+	stage.count = count > 0 ? count : 0;
+	stage.batch = batch > 0 ? batch : 1;
+	items += stage.count;
+	return (int)stages.size() - 1;
+}
+
+void JobGraph::addDependency(int stage, int before)
+{
+	if (before < 0 || before >= stage || stage >= (int)stages.size())
+	{
+		return;
+	}
+	stages[before].dependents.push_back(stage);
+	stages[stage].dependencies++;
+}
+
+void JobGraph::clear()
+{
+	stages.clear();
+	items = 0;
+}
+
+int JobGraph::getStageCount() const
+{
+	return (int)stages.size();
+}
+
+int JobGraph::getItemCount() const
+{
+	return items;
+}
+
+JobSystem::~JobSystem()
+{
+	stop();
+}
+
+void JobSystem::start(int worker_count)
+{
+	stop();
+
+	if (worker_count < 0)
+	{
+		int cores = (int)std::thread::hardware_concurrency();
+		worker_count = cores > 1 ? cores - 1 : 0;
+	}
+	if (worker_count > JOB_MAX_WORKERS)
+	{
+		worker_count = JOB_MAX_WORKERS;
+	}
+
+	for (int i = 0; i <= worker_count; i++)
+	{
+		queues.emplace_back(new Queue);
+	}
+	running = true;
+	for (int i = 1; i <= worker_count; i++)
+	{
+		workers.emplace_back(&JobSystem::work, this, i);
+	}
+}
+
+void JobSystem::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		running = false;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	workers.clear();
+	queues.clear();
+}
+
+/**
+*   @brief   Runs a graph
+*   @details Small graphs, or any graph when there are no workers, run
+			 stage by stage on this thread in the order they were added.
+			 Otherwise the stages with nothing to wait for are released
+			 onto this thread's deque and it works alongside the workers
+			 until the last stage finishes.
+*   @return  void
+*/
+void JobSystem::run(JobGraph& graph)
+{
+	graphs++;
+	if (workers.empty() || graph.getItemCount() < JOB_INLINE_THRESHOLD)
+	{
+		inlined++;
+		for (JobGraph::Stage& stage : graph.stages)
+		{
+			if (stage.count > 0)
+			{
+				stage.work(0, stage.count);
+			}
+		}
+		return;
+	}
+
+	for (JobGraph::Stage& stage : graph.stages)
+	{
+		stage.waiting = stage.dependencies;
+		stage.remaining = (stage.count + stage.batch - 1) / stage.batch;
+	}
+	graph.unfinished = (int)graph.stages.size();
+
+	for (int i = 0; i < (int)graph.stages.size(); i++)
+	{
+		if (graph.stages[i].dependencies == 0)
+		{
+			release(0, graph, i);
+		}
+	}
+
+	while (graph.unfinished.load(std::memory_order_acquire) > 0)
+	{
+		Job job;
+		if (pop(0, job))
+		{
+			execute(0, job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+int JobSystem::getWorkerCount() const
+{
+	return (int)workers.size();
+}
+
+long long JobSystem::getGraphCount() const
+{
+	return graphs;
+}
+
+long long JobSystem::getInlineCount() const
+{
+	return inlined;
+}
+
+long long JobSystem::getStealCount() const
+{
+	return steals.load(std::memory_order_relaxed);
+}
+
+/**
+*   @brief   Worker loop
+*   @details Runs jobs while there are any to be had and sleeps until
+			 more are queued otherwise.
+*   @return  void
+*/
+void JobSystem::work(int queue)
+{
+	while (true)
+	{
+		Job job;
+		if (pop(queue, job))
+		{
+			execute(queue, job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(wake_mutex);
+		wake.wait(lock, [this]
+		{
+			return queued.load() > 0 || !running;
+		});
+		if (!running)
+		{
+			return;
+		}
+	}
+}
+
+/**
+*   @brief   Takes a job
+*   @details Newest first from the thread's own deque, then oldest first
+			 from the others, starting with the next one along so the
+			 thieves spread out.
+*   @return  false if every deque was empty.
+*/
+bool JobSystem::pop(int queue, Job& job)
+{
+	int count = (int)queues.size();
+	for (int i = 0; i < count; i++)
+	{
+		int victim = (queue + i) % count;
+		Queue& from = *queues[victim];
+		std::lock_guard<std::mutex> lock(from.mutex);
+		if (from.jobs.empty())
+		{
+			continue;
+		}
+
+		if (i == 0)
+		{
+			job = from.jobs.back();
+			from.jobs.pop_back();
+		}
+		else
+		{
+			job = from.jobs.front();
+			from.jobs.pop_front();
+			steals.fetch_add(1, std::memory_order_relaxed);
+		}
+		queued--;
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::execute(int queue, const Job& job)
+{
+	JobGraph::Stage& stage = job.graph->stages[job.stage];
+	stage.work(job.begin, job.end);
+	if (--stage.remaining == 0)
+	{
+		finish(queue, *job.graph, job.stage);
+	}
+}
+
+/**
+*   @brief   Queues a stage's jobs
+*   @details The jobs go on the releasing thread's deque in reverse, so
+			 popping from the back starts at the stage's first items.
+*   @return  void
+*/
+void JobSystem::release(int queue, JobGraph& graph, int index)
+{
+	JobGraph::Stage& stage = graph.stages[index];
+	if (stage.count == 0)
+	{
+		finish(queue, graph, index);
+		return;
+	}
+
+	int jobs = 0;
+	{
+		Queue& to = *queues[queue];
+		std::lock_guard<std::mutex> lock(to.mutex);
+		for (int end = stage.count; end > 0; end -= stage.batch)
+		{
+			Job job;
+			job.graph = &graph;
+			job.stage = index;
+			job.begin = end > stage.batch ? end - stage.batch : 0;
+			job.end = end;
+			to.jobs.push_back(job);
+			jobs++;
+		}
+	}
+	queued += jobs;
+
+	// taking the lock means no worker can be between checking for work
+	// and going to sleep, so none misses the wake up
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+	}
+	if (jobs > 1)
+	{
+		wake.notify_all();
+	}
+	else
+	{
+		wake.notify_one();
+	}
+}
+
+/**
+*   @brief   Finishes a stage
+*   @details Releases every stage that was only waiting on this one.
+			 The graph is only marked done after that, so run cannot
+			 return while a dependent is still to be queued.
+*   @return  void
+*/
+void JobSystem::finish(int queue, JobGraph& graph, int index)
+{
+	for (int dependent : graph.stages[index].dependents)
+	{
+		if (--graph.stages[dependent].waiting == 0)
+		{
+			release(queue, graph, dependent);
+		}
+	}
+	graph.unfinished--;
+}
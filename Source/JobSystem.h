@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Constants.h"
+
+/**
+*  A frame's worth of work, split into stages.
+*  Each stage covers a range of items and is cut into jobs of a batch of
+*  items each; the jobs of a stage may run in any order on any thread,
+*  so they must only touch their own items. A stage starts once every
+*  stage it depends on has finished. Stages can only depend on stages
+*  added before them, which keeps the graph acyclic and means running
+*  the stages in the order they were added is always valid.
+*/
+class JobGraph
+{
+public:
+	using Work = std::function<void(int begin, int end)>;
+
+	JobGraph() = default;
+	JobGraph(const JobGraph&) = delete;
+	JobGraph& operator=(const JobGraph&) = delete;
+
+	/**
+	*  Adds a stage.
+	*  @param [in] count How many items the stage covers.
+	*  @param [in] batch Items per job, at least 1.
+	*  @param [in] work Called with each job's [begin, end) range.
+	*  @return The stage's id, for addDependency.
+	*/
+	int addStage(int count, int batch, Work work);
+
+	/**
+	*  Holds a stage back until an earlier one has finished.
+	*  @param [in] stage The stage that waits.
+	*  @param [in] before The stage it waits for; must be lower than stage.
+	*/
+	void addDependency(int stage, int before);
+
+	void clear();
+	int getStageCount() const;
+
+	/**
+	*  Items across every stage, used to judge whether the graph is worth
+	*  handing to the workers at all.
+	*/
+	int getItemCount() const;
+
+private:
+	friend class JobSystem;
+
+	struct Stage
+	{
+		Work work;
+		int count = 0;
+		int batch = 1;
+		int dependencies = 0;
+		std::vector<int> dependents;
+
+		// only used while the graph runs
+		std::atomic<int> waiting{ 0 };
+		std::atomic<int> remaining{ 0 };
+	};
+
+	// a deque, so stages never move once added
+	std::deque<Stage> stages;
+	std::atomic<int> unfinished{ 0 };
+	int items = 0;
+};
+
+/**
+*  Fixed pool of worker threads that run job graphs.
+*  Every worker owns a deque of jobs and so does the thread calling run.
+*  A thread pushes the jobs of any stage it releases onto the back of
+*  its own deque and pops from the back, so it carries on with the work
+*  it just made while that data is still in its cache. A thread whose
+*  deque is empty steals from the front of someone else's, taking the
+*  oldest, and usually biggest, piece of outstanding work.
+*  Graphs with fewer than JOB_INLINE_THRESHOLD items are run inline on
+*  the calling thread, since waking the workers would cost more than the
+*  work itself.
+*/
+class JobSystem
+{
+public:
+	JobSystem() = default;
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	/**
+	*  Starts the workers.
+	*  @param [in] workers Threads to start, capped at JOB_MAX_WORKERS;
+	*              negative picks one per spare core and 0 runs every
+	*              graph inline.
+	*/
+	void start(int workers);
+	void stop();
+
+	/**
+	*  Runs a graph to completion. The calling thread works through
+	*  jobs too rather than waiting idle. Only one thread may call this.
+	*/
+	void run(JobGraph& graph);
+
+	int getWorkerCount() const;
+	long long getGraphCount() const;
+	long long getInlineCount() const;  /**< Graphs that were too small to share out. */
+	long long getStealCount() const;   /**< Jobs taken from another thread's deque. */
+
+private:
+	struct Job
+	{
+		JobGraph* graph = nullptr;
+		int stage = 0;
+		int begin = 0;
+		int end = 0;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void work(int queue);
+	bool pop(int queue, Job& job);
+	void execute(int queue, const Job& job);
+	void release(int queue, JobGraph& graph, int stage);
+	void finish(int queue, JobGraph& graph, int stage);
+
+	// queue 0 belongs to the thread calling run, the rest to the workers
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+
+	std::mutex wake_mutex;
+	std::condition_variable wake;
+	std::atomic<int> queued{ 0 };
+	std::atomic<bool> running{ false };
+
+	long long graphs = 0;
+	long long inlined = 0;
+	std::atomic<long long> steals{ 0 };
+};
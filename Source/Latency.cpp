@@ -0,0 +1,176 @@
+#include "Latency.h"
+
+namespace
+{
+	double milliseconds(InputLatency::clock::duration time)
+	{
+		return std::chrono::duration<double, std::milli>(time).count();
+	}
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+	clear();
+}
+
+void LatencyHistogram::add(double ms)
+{
+	int bucket = ms > 0.0 ? (int)(ms * 1000.0 / LATENCY_BUCKET_US) : 0;
+	buckets[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS]++;
+	count++;
+	total_ms += ms;
+	if (ms > max_ms)
+	{
+		max_ms = ms;
+	}
+}
+
+void LatencyHistogram::clear()
+{
+	for (long long& bucket : buckets)
+	{
+		bucket = 0;
+	}
+	count = 0;
+	total_ms = 0.0;
+	max_ms = 0.0;
+}
+
+long long LatencyHistogram::getCount() const
+{
+	return count;
+}
+
+double LatencyHistogram::getMean() const
+{
+	return count ? total_ms / count : 0.0;
+}
+
+double LatencyHistogram::getMax() const
+{
+	return max_ms;
+}
+
+double LatencyHistogram::getPercentile(double fraction) const
+{
+	if (count == 0)
+	{
+		return 0.0;
+	}
+
+	long long rank = (long long)(fraction * count);
+	long long seen = 0;
+	for (int i = 0; i < LATENCY_BUCKETS; i++)
+	{
+		seen += buckets[i];
+		if (seen > rank)
+		{
+			return (i + 1) * LATENCY_BUCKET_US / 1000.0;
+		}
+	}
+	return max_ms;
+}
+
+void LatencyHistogram::write(std::ostream& out) const
+{
+	out << count << " events  mean: " << getMean() << " ms  p50: " << getPercentile(0.5) <<
+		" ms  p90: " << getPercentile(0.9) << " ms  p99: " << getPercentile(0.99) <<
+		" ms  max: " << max_ms << " ms" << std::endl;
+	for (int i = 0; i <= LATENCY_BUCKETS; i++)
+	{
+		if (buckets[i] == 0)
+		{
+			continue;
+		}
+		if (i < LATENCY_BUCKETS)
+		{
+			out << "    " << i * LATENCY_BUCKET_US / 1000.0 << " - " <<
+				(i + 1) * LATENCY_BUCKET_US / 1000.0 << " ms: " << buckets[i] << std::endl;
+		}
+		else
+		{
+			out << "    over " << i * LATENCY_BUCKET_US / 1000.0 << " ms: " << buckets[i] << std::endl;
+		}
+	}
+}
+
+uint32_t InputLatency::arrive()
+{
+	arrived++;
+	arrived_at[arrived % LATENCY_PENDING] = clock::now();
+	return arrived;
+}
+
+uint32_t InputLatency::getLatest() const
+{
+	return arrived;
+}
+
+/**
+*   @brief   Input consumed
+*   @details Every event between the last one consumed and sequence
+			 was picked up by the same tick. Sequence numbers are
+			 compared by difference so they can wrap.
+*   @return  void
+*/
+void InputLatency::consume(uint32_t sequence, clock::time_point when)
+{
+	if ((int32_t)(sequence - consumed) <= 0 || (int32_t)(arrived - sequence) < 0)
+	{
+		return;
+	}
+
+	// events whose stamps have since been overwritten are dropped
+	uint32_t oldest = arrived - LATENCY_PENDING + 1;
+	uint32_t first = (int32_t)(oldest - consumed) > 1 ? oldest : consumed + 1;
+	for (uint32_t event = first; (int32_t)(sequence - event) >= 0; event++)
+	{
+		event_to_sim.add(milliseconds(when - arrived_at[event % LATENCY_PENDING]));
+		consumed_at[event % LATENCY_PENDING] = when;
+	}
+	if ((int32_t)(first - presented) > 1)
+	{
+		presented = first - 1;
+	}
+	consumed = sequence;
+}
+
+/**
+*   @brief   Frame presented
+*   @details Everything consumed before this call was drawn into the
+			 frame that has just been swapped in.
+*   @return  void
+*/
+void InputLatency::present(clock::time_point when)
+{
+	if ((int32_t)(consumed - presented) <= 0)
+	{
+		return;
+	}
+
+	uint32_t oldest = consumed - LATENCY_PENDING + 1;
+	uint32_t first = (int32_t)(oldest - presented) > 1 ? oldest : presented + 1;
+	for (uint32_t event = first; (int32_t)(consumed - event) >= 0; event++)
+	{
+		sim_to_present.add(milliseconds(when - consumed_at[event % LATENCY_PENDING]));
+	}
+	presented = consumed;
+}
+
+void InputLatency::clear()
+{
+	consumed = arrived;
+	presented = arrived;
+	event_to_sim.clear();
+	sim_to_present.clear();
+}
+
+const LatencyHistogram& InputLatency::getEventToSim() const
+{
+	return event_to_sim;
+}
+
+const LatencyHistogram& InputLatency::getSimToPresent() const
+{
+	return sim_to_present;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include "Constants.h"
+
+/**
+*  Counts latencies in LATENCY_BUCKET_US wide buckets.
+*  Anything past the last bucket lands in an overflow bucket, so the
+*  percentiles stay honest about the tail even if they cannot say how
+*  long it is.
+*/
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+
+	void add(double ms);
+	void clear();
+
+	long long getCount() const;
+	double getMean() const;
+	double getMax() const;
+
+	/**
+	*  The latency below which a fraction of the samples fall.
+	*  @param [in] fraction 0.5 for the median, 0.99 for the 99th percentile.
+	*  @return The upper edge of the bucket holding it, in milliseconds.
+	*/
+	double getPercentile(double fraction) const;
+
+	/**
+	*  Writes a summary line followed by every non-empty bucket.
+	*/
+	void write(std::ostream& out) const;
+
+private:
+	long long buckets[LATENCY_BUCKETS + 1];
+	long long count = 0;
+	double total_ms = 0.0;
+	double max_ms = 0.0;
+};
+
+/**
+*  Follows input events from arrival to the screen.
+*  Each event is stamped with a sequence number when its callback runs.
+*  Whatever consumes input (a simulation tick) reports the newest
+*  sequence number it has seen and when; the game reports when a frame
+*  it drew has been presented. Every event then contributes one sample
+*  to each histogram: event to sim, from arrival to the tick that
+*  consumed it, and sim to present, from that tick to the end of the
+*  first buffer swap after it was drawn.
+*  Only the game thread may call these.
+*/
+class InputLatency
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	/**
+	*  Stamps an input event.
+	*  @return The event's sequence number, counting from 1.
+	*/
+	uint32_t arrive();
+
+	/**
+	*  The newest event stamped so far, to hand to whatever consumes input.
+	*/
+	uint32_t getLatest() const;
+
+	/**
+	*  Records that every event up to sequence was consumed at when.
+	*  Events older than LATENCY_PENDING behind the newest are forgotten.
+	*/
+	void consume(uint32_t sequence, clock::time_point when);
+
+	/**
+	*  Records that the frame drawing everything consumed so far has
+	*  been presented. Call once the swap has returned.
+	*/
+	void present(clock::time_point when);
+
+	void clear();
+
+	const LatencyHistogram& getEventToSim() const;
+	const LatencyHistogram& getSimToPresent() const;
+
+private:
+	clock::time_point arrived_at[LATENCY_PENDING];
+	clock::time_point consumed_at[LATENCY_PENDING];
+	uint32_t arrived = 0;
+	uint32_t consumed = 0;
+	uint32_t presented = 0;
+
+	LatencyHistogram event_to_sim;
+	LatencyHistogram sim_to_present;
+};
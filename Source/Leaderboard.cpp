@@ -0,0 +1,553 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include "Constants.h"
+#include "Leaderboard.h"
+
+namespace
+{
+	constexpr char MAGIC[4] = { 'B', 'K', 'L', 'B' };
+	constexpr uint16_t VERSION = 1;
+	constexpr int RECORD_BATCH = 4096;
+
+	enum RecordType : uint8_t
+	{
+		ADD = 1,
+		RENAME = 2
+	};
+
+	struct LeaderboardHeader
+	{
+		char magic[4];
+		uint16_t version;
+		uint16_t record_size;
+		uint32_t snapshot_records;
+		uint32_t reserved;
+	};
+	static_assert(sizeof(LeaderboardHeader) == 16, "leaderboard header is 16 bytes");
+
+	constexpr int32_t NO_SCORE = INT32_MIN;
+
+	void copyInitials(char* out, const char* initials, int size)
+	{
+		int i = 0;
+		for (; i < 3 && initials && initials[i]; i++)
+		{
+			out[i] = initials[i];
+		}
+		for (; i < size; i++)
+		{
+			out[i] = 0;
+		}
+	}
+
+	double secondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+struct Leaderboard::Record
+{
+	uint8_t type;
+	char initials[3];
+	uint32_t id;
+	int32_t score;
+	uint32_t check;  /**< FNV-1a of the 12 bytes before it. */
+
+	void seal()
+	{
+		check = checksum();
+	}
+
+	bool isSealed() const
+	{
+		return check == checksum();
+	}
+
+	uint32_t checksum() const
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(this);
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < offsetof(Record, check); i++)
+		{
+			hash ^= bytes[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+};
+
+Leaderboard::~Leaderboard()
+{
+	close();
+}
+
+/**
+*   @brief   Opens the leaderboard
+*   @details A compaction interrupted between removing the old file and
+			 renaming the new one leaves only the new one, which is
+			 picked up here.
+*   @return  false if the file could not be written.
+*/
+bool Leaderboard::open(const std::string& file_path)
+{
+	close();
+	path = file_path;
+
+	std::string temp = path + ".tmp";
+	std::ifstream existing(path, std::ios::binary);
+	if (!existing.is_open())
+	{
+		std::rename(temp.c_str(), path.c_str());
+	}
+	existing.close();
+
+	if (!load() || appended_records > LEADERBOARD_COMPACT_RECORDS)
+	{
+		return compact();
+	}
+
+	log.open(path, std::ios::binary | std::ios::app);
+	return log.is_open();
+}
+
+void Leaderboard::close()
+{
+	if (log.is_open())
+	{
+		log.close();
+	}
+}
+
+/**
+*   @brief   Reads the log
+*   @details The snapshot is built into the tree in one pass if it is in
+			 order, as compaction writes it; the records after it are
+			 replayed one at a time. Reading stops at the first torn or
+			 inconsistent record.
+*   @return  false if the file is missing or damaged and needs
+			 rewriting.
+*/
+bool Leaderboard::load()
+{
+	tree.clear();
+	scores.clear();
+	appended_records = 0;
+
+	std::ifstream file(path, std::ios::binary);
+	LeaderboardHeader header = {};
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+		header.version != VERSION || header.record_size != sizeof(Record))
+	{
+		if (file.is_open())
+		{
+			// never overwrite what we cannot read
+			file.close();
+			std::string aside = path + ".bad";
+			std::remove(aside.c_str());
+			std::rename(path.c_str(), aside.c_str());
+		}
+		return false;
+	}
+
+	std::vector<RankEntry> snapshot;
+	snapshot.reserve(header.snapshot_records);
+	bool sorted = true;
+	bool intact = true;
+	bool torn = false;
+
+	std::vector<Record> records(RECORD_BATCH);
+	size_t got = 0;
+	size_t next = 0;
+	auto nextRecord = [&]() -> const Record*
+	{
+		if (next == got)
+		{
+			file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(Record));
+			got = (size_t)file.gcount() / sizeof(Record);
+			next = 0;
+			if (file.gcount() % sizeof(Record) != 0)
+			{
+				// torn by a crash mid write; the whole records before it still count
+				torn = true;
+			}
+			if (got == 0)
+			{
+				return nullptr;
+			}
+		}
+		const Record* record = &records[next++];
+		if (!record->isSealed())
+		{
+			intact = false;
+			return nullptr;
+		}
+		return record;
+	};
+
+	// a score's id may only be added once
+	auto claim = [this](const Record& record)
+	{
+		if (record.id < scores.size() && scores[record.id] != NO_SCORE)
+		{
+			return false;
+		}
+		if (record.id >= scores.size())
+		{
+			scores.resize((size_t)record.id + 1, NO_SCORE);
+		}
+		scores[record.id] = record.score;
+		return true;
+	};
+
+	for (uint32_t i = 0; i < header.snapshot_records; i++)
+	{
+		const Record* record = nextRecord();
+		if (!record || record->type != ADD || !claim(*record))
+		{
+			intact = false;
+			break;
+		}
+
+		RankEntry entry;
+		entry.score = record->score;
+		entry.id = record->id;
+		copyInitials(entry.initials, record->initials, sizeof(entry.initials));
+		sorted = sorted && (snapshot.empty() ||
+			ranksBefore(snapshot.back().score, snapshot.back().id, entry.score, entry.id));
+		snapshot.push_back(entry);
+	}
+
+	if (sorted)
+	{
+		tree.build(snapshot.data(), snapshot.size());
+	}
+	else
+	{
+		for (const RankEntry& entry : snapshot)
+		{
+			tree.insert(entry);
+		}
+	}
+	std::vector<RankEntry>().swap(snapshot);
+
+	while (intact)
+	{
+		const Record* record = nextRecord();
+		if (!record)
+		{
+			break;
+		}
+
+		if (record->type == ADD && claim(*record))
+		{
+			RankEntry entry;
+			entry.score = record->score;
+			entry.id = record->id;
+			copyInitials(entry.initials, record->initials, sizeof(entry.initials));
+			tree.insert(entry);
+		}
+		else if (record->type == RENAME && record->id < scores.size() &&
+			scores[record->id] != NO_SCORE)
+		{
+			RankEntry* entry = tree.find(scores[record->id], record->id);
+			copyInitials(entry->initials, record->initials, sizeof(entry->initials));
+		}
+		else
+		{
+			intact = false;
+			break;
+		}
+		appended_records++;
+	}
+	return intact && !torn;
+}
+
+uint32_t Leaderboard::add(int32_t score, const char* initials)
+{
+	RankEntry entry;
+	entry.score = score;
+	entry.id = (uint32_t)scores.size();
+	copyInitials(entry.initials, initials, sizeof(entry.initials));
+	scores.push_back(score);
+	tree.insert(entry);
+
+	Record record;
+	record.type = ADD;
+	copyInitials(record.initials, initials, sizeof(record.initials));
+	record.id = entry.id;
+	record.score = score;
+	append(record);
+	return entry.id;
+}
+
+bool Leaderboard::rename(uint32_t id, const char* initials)
+{
+	RankEntry* entry = id < scores.size() ? tree.find(scores[id], id) : nullptr;
+	if (!entry)
+	{
+		return false;
+	}
+	copyInitials(entry->initials, initials, sizeof(entry->initials));
+
+	Record record;
+	record.type = RENAME;
+	copyInitials(record.initials, initials, sizeof(record.initials));
+	record.id = id;
+	record.score = scores[id];
+	return append(record);
+}
+
+bool Leaderboard::append(const Record& record)
+{
+	static_assert(sizeof(Record) == 16, "leaderboard records are 16 bytes");
+	if (!log.is_open())
+	{
+		return false;
+	}
+
+	Record sealed = record;
+	sealed.seal();
+	log.write(reinterpret_cast<const char*>(&sealed), sizeof(sealed));
+	if (durable)
+	{
+		log.flush();
+	}
+	appended_records++;
+	return !log.fail();
+}
+
+size_t Leaderboard::rank(uint32_t id) const
+{
+	if (id >= scores.size() || scores[id] == NO_SCORE)
+	{
+		return 0;
+	}
+	return tree.rankOf(scores[id], id) + 1;
+}
+
+size_t Leaderboard::size() const
+{
+	return tree.size();
+}
+
+void Leaderboard::range(size_t first_rank, int count, std::vector<RankEntry>& out) const
+{
+	out.resize(count > 0 ? (size_t)count : 0);
+	int copied = first_rank > 0 ? tree.range(first_rank - 1, count, out.data()) : 0;
+	out.resize((size_t)copied);
+}
+
+/**
+*   @brief   Compacts the log
+*   @details Writes every score in rank order to a new file beside the
+			 old one, then swaps it in. Renames are folded into the
+			 scores they changed.
+*   @return  false if the new file could not be written.
+*/
+bool Leaderboard::compact()
+{
+	close();
+	std::string temp = path + ".tmp";
+	std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+	if (file.is_open())
+	{
+		LeaderboardHeader header = {};
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.record_size = sizeof(Record);
+		header.snapshot_records = (uint32_t)tree.size();
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		std::vector<Record> batch;
+		batch.reserve(RECORD_BATCH);
+		tree.forEach([&](const RankEntry& entry)
+		{
+			Record record;
+			record.type = ADD;
+			copyInitials(record.initials, entry.initials, sizeof(record.initials));
+			record.id = entry.id;
+			record.score = entry.score;
+			record.seal();
+			batch.push_back(record);
+			if (batch.size() == RECORD_BATCH)
+			{
+				file.write(reinterpret_cast<const char*>(batch.data()), batch.size() * sizeof(Record));
+				batch.clear();
+			}
+		});
+		file.write(reinterpret_cast<const char*>(batch.data()), batch.size() * sizeof(Record));
+		file.close();
+	}
+
+	bool written = !file.fail();
+	if (written)
+	{
+		// rename will not replace an existing file everywhere
+		std::remove(path.c_str());
+		written = std::rename(temp.c_str(), path.c_str()) == 0;
+	}
+	else
+	{
+		std::remove(temp.c_str());
+	}
+	if (written)
+	{
+		appended_records = 0;
+	}
+
+	log.open(path, std::ios::binary | std::ios::app);
+	return written && log.is_open();
+}
+
+void Leaderboard::setDurable(bool flush_each)
+{
+	durable = flush_each;
+	if (durable && log.is_open())
+	{
+		log.flush();
+	}
+}
+
+long long Leaderboard::getAppendedRecords() const
+{
+	return appended_records;
+}
+
+const RankTree& Leaderboard::getTree() const
+{
+	return tree;
+}
+
+/**
+*   @brief   Benchmarks the leaderboard.
+*   @details Scores are drawn from a narrow range so there are plenty of
+			 ties for the id ordering to settle.
+*   @return  The timings.
+*/
+LeaderboardBenchReport runLeaderboardBenchmark(long long entries, uint32_t seed,
+	const std::string& path)
+{
+	using clock = std::chrono::steady_clock;
+	LeaderboardBenchReport report;
+	report.entries = entries;
+
+	std::vector<RankEntry> all((size_t)entries);
+	uint32_t random = seed;
+	for (long long i = 0; i < entries; i++)
+	{
+		random = random * 1664525u + 1013904223u;
+		all[i].score = (int32_t)(random >> 12) % 200000;
+		all[i].id = (uint32_t)i;
+		copyInitials(all[i].initials, "BEN", sizeof(all[i].initials));
+	}
+
+	{
+		RankTree tree;
+		auto start = clock::now();
+		for (const RankEntry& entry : all)
+		{
+			tree.insert(entry);
+		}
+		report.insert_ns = entries ? secondsSince(start) * 1e9 / entries : 0.0;
+		report.tree_bytes = tree.memoryUsage();
+		report.height = tree.getHeight();
+
+		const int queries = 1000000;
+		size_t checksum = 0;
+		start = clock::now();
+		for (int i = 0; i < queries && entries; i++)
+		{
+			random = random * 1664525u + 1013904223u;
+			const RankEntry& entry = all[random % entries];
+			checksum += tree.rankOf(entry.score, entry.id);
+		}
+		report.rank_ns = secondsSince(start) * 1e9 / queries + (checksum == 1 ? 1e-9 : 0.0);
+
+		RankEntry page[100];
+		const int reads = 1000;
+		start = clock::now();
+		for (int i = 0; i < reads; i++)
+		{
+			tree.range(0, 100, page);
+		}
+		report.top_us = secondsSince(start) * 1e6 / reads;
+		start = clock::now();
+		for (int i = 0; i < reads; i++)
+		{
+			tree.range((size_t)entries / 2, 100, page);
+		}
+		report.range_us = secondsSince(start) * 1e6 / reads;
+
+		// check a sample of ranks and the top page against a sorted copy
+		std::vector<RankEntry> sorted = all;
+		auto order = [](const RankEntry& a, const RankEntry& b)
+		{
+			return ranksBefore(a.score, a.id, b.score, b.id);
+		};
+		std::sort(sorted.begin(), sorted.end(), order);
+		for (int i = 0; i < 1000 && entries; i++)
+		{
+			random = random * 1664525u + 1013904223u;
+			const RankEntry& entry = all[random % entries];
+			size_t expected = std::lower_bound(sorted.begin(), sorted.end(), entry, order) - sorted.begin();
+			report.mismatches += tree.rankOf(entry.score, entry.id) != expected;
+		}
+		int top = tree.range(0, 100, page);
+		for (int i = 0; i < top; i++)
+		{
+			report.mismatches += page[i].id != sorted[i].id;
+		}
+	}
+
+	// the same scores through the log
+	std::remove(path.c_str());
+	{
+		Leaderboard board;
+		board.open(path);
+		long long durable = entries < 100000 ? entries : 100000;
+		auto start = clock::now();
+		for (long long i = 0; i < durable; i++)
+		{
+			board.add(all[i].score, all[i].initials);
+		}
+		report.append_ns = durable ? secondsSince(start) * 1e9 / durable : 0.0;
+
+		board.setDurable(false);
+		for (long long i = durable; i < entries; i++)
+		{
+			board.add(all[i].score, all[i].initials);
+		}
+		board.setDurable(true);
+
+		start = clock::now();
+		board.compact();
+		report.compact_seconds = secondsSince(start);
+	}
+
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	report.log_bytes = file.is_open() ? (long long)file.tellg() : 0;
+	file.close();
+
+	{
+		Leaderboard board;
+		auto start = clock::now();
+		board.open(path);
+		report.load_seconds = secondsSince(start);
+		report.mismatches += (long long)board.size() != entries;
+		for (int i = 0; i < 1000 && entries; i++)
+		{
+			random = random * 1664525u + 1013904223u;
+			uint32_t id = (uint32_t)(random % entries);
+			report.mismatches += board.rank(id) != board.getTree().rankOf(all[id].score, id) + 1;
+		}
+	}
+	std::remove(path.c_str());
+	return report;
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "RankTree.h"
+
+/*! \file Leaderboard.h
+@brief   Persistent leaderboard.
+@details The file is a 16 byte header ("BKLB", version, record size,
+         snapshot record count) followed by 16 byte records. The first
+         snapshot records are ADDs already in rank order, written by the
+         last compaction; everything after them was appended since, in
+         the order it happened. Each record carries a checksum, so a
+         record torn by a crash is spotted and dropped. All integers are
+         little endian.
+*/
+
+/**
+*  Every score ever set, ranked.
+*  Scores are kept in a RankTree, so adding one and asking where it
+*  ranked are O(log n) however many there are. Each change is appended
+*  to the log rather than rewriting the file; once the appended part
+*  outgrows LEADERBOARD_COMPACT_RECORDS the file is compacted into a
+*  sorted snapshot, which loads in one pass without any tree inserts.
+*/
+class Leaderboard
+{
+public:
+	Leaderboard() = default;
+	~Leaderboard();
+
+	Leaderboard(const Leaderboard&) = delete;
+	Leaderboard& operator=(const Leaderboard&) = delete;
+
+	/**
+	*  Loads the log, compacting it first if it is due or damaged, and
+	*  opens it for appending.
+	*  @param [in] path The log file; created if missing.
+	*  @return false if the file could not be written.
+	*/
+	bool open(const std::string& path);
+	void close();
+
+	/**
+	*  Records a score.
+	*  @param [in] score The score.
+	*  @param [in] initials Up to three letters.
+	*  @return The score's id.
+	*/
+	uint32_t add(int32_t score, const char* initials);
+
+	/**
+	*  Changes the initials a score was recorded with.
+	*  @return false if there is no such score.
+	*/
+	bool rename(uint32_t id, const char* initials);
+
+	/**
+	*  Where a score ranks.
+	*  @return 1 for the top score, 0 if there is no such score.
+	*/
+	size_t rank(uint32_t id) const;
+	size_t size() const;
+
+	/**
+	*  Copies scores in rank order, e.g. rank 1 onwards for the top ten.
+	*  @param [in] first_rank 1-based rank of the first score.
+	*  @param [in] count Most scores to copy.
+	*  @param [out] out Receives them.
+	*/
+	void range(size_t first_rank, int count, std::vector<RankEntry>& out) const;
+
+	/**
+	*  Rewrites the log as a sorted snapshot.
+	*  @return false if the new file could not be written; the old one
+	*          is kept.
+	*/
+	bool compact();
+
+	/**
+	*  Flushes every record as it is written, the default, so a score
+	*  survives a crash. Bulk imports can turn it off.
+	*/
+	void setDurable(bool durable);
+
+	long long getAppendedRecords() const;  /**< Records since the last compaction. */
+	const RankTree& getTree() const;
+
+private:
+	struct Record;
+
+	bool load();
+	bool append(const Record& record);
+
+	std::string path;
+	std::ofstream log;
+	RankTree tree;
+	std::vector<int32_t> scores;  /**< By id, to find an entry's key. */
+	long long appended_records = 0;
+	bool durable = true;
+};
+
+/**
+*  Results of filling a leaderboard and querying it.
+*/
+struct LeaderboardBenchReport
+{
+	long long entries = 0;
+	double insert_ns = 0.0;       /**< Per score, tree only. */
+	double rank_ns = 0.0;         /**< Per rank query. */
+	double top_us = 0.0;          /**< Reading the top hundred. */
+	double range_us = 0.0;        /**< Reading a hundred from the middle. */
+	double append_ns = 0.0;       /**< Per score added through the log, flushed. */
+	double compact_seconds = 0.0;
+	double load_seconds = 0.0;    /**< Reopening the compacted log. */
+	long long log_bytes = 0;
+	size_t tree_bytes = 0;
+	int height = 0;
+	long long mismatches = 0;     /**< Ranks that disagreed with a sorted copy. */
+};
+
+/**
+*   @brief   Benchmarks the leaderboard.
+*   @details Inserts random scores into a tree and times rank and range
+             queries, checking a sample of ranks against a sorted copy.
+             Then writes the same scores through a log at path, times
+             compacting it and loading it back, and deletes it.
+*   @param   [in] entries How many scores.
+*   @param   [in] seed Seeds the scores.
+*   @param   [in] path Scratch file for the log.
+*   @return  The timings.
+*/
+LeaderboardBenchReport runLeaderboardBenchmark(long long entries, uint32_t seed,
+	const std::string& path);
@@ -0,0 +1,385 @@
+#include <atomic>
+#include <chrono>
+
+#include "Constants.h"
+#include "JobSystem.h"
+#include "LevelGenerator.h"
+
+namespace
+{
+	// how the drop chances are split, picked per level
+	constexpr DropTable DROP_PROFILES[] =
+	{
+		{ 51, 8 },   // the classic one gem in five
+		{ 26, 10 },  // sparse gems, more power ups
+		{ 77, 5 },   // gem rain
+		{ 40, 0 },   // no power ups
+	};
+	constexpr int NUM_DROP_PROFILES = sizeof(DROP_PROFILES) / sizeof(DROP_PROFILES[0]);
+
+	enum Colouring
+	{
+		CHECKER = 0,
+		ROW_STRIPES,
+		COLUMN_STRIPES,
+		SCATTERED,
+		NUM_COLOURINGS
+	};
+
+	// cells per batch in runLevelBatch
+	constexpr int LEVEL_BATCH_SIZE = 1024;
+
+	/**
+	*  SplitMix64: tiny, fast and fully specified, so every platform gets
+	*  the same stream from the same seed.
+	*/
+	struct Random
+	{
+		uint64_t state;
+
+		uint64_t next()
+		{
+			uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		uint32_t below(uint32_t bound)
+		{
+			// the top bits are the best mixed; bound is always tiny
+			return (uint32_t)(((next() >> 32) * bound) >> 32);
+		}
+	};
+
+	uint64_t mix(uint64_t value)
+	{
+		Random random = { value };
+		return random.next();
+	}
+
+	/**
+	*  Scales the base density by the curve's shape at a cell, both out
+	*  of 256, with a floor so no row is left entirely bare.
+	*/
+	int cellDensity(const Level& level, int row, int column)
+	{
+		int last_row = level.rows > 1 ? level.rows - 1 : 1;
+		int last_column = level.columns > 1 ? level.columns - 1 : 1;
+		int shape = 256;
+		switch (level.curve)
+		{
+		case DensityCurve::TOP_HEAVY:
+			shape = 256 - 192 * row / last_row;
+			break;
+		case DensityCurve::BOTTOM_HEAVY:
+			shape = 64 + 192 * row / last_row;
+			break;
+		case DensityCurve::PYRAMID:
+		{
+			int offset = 2 * column - last_column;
+			shape = 256 - 192 * (offset < 0 ? -offset : offset) / last_column;
+			break;
+		}
+		case DensityCurve::WAVES:
+			shape = (row / 2) % 2 ? 96 : 256;
+			break;
+		default:
+			break;
+		}
+
+		int density = 24 + level.density * shape / 256;
+		return density < 256 ? density : 256;
+	}
+
+	BlockType colourOf(int colouring, int row, int column, Random& random)
+	{
+		int pick = 0;
+		switch (colouring)
+		{
+		case CHECKER:
+			pick = (row + column) % 2;
+			break;
+		case ROW_STRIPES:
+			pick = row % 2;
+			break;
+		case COLUMN_STRIPES:
+			pick = column % 2;
+			break;
+		default:
+			pick = (int)random.below(2);
+			break;
+		}
+		return pick ? BlockType::BLUE : BlockType::RED;
+	}
+
+	/**
+	*  Puts a block in a cell and its mirror, rolling what it drops.
+	*/
+	void placeBlock(Level& level, int row, int column, int colouring,
+		int power_up_cap, Random& random)
+	{
+		int mirror = level.columns - 1 - column;
+		int copies = level.mirrored && mirror != column ? 2 : 1;
+
+		BlockType type = colourOf(colouring, row, column, random);
+		BlockDrop drop = BlockDrop::NONE;
+		uint32_t roll = random.below(256);
+		if (roll < level.drops.power_up && level.power_up_count + copies <= power_up_cap)
+		{
+			type = BlockType::POWER_UP;
+			drop = BlockDrop::POWER_UP;
+			level.power_up_count += copies;
+		}
+		else if (roll < (uint32_t)level.drops.power_up + level.drops.gem)
+		{
+			drop = BlockDrop::GEM;
+		}
+
+		int cells[2] = { row * level.columns + column, row * level.columns + mirror };
+		for (int i = 0; i < copies; i++)
+		{
+			level.types[cells[i]] = (uint8_t)type;
+			level.block_drops[cells[i]] = (uint8_t)drop;
+			level.block_count++;
+		}
+	}
+
+	void resetLevel(Level& level, uint64_t seed, int columns, int rows)
+	{
+		level.seed = seed;
+		level.columns = columns > 0 ? columns : 0;
+		level.rows = rows > 0 ? rows : 0;
+		level.curve = DensityCurve::FLAT;
+		level.density = 0;
+		level.mirrored = false;
+		level.drops = DropTable();
+		level.gem_interval = 0;
+		level.block_count = 0;
+		level.power_up_count = 0;
+		level.types.assign((size_t)level.columns * level.rows, (uint8_t)BlockType::EMPTY);
+		level.block_drops.assign((size_t)level.columns * level.rows, (uint8_t)BlockDrop::NONE);
+	}
+
+	int powerUpCap(const Level& level)
+	{
+		int cap = level.columns * level.rows * LEVEL_POWER_UP_PERCENT / 100;
+		return cap > 1 ? cap : 1;
+	}
+
+	void fnv1a(uint64_t& hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+}
+
+LevelLayout levelLayout(const Level& level)
+{
+	LevelLayout layout;
+	layout.columns = level.columns;
+	layout.rows = level.rows;
+	layout.gem_interval = level.gem_interval;
+	layout.block_count = level.block_count;
+	layout.power_up_count = level.power_up_count;
+	layout.types = level.types.data();
+	layout.block_drops = level.block_drops.data();
+	return layout;
+}
+
+/**
+*   @brief   Generates a level from a seed.
+*   @details The settings are drawn first, in a fixed order, then the
+			 cells row by row; with mirroring only the left half (and
+			 the middle column) is rolled.
+*   @return  void
+*/
+void generateLevel(uint64_t seed, int columns, int rows, Level& level)
+{
+	resetLevel(level, seed, columns, rows);
+	Random random = { seed };
+	level.curve = (DensityCurve)random.below((uint32_t)DensityCurve::NUM_CURVES);
+	level.density = (uint8_t)(96 + random.below(144));
+	level.mirrored = random.below(2) != 0;
+	level.drops = DROP_PROFILES[random.below(NUM_DROP_PROFILES)];
+	int colouring = (int)random.below(NUM_COLOURINGS);
+	int power_up_cap = powerUpCap(level);
+
+	int rolled_columns = level.mirrored ? (level.columns + 1) / 2 : level.columns;
+	for (int row = 0; row < level.rows; row++)
+	{
+		for (int column = 0; column < rolled_columns; column++)
+		{
+			if ((int)random.below(256) < cellDensity(level, row, column))
+			{
+				placeBlock(level, row, column, colouring, power_up_cap, random);
+			}
+		}
+	}
+
+	// top up a sparse roll by walking the empty cells from a random start
+	int cells = level.columns * level.rows;
+	int minimum = (cells * LEVEL_MIN_BLOCK_PERCENT + 99) / 100;
+	int rolled_cells = level.rows * rolled_columns;
+	int start = rolled_cells ? (int)random.below((uint32_t)rolled_cells) : 0;
+	for (int i = 0; i < rolled_cells && level.block_count < minimum; i++)
+	{
+		int cell = (start + i) % rolled_cells;
+		int row = cell / rolled_columns;
+		int column = cell % rolled_columns;
+		if (level.types[row * level.columns + column] == (uint8_t)BlockType::EMPTY)
+		{
+			placeBlock(level, row, column, colouring, power_up_cap, random);
+		}
+	}
+}
+
+const char* validateLevel(const Level& level)
+{
+	size_t cells = (size_t)level.columns * level.rows;
+	if (cells == 0)
+	{
+		return "empty grid";
+	}
+	if (level.types.size() != cells || level.block_drops.size() != cells)
+	{
+		return "cell buffers do not match the grid";
+	}
+
+	int blocks = 0;
+	int power_ups = 0;
+	for (size_t i = 0; i < cells; i++)
+	{
+		uint8_t type = level.types[i];
+		uint8_t drop = level.block_drops[i];
+		if (type > (uint8_t)BlockType::POWER_UP || drop > (uint8_t)BlockDrop::POWER_UP)
+		{
+			return "unknown block type or drop";
+		}
+		if (type == (uint8_t)BlockType::EMPTY && drop != (uint8_t)BlockDrop::NONE)
+		{
+			return "empty cell drops something";
+		}
+		if ((type == (uint8_t)BlockType::POWER_UP) != (drop == (uint8_t)BlockDrop::POWER_UP))
+		{
+			return "power up block and drop disagree";
+		}
+		if (level.mirrored)
+		{
+			size_t mirror = i - i % level.columns + (level.columns - 1 - i % level.columns);
+			if (level.types[mirror] != type || level.block_drops[mirror] != drop)
+			{
+				return "mirrored level is not symmetric";
+			}
+		}
+		blocks += type != (uint8_t)BlockType::EMPTY;
+		power_ups += drop == (uint8_t)BlockDrop::POWER_UP;
+	}
+
+	if (blocks != level.block_count || power_ups != level.power_up_count)
+	{
+		return "counts do not match the cells";
+	}
+	if (level.seed != 0 && blocks * 100 < (int)cells * LEVEL_MIN_BLOCK_PERCENT)
+	{
+		return "too few blocks";
+	}
+	if (level.seed != 0 && power_ups > powerUpCap(level))
+	{
+		return "too many power ups";
+	}
+	return nullptr;
+}
+
+uint64_t levelHash(const Level& level)
+{
+	uint64_t hash = 14695981039346656037ull;
+	int32_t header[] = { level.columns, level.rows, (int32_t)level.curve, level.density,
+		level.mirrored, level.drops.gem, level.drops.power_up, level.gem_interval };
+	fnv1a(hash, &level.seed, sizeof(level.seed));
+	fnv1a(hash, header, sizeof(header));
+	fnv1a(hash, level.types.data(), level.types.size());
+	fnv1a(hash, level.block_drops.data(), level.block_drops.size());
+	return hash;
+}
+
+uint64_t dailySeed(int year, int month, int day)
+{
+	uint64_t date = (uint64_t)year * 10000 + (uint64_t)month * 100 + (uint64_t)day;
+	uint64_t seed = mix(date ^ 0x4441494C59ull);  // "DAILY"
+	return seed ? seed : 1;
+}
+
+uint64_t endlessSeed(uint64_t run_seed, int level_number)
+{
+	uint64_t seed = mix(run_seed + 0x9E3779B97F4A7C15ull * (uint64_t)(level_number + 1));
+	return seed ? seed : 1;
+}
+
+/**
+*   @brief   Generates and validates a run of seeds.
+*   @details Each batch keeps its own level buffers and counts, so the
+			 only shared writes are a handful of atomic adds per batch.
+*   @return  The results.
+*/
+LevelBatchReport runLevelBatch(uint64_t first_seed, long long count, JobSystem& jobs)
+{
+	LevelBatchReport report;
+	report.levels = count;
+	report.workers = jobs.getWorkerCount();
+
+	std::atomic<long long> invalid{ 0 };
+	std::atomic<long long> unstable{ 0 };
+	std::atomic<uint64_t> checksum{ 0 };
+
+	auto start = std::chrono::steady_clock::now();
+	long long batches = (count + LEVEL_BATCH_SIZE - 1) / LEVEL_BATCH_SIZE;
+	JobGraph graph;
+	graph.addStage((int)batches, 1, [&](int begin, int end)
+	{
+		Level level;
+		Level again;
+		long long batch_invalid = 0;
+		long long batch_unstable = 0;
+		uint64_t batch_checksum = 0;
+		for (long long batch = begin; batch < end; batch++)
+		{
+			long long first = batch * LEVEL_BATCH_SIZE;
+			long long last = first + LEVEL_BATCH_SIZE < count ? first + LEVEL_BATCH_SIZE : count;
+			for (long long i = first; i < last; i++)
+			{
+				uint64_t seed = first_seed + (uint64_t)i;
+				generateLevel(seed, BLOCKS_PER_ROW, BLOCK_ROWS, level);
+				generateLevel(seed, BLOCKS_PER_ROW, BLOCK_ROWS, again);
+
+				uint64_t hash = levelHash(level);
+				batch_invalid += validateLevel(level) != nullptr;
+				batch_unstable += hash != levelHash(again);
+				batch_checksum ^= hash;
+			}
+		}
+		invalid += batch_invalid;
+		unstable += batch_unstable;
+		checksum ^= batch_checksum;
+	});
+	jobs.run(graph);
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	report.invalid = invalid;
+	report.unstable = unstable;
+	report.checksum = checksum;
+
+	// one large level, after a warm up so the buffers are already sized
+	Level large;
+	generateLevel(first_seed, 100, 100, large);
+	auto large_start = std::chrono::steady_clock::now();
+	generateLevel(first_seed + 1, 100, 100, large);
+	report.large_level_us = std::chrono::duration<double, std::micro>(
+		std::chrono::steady_clock::now() - large_start).count();
+	report.invalid += validateLevel(large) != nullptr;
+	return report;
+}
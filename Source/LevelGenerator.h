@@ -0,0 +1,160 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+/**
+*  What a cell of a level holds; picks the block's texture.
+*/
+enum class BlockType : uint8_t
+{
+	EMPTY = 0,
+	RED = 1,
+	BLUE = 2,
+	POWER_UP = 3
+};
+
+/**
+*  What a block releases when it is destroyed.
+*/
+enum class BlockDrop : uint8_t
+{
+	NONE = 0,
+	GEM = 1,
+	POWER_UP = 2
+};
+
+/**
+*  How a level's blocks thin out across the grid.
+*/
+enum class DensityCurve : uint8_t
+{
+	FLAT = 0,
+	TOP_HEAVY,
+	BOTTOM_HEAVY,
+	PYRAMID,
+	WAVES,
+	NUM_CURVES
+};
+
+/**
+*  Chances out of 256 that a block carries each drop.
+*/
+struct DropTable
+{
+	uint8_t gem = 0;
+	uint8_t power_up = 0;
+};
+
+/**
+*  A block layout, row by row from the top left.
+*/
+struct Level
+{
+	uint64_t seed = 0;
+	int columns = 0;
+	int rows = 0;
+	DensityCurve curve = DensityCurve::FLAT;
+	uint8_t density = 0;         /**< Base chance out of 256 that a cell holds a block. */
+	bool mirrored = false;       /**< The right half mirrors the left. */
+	DropTable drops;
+	int gem_interval = 0;        /**< Every nth block destroyed drops a gem instead, 0 to use the drops. */
+	int block_count = 0;
+	int power_up_count = 0;
+	std::vector<uint8_t> types;  /**< BlockType per cell. */
+	std::vector<uint8_t> block_drops;  /**< BlockDrop per cell. */
+};
+
+/**
+*  A read only view of a level's cells, all the simulation needs to lay
+*  one out. The campaign's levels are baked into the binary as these;
+*  a generated Level lends one over its buffers.
+*/
+struct LevelLayout
+{
+	int columns = 0;
+	int rows = 0;
+	int gem_interval = 0;  /**< As Level::gem_interval. */
+	int block_count = 0;
+	int power_up_count = 0;
+	const uint8_t* types = nullptr;        /**< BlockType per cell. */
+	const uint8_t* block_drops = nullptr;  /**< BlockDrop per cell. */
+};
+
+/**
+*   @brief   Views a level's cells
+*   @return  A layout valid until the level is next changed.
+*/
+LevelLayout levelLayout(const Level& level);
+
+/**
+*   @brief   Generates a level from a seed.
+*   @details Only integer maths on fixed width types and a generator of
+             our own are used, never the standard library's
+             distributions, so a seed builds the same level on every
+             machine, compiler and build. The seed picks a density
+             curve, a base density, a colouring, whether the layout is
+             mirrored and a drop table, then every cell is rolled
+             against the curve. Sparse rolls are topped up to
+             LEVEL_MIN_BLOCK_PERCENT and power ups are capped at
+             LEVEL_POWER_UP_PERCENT of the cells.
+*   @param   [in] seed Any value; the same seed gives the same level.
+*   @param   [in] columns,rows The grid's size.
+*   @param   [out] level Filled in; its buffers are reused.
+*   @return  void
+*/
+void generateLevel(uint64_t seed, int columns, int rows, Level& level);
+
+/**
+*   @brief   Checks a level is playable and consistent.
+*   @return  nullptr if it is, otherwise what is wrong with it.
+*/
+const char* validateLevel(const Level& level);
+
+/**
+*   @brief   Hashes a level's layout and settings.
+*   @return  A 64-bit FNV-1a hash, equal across machines for equal levels.
+*/
+uint64_t levelHash(const Level& level);
+
+/**
+*   @brief   The seed of a day's challenge level.
+*   @details Everyone playing on the same date gets the same level.
+*   @return  The seed.
+*/
+uint64_t dailySeed(int year, int month, int day);
+
+/**
+*   @brief   The seed of a level in an endless run.
+*   @param   [in] run_seed The run's own seed.
+*   @param   [in] level_number Levels cleared so far in the run.
+*   @return  The seed.
+*/
+uint64_t endlessSeed(uint64_t run_seed, int level_number);
+
+/**
+*  Results of generating and validating a batch of seeds.
+*/
+struct LevelBatchReport
+{
+	long long levels = 0;
+	long long invalid = 0;       /**< Levels that failed validation. */
+	long long unstable = 0;      /**< Seeds that built a different level the second time. */
+	uint64_t checksum = 0;       /**< XOR of every level's hash, independent of order. */
+	double seconds = 0.0;
+	int workers = 0;
+	double large_level_us = 0.0; /**< Time to build one 100 x 100 level. */
+};
+
+/**
+*   @brief   Generates and validates a run of seeds.
+*   @details Seeds first_seed to first_seed + count - 1 are spread over
+             the job system's workers; each is built twice, validated
+             and hashed.
+*   @param   [in] first_seed The first seed.
+*   @param   [in] count How many seeds.
+*   @param   [in] jobs Runs the batches.
+*   @return  The results.
+*/
+LevelBatchReport runLevelBatch(uint64_t first_seed, long long count, JobSystem& jobs);
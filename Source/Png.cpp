@@ -0,0 +1,819 @@
+#include <cstring>
+
+#include "Png.h"
+
+namespace
+{
+	const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+	// deflate's length and distance codes: the smallest value each
+	// stands for and the extra bits that follow it
+	const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+		31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+		2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+		193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+		6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	// the order code length code lengths are stored in
+	const uint8_t CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13,
+		2, 14, 1, 15 };
+
+	constexpr int MAX_BITS = 15;
+	constexpr int WINDOW = 32768;
+	constexpr int MIN_MATCH = 3;
+	constexpr int MAX_MATCH = 258;
+	constexpr int HASH_BITS = 15;
+
+	uint32_t crc_table[256];
+	bool crc_ready = false;
+
+	uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+	{
+		if (!crc_ready)
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t value = i;
+				for (int bit = 0; bit < 8; bit++)
+				{
+					value = value & 1 ? 0xedb88320u ^ (value >> 1) : value >> 1;
+				}
+				crc_table[i] = value;
+			}
+			crc_ready = true;
+		}
+
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+		{
+			crc = crc_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	uint32_t adler32(const uint8_t* data, size_t size)
+	{
+		// 5552 bytes is the most that can be summed before b could overflow
+		uint32_t a = 1;
+		uint32_t b = 0;
+		while (size > 0)
+		{
+			size_t block = size < 5552 ? size : 5552;
+			size -= block;
+			for (size_t i = 0; i < block; i++)
+			{
+				a += data[i];
+				b += a;
+			}
+			data += block;
+			a %= 65521;
+			b %= 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	uint32_t readBigEndian(const uint8_t* data)
+	{
+		return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+	}
+
+	void writeBigEndian(std::vector<uint8_t>& out, uint32_t value)
+	{
+		out.push_back((uint8_t)(value >> 24));
+		out.push_back((uint8_t)(value >> 16));
+		out.push_back((uint8_t)(value >> 8));
+		out.push_back((uint8_t)value);
+	}
+
+	/**
+	*  Reads deflate's bit stream, least significant bit first. Reading
+	*  past the end gives zeros and sets overrun.
+	*/
+	struct BitReader
+	{
+		const uint8_t* data;
+		size_t size;
+		size_t position = 0;
+		uint32_t buffer = 0;
+		int count = 0;
+		bool overrun = false;
+
+		uint32_t bits(int wanted)
+		{
+			while (count < wanted)
+			{
+				uint32_t byte = 0;
+				if (position < size)
+				{
+					byte = data[position++];
+				}
+				else
+				{
+					overrun = true;
+				}
+				buffer |= byte << count;
+				count += 8;
+			}
+			uint32_t value = buffer & ((1u << wanted) - 1);
+			buffer >>= wanted;
+			count -= wanted;
+			return value;
+		}
+
+		void alignToByte()
+		{
+			buffer = 0;
+			count = 0;
+		}
+	};
+
+	/**
+	*  A canonical Huffman code, held as how many codes there are of
+	*  each length and the symbols in code order.
+	*/
+	struct Huffman
+	{
+		uint16_t counts[MAX_BITS + 1];
+		uint16_t symbols[288];
+
+		/**
+		*  @return false if the lengths over subscribe the code.
+		*/
+		bool build(const uint8_t* lengths, int symbol_count)
+		{
+			std::memset(counts, 0, sizeof(counts));
+			for (int i = 0; i < symbol_count; i++)
+			{
+				counts[lengths[i]]++;
+			}
+			counts[0] = 0;
+
+			int left = 1;
+			uint16_t offsets[MAX_BITS + 1] = {};
+			for (int length = 1; length <= MAX_BITS; length++)
+			{
+				left = (left << 1) - counts[length];
+				if (left < 0)
+				{
+					return false;
+				}
+				if (length < MAX_BITS)
+				{
+					offsets[length + 1] = (uint16_t)(offsets[length] + counts[length]);
+				}
+			}
+			for (int i = 0; i < symbol_count; i++)
+			{
+				if (lengths[i] != 0)
+				{
+					symbols[offsets[lengths[i]]++] = (uint16_t)i;
+				}
+			}
+			return true;
+		}
+
+		/**
+		*  @return The next symbol, or -1 for a code that is not in use.
+		*/
+		int decode(BitReader& in) const
+		{
+			int code = 0;
+			int first = 0;
+			int index = 0;
+			for (int length = 1; length <= MAX_BITS; length++)
+			{
+				code |= (int)in.bits(1);
+				int count = counts[length];
+				if (code - first < count)
+				{
+					return symbols[index + code - first];
+				}
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+	};
+
+	bool inflateCodes(BitReader& in, const Huffman& literals, const Huffman& distances,
+		std::vector<uint8_t>& out)
+	{
+		for (;;)
+		{
+			int symbol = literals.decode(in);
+			if (symbol < 0 || in.overrun)
+			{
+				return false;
+			}
+			if (symbol < 256)
+			{
+				out.push_back((uint8_t)symbol);
+				continue;
+			}
+			if (symbol == 256)
+			{
+				return true;
+			}
+
+			symbol -= 257;
+			if (symbol >= 29)
+			{
+				return false;
+			}
+			int length = LENGTH_BASE[symbol] + (int)in.bits(LENGTH_EXTRA[symbol]);
+			int code = distances.decode(in);
+			if (code < 0 || code >= 30)
+			{
+				return false;
+			}
+			size_t distance = DISTANCE_BASE[code] + in.bits(DISTANCE_EXTRA[code]);
+			if (distance > out.size())
+			{
+				return false;
+			}
+			// byte by byte, since a match may overlap what it copies
+			size_t from = out.size() - distance;
+			for (int i = 0; i < length; i++)
+			{
+				out.push_back(out[from + i]);
+			}
+		}
+	}
+
+	bool inflateDynamic(BitReader& in, std::vector<uint8_t>& out)
+	{
+		int literal_count = (int)in.bits(5) + 257;
+		int distance_count = (int)in.bits(5) + 1;
+		int code_length_count = (int)in.bits(4) + 4;
+		if (literal_count > 286 || distance_count > 30)
+		{
+			return false;
+		}
+
+		uint8_t lengths[320] = {};
+		for (int i = 0; i < code_length_count; i++)
+		{
+			lengths[CODE_LENGTH_ORDER[i]] = (uint8_t)in.bits(3);
+		}
+		Huffman code_lengths;
+		if (!code_lengths.build(lengths, 19))
+		{
+			return false;
+		}
+
+		std::memset(lengths, 0, sizeof(lengths));
+		int total = literal_count + distance_count;
+		for (int i = 0; i < total;)
+		{
+			int symbol = code_lengths.decode(in);
+			if (symbol < 0 || in.overrun)
+			{
+				return false;
+			}
+			if (symbol < 16)
+			{
+				lengths[i++] = (uint8_t)symbol;
+				continue;
+			}
+
+			uint8_t repeat_length = 0;
+			int repeat = 0;
+			if (symbol == 16)
+			{
+				if (i == 0)
+				{
+					return false;
+				}
+				repeat_length = lengths[i - 1];
+				repeat = 3 + (int)in.bits(2);
+			}
+			else if (symbol == 17)
+			{
+				repeat = 3 + (int)in.bits(3);
+			}
+			else
+			{
+				repeat = 11 + (int)in.bits(7);
+			}
+			if (i + repeat > total)
+			{
+				return false;
+			}
+			while (repeat--)
+			{
+				lengths[i++] = repeat_length;
+			}
+		}
+
+		Huffman literals;
+		Huffman distances;
+		return lengths[256] != 0 && literals.build(lengths, literal_count) &&
+			distances.build(lengths + literal_count, distance_count) &&
+			inflateCodes(in, literals, distances, out);
+	}
+
+	bool inflateFixed(BitReader& in, std::vector<uint8_t>& out)
+	{
+		static Huffman literals;
+		static Huffman distances;
+		static bool built = false;
+		if (!built)
+		{
+			uint8_t lengths[288];
+			for (int i = 0; i < 288; i++)
+			{
+				lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+			}
+			literals.build(lengths, 288);
+			for (int i = 0; i < 30; i++)
+			{
+				lengths[i] = 5;
+			}
+			distances.build(lengths, 30);
+			built = true;
+		}
+		return inflateCodes(in, literals, distances, out);
+	}
+
+	/**
+	*  Writes deflate's bit stream, least significant bit first.
+	*/
+	struct BitWriter
+	{
+		std::vector<uint8_t>& out;
+		uint32_t buffer = 0;
+		int count = 0;
+
+		void bits(uint32_t value, int length)
+		{
+			buffer |= value << count;
+			count += length;
+			while (count >= 8)
+			{
+				out.push_back((uint8_t)buffer);
+				buffer >>= 8;
+				count -= 8;
+			}
+		}
+
+		// Huffman codes go most significant bit first
+		void code(uint32_t value, int length)
+		{
+			uint32_t reversed = 0;
+			for (int i = 0; i < length; i++)
+			{
+				reversed = (reversed << 1) | ((value >> i) & 1);
+			}
+			bits(reversed, length);
+		}
+
+		void flush()
+		{
+			if (count > 0)
+			{
+				out.push_back((uint8_t)buffer);
+			}
+			buffer = 0;
+			count = 0;
+		}
+	};
+
+	void writeLiteral(BitWriter& out, int symbol)
+	{
+		if (symbol < 144)
+		{
+			out.code(0x30 + symbol, 8);
+		}
+		else if (symbol < 256)
+		{
+			out.code(0x190 + symbol - 144, 9);
+		}
+		else if (symbol < 280)
+		{
+			out.code(symbol - 256, 7);
+		}
+		else
+		{
+			out.code(0xc0 + symbol - 280, 8);
+		}
+	}
+
+	void writeMatch(BitWriter& out, int length, int distance)
+	{
+		int code = 28;
+		while (LENGTH_BASE[code] > length)
+		{
+			code--;
+		}
+		writeLiteral(out, 257 + code);
+		out.bits(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+		code = 29;
+		while (DISTANCE_BASE[code] > distance)
+		{
+			code--;
+		}
+		out.code(code, 5);
+		out.bits(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+	}
+
+	int paeth(int left, int up, int up_left)
+	{
+		int estimate = left + up - up_left;
+		int to_left = estimate > left ? estimate - left : left - estimate;
+		int to_up = estimate > up ? estimate - up : up - estimate;
+		int to_up_left = estimate > up_left ? estimate - up_left : up_left - estimate;
+		if (to_left <= to_up && to_left <= to_up_left)
+		{
+			return left;
+		}
+		return to_up <= to_up_left ? up : up_left;
+	}
+
+	/**
+	*  Applies (or, undoing, reverses) a row filter in place.
+	*/
+	bool filterRow(int filter, uint8_t* row, const uint8_t* previous, size_t stride,
+		int bytes_per_pixel, bool undo)
+	{
+		for (size_t i = 0; i < stride; i++)
+		{
+			int left = i >= (size_t)bytes_per_pixel ? row[i - bytes_per_pixel] : 0;
+			int up = previous ? previous[i] : 0;
+			int up_left = previous && i >= (size_t)bytes_per_pixel ? previous[i - bytes_per_pixel] : 0;
+			int predicted = 0;
+			switch (filter)
+			{
+			case 0:
+				break;
+			case 1:
+				predicted = left;
+				break;
+			case 2:
+				predicted = up;
+				break;
+			case 3:
+				predicted = (left + up) / 2;
+				break;
+			case 4:
+				predicted = paeth(left, up, up_left);
+				break;
+			default:
+				return false;
+			}
+			row[i] = (uint8_t)(undo ? row[i] + predicted : row[i] - predicted);
+		}
+		return true;
+	}
+
+	/**
+	*  Filters a row of the original pixels into out, since filtering
+	*  reads the unfiltered neighbours.
+	*/
+	void filterInto(int filter, const uint8_t* row, const uint8_t* previous, size_t stride,
+		uint8_t* out)
+	{
+		for (size_t i = 0; i < stride; i++)
+		{
+			int left = i >= 4 ? row[i - 4] : 0;
+			int up = previous ? previous[i] : 0;
+			int up_left = previous && i >= 4 ? previous[i - 4] : 0;
+			int predicted = filter == 1 ? left : filter == 2 ? up :
+				filter == 3 ? (left + up) / 2 : filter == 4 ? paeth(left, up, up_left) : 0;
+			out[i] = (uint8_t)(row[i] - predicted);
+		}
+	}
+
+	void writeChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data)
+	{
+		writeBigEndian(out, (uint32_t)data.size());
+		size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		writeBigEndian(out, crc32(out.data() + start, out.size() - start));
+	}
+}
+
+/**
+*   @brief   Unpacks a zlib stream
+*   @return  false if it is damaged or its checksum is wrong.
+*/
+bool inflateZlib(const uint8_t* compressed, size_t size, std::vector<uint8_t>& out)
+{
+	out.clear();
+	if (size < 6 || (compressed[0] & 0x0f) != 8 ||
+		((compressed[0] << 8) | compressed[1]) % 31 != 0 || (compressed[1] & 0x20))
+	{
+		return false;
+	}
+
+	BitReader in = { compressed + 2, size - 2 };
+	bool last = false;
+	while (!last)
+	{
+		last = in.bits(1) != 0;
+		uint32_t type = in.bits(2);
+		bool ok = false;
+		if (type == 0)
+		{
+			in.alignToByte();
+			if (in.position + 4 > in.size)
+			{
+				return false;
+			}
+			const uint8_t* header = in.data + in.position;
+			uint32_t length = header[0] | header[1] << 8;
+			uint32_t check = header[2] | header[3] << 8;
+			in.position += 4;
+			ok = (length ^ 0xffff) == check && in.position + length <= in.size;
+			if (ok)
+			{
+				out.insert(out.end(), in.data + in.position, in.data + in.position + length);
+				in.position += length;
+			}
+		}
+		else if (type == 1)
+		{
+			ok = inflateFixed(in, out);
+		}
+		else if (type == 2)
+		{
+			ok = inflateDynamic(in, out);
+		}
+		if (!ok || in.overrun)
+		{
+			return false;
+		}
+	}
+
+	in.alignToByte();
+	return in.position + 4 <= in.size &&
+		readBigEndian(in.data + in.position) == adler32(out.data(), out.size());
+}
+
+/**
+*   @brief   Packs bytes into a zlib stream
+*   @details Greedy LZ77 against the most recent earlier position
+			 with the same three bytes, in a single fixed Huffman
+			 block. Far from the best deflate, but the padding and
+			 flat colour of an atlas, and the unchanged runs of a
+			 captured frame, compress well with it.
+*   @return  void
+*/
+void deflateZlib(const uint8_t* data, size_t length, std::vector<uint8_t>& out, std::vector<int>& head)
+{
+	out.clear();
+	out.push_back(0x78);
+	out.push_back(0x01);
+
+	BitWriter writer = { out };
+	writer.bits(1, 1);
+	writer.bits(1, 2);
+
+	head.assign((size_t)1 << HASH_BITS, -1);
+	const int size = (int)length;
+	auto hash = [data](int at)
+	{
+		uint32_t value = (uint32_t)data[at] << 16 | (uint32_t)data[at + 1] << 8 | data[at + 2];
+		return (value * 2654435761u) >> (32 - HASH_BITS);
+	};
+
+	int at = 0;
+	while (at < size)
+	{
+		int best = 0;
+		int best_distance = 0;
+		if (at + MIN_MATCH <= size)
+		{
+			uint32_t slot = hash(at);
+			int candidate = head[slot];
+			head[slot] = at;
+			if (candidate >= 0 && at - candidate <= WINDOW)
+			{
+				int limit = size - at < MAX_MATCH ? size - at : MAX_MATCH;
+				while (best < limit && data[candidate + best] == data[at + best])
+				{
+					best++;
+				}
+				best_distance = at - candidate;
+			}
+		}
+
+		if (best >= MIN_MATCH)
+		{
+			writeMatch(writer, best, best_distance);
+			// the skipped positions still seed later matches
+			for (int i = at + 1; i < at + best && i + MIN_MATCH <= size; i++)
+			{
+				head[hash(i)] = i;
+			}
+			at += best;
+		}
+		else
+		{
+			writeLiteral(writer, data[at]);
+			at++;
+		}
+	}
+	writeLiteral(writer, 256);
+	writer.flush();
+	writeBigEndian(out, adler32(data, length));
+}
+
+/**
+*   @brief   Decodes a PNG
+*   @details Checks every chunk's CRC, joins the image data, inflates it,
+			 reverses each row's filter and widens whatever the colour
+			 type is to RGBA.
+*   @return  true if the image was decoded.
+*/
+bool decodePng(const std::vector<uint8_t>& bytes, Image& image, std::string& error)
+{
+	if (bytes.size() < 8 || std::memcmp(bytes.data(), SIGNATURE, 8) != 0)
+	{
+		error = "not a PNG";
+		return false;
+	}
+
+	int width = 0;
+	int height = 0;
+	int colour_type = -1;
+	std::vector<uint8_t> compressed;
+	uint8_t palette[256][4] = {};
+	size_t at = 8;
+	bool ended = false;
+	while (!ended)
+	{
+		if (at + 12 > bytes.size())
+		{
+			error = "truncated chunk";
+			return false;
+		}
+		uint32_t length = readBigEndian(&bytes[at]);
+		if (length > bytes.size() - at - 12)
+		{
+			error = "truncated chunk";
+			return false;
+		}
+		const uint8_t* type = &bytes[at + 4];
+		const uint8_t* data = type + 4;
+		if (crc32(type, length + 4) != readBigEndian(data + length))
+		{
+			error = "chunk CRC mismatch";
+			return false;
+		}
+
+		if (std::memcmp(type, "IHDR", 4) == 0 && length >= 13)
+		{
+			width = (int)readBigEndian(data);
+			height = (int)readBigEndian(data + 4);
+			colour_type = data[9];
+			if (data[8] != 8 || data[12] != 0 || data[10] != 0 || data[11] != 0)
+			{
+				error = "only 8 bit, non-interlaced images are supported";
+				return false;
+			}
+		}
+		else if (std::memcmp(type, "PLTE", 4) == 0)
+		{
+			for (uint32_t i = 0; i < length / 3 && i < 256; i++)
+			{
+				palette[i][0] = data[i * 3];
+				palette[i][1] = data[i * 3 + 1];
+				palette[i][2] = data[i * 3 + 2];
+				palette[i][3] = 255;
+			}
+		}
+		else if (std::memcmp(type, "tRNS", 4) == 0 && colour_type == 3)
+		{
+			for (uint32_t i = 0; i < length && i < 256; i++)
+			{
+				palette[i][3] = data[i];
+			}
+		}
+		else if (std::memcmp(type, "IDAT", 4) == 0)
+		{
+			compressed.insert(compressed.end(), data, data + length);
+		}
+		else if (std::memcmp(type, "IEND", 4) == 0)
+		{
+			ended = true;
+		}
+		at += length + 12;
+	}
+
+	int channels = colour_type == 0 ? 1 : colour_type == 2 ? 3 : colour_type == 3 ? 1 :
+		colour_type == 4 ? 2 : colour_type == 6 ? 4 : 0;
+	if (width <= 0 || height <= 0 || width > 16384 || height > 16384 || channels == 0)
+	{
+		error = "bad or missing header";
+		return false;
+	}
+
+	std::vector<uint8_t> raw;
+	if (!inflateZlib(compressed.data(), compressed.size(), raw))
+	{
+		error = "damaged image data";
+		return false;
+	}
+	size_t stride = (size_t)width * channels;
+	if (raw.size() < (stride + 1) * height)
+	{
+		error = "image data too short";
+		return false;
+	}
+
+	image.width = width;
+	image.height = height;
+	image.pixels.resize((size_t)width * height * 4);
+	for (int y = 0; y < height; y++)
+	{
+		uint8_t* row = &raw[y * (stride + 1) + 1];
+		const uint8_t* previous = y > 0 ? row - stride - 1 : nullptr;
+		if (!filterRow(row[-1], row, previous, stride, channels, true))
+		{
+			error = "unknown row filter";
+			return false;
+		}
+
+		uint8_t* pixel = &image.pixels[(size_t)y * width * 4];
+		for (int x = 0; x < width; x++, pixel += 4)
+		{
+			const uint8_t* source = row + x * channels;
+			switch (colour_type)
+			{
+			case 0:
+				pixel[0] = pixel[1] = pixel[2] = source[0];
+				pixel[3] = 255;
+				break;
+			case 2:
+				std::memcpy(pixel, source, 3);
+				pixel[3] = 255;
+				break;
+			case 3:
+				std::memcpy(pixel, palette[source[0]], 4);
+				break;
+			case 4:
+				pixel[0] = pixel[1] = pixel[2] = source[0];
+				pixel[3] = source[1];
+				break;
+			default:
+				std::memcpy(pixel, source, 4);
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+void encodePng(const Image& image, std::vector<uint8_t>& bytes)
+{
+	size_t stride = (size_t)image.width * 4;
+	std::vector<uint8_t> raw((stride + 1) * image.height);
+	std::vector<uint8_t> trial(stride);
+	for (int y = 0; y < image.height; y++)
+	{
+		const uint8_t* row = &image.pixels[y * stride];
+		const uint8_t* previous = y > 0 ? row - stride : nullptr;
+		uint8_t* out = &raw[y * (stride + 1)];
+
+		// the filter leaving the smallest values usually compresses best
+		long best_cost = -1;
+		for (int filter = 0; filter <= 4; filter++)
+		{
+			filterInto(filter, row, previous, stride, trial.data());
+			long cost = 0;
+			for (uint8_t value : trial)
+			{
+				cost += value < 128 ? value : 256 - value;
+			}
+			if (best_cost < 0 || cost < best_cost)
+			{
+				best_cost = cost;
+				out[0] = (uint8_t)filter;
+				std::memcpy(out + 1, trial.data(), stride);
+			}
+		}
+	}
+
+	bytes.assign(SIGNATURE, SIGNATURE + 8);
+	std::vector<uint8_t> header;
+	writeBigEndian(header, (uint32_t)image.width);
+	writeBigEndian(header, (uint32_t)image.height);
+	header.push_back(8);  // bit depth
+	header.push_back(6);  // RGBA
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	writeChunk(bytes, "IHDR", header);
+
+	std::vector<uint8_t> compressed;
+	std::vector<int> head;
+	deflateZlib(raw.data(), raw.size(), compressed, head);
+	writeChunk(bytes, "IDAT", compressed);
+	writeChunk(bytes, "IEND", std::vector<uint8_t>());
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*! \file Png.h
+@brief   Just enough PNG for the offline tools and software renderer.
+@details Reads non-interlaced 8 bit greyscale, RGB, palette and alpha
+         images, and writes RGBA, with an inflate and a fixed Huffman
+         deflate of our own so neither needs an image library; frame
+         capture uses the same zlib streams. The GL game never decodes
+         a PNG itself; the engine does that.
+*/
+
+/**
+*  Pixels, RGBA8 row by row from the top left.
+*/
+struct Image
+{
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+/**
+*   @brief   Decodes a PNG
+*   @param   [in] bytes The file.
+*   @param   [out] image Receives the pixels, converted to RGBA.
+*   @param   [out] error Describes what went wrong on failure.
+*   @return  true if the image was decoded.
+*/
+bool decodePng(const std::vector<uint8_t>& bytes, Image& image, std::string& error);
+
+/**
+*   @brief   Encodes a PNG
+*   @details Each row gets whichever filter leaves the smallest values,
+             then the lot is compressed as one fixed Huffman block.
+*   @param   [in] image The pixels.
+*   @param   [out] bytes Receives the file.
+*   @return  void
+*/
+void encodePng(const Image& image, std::vector<uint8_t>& bytes);
+
+/**
+*   @brief   Packs bytes into a zlib stream.
+*   @param   [in] data,length What to pack.
+*   @param   [out] out Receives the stream; cleared first.
+*   @param   [in,out] head Working space, kept between calls so they
+             need not allocate.
+*   @return  void
+*/
+void deflateZlib(const uint8_t* data, size_t length, std::vector<uint8_t>& out, std::vector<int>& head);
+
+/**
+*   @brief   Unpacks a zlib stream.
+*   @param   [out] out Receives the bytes; cleared first.
+*   @return  false if it is damaged or its checksum is wrong.
+*/
+bool inflateZlib(const uint8_t* compressed, size_t size, std::vector<uint8_t>& out);
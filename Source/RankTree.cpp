@@ -0,0 +1,417 @@
+#include "RankTree.h"
+
+namespace
+{
+	// bulk built nodes are left this full, out of 4
+	constexpr int BUILD_FILL_QUARTERS = 3;
+}
+
+void RankTree::clear()
+{
+	leaves.clear();
+	inners.clear();
+	root = NONE;
+	leftmost = NONE;
+	height = 0;
+	count = 0;
+}
+
+/**
+*   @brief   Picks the child a key belongs under
+*   @details The last child whose first key does not rank after it. The
+			 first child's key is never compared, so it only has to be
+			 right once the child is split off to the right of another.
+*   @return  The child's slot.
+*/
+int RankTree::childFor(const Inner& node, int32_t score, uint32_t id)
+{
+	int low = 1;
+	int high = node.count;
+	while (low < high)
+	{
+		int middle = (low + high) / 2;
+		if (ranksBefore(score, id, node.first_score[middle], node.first_id[middle]))
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle + 1;
+		}
+	}
+	return low - 1;
+}
+
+/**
+*   @return  How many of the leaf's entries rank ahead of the key.
+*/
+int RankTree::positionIn(const Leaf& leaf, int32_t score, uint32_t id)
+{
+	int low = 0;
+	int high = leaf.count;
+	while (low < high)
+	{
+		int middle = (low + high) / 2;
+		const RankEntry& entry = leaf.entries[middle];
+		if (ranksBefore(entry.score, entry.id, score, id))
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return low;
+}
+
+/**
+*   @brief   Inserts an entry
+*   @details Every size on the way down is counted up first. A full leaf
+			 splits in half and hands its new right sibling to its
+			 parent, which may split in turn; a split root grows the
+			 tree by a level.
+*   @return  void
+*/
+void RankTree::insert(const RankEntry& entry)
+{
+	if (root == NONE)
+	{
+		leaves.emplace_back();
+		root = 0;
+		leftmost = 0;
+		height = 0;
+	}
+
+	uint32_t path[MAX_HEIGHT + 1];
+	int slots[MAX_HEIGHT + 1];
+	uint32_t node = root;
+	for (int level = height; level > 0; level--)
+	{
+		Inner& inner = inners[node];
+		int slot = childFor(inner, entry.score, entry.id);
+		inner.sizes[slot]++;
+		path[level] = node;
+		slots[level] = slot;
+		node = inner.children[slot];
+	}
+	count++;
+
+	Leaf* leaf = &leaves[node];
+	int position = positionIn(*leaf, entry.score, entry.id);
+	if (leaf->count < LEAF_SIZE)
+	{
+		for (int i = leaf->count; i > position; i--)
+		{
+			leaf->entries[i] = leaf->entries[i - 1];
+		}
+		leaf->entries[position] = entry;
+		leaf->count++;
+		return;
+	}
+
+	RankEntry all[LEAF_SIZE + 1];
+	for (int i = 0, j = 0; i <= LEAF_SIZE; i++)
+	{
+		all[i] = i == position ? entry : leaf->entries[j++];
+	}
+
+	uint32_t right = (uint32_t)leaves.size();
+	leaves.emplace_back();
+	leaf = &leaves[node];
+	Leaf& sibling = leaves[right];
+	int keep = (LEAF_SIZE + 1) / 2;
+	leaf->count = keep;
+	sibling.count = LEAF_SIZE + 1 - keep;
+	for (int i = 0; i < keep; i++)
+	{
+		leaf->entries[i] = all[i];
+	}
+	for (int i = 0; i < sibling.count; i++)
+	{
+		sibling.entries[i] = all[keep + i];
+	}
+	sibling.next = leaf->next;
+	leaf->next = right;
+
+	insertChild(path, slots, 1, right, sibling.entries[0], (uint32_t)sibling.count);
+}
+
+/**
+*   @brief   Adds a split off node to its parent
+*   @details The new child goes straight after the one it split from,
+			 whose size loses what moved across.
+*   @return  void
+*/
+void RankTree::insertChild(const uint32_t* path, const int* slots, int level,
+	uint32_t child, const RankEntry& first, uint32_t child_size)
+{
+	if (level > height)
+	{
+		// the root split: a new root above the two halves
+		uint32_t old_root = root;
+		uint32_t old_size = (uint32_t)(count - child_size);
+		root = (uint32_t)inners.size();
+		inners.emplace_back();
+		Inner& top = inners[root];
+		top.count = 2;
+		top.children[0] = old_root;
+		top.sizes[0] = old_size;
+		top.first_score[0] = 0;
+		top.first_id[0] = 0;
+		top.children[1] = child;
+		top.sizes[1] = child_size;
+		top.first_score[1] = first.score;
+		top.first_id[1] = first.id;
+		height++;
+		return;
+	}
+
+	uint32_t node = path[level];
+	int slot = slots[level] + 1;
+	inners[node].sizes[slot - 1] -= child_size;
+	if (inners[node].count < INNER_SIZE)
+	{
+		Inner& inner = inners[node];
+		for (int i = inner.count; i > slot; i--)
+		{
+			inner.children[i] = inner.children[i - 1];
+			inner.sizes[i] = inner.sizes[i - 1];
+			inner.first_score[i] = inner.first_score[i - 1];
+			inner.first_id[i] = inner.first_id[i - 1];
+		}
+		inner.children[slot] = child;
+		inner.sizes[slot] = child_size;
+		inner.first_score[slot] = first.score;
+		inner.first_id[slot] = first.id;
+		inner.count++;
+		return;
+	}
+
+	// full: split it around the new child
+	uint32_t right = (uint32_t)inners.size();
+	inners.emplace_back();
+	Inner& inner = inners[node];
+	Inner& sibling = inners[right];
+
+	uint32_t children[INNER_SIZE + 1];
+	uint32_t sizes[INNER_SIZE + 1];
+	int32_t scores[INNER_SIZE + 1];
+	uint32_t ids[INNER_SIZE + 1];
+	for (int i = 0, j = 0; i <= INNER_SIZE; i++)
+	{
+		if (i == slot)
+		{
+			children[i] = child;
+			sizes[i] = child_size;
+			scores[i] = first.score;
+			ids[i] = first.id;
+		}
+		else
+		{
+			children[i] = inner.children[j];
+			sizes[i] = inner.sizes[j];
+			scores[i] = inner.first_score[j];
+			ids[i] = inner.first_id[j];
+			j++;
+		}
+	}
+
+	int keep = (INNER_SIZE + 1) / 2;
+	inner.count = keep;
+	sibling.count = INNER_SIZE + 1 - keep;
+	uint32_t moved = 0;
+	for (int i = 0; i <= INNER_SIZE; i++)
+	{
+		Inner& target = i < keep ? inner : sibling;
+		int k = i < keep ? i : i - keep;
+		target.children[k] = children[i];
+		target.sizes[k] = sizes[i];
+		target.first_score[k] = scores[i];
+		target.first_id[k] = ids[i];
+		moved += i < keep ? 0 : sizes[i];
+	}
+
+	RankEntry sibling_first;
+	sibling_first.score = sibling.first_score[0];
+	sibling_first.id = sibling.first_id[0];
+	insertChild(path, slots, level + 1, right, sibling_first, moved);
+}
+
+RankEntry* RankTree::find(int32_t score, uint32_t id)
+{
+	if (root == NONE)
+	{
+		return nullptr;
+	}
+
+	uint32_t node = root;
+	for (int level = height; level > 0; level--)
+	{
+		const Inner& inner = inners[node];
+		node = inner.children[childFor(inner, score, id)];
+	}
+	Leaf& leaf = leaves[node];
+	int position = positionIn(leaf, score, id);
+	if (position < leaf.count && leaf.entries[position].score == score &&
+		leaf.entries[position].id == id)
+	{
+		return &leaf.entries[position];
+	}
+	return nullptr;
+}
+
+size_t RankTree::rankOf(int32_t score, uint32_t id) const
+{
+	if (root == NONE)
+	{
+		return 0;
+	}
+
+	size_t rank = 0;
+	uint32_t node = root;
+	for (int level = height; level > 0; level--)
+	{
+		const Inner& inner = inners[node];
+		int slot = childFor(inner, score, id);
+		for (int i = 0; i < slot; i++)
+		{
+			rank += inner.sizes[i];
+		}
+		node = inner.children[slot];
+	}
+	return rank + positionIn(leaves[node], score, id);
+}
+
+/**
+*   @brief   Copies entries in rank order
+*   @details Walks down by subtree size to the first entry's leaf, then
+			 along the leaf chain.
+*   @return  How many were copied.
+*/
+int RankTree::range(size_t first, int wanted, RankEntry* out) const
+{
+	if (root == NONE || first >= count || wanted <= 0)
+	{
+		return 0;
+	}
+
+	uint32_t node = root;
+	for (int level = height; level > 0; level--)
+	{
+		const Inner& inner = inners[node];
+		int slot = 0;
+		while (slot < inner.count - 1 && first >= inner.sizes[slot])
+		{
+			first -= inner.sizes[slot];
+			slot++;
+		}
+		node = inner.children[slot];
+	}
+
+	int copied = 0;
+	int position = (int)first;
+	for (uint32_t leaf = node; leaf != NONE && copied < wanted; leaf = leaves[leaf].next)
+	{
+		for (; position < leaves[leaf].count && copied < wanted; position++)
+		{
+			out[copied++] = leaves[leaf].entries[position];
+		}
+		position = 0;
+	}
+	return copied;
+}
+
+/**
+*   @brief   Builds the tree from sorted entries
+*   @details Fills the leaves left to right, then builds each level of
+			 inner nodes over the one below until a single node is left.
+*   @return  void
+*/
+void RankTree::build(const RankEntry* sorted, size_t total)
+{
+	clear();
+	if (total == 0)
+	{
+		return;
+	}
+
+	const size_t leaf_fill = LEAF_SIZE * BUILD_FILL_QUARTERS / 4;
+	size_t leaf_count = (total + leaf_fill - 1) / leaf_fill;
+	leaves.resize(leaf_count);
+	for (size_t i = 0; i < leaf_count; i++)
+	{
+		Leaf& leaf = leaves[i];
+		size_t begin = i * total / leaf_count;
+		size_t end = (i + 1) * total / leaf_count;
+		leaf.count = (int)(end - begin);
+		for (size_t j = begin; j < end; j++)
+		{
+			leaf.entries[j - begin] = sorted[j];
+		}
+		leaf.next = i + 1 < leaf_count ? (uint32_t)(i + 1) : NONE;
+	}
+	count = total;
+	leftmost = 0;
+
+	// each level: the node, its entry count and its first key
+	struct Child
+	{
+		uint32_t node;
+		uint32_t size;
+		int32_t score;
+		uint32_t id;
+	};
+	std::vector<Child> level(leaf_count);
+	for (size_t i = 0; i < leaf_count; i++)
+	{
+		level[i] = { (uint32_t)i, (uint32_t)leaves[i].count,
+			leaves[i].entries[0].score, leaves[i].entries[0].id };
+	}
+
+	const size_t inner_fill = INNER_SIZE * BUILD_FILL_QUARTERS / 4;
+	height = 0;
+	while (level.size() > 1)
+	{
+		size_t parents = (level.size() + inner_fill - 1) / inner_fill;
+		std::vector<Child> above(parents);
+		for (size_t i = 0; i < parents; i++)
+		{
+			size_t begin = i * level.size() / parents;
+			size_t end = (i + 1) * level.size() / parents;
+			uint32_t index = (uint32_t)inners.size();
+			inners.emplace_back();
+			Inner& inner = inners[index];
+			inner.count = (int)(end - begin);
+			uint32_t size = 0;
+			for (size_t j = begin; j < end; j++)
+			{
+				int k = (int)(j - begin);
+				inner.children[k] = level[j].node;
+				inner.sizes[k] = level[j].size;
+				inner.first_score[k] = level[j].score;
+				inner.first_id[k] = level[j].id;
+				size += level[j].size;
+			}
+			above[i] = { index, size, level[begin].score, level[begin].id };
+		}
+		level.swap(above);
+		height++;
+	}
+	root = level[0].node;
+}
+
+size_t RankTree::size() const
+{
+	return count;
+}
+
+int RankTree::getHeight() const
+{
+	return height;
+}
+
+size_t RankTree::memoryUsage() const
+{
+	return leaves.capacity() * sizeof(Leaf) + inners.capacity() * sizeof(Inner);
+}
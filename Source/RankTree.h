@@ -0,0 +1,130 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+*  One score on the leaderboard.
+*  Higher scores rank first; equal scores rank in the order they were
+*  set, so ids are handed out in that order.
+*/
+struct RankEntry
+{
+	int32_t score = 0;
+	uint32_t id = 0;
+	char initials[4] = {};  /**< Three letters and a terminator. */
+};
+
+/**
+*   @return  True if the first key ranks ahead of the second.
+*/
+inline bool ranksBefore(int32_t score, uint32_t id, int32_t other_score, uint32_t other_id)
+{
+	return score > other_score || (score == other_score && id < other_id);
+}
+
+/**
+*  Order statistic B+ tree of leaderboard entries.
+*  Leaves hold up to LEAF_SIZE entries in rank order and are chained
+*  left to right; inner nodes hold up to INNER_SIZE children along with
+*  each child's first key and how many entries lie beneath it. Insert,
+*  rank and find descend one path and select sums sizes on the way
+*  down, so all are O(log n), and reading k entries from a rank is
+*  O(log n + k) along the leaf chain. Nodes live in two flat arrays and
+*  refer to each other by index, which keeps ten million entries to
+*  about 20 bytes each with no per-entry allocation.
+*/
+class RankTree
+{
+public:
+	static constexpr int LEAF_SIZE = 64;
+	static constexpr int INNER_SIZE = 64;
+
+	RankTree() = default;
+
+	void clear();
+
+	/**
+	*  Adds an entry. Its score and id must not already be in the tree.
+	*/
+	void insert(const RankEntry& entry);
+
+	/**
+	*  Finds an entry by its key.
+	*  @return The entry, or nullptr. Valid until the next insert.
+	*/
+	RankEntry* find(int32_t score, uint32_t id);
+
+	/**
+	*  Counts the entries that rank ahead of a key.
+	*  @return The key's 0-based rank, whether or not it is in the tree.
+	*/
+	size_t rankOf(int32_t score, uint32_t id) const;
+
+	/**
+	*  Copies entries in rank order.
+	*  @param [in] first 0-based rank of the first entry.
+	*  @param [in] count Most entries to copy.
+	*  @param [out] out Room for count entries.
+	*  @return How many were copied.
+	*/
+	int range(size_t first, int count, RankEntry* out) const;
+
+	/**
+	*  Replaces the contents with entries already in rank order.
+	*  Nodes are left three quarters full so later inserts rarely split.
+	*  O(n), against O(n log n) for inserting them one at a time.
+	*/
+	void build(const RankEntry* sorted, size_t count);
+
+	/**
+	*  Calls function with every entry, in rank order.
+	*/
+	template <typename Function>
+	void forEach(Function function) const
+	{
+		for (uint32_t leaf = leftmost; leaf != NONE; leaf = leaves[leaf].next)
+		{
+			for (int i = 0; i < leaves[leaf].count; i++)
+			{
+				function(leaves[leaf].entries[i]);
+			}
+		}
+	}
+
+	size_t size() const;
+	int getHeight() const;       /**< Inner levels above the leaves. */
+	size_t memoryUsage() const;  /**< Bytes held by the node arrays. */
+
+private:
+	static constexpr uint32_t NONE = 0xffffffffu;
+	static constexpr int MAX_HEIGHT = 16;
+
+	struct Leaf
+	{
+		int count = 0;
+		uint32_t next = NONE;
+		RankEntry entries[LEAF_SIZE];
+	};
+
+	struct Inner
+	{
+		int count = 0;
+		uint32_t children[INNER_SIZE];
+		uint32_t sizes[INNER_SIZE];        /**< Entries beneath each child. */
+		int32_t first_score[INNER_SIZE];   /**< Each child's first key. */
+		uint32_t first_id[INNER_SIZE];
+	};
+
+	static int childFor(const Inner& node, int32_t score, uint32_t id);
+	static int positionIn(const Leaf& leaf, int32_t score, uint32_t id);
+	void insertChild(const uint32_t* path, const int* slots, int level,
+		uint32_t child, const RankEntry& first, uint32_t child_size);
+
+	std::vector<Leaf> leaves;
+	std::vector<Inner> inners;
+	uint32_t root = NONE;
+	uint32_t leftmost = NONE;
+	int height = 0;
+	size_t count = 0;
+};
@@ -0,0 +1,227 @@
+#include "RasterKernels.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RASTER_SSE 1
+#include <emmintrin.h>
+#else
+#define RASTER_SSE 0
+#endif
+
+namespace
+{
+	inline float clamp(float value, float low, float high)
+	{
+		return value < low ? low : value > high ? high : value;
+	}
+
+	/**
+	*   @brief   Blends one pixel over another
+	*   @details Alpha 255 is stretched to 256 so an opaque pixel replaces
+				 what is under it outright.
+	*   @return  void
+	*/
+	inline void blendPixel(uint8_t* target, const int colour[4])
+	{
+		int weight = colour[3] + (colour[3] >> 7);
+		for (int c = 0; c < 3; c++)
+		{
+			target[c] = (uint8_t)((colour[c] * weight + target[c] * (256 - weight)) >> 8);
+		}
+		target[3] = 255;
+	}
+}
+
+/**
+*   @brief   Draws a textured span, bilinear filtered, tinted and blended.
+*   @details Both texel pairs are blended vertically first, then the
+			 result horizontally, each step rounding down to 8 bits, the
+			 same as the SSE version does.
+*   @return  void
+*/
+void drawSpanScalar(uint8_t* target, int first, int count, const SpanSampler& sampler)
+{
+	for (int i = 0; i < count; i++)
+	{
+		float u = clamp(sampler.u + (float)(first + i) * sampler.du, sampler.min_u, sampler.max_u);
+		float v = clamp(sampler.v + (float)(first + i) * sampler.dv, sampler.min_v, sampler.max_v);
+		int x = (int)u;
+		int y = (int)v;
+		int fx = (int)((u - (float)x) * 256.0f);
+		int fy = (int)((v - (float)y) * 256.0f);
+
+		const uint8_t* top = sampler.texels + ((size_t)y * sampler.pitch + x) * 4;
+		const uint8_t* bottom = top + (size_t)sampler.pitch * 4;
+		int colour[4];
+		for (int c = 0; c < 4; c++)
+		{
+			int left = (top[c] * (256 - fy) + bottom[c] * fy) >> 8;
+			int right = (top[c + 4] * (256 - fy) + bottom[c + 4] * fy) >> 8;
+			int texel = (left * (256 - fx) + right * fx) >> 8;
+			colour[c] = (texel * sampler.tint[c]) >> 8;
+		}
+		blendPixel(target + (size_t)(first + i) * 4, colour);
+	}
+}
+
+void fillSpanScalar(uint8_t* target, int count, const uint16_t colour[4])
+{
+	const int solid[4] = { colour[0], colour[1], colour[2], colour[3] > 255 ? 255 : colour[3] };
+	for (int i = 0; i < count; i++)
+	{
+		blendPixel(target + (size_t)i * 4, solid);
+	}
+}
+
+#if RASTER_SSE
+
+namespace
+{
+	/**
+	*   @brief   Samples one texel's neighbourhood
+	*   @details The two texels of each row are loaded together as eight
+				 16 bit lanes, blended vertically, then the right texel's
+				 half is weighted and added onto the left's.
+	*   @return  The filtered texel in the low four lanes.
+	*/
+	inline __m128i sampleTexel(const uint8_t* top, size_t row, int fx, int fy)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i upper = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(top)), zero);
+		__m128i lower = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(top + row)), zero);
+		__m128i vertical = _mm_srli_epi16(_mm_add_epi16(
+			_mm_mullo_epi16(upper, _mm_set1_epi16((short)(256 - fy))),
+			_mm_mullo_epi16(lower, _mm_set1_epi16((short)fy))), 8);
+
+		__m128i weights = _mm_unpacklo_epi64(_mm_set1_epi16((short)(256 - fx)), _mm_set1_epi16((short)fx));
+		__m128i weighted = _mm_mullo_epi16(vertical, weights);
+		return _mm_srli_epi16(_mm_add_epi16(weighted, _mm_srli_si128(weighted, 8)), 8);
+	}
+
+	/**
+	*   @brief   Blends two pixels over two target pixels
+	*   @details Each operand holds two pixels as eight 16 bit lanes; each
+				 pixel's alpha is spread across its lanes as its weight.
+	*   @return  The blended pixels, still 16 bits a channel.
+	*/
+	inline __m128i blendPair(__m128i source, __m128i target)
+	{
+		__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(source, _MM_SHUFFLE(3, 3, 3, 3)),
+			_MM_SHUFFLE(3, 3, 3, 3));
+		__m128i weight = _mm_add_epi16(alpha, _mm_srli_epi16(alpha, 7));
+		return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(source, weight),
+			_mm_mullo_epi16(target, _mm_sub_epi16(_mm_set1_epi16(256), weight))), 8);
+	}
+}
+
+/**
+*   @brief   Draws a textured span, bilinear filtered, tinted and blended.
+*   @details Four pixels at a time: their texel coordinates and weights
+			 are worked out together in float lanes, each is filtered
+			 across its colour channels, and the four are tinted and
+			 blended as two pairs, one register each.
+*   @return  void
+*/
+void drawSpan(uint8_t* target, int first, int count, const SpanSampler& sampler)
+{
+	const __m128 steps = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	const __m128 u = _mm_set1_ps(sampler.u), du = _mm_set1_ps(sampler.du);
+	const __m128 v = _mm_set1_ps(sampler.v), dv = _mm_set1_ps(sampler.dv);
+	const __m128 min_u = _mm_set1_ps(sampler.min_u), max_u = _mm_set1_ps(sampler.max_u);
+	const __m128 min_v = _mm_set1_ps(sampler.min_v), max_v = _mm_set1_ps(sampler.max_v);
+	const __m128 fraction = _mm_set1_ps(256.0f);
+	const __m128i tint = _mm_setr_epi16(sampler.tint[0], sampler.tint[1], sampler.tint[2], sampler.tint[3],
+		sampler.tint[0], sampler.tint[1], sampler.tint[2], sampler.tint[3]);
+	const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+	const __m128i zero = _mm_setzero_si128();
+	const size_t row = (size_t)sampler.pitch * 4;
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		// exact small integers, so this matches the scalar version's float maths
+		__m128 pixel = _mm_add_ps(_mm_set1_ps((float)(first + i)), steps);
+		__m128 su = _mm_min_ps(_mm_max_ps(_mm_add_ps(u, _mm_mul_ps(pixel, du)), min_u), max_u);
+		__m128 sv = _mm_min_ps(_mm_max_ps(_mm_add_ps(v, _mm_mul_ps(pixel, dv)), min_v), max_v);
+		__m128i x = _mm_cvttps_epi32(su);
+		__m128i y = _mm_cvttps_epi32(sv);
+		__m128i fx = _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(su, _mm_cvtepi32_ps(x)), fraction));
+		__m128i fy = _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(sv, _mm_cvtepi32_ps(y)), fraction));
+
+		alignas(16) int xs[4], ys[4], fxs[4], fys[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(xs), x);
+		_mm_store_si128(reinterpret_cast<__m128i*>(ys), y);
+		_mm_store_si128(reinterpret_cast<__m128i*>(fxs), fx);
+		_mm_store_si128(reinterpret_cast<__m128i*>(fys), fy);
+
+		__m128i texels[4];
+		for (int k = 0; k < 4; k++)
+		{
+			const uint8_t* top = sampler.texels + ((size_t)ys[k] * sampler.pitch + xs[k]) * 4;
+			texels[k] = sampleTexel(top, row, fxs[k], fys[k]);
+		}
+		__m128i low = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi64(texels[0], texels[1]), tint), 8);
+		__m128i high = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi64(texels[2], texels[3]), tint), 8);
+
+		__m128i* out = reinterpret_cast<__m128i*>(target + (size_t)(first + i) * 4);
+		__m128i under = _mm_loadu_si128(out);
+		low = blendPair(low, _mm_unpacklo_epi8(under, zero));
+		high = blendPair(high, _mm_unpackhi_epi8(under, zero));
+		_mm_storeu_si128(out, _mm_or_si128(_mm_packus_epi16(low, high), opaque));
+	}
+	drawSpanScalar(target, first + i, count - i, sampler);
+}
+
+/**
+*   @brief   Blends a solid colour over a span.
+*   @details The colour's share of every pixel is the same, so it is
+			 worked out once and only the target's share per pixel.
+*   @return  void
+*/
+void fillSpan(uint8_t* target, int count, const uint16_t colour[4])
+{
+	int alpha = colour[3] > 255 ? 255 : colour[3];
+	int weight = alpha + (alpha >> 7);
+	const __m128i source = _mm_setr_epi16(
+		(short)(colour[0] * weight), (short)(colour[1] * weight), (short)(colour[2] * weight), 0,
+		(short)(colour[0] * weight), (short)(colour[1] * weight), (short)(colour[2] * weight), 0);
+	const __m128i remaining = _mm_set1_epi16((short)(256 - weight));
+	const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+	const __m128i zero = _mm_setzero_si128();
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i* out = reinterpret_cast<__m128i*>(target + (size_t)i * 4);
+		__m128i under = _mm_loadu_si128(out);
+		__m128i low = _mm_srli_epi16(_mm_add_epi16(source,
+			_mm_mullo_epi16(_mm_unpacklo_epi8(under, zero), remaining)), 8);
+		__m128i high = _mm_srli_epi16(_mm_add_epi16(source,
+			_mm_mullo_epi16(_mm_unpackhi_epi8(under, zero), remaining)), 8);
+		_mm_storeu_si128(out, _mm_or_si128(_mm_packus_epi16(low, high), opaque));
+	}
+	fillSpanScalar(target + (size_t)i * 4, count - i, colour);
+}
+
+bool rasterKernelsVectorised()
+{
+	return true;
+}
+
+#else
+
+void drawSpan(uint8_t* target, int first, int count, const SpanSampler& sampler)
+{
+	drawSpanScalar(target, first, count, sampler);
+}
+
+void fillSpan(uint8_t* target, int count, const uint16_t colour[4])
+{
+	fillSpanScalar(target, count, colour);
+}
+
+bool rasterKernelsVectorised()
+{
+	return false;
+}
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+
+/*! \file RasterKernels.h
+@brief   Inner loops of the software renderer.
+@details Every kernel draws one span of a row into an RGBA8 target,
+         blending over what is there the way the GL renderer does, with
+         source alpha, and leaves the target opaque. The arithmetic is
+         8 bit fixed point throughout, so the SSE and scalar versions
+         produce exactly the same pixels; the SSE versions are used
+         wherever the build targets SSE2 and the scalar ones are kept
+         for other targets and so the benchmark can compare the two.
+*/
+
+/**
+*  How a span samples its texture.
+*  Coordinates are in texels with texel centres on whole numbers, and
+*  move by du, dv per pixel from u, v at pixel 0 of the row, so a span
+*  samples the same texels whichever tile it is drawn from.
+*/
+struct SpanSampler
+{
+	const uint8_t* texels;   /**< RGBA, pitch texels a row. */
+	int pitch;
+	float u, v;
+	float du, dv;
+	float min_u, min_v;      /**< First texel that may be sampled. */
+	float max_u, max_v;      /**< Last; the texel after it is read but given no weight. */
+	uint16_t tint[4];        /**< Scales each channel, 256 for 1. */
+};
+
+/**
+*   @brief   Draws a textured span, bilinear filtered, tinted and blended.
+*   @param   [in,out] target The row's first pixel.
+*   @param   [in] first The span's first pixel in the row.
+*   @param   [in] count How many pixels.
+*   @param   [in] sampler The texture and where the span samples it.
+*   @return  void
+*/
+void drawSpan(uint8_t* target, int first, int count, const SpanSampler& sampler);
+void drawSpanScalar(uint8_t* target, int first, int count, const SpanSampler& sampler);
+
+/**
+*   @brief   Blends a solid colour over a span.
+*   @param   [in,out] target The span's first pixel.
+*   @param   [in] count How many pixels.
+*   @param   [in] colour Red, green and blue 0 to 255, then alpha 0 to 256.
+*   @return  void
+*/
+void fillSpan(uint8_t* target, int count, const uint16_t colour[4]);
+void fillSpanScalar(uint8_t* target, int count, const uint16_t colour[4]);
+
+/**
+*   @return  True when the SSE kernels are compiled in.
+*/
+bool rasterKernelsVectorised();
@@ -0,0 +1,180 @@
+#include <cstring>
+#include <type_traits>
+
+#include "RewindBuffer.h"
+#include "StateDelta.h"
+
+static_assert(std::is_trivially_copyable<SimState>::value,
+	"SimState is snapshotted as raw bytes");
+
+namespace
+{
+	constexpr size_t STATE_SIZE = sizeof(SimState);
+	static_assert(STATE_SIZE < 0x10000, "delta runs are 16-bit");
+}
+
+RewindBuffer::RewindBuffer(int capacity_ticks, int keyframe_interval)
+	: frames(capacity_ticks > 0 ? capacity_ticks : 1),
+	keyframe_interval(keyframe_interval > 0 ? keyframe_interval : 1)
+{
+}
+
+void RewindBuffer::clear()
+{
+	oldest = 0;
+	count = 0;
+	since_keyframe = 0;
+}
+
+/**
+*   @brief   Captures a tick.
+*   @details Stores a keyframe on schedule (or when the buffer is empty)
+             and otherwise an encoded XOR delta against the previous tick.
+             When the ring is full the oldest frame's storage is reused.
+*   @return  void
+*/
+void RewindBuffer::capture(const SimState& state)
+{
+	int capacity = (int)frames.size();
+	int index;
+	if (count < capacity)
+	{
+		index = (oldest + count) % capacity;
+		count++;
+	}
+	else
+	{
+		index = oldest;
+		oldest = (oldest + 1) % capacity;
+	}
+
+	Frame& frame = frames[index];
+	frame.tick = state.tick;
+	frame.data.clear();
+
+	if (count == 1 || since_keyframe + 1 >= keyframe_interval)
+	{
+		frame.keyframe = true;
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&state);
+		frame.data.assign(bytes, bytes + STATE_SIZE);
+		since_keyframe = 0;
+	}
+	else
+	{
+		frame.keyframe = false;
+		encodeStateDelta(reinterpret_cast<const uint8_t*>(&last_state),
+			reinterpret_cast<const uint8_t*>(&state), STATE_SIZE, frame.data);
+		since_keyframe++;
+	}
+
+	std::memcpy(&last_state, &state, STATE_SIZE);
+}
+
+/**
+*   @brief   Restores a tick.
+*   @details Walks back to the closest keyframe at or before the tick and
+             replays the deltas forward onto it.
+*   @return  true if the tick could be reconstructed.
+*/
+bool RewindBuffer::restore(uint32_t tick, SimState& state) const
+{
+	int offset = offsetOf(tick);
+	if (offset < 0)
+	{
+		return false;
+	}
+
+	int key = offset;
+	while (key >= 0 && !frameAt(key).keyframe)
+	{
+		key--;
+	}
+	if (key < 0)
+	{
+		return false;
+	}
+
+	uint8_t* bytes = reinterpret_cast<uint8_t*>(&state);
+	std::memcpy(bytes, frameAt(key).data.data(), STATE_SIZE);
+	for (int i = key + 1; i <= offset; i++)
+	{
+		const std::vector<uint8_t>& delta = frameAt(i).data;
+		applyStateDelta(delta.data(), delta.size(), bytes, STATE_SIZE);
+	}
+	return true;
+}
+
+/**
+*   @brief   Drops frames after a tick.
+*   @details The next capture is forced to be a keyframe so the new
+             timeline does not depend on deltas from the discarded one.
+*   @return  void
+*/
+void RewindBuffer::truncate(uint32_t tick)
+{
+	int offset = offsetOf(tick);
+	if (offset < 0)
+	{
+		return;
+	}
+
+	SimState kept;
+	if (restore(tick, kept))
+	{
+		std::memcpy(&last_state, &kept, STATE_SIZE);
+	}
+	count = offset + 1;
+	since_keyframe = keyframe_interval;
+}
+
+bool RewindBuffer::empty() const
+{
+	return count == 0;
+}
+
+uint32_t RewindBuffer::oldestTick() const
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (frameAt(i).keyframe)
+		{
+			return frameAt(i).tick;
+		}
+	}
+	return newestTick();
+}
+
+uint32_t RewindBuffer::newestTick() const
+{
+	return count ? frameAt(count - 1).tick : 0;
+}
+
+size_t RewindBuffer::memoryUsage() const
+{
+	size_t bytes = frames.size() * sizeof(Frame);
+	for (const Frame& frame : frames)
+	{
+		bytes += frame.data.capacity();
+	}
+	return bytes;
+}
+
+const RewindBuffer::Frame& RewindBuffer::frameAt(int offset) const
+{
+	return frames[(oldest + offset) % frames.size()];
+}
+
+int RewindBuffer::offsetOf(uint32_t tick) const
+{
+	if (count == 0)
+	{
+		return -1;
+	}
+
+	uint32_t newest = newestTick();
+	if (tick > newest || newest - tick >= (uint32_t)count)
+	{
+		return -1;
+	}
+	return count - 1 - (int)(newest - tick);
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Simulation.h"
+
+/**
+*  A rolling history of simulation states that can be scrubbed back through.
+*  One snapshot is captured per tick into a fixed size ring. Every
+*  keyframe_interval ticks a full copy of the state is stored; the ticks in
+*  between only store a StateDelta against the previous tick, which for
+*  Breakout is usually a few dozen bytes.
+*  Restoring decodes forward from the nearest keyframe. Frame storage is
+*  reused as the ring wraps so capturing does not allocate once warm.
+*/
+class RewindBuffer
+{
+public:
+	/**
+	*  Constructor.
+	*  @param [in] capacity_ticks How many ticks of history to keep.
+	*  @param [in] keyframe_interval Ticks between full snapshots.
+	*/
+	RewindBuffer(int capacity_ticks, int keyframe_interval);
+
+	/**
+	*  Forgets all history, e.g. when a new game starts.
+	*/
+	void clear();
+
+	/**
+	*  Records the state for the tick that has just been simulated.
+	*  Ticks are expected to be captured in order without gaps.
+	*  @param [in] state The state after the tick.
+	*/
+	void capture(const SimState& state);
+
+	/**
+	*  Reconstructs the state recorded for a tick.
+	*  @param [in] tick The tick to restore.
+	*  @param [out] state Receives the recorded state.
+	*  @return false if the tick is no longer (or not yet) in the buffer.
+	*/
+	bool restore(uint32_t tick, SimState& state) const;
+
+	/**
+	*  Discards everything recorded after a tick.
+	*  Used when play resumes from a rewound point so that the new timeline
+	*  replaces the old one.
+	*  @param [in] tick The last tick to keep.
+	*/
+	void truncate(uint32_t tick);
+
+	bool empty() const;
+
+	/**
+	*  The oldest tick that can still be restored.
+	*  Deltas whose keyframe has been overwritten are not restorable.
+	*/
+	uint32_t oldestTick() const;
+	uint32_t newestTick() const;
+
+	/**
+	*  Bytes currently held by the frame storage.
+	*/
+	size_t memoryUsage() const;
+
+private:
+	struct Frame
+	{
+		uint32_t tick = 0;
+		bool keyframe = false;
+		std::vector<uint8_t> data;
+	};
+
+	const Frame& frameAt(int offset) const;
+	int offsetOf(uint32_t tick) const;
+
+	std::vector<Frame> frames;
+	int oldest = 0;               /**< Ring index of the oldest frame. */
+	int count = 0;                /**< Number of frames held. */
+	int keyframe_interval = 1;
+	int since_keyframe = 0;
+	SimState last_state;          /**< The most recently captured state. */
+};
@@ -0,0 +1,316 @@
+#include <chrono>
+
+#include "CampaignLevels.h"
+#include "SimThread.h"
+
+SimThread::~SimThread()
+{
+	stop();
+}
+
+void SimThread::start(Telemetry* telemetry, SpectatorServer* server)
+{
+	stop();
+
+	simulation.setTelemetry(telemetry);
+	spectator_server = server;
+	running = true;
+	thread = std::thread(&SimThread::run, this);
+}
+
+void SimThread::stop()
+{
+	running = false;
+	if (thread.joinable())
+	{
+		thread.join();
+	}
+}
+
+void SimThread::setActive(bool enabled)
+{
+	active.store(enabled, std::memory_order_release);
+}
+
+uint32_t SimThread::newGame(uint32_t seed, uint64_t level_seed, bool endless_run)
+{
+	requested_seed = seed;
+	requested_level = level_seed;
+	requested_endless = endless_run;
+	return ++requested_game;
+}
+
+void SimThread::setPaddleAxis(fixed axis)
+{
+	paddle_axis.store(axis, std::memory_order_relaxed);
+}
+
+void SimThread::setPaddleTarget(bool tracking, fixed target)
+{
+	// one word, so a tick never sees the flag of one sample with the
+	// target of another
+	paddle_target.store((uint64_t)tracking << 32 | (uint32_t)target, std::memory_order_relaxed);
+}
+
+void SimThread::setInputSequence(uint32_t sequence)
+{
+	input_sequence.store(sequence, std::memory_order_release);
+}
+
+void SimThread::fire()
+{
+	fire_requested = true;
+}
+
+void SimThread::setRewinding(bool enabled)
+{
+	rewinding = enabled;
+}
+
+void SimThread::setAutopilot(bool enabled)
+{
+	autopilot_enabled = enabled;
+}
+
+bool SimThread::update()
+{
+	return snapshots.update();
+}
+
+const SimSnapshot& SimThread::snapshot() const
+{
+	return snapshots.front();
+}
+
+/**
+*   @brief   Simulation thread
+*   @details Sleeps until the next tick is due, runs every tick that is
+             due (or scrubs back while rewinding), services the
+             spectator server and publishes a snapshot. If it falls more
+             than MAX_SIM_TICKS_PER_FRAME ticks behind, the backlog is
+             dropped rather than spiralling.
+*   @return  void
+*/
+void SimThread::run()
+{
+	using clock = std::chrono::steady_clock;
+	const clock::duration tick_time = std::chrono::duration_cast<clock::duration>(
+		std::chrono::nanoseconds(1000000000 / SIM_TICK_RATE));
+
+	clock::time_point next_tick = clock::now();
+	clock::time_point next_second = next_tick + std::chrono::seconds(1);
+	while (running)
+	{
+		if (requested_game.load(std::memory_order_acquire) != game)
+		{
+			startGame();
+		}
+
+		bool scrubbing = rewinding;
+		if (was_rewinding && !scrubbing)
+		{
+			// resume from the tick being shown, dropping the old future
+			rewind_buffer.truncate(simulation.getState().tick);
+		}
+		was_rewinding = scrubbing;
+
+		clock::time_point now = clock::now();
+		if (!active.load(std::memory_order_acquire) || game == 0)
+		{
+			next_tick = now + tick_time;
+		}
+		else
+		{
+			int ticks = 0;
+			while (now >= next_tick && ticks < MAX_SIM_TICKS_PER_FRAME)
+			{
+				if (scrubbing)
+				{
+					scrub();
+				}
+				else
+				{
+					tick();
+				}
+				next_tick += tick_time;
+				ticks++;
+			}
+			if (now >= next_tick)
+			{
+				next_tick = now + tick_time;
+				backlog_drops++;
+			}
+		}
+
+		if (now >= next_second)
+		{
+			// walking the history to size it is too slow to do every tick
+			rewind_bytes = rewind_buffer.memoryUsage();
+			tick_rate = ticks_this_second;
+			ticks_this_second = 0;
+			next_second = now + std::chrono::seconds(1);
+		}
+
+		if (spectator_server)
+		{
+			spectator_server->update();
+		}
+		publish();
+		std::this_thread::sleep_until(next_tick);
+	}
+}
+
+void SimThread::startGame()
+{
+	game = requested_game.load(std::memory_order_acquire);
+	run_seed = requested_level;
+	endless = requested_endless && run_seed != 0;
+	loadLevel(0);
+	rewind_buffer.clear();
+	rewind_buffer.capture(simulation.getState());
+	autopilot.reset(requested_seed);
+	fire_requested = false;
+}
+
+/**
+*   @brief   Loads a level
+*   @details Level 0 starts a new game, later ones carry on the
+             campaign or an endless run. Campaign levels are baked into
+             the binary and only need pointing at; the others are
+             generated here rather than on the game thread, which takes
+             a few microseconds.
+*   @return  void
+*/
+void SimThread::loadLevel(int number)
+{
+	LevelLayout layout;
+	if (run_seed == 0)
+	{
+		layout = campaignLevel(number);
+	}
+	else
+	{
+		generateLevel(levelSeed(number), BLOCKS_PER_ROW, BLOCK_ROWS, level);
+		layout = levelLayout(level);
+	}
+
+	if (number == 0)
+	{
+		simulation.newGame(layout);
+	}
+	else
+	{
+		simulation.nextLevel(layout);
+	}
+}
+
+uint64_t SimThread::levelSeed(int number) const
+{
+	return endless && number > 0 ? endlessSeed(run_seed, number) : run_seed;
+}
+
+/**
+*   @brief   Runs one tick
+*   @details Takes the player's input, or the autopilot's while it is
+             flying, then records the result for rewind and viewers.
+             Notes when a new input event is first picked up so the
+             game can measure its latency.
+*   @return  void
+*/
+void SimThread::tick()
+{
+	// the sequence is read first, so the input read after it is at
+	// least as new as the events it counts
+	uint32_t sequence = input_sequence.load(std::memory_order_acquire);
+	if (sequence != input_consumed)
+	{
+		input_consumed = sequence;
+		input_consumed_at = std::chrono::steady_clock::now();
+	}
+
+	SimInput input;
+	bool fire = fire_requested.exchange(false);
+	if (autopilot_enabled)
+	{
+		input = autopilot.think(simulation);
+	}
+	else
+	{
+		input.paddle_axis = paddle_axis.load(std::memory_order_relaxed);
+		uint64_t target = paddle_target.load(std::memory_order_relaxed);
+		input.paddle_tracking = (target >> 32) != 0;
+		input.paddle_target = (fixed)(uint32_t)target;
+		input.fire = fire;
+	}
+
+	simulation.step(input);
+
+	// the level comes from the state, which a rewind may have taken back
+	// into an earlier level than the last one loaded
+	int cleared = simulation.getState().level;
+	bool more_levels = endless || (run_seed == 0 && cleared + 1 < CAMPAIGN_LEVELS);
+	if (more_levels && simulation.getState().status == SimStatus::WON)
+	{
+		loadLevel(cleared + 1);
+	}
+	rewind_buffer.capture(simulation.getState());
+	if (spectator_server)
+	{
+		spectator_server->publish(simulation.getState());
+	}
+	ticks_this_second++;
+}
+
+/**
+*   @brief   Scrubs back through the rewind history
+*   @details Moves back REWIND_SCRUB_SPEED ticks for every tick of real
+             time, stopping at the oldest restorable tick.
+*   @return  void
+*/
+void SimThread::scrub()
+{
+	fire_requested = false;
+
+	uint32_t current = simulation.getState().tick;
+	uint32_t oldest = rewind_buffer.oldestTick();
+	uint32_t target = current - oldest > (uint32_t)REWIND_SCRUB_SPEED ?
+		current - REWIND_SCRUB_SPEED : oldest;
+
+	SimState state;
+	if (rewind_buffer.restore(target, state))
+	{
+		simulation.setState(state);
+		if (spectator_server)
+		{
+			spectator_server->publish(state);
+		}
+	}
+}
+
+void SimThread::publish()
+{
+	SimSnapshot& snapshot = snapshots.back();
+	snapshot.state = simulation.getState();
+	snapshot.blocks = simulation.getBlockGrid();
+	snapshot.game = game;
+	snapshot.level_number = simulation.getState().level;
+	snapshot.level_seed = levelSeed(snapshot.level_number);
+
+	snapshot.rewinding = was_rewinding;
+	snapshot.autopilot = autopilot_enabled;
+	snapshot.rewind_oldest = rewind_buffer.oldestTick();
+	snapshot.rewind_newest = rewind_buffer.newestTick();
+	snapshot.rewind_bytes = rewind_bytes;
+
+	snapshot.viewers = spectator_server ? spectator_server->getViewerCount() : 0;
+	snapshot.viewer_bytes = spectator_server ? spectator_server->getBytesSent() : 0;
+	snapshot.viewer_resyncs = spectator_server ? spectator_server->getResyncCount() : 0;
+	snapshot.viewer_drops = spectator_server ? spectator_server->getDroppedCount() : 0;
+
+	snapshot.input_sequence = input_consumed;
+	snapshot.input_consumed = input_consumed_at;
+
+	snapshot.tick_rate = tick_rate;
+	snapshot.backlog_drops = backlog_drops;
+	snapshots.publish();
+}
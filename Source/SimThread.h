@@ -0,0 +1,160 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "Autopilot.h"
+#include "BlockGrid.h"
+#include "Constants.h"
+#include "RewindBuffer.h"
+#include "Simulation.h"
+#include "Spectator.h"
+#include "Telemetry.h"
+#include "TripleBuffer.h"
+
+/**
+*  Everything the game needs to draw a tick.
+*  Published by the simulation thread after each round of ticks; the
+*  renderer reads it and never touches the simulation itself.
+*/
+struct SimSnapshot
+{
+	SimState state;
+	BlockGrid blocks;
+	uint32_t game = 0;  /**< The newGame request the state belongs to, 0 before any. */
+	uint64_t level_seed = 0;  /**< Seed of the level being played, 0 for a campaign level. */
+	int level_number = 0;     /**< Levels cleared so far, from the state. */
+
+	bool rewinding = false;
+	bool autopilot = false;
+	uint32_t rewind_oldest = 0;
+	uint32_t rewind_newest = 0;
+	size_t rewind_bytes = 0;
+
+	int viewers = 0;
+	long long viewer_bytes = 0;
+	int viewer_resyncs = 0;
+	int viewer_drops = 0;
+
+	uint32_t input_sequence = 0;  /**< Newest input event a tick has consumed. */
+	std::chrono::steady_clock::time_point input_consumed;  /**< When that tick ran. */
+
+	int tick_rate = 0;      /**< Ticks run in the last second. */
+	int backlog_drops = 0;  /**< Times the thread fell too far behind and skipped ahead. */
+};
+
+/**
+*  Runs the fixed point simulation on its own thread.
+*  The thread keeps its own clock and steps at SIM_TICK_RATE whatever
+*  the frame rate is doing, so a slow frame or a stall in the driver no
+*  longer holds up physics, and a burst of physics no longer delays a
+*  frame. The game talks to it through atomics (input, new game, rewind,
+*  autopilot) and reads the results from a triple buffer of snapshots.
+*  Once started the thread owns the simulation, the rewind history, the
+*  autopilot and the spectator server.
+*/
+class SimThread
+{
+public:
+	SimThread() = default;
+	~SimThread();
+
+	SimThread(const SimThread&) = delete;
+	SimThread& operator=(const SimThread&) = delete;
+
+	/**
+	*  Starts the thread.
+	*  @param [in] telemetry Receives the simulation's events, or nullptr.
+	*  @param [in] spectator_server Published to every tick, or nullptr.
+	*/
+	void start(Telemetry* telemetry, SpectatorServer* spectator_server);
+	void stop();
+
+	/**
+	*  Lets the simulation run, or holds it where it is.
+	*  The clock restarts on resuming, so time spent held is not caught up.
+	*/
+	void setActive(bool active);
+
+	/**
+	*  Asks for a new game.
+	*  @param [in] seed Seeds the autopilot.
+	*  @param [in] level_seed The level to generate, 0 to play the campaign
+	*              from the classic layout.
+	*  @param [in] endless Generate the next level of the run from
+	*              level_seed each time one is cleared, instead of winning.
+	*  @return The id the new game's snapshots will carry.
+	*/
+	uint32_t newGame(uint32_t seed, uint64_t level_seed = 0, bool endless = false);
+
+	/**
+	*  Sets where the paddle is being pushed, -1 full left to 1 full right.
+	*/
+	void setPaddleAxis(fixed axis);
+
+	/**
+	*  Centres the paddle on a playfield x each tick instead, or stops.
+	*/
+	void setPaddleTarget(bool tracking, fixed target);
+
+	/**
+	*  Tags the input passed so far with the newest input event's
+	*  sequence number, so snapshots can say which tick consumed it.
+	*/
+	void setInputSequence(uint32_t sequence);
+	void fire();
+	void setRewinding(bool rewinding);
+	void setAutopilot(bool enabled);
+
+	/**
+	*  Takes the newest snapshot. Only the game thread may call this.
+	*  @return false if nothing new has been published.
+	*/
+	bool update();
+	const SimSnapshot& snapshot() const;
+
+private:
+	void run();
+	void startGame();
+	void loadLevel(int number);
+	uint64_t levelSeed(int number) const;
+	void tick();
+	void scrub();
+	void publish();
+
+	// only touched by the simulation thread once it is running
+	Simulation simulation;
+	RewindBuffer rewind_buffer{ REWIND_SECONDS * SIM_TICK_RATE, REWIND_KEYFRAME_INTERVAL };
+	Autopilot autopilot;
+	SpectatorServer* spectator_server = nullptr;
+	uint32_t game = 0;
+	Level level;  /**< The generated level being played. */
+	uint64_t run_seed = 0;
+	bool endless = false;
+	bool was_rewinding = false;
+	uint32_t input_consumed = 0;
+	std::chrono::steady_clock::time_point input_consumed_at;
+	size_t rewind_bytes = 0;
+	int ticks_this_second = 0;
+	int tick_rate = 0;
+	int backlog_drops = 0;
+
+	// requests from the game thread
+	std::atomic<bool> running{ false };
+	std::atomic<bool> active{ false };
+	std::atomic<uint32_t> requested_game{ 0 };
+	std::atomic<uint32_t> requested_seed{ 1 };
+	std::atomic<uint64_t> requested_level{ 0 };
+	std::atomic<bool> requested_endless{ false };
+	std::atomic<fixed> paddle_axis{ 0 };
+	std::atomic<uint64_t> paddle_target{ 0 };  /**< Tracking flag in the high word, target in the low. */
+	std::atomic<uint32_t> input_sequence{ 0 };
+	std::atomic<bool> fire_requested{ false };
+	std::atomic<bool> rewinding{ false };
+	std::atomic<bool> autopilot_enabled{ false };
+
+	TripleBuffer<SimSnapshot> snapshots;
+	std::thread thread;
+};
@@ -0,0 +1,985 @@
+#include <algorithm>
+
+#include "CampaignLevels.h"
+#include "Simulation.h"
+
+namespace
+{
+	constexpr fixed FIELD_WIDTH  = toFixed(PLAYFIELD_WIDTH);
+	constexpr fixed FIELD_HEIGHT = toFixed(PLAYFIELD_HEIGHT);
+
+	constexpr fixed SPEED_STEP = fixedRatio(1, 10);
+
+	// top left of the block grid
+	constexpr fixed GRID_TOP  = toFixed(48);
+	constexpr fixed GRID_LEFT = (FIELD_WIDTH -
+		BLOCKS_PER_ROW * Simulation::BLOCK_WIDTH) / 2;
+
+	// the ball only counts as hitting a block face within 90% of its width
+	constexpr fixed BALL_FACE  = Simulation::BALL_SIZE * 9 / 10;
+	constexpr fixed BLOCK_FACE = Simulation::BLOCK_WIDTH * 9 / 10;
+
+	/**
+	*  Widens [first, last] to take in the grid rows that a span of height
+	*  h starting at y overlaps.
+	*/
+	void addRows(fixed y, fixed h, int& first, int& last)
+	{
+		if (y + h <= GRID_TOP || y >= GRID_TOP + BLOCK_ROWS * Simulation::BLOCK_HEIGHT)
+		{
+			return;
+		}
+
+		int top_row = y > GRID_TOP ? (y - GRID_TOP) / Simulation::BLOCK_HEIGHT : 0;
+		int bottom_row = (y + h - GRID_TOP - 1) / Simulation::BLOCK_HEIGHT;
+		bottom_row = bottom_row < BLOCK_ROWS ? bottom_row : BLOCK_ROWS - 1;
+		first = top_row < first ? top_row : first;
+		last = bottom_row > last ? bottom_row : last;
+	}
+
+	/**
+	*  Returns a mask of the grid columns that a span of width w starting
+	*  at x overlaps.
+	*/
+	uint32_t columnSpan(fixed x, fixed w)
+	{
+		fixed left = x - GRID_LEFT;
+		fixed right = left + w;
+		if (right <= 0 || left >= BLOCKS_PER_ROW * Simulation::BLOCK_WIDTH)
+		{
+			return 0;
+		}
+
+		int first = left > 0 ? left / Simulation::BLOCK_WIDTH : 0;
+		int last = (right - 1) / Simulation::BLOCK_WIDTH;
+		last = last < BLOCKS_PER_ROW ? last : BLOCKS_PER_ROW - 1;
+		return ((2u << last) - 1) & ~((1u << first) - 1);
+	}
+
+	/**
+	*  Paddle deflection bands, from the right edge inwards.
+	*  A ball whose centre is past edge * paddle width bounces off at vx, vy.
+	*/
+	struct Deflection
+	{
+		fixed edge;
+		fixed vx;
+		fixed vy;
+	};
+
+	constexpr Deflection DEFLECTIONS[] =
+	{
+		{ fixedRatio(71, 100), fixedRatio(500, 1000), fixedRatio(-866, 1000) },
+		{ fixedRatio(57, 100), fixedRatio(259, 1000), fixedRatio(-966, 1000) },
+		{ fixedRatio(43, 100), 0,                     -FIXED_ONE },
+		{ fixedRatio(29, 100), fixedRatio(-259, 1000), fixedRatio(-966, 1000) },
+		{ fixedRatio(14, 100), fixedRatio(-500, 1000), fixedRatio(-866, 1000) },
+	};
+	constexpr fixed DIAGONAL = fixedRatio(707, 1000);
+
+	// contact scheduling: where each mover sits in the queue
+	constexpr int BALL_MOVER = 0;
+	constexpr int POWER_UP_MOVER = 1;
+	constexpr int FIRST_GEM_MOVER = 2;
+	constexpr int FIRST_LASER_MOVER = FIRST_GEM_MOVER + MAX_GEMS;
+
+	// a contact further ahead than this is never; it keeps every
+	// position worked out along the way well inside 64 bits
+	constexpr int64_t HORIZON = 1 << 24;
+	constexpr int64_t NO_LIMIT = (int64_t)1 << 62;
+
+	const SimBody& moverBody(const SimState& state, int mover)
+	{
+		if (mover == BALL_MOVER)
+		{
+			return state.ball;
+		}
+		if (mover == POWER_UP_MOVER)
+		{
+			return state.power_up;
+		}
+		if (mover < FIRST_LASER_MOVER)
+		{
+			return state.gems[mover - FIRST_GEM_MOVER];
+		}
+		return state.lasers[mover - FIRST_LASER_MOVER];
+	}
+
+	uint8_t moverVisible(const SimState& state, int mover)
+	{
+		if (mover == BALL_MOVER)
+		{
+			return 1;
+		}
+		if (mover == POWER_UP_MOVER)
+		{
+			return state.power_up_visible;
+		}
+		if (mover < FIRST_LASER_MOVER)
+		{
+			return state.gem_visible[mover - FIRST_GEM_MOVER];
+		}
+		return state.laser_visible[mover - FIRST_LASER_MOVER];
+	}
+
+	int64_t floorDiv(int64_t a, int64_t b)
+	{
+		return a >= 0 ? a / b : -((-a + b - 1) / b);
+	}
+
+	/**
+	*  Narrows [first, last] to the ticks k on which
+	*  low < start + k * step < high.
+	*  @return false if none are left.
+	*/
+	bool narrow(int64_t start, int64_t step, int64_t low, int64_t high, int64_t& first, int64_t& last)
+	{
+		if (step < 0)
+		{
+			int64_t flipped = -low;
+			low = -high;
+			high = flipped;
+			start = -start;
+			step = -step;
+		}
+		if (step == 0)
+		{
+			return low < start && start < high && first <= last;
+		}
+		first = std::max(first, floorDiv(low - start, step) + 1);
+		last = std::min(last, floorDiv(high - start - 1, step));
+		return first <= last;
+	}
+
+	/**
+	*  The first tick k on which low < start + k * step < high, or past
+	*  HORIZON if there is none.
+	*/
+	int64_t firstWithin(int64_t start, int64_t step, int64_t low, int64_t high)
+	{
+		int64_t first = 0;
+		int64_t last = HORIZON;
+		return narrow(start, step, low, high, first, last) ? first : HORIZON + 1;
+	}
+
+	void fnv1a(uint64_t& hash, const void* data, int size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (int i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	void hashBody(uint64_t& hash, const SimBody& body)
+	{
+		fnv1a(hash, &body.x, sizeof(body.x));
+		fnv1a(hash, &body.y, sizeof(body.y));
+		fnv1a(hash, &body.vx, sizeof(body.vx));
+		fnv1a(hash, &body.vy, sizeof(body.vy));
+	}
+}
+
+/**
+*   @brief   New Game
+*   @details Lays out the classic block grid and resets every counter,
+             mirroring BreakoutGame::newGame.
+*   @return  void
+*/
+void Simulation::newGame()
+{
+	newGame(campaignLevel(0));
+}
+
+void Simulation::newGame(const LevelLayout& level)
+{
+	state = SimState();
+	state.lives = 4;
+	state.game_speed = FIXED_ONE;
+	state.paddle.x = (FIELD_WIDTH - PADDLE_WIDTH) / 2;
+	state.paddle.y = FIELD_HEIGHT - PADDLE_HEIGHT;
+	layOut(level);
+}
+
+/**
+*   @brief   Next level
+*   @details Clears everything in flight, keeps the score, lives and
+             speed, and serves from wherever the paddle is. The level
+             count is part of the state, so restoring a state from an
+             earlier level puts the run back there too.
+*   @return  void
+*/
+void Simulation::nextLevel(const LevelLayout& level)
+{
+	SimState next;
+	next.tick = state.tick;
+	next.score = state.score;
+	next.lives = state.lives;
+	next.game_speed = state.game_speed;
+	next.level = state.level + 1;
+	next.paddle = state.paddle;
+	state = next;
+	layOut(level);
+}
+
+/**
+*   @brief   Lay out
+*   @details Copies the level's cells into the state, rebuilds the block
+             index and serves the ball. Cells outside the level are left
+             empty. The layout is read straight from wherever it lives,
+             a baked campaign table or a generated level's buffers.
+*   @return  void
+*/
+void Simulation::layOut(const LevelLayout& level)
+{
+	for (int i = 0; i < MAX_BLOCKS; i++)
+	{
+		int row = i / BLOCKS_PER_ROW;
+		int column = i % BLOCKS_PER_ROW;
+		block_x[i] = GRID_LEFT + column * BLOCK_WIDTH;
+		block_y[i] = GRID_TOP + row * BLOCK_HEIGHT;
+
+		uint8_t type = (uint8_t)BlockType::EMPTY;
+		uint8_t drop = (uint8_t)BlockDrop::NONE;
+		if (row < level.rows && column < level.columns)
+		{
+			type = level.types[row * level.columns + column];
+			drop = level.block_drops[row * level.columns + column];
+		}
+		state.block_type[i] = type;
+		state.block_drop[i] = drop;
+		state.block_visible[i] = type != (uint8_t)BlockType::EMPTY;
+	}
+	state.gem_interval = level.gem_interval;
+	block_grid.build(state.block_visible);
+	forgetContacts();
+	serveBall();
+}
+
+/**
+*   @brief   Advances one tick.
+*   @details Collisions are resolved against the current positions before
+             anything moves, the same order the float update uses.
+*   @return  void
+*/
+void Simulation::step(const SimInput& input)
+{
+	if (state.status != SimStatus::PLAYING)
+	{
+		return;
+	}
+
+	if (input.fire)
+	{
+		shootLaser();
+	}
+
+	wallCollision();
+	blockCollision();
+	paddleCollision();
+	integrate(input);
+
+	if (state.power_up_shots == MAX_LASERS)
+	{
+		state.power_up_active = 0;
+	}
+	if (block_grid.getLiveCount() == 0)
+	{
+		state.status = SimStatus::WON;
+	}
+	else if (state.lives == 0)
+	{
+		state.status = SimStatus::LOST;
+	}
+	state.tick++;
+}
+
+/**
+*   @brief   Coasts to the next contact.
+*   @details A step that makes no contact only moves things, and each
+             moves by the same amount every tick, so any number of them
+             is one multiply per mover. The paddle is clamped once; as it
+             moves the same way every tick, clamping the whole move
+             gives the same place as clamping each tick's. Anything else
+             the next step would change (firing, a game that is already
+             over, a paddle outside the field) is left to step.
+*   @return  The ticks run.
+*/
+uint32_t Simulation::coast(const SimInput& input, uint32_t max_ticks)
+{
+	SimBody& paddle = state.paddle;
+	if (state.status != SimStatus::PLAYING || input.fire || max_ticks == 0 ||
+		block_grid.getLiveCount() == 0 || state.lives == 0 ||
+		(state.power_up_shots == MAX_LASERS && state.power_up_active) ||
+		paddle.x < 0 || paddle.x > FIELD_WIDTH - PADDLE_WIDTH)
+	{
+		return 0;
+	}
+
+	scheduleContacts();
+	uint32_t next = contacts.nextTick();
+	if (next <= state.tick)
+	{
+		return 0;
+	}
+	uint32_t ticks = next - state.tick < max_ticks ? next - state.tick : max_ticks;
+
+	int64_t paddle_x = input.paddle_tracking ? input.paddle_target - PADDLE_WIDTH / 2 :
+		paddle.x + (int64_t)ticks * fixedMul(input.paddle_axis, PADDLE_SPEED);
+	paddle.vx = input.paddle_tracking ? 0 : input.paddle_axis;
+	paddle.x = (fixed)std::min(std::max(paddle_x, (int64_t)0), (int64_t)(FIELD_WIDTH - PADDLE_WIDTH));
+
+	fixed ball_speed = fixedMul(BALL_SPEED, state.game_speed);
+	state.ball.x += (fixed)ticks * fixedMul(state.ball.vx, ball_speed);
+	state.ball.y += (fixed)ticks * fixedMul(state.ball.vy, ball_speed);
+	for (int i = 0; i < MAX_GEMS; i++)
+	{
+		state.gems[i].y += (fixed)ticks * fixedMul(state.gems[i].vy, DROP_SPEED);
+	}
+	state.power_up.y += (fixed)ticks * fixedMul(state.power_up.vy, DROP_SPEED);
+	for (int i = 0; i < MAX_LASERS; i++)
+	{
+		state.lasers[i].y += (fixed)ticks * fixedMul(state.lasers[i].vy, DROP_SPEED);
+	}
+
+	state.tick += ticks;
+	return ticks;
+}
+
+const SimState& Simulation::getState() const
+{
+	return state;
+}
+
+void Simulation::setState(const SimState& new_state)
+{
+	state = new_state;
+	block_grid.build(state.block_visible);
+	forgetContacts();
+}
+
+fixed Simulation::blockX(int index) const
+{
+	return block_x[index];
+}
+
+fixed Simulation::blockY(int index) const
+{
+	return block_y[index];
+}
+
+const BlockGrid& Simulation::getBlockGrid() const
+{
+	return block_grid;
+}
+
+/**
+*   @brief   Laser column
+*   @details A laser hits a block when its left edge is strictly inside
+             the block's width shifted left by half a laser, so each
+             position maps to at most one column.
+*   @return  The column, or -1.
+*/
+int Simulation::laserColumn(fixed x)
+{
+	fixed offset = x - GRID_LEFT + LASER_WIDTH / 2;
+	if (offset <= 0 || offset % BLOCK_WIDTH == 0)
+	{
+		return -1;
+	}
+
+	int column = offset / BLOCK_WIDTH;
+	return column < BLOCKS_PER_ROW ? column : -1;
+}
+
+/**
+*   @brief   Collision detection walls
+*   @details Bounces the ball off the sides and top of the playfield and
+             retires lasers that have left the top.
+*   @return  void
+*/
+void Simulation::wallCollision()
+{
+	SimBody& ball = state.ball;
+	if ((ball.x <= 0 && ball.vx < 0) ||
+		(ball.x + BALL_SIZE >= FIELD_WIDTH && ball.vx > 0))
+	{
+		ball.vx = -ball.vx;
+	}
+	if (ball.y <= 0 && ball.vy < 0)
+	{
+		ball.vy = -ball.vy;
+	}
+
+	for (int i = 0; i < MAX_LASERS; i++)
+	{
+		if (state.laser_visible[i] && state.lasers[i].y <= 0)
+		{
+			state.laser_visible[i] = 0;
+			state.lasers[i] = SimBody();
+		}
+	}
+}
+
+/**
+*   @brief   Collision detection blocks
+*   @details Tests lasers and the ball against the live blocks using the
+             same overlap rules as BreakoutGame::blockCollision. The
+             occupancy index narrows that to the blocks each could be
+             touching: a laser's column and the rows it spans, and the
+             rows and columns under the ball. They are then visited in
+             index order, as a full scan would, so blocks die in the
+             same order and drop the same gems.
+*   @return  void
+*/
+void Simulation::blockCollision()
+{
+	SimBody& ball = state.ball;
+
+	uint32_t candidates[BLOCK_ROWS] = {};
+	for (int j = 0; j < MAX_LASERS; j++)
+	{
+		if (state.laser_visible[j])
+		{
+			laserCandidates(state.lasers[j], candidates);
+		}
+	}
+
+	int first_row = BLOCK_ROWS;
+	int last_row = -1;
+	addRows(ball.y, BALL_SIZE, first_row, last_row);
+	uint32_t ball_columns = columnSpan(ball.x, BALL_SIZE);
+	for (int row = first_row; row <= last_row; row++)
+	{
+		candidates[row] |= ball_columns;
+	}
+
+	for (int row = 0; row < BLOCK_ROWS; row++)
+	{
+		for (uint32_t mask = candidates[row] & block_grid.rowMask(row); mask; mask &= mask - 1)
+		{
+			int i = row * BLOCKS_PER_ROW + countTrailingZeros(mask);
+
+			fixed left = block_x[i];
+			fixed top = block_y[i];
+			fixed right = left + BLOCK_WIDTH;
+			fixed bottom = top + BLOCK_HEIGHT;
+
+			for (int j = 0; j < MAX_LASERS && state.block_visible[i]; j++)
+			{
+				const SimBody& laser = state.lasers[j];
+				if (state.laser_visible[j] &&
+					laser.y < bottom && laser.y + LASER_HEIGHT > top &&
+					laser.x > left - LASER_WIDTH / 2 &&
+					laser.x + LASER_WIDTH < right + LASER_WIDTH / 2)
+				{
+					state.laser_visible[j] = 0;
+					state.lasers[j] = SimBody();
+					destroyBlock(i);
+				}
+			}
+			if (!state.block_visible[i])
+			{
+				continue;
+			}
+
+			bool within_face = ball.x + BALL_FACE > left && ball.x < left + BLOCK_FACE;
+			bool spans_rows = ball.y < bottom && ball.y + BALL_SIZE > top;
+
+			if ((spans_rows && within_face && ball.vy < 0) ||
+				(ball.y < top && ball.y + BALL_SIZE > top && within_face && ball.vy > 0))
+			{
+				ball.vy = -ball.vy;
+				destroyBlock(i);
+			}
+			else if ((spans_rows && ball.x + BALL_SIZE > left && ball.x < left && ball.vx > 0) ||
+				(spans_rows && ball.x < right && ball.x + BALL_SIZE > right && ball.vx < 0))
+			{
+				ball.vx = -ball.vx;
+				destroyBlock(i);
+			}
+		}
+	}
+}
+
+/**
+*   @brief   Blocks a laser could hit
+*   @details Lasers travel straight up their column, so one still below
+             the column's lowest live block cannot be touching anything.
+             Otherwise it can only be touching the rows it spans.
+*   @return  void
+*/
+void Simulation::laserCandidates(const SimBody& laser, uint32_t* candidates) const
+{
+	int column = laserColumn(laser.x);
+	if (column < 0)
+	{
+		return;
+	}
+
+	int lowest = block_grid.lowestRow(column);
+	if (lowest < 0 || laser.y >= GRID_TOP + (lowest + 1) * BLOCK_HEIGHT)
+	{
+		return;
+	}
+
+	int first_row = BLOCK_ROWS;
+	int last_row = -1;
+	addRows(laser.y, LASER_HEIGHT, first_row, last_row);
+	for (int row = first_row; row <= last_row; row++)
+	{
+		candidates[row] |= 1u << column;
+	}
+}
+
+/**
+*   @brief   Collision detection paddle
+*   @details Deflects the ball depending on where it lands on the paddle,
+             costs a life if it is missed and collects falling pickups.
+*   @return  void
+*/
+void Simulation::paddleCollision()
+{
+	const SimBody& paddle = state.paddle;
+	SimBody& ball = state.ball;
+
+	if (ball.y + BALL_SIZE > paddle.y)
+	{
+		fixed centre = ball.x + BALL_SIZE / 2;
+		if (ball.x + BALL_SIZE < paddle.x || ball.x > paddle.x + PADDLE_WIDTH)
+		{
+			if (ball.y > paddle.y)
+			{
+				state.lives--;
+				report(TelemetryEvent::LIFE_LOST, state.lives, ball.x, ball.y);
+				serveBall();
+				return;
+			}
+		}
+		else if (ball.x + BALL_SIZE >= paddle.x + PADDLE_WIDTH)
+		{
+			ball.vx = DIAGONAL;
+			ball.vy = -DIAGONAL;
+		}
+		else
+		{
+			bool deflected = false;
+			for (const Deflection& band : DEFLECTIONS)
+			{
+				if (centre >= paddle.x + fixedMul(PADDLE_WIDTH, band.edge))
+				{
+					ball.vx = band.vx;
+					ball.vy = band.vy;
+					deflected = true;
+					break;
+				}
+			}
+			if (!deflected)
+			{
+				ball.vx = -DIAGONAL;
+				ball.vy = -DIAGONAL;
+			}
+		}
+	}
+
+	for (int i = 0; i < MAX_GEMS; i++)
+	{
+		const SimBody& gem = state.gems[i];
+		if (state.gem_visible[i] && gem.y + GEM_SIZE > paddle.y)
+		{
+			if (gem.x > paddle.x && gem.x + GEM_SIZE < paddle.x + PADDLE_WIDTH)
+			{
+				report(TelemetryEvent::GEM_CAUGHT, i, gem.x, gem.y);
+				state.score += 100;
+				state.gem_visible[i] = 0;
+				state.gems[i] = SimBody();
+			}
+			else if (gem.y > paddle.y)
+			{
+				report(TelemetryEvent::GEM_MISSED, i, gem.x, gem.y);
+				state.gem_visible[i] = 0;
+				state.gems[i] = SimBody();
+			}
+		}
+	}
+
+	const SimBody& power_up = state.power_up;
+	if (state.power_up_visible && power_up.y + GEM_SIZE > paddle.y)
+	{
+		if (power_up.x > paddle.x && power_up.x + GEM_SIZE < paddle.x + PADDLE_WIDTH)
+		{
+			report(TelemetryEvent::POWER_UP_COLLECTED, 0, power_up.x, power_up.y);
+			state.power_up_active = 1;
+			state.power_up_shots = 0;
+			state.power_up_visible = 0;
+			state.power_up = SimBody();
+		}
+		else if (power_up.y > paddle.y)
+		{
+			state.power_up_visible = 0;
+			state.power_up = SimBody();
+		}
+	}
+}
+
+/**
+*   @brief   Moves everything by one tick.
+*   @details The paddle is pushed along by the input's axis, or put
+             straight under the pointer when tracking one, and clamped
+             to the playfield; everything else travels along its
+             velocity scaled by its speed.
+*   @return  void
+*/
+void Simulation::integrate(const SimInput& input)
+{
+	SimBody& paddle = state.paddle;
+	if (input.paddle_tracking)
+	{
+		// a pointer places the paddle directly rather than pushing it
+		paddle.vx = 0;
+		paddle.x = input.paddle_target - PADDLE_WIDTH / 2;
+	}
+	else
+	{
+		paddle.vx = input.paddle_axis;
+		paddle.x += fixedMul(paddle.vx, PADDLE_SPEED);
+	}
+	if (paddle.x < 0)
+	{
+		paddle.x = 0;
+	}
+	else if (paddle.x > FIELD_WIDTH - PADDLE_WIDTH)
+	{
+		paddle.x = FIELD_WIDTH - PADDLE_WIDTH;
+	}
+
+	fixed ball_speed = fixedMul(BALL_SPEED, state.game_speed);
+	state.ball.x += fixedMul(state.ball.vx, ball_speed);
+	state.ball.y += fixedMul(state.ball.vy, ball_speed);
+
+	for (int i = 0; i < MAX_GEMS; i++)
+	{
+		state.gems[i].y += fixedMul(state.gems[i].vy, DROP_SPEED);
+	}
+	state.power_up.y += fixedMul(state.power_up.vy, DROP_SPEED);
+	for (int i = 0; i < MAX_LASERS; i++)
+	{
+		state.lasers[i].y += fixedMul(state.lasers[i].vy, DROP_SPEED);
+	}
+}
+
+/**
+*   @brief   serve ball
+*   @details Puts the ball on the centre of the paddle heading straight up.
+*   @return  void
+*/
+void Simulation::serveBall()
+{
+	SimBody& ball = state.ball;
+	ball.y = FIELD_HEIGHT - (PADDLE_HEIGHT + BALL_SIZE);
+	ball.x = state.paddle.x + PADDLE_WIDTH / 2 - BALL_SIZE / 2;
+	ball.vx = 0;
+	ball.vy = -FIXED_ONE;
+}
+
+void Simulation::destroyBlock(int index)
+{
+	releaseGem(index);
+	releasePowerUp(index);
+	state.block_visible[index] = 0;
+	block_grid.kill(index);
+	block_changes++;
+	state.no_hit++;
+	state.score += 5;
+	report(TelemetryEvent::BLOCK_DESTROYED, index, block_x[index], block_y[index]);
+}
+
+/**
+*   @brief   Release Gem
+*   @details Classic levels drop a gem from every fifth block, generated
+             ones from the blocks that carry one; either way it falls from
+             the first free slot and every twenty-fifth block speeds the
+             ball up.
+*   @return  void
+*/
+void Simulation::releaseGem(int index)
+{
+	bool drops = state.gem_interval > 0 ?
+		state.no_hit % state.gem_interval == state.gem_interval - 1 :
+		state.block_drop[index] == (uint8_t)BlockDrop::GEM;
+	if (drops)
+	{
+		for (int i = 0; i < MAX_GEMS; i++)
+		{
+			if (!state.gem_visible[i])
+			{
+				SimBody& gem = state.gems[i];
+				gem.x = block_x[index] + (BLOCK_WIDTH - GEM_SIZE) / 2;
+				gem.y = block_y[index];
+				gem.vx = 0;
+				gem.vy = GEM_FALL;
+				state.gem_visible[i] = 1;
+				break;
+			}
+		}
+	}
+	if (state.no_hit % 25 == 24)
+	{
+		state.game_speed += SPEED_STEP;
+		report(TelemetryEvent::SPEED_STEP, state.no_hit + 1, state.game_speed, 0);
+	}
+}
+
+/**
+*   @brief   Release Power Up
+*   @details Drops the power up from the blocks that carry it.
+*   @return  void
+*/
+void Simulation::releasePowerUp(int index)
+{
+	if (state.block_drop[index] == (uint8_t)BlockDrop::POWER_UP)
+	{
+		SimBody& power_up = state.power_up;
+		power_up.x = block_x[index] + (BLOCK_WIDTH - GEM_SIZE) / 2;
+		power_up.y = block_y[index];
+		power_up.vx = 0;
+		power_up.vy = POWER_UP_FALL;
+		state.power_up_visible = 1;
+	}
+}
+
+/**
+*   @brief   Shoot laser
+*   @details Fires from the centre of the paddle while the power up has
+             shots left and a laser slot is free.
+*   @return  void
+*/
+void Simulation::shootLaser()
+{
+	if (!state.power_up_active || state.power_up_shots >= MAX_LASERS)
+	{
+		return;
+	}
+
+	for (int i = 0; i < MAX_LASERS; i++)
+	{
+		if (!state.laser_visible[i])
+		{
+			SimBody& laser = state.lasers[i];
+			laser.x = state.paddle.x + PADDLE_WIDTH / 2 - LASER_WIDTH / 2;
+			laser.y = FIELD_HEIGHT - PADDLE_HEIGHT;
+			laser.vx = 0;
+			laser.vy = -FIXED_ONE;
+			state.laser_visible[i] = 1;
+			state.power_up_shots++;
+			report(TelemetryEvent::LASER_FIRED, i, laser.x, laser.y);
+			return;
+		}
+	}
+}
+
+/**
+*   @brief   Brings the contact queue up to date
+*   @details A mover keeps its scheduled contact if that is still ahead
+             and it is where the prediction's line says it should be by
+             now, moving the same way at the same speed; otherwise its
+             contact is worked out again. So a gem being caught leaves
+             the ball's contact alone, and the ball bouncing leaves the
+             gems'.
+*   @return  void
+*/
+void Simulation::scheduleContacts()
+{
+	static_assert(FIRST_LASER_MOVER + MAX_LASERS == CONTACT_MOVERS, "every mover has a place in the queue");
+
+	for (int mover = 0; mover < CONTACT_MOVERS; mover++)
+	{
+		const SimBody& body = moverBody(state, mover);
+		uint8_t visible = moverVisible(state, mover);
+		bool ball = mover == BALL_MOVER;
+		bool hits_blocks = ball || mover >= FIRST_LASER_MOVER;
+		fixed speed = ball ? fixedMul(BALL_SPEED, state.game_speed) : DROP_SPEED;
+
+		Prediction& prediction = predictions[mover];
+		if (prediction.valid && contacts.tickOf(mover) >= state.tick && prediction.visible == visible &&
+			prediction.speed == speed && (!hits_blocks || prediction.block_changes == block_changes))
+		{
+			const SimBody& from = prediction.body;
+			int64_t ticks = state.tick - prediction.tick;
+			int64_t dx = ball ? fixedMul(from.vx, speed) : 0;
+			if (body.vx == from.vx && body.vy == from.vy &&
+				body.x == from.x + ticks * dx && body.y == from.y + ticks * fixedMul(from.vy, speed))
+			{
+				continue;
+			}
+		}
+
+		prediction.valid = true;
+		prediction.tick = state.tick;
+		prediction.block_changes = block_changes;
+		prediction.speed = speed;
+		prediction.visible = visible;
+		prediction.body = body;
+
+		int64_t ahead = HORIZON + 1;
+		if (ball)
+		{
+			ahead = ballContact();
+		}
+		else if (visible)
+		{
+			ahead = hits_blocks ? laserContact(body) : dropContact(body);
+		}
+		contacts.schedule(mover, ahead > HORIZON || ahead >= ContactQueue<CONTACT_MOVERS>::NEVER - state.tick ?
+			ContactQueue<CONTACT_MOVERS>::NEVER : state.tick + (uint32_t)ahead);
+	}
+}
+
+void Simulation::forgetContacts()
+{
+	for (Prediction& prediction : predictions)
+	{
+		prediction.valid = false;
+	}
+}
+
+/**
+*   @brief   Ticks until the ball next makes contact
+*   @details The walls and the paddle line come first, as they bound
+             the flight. Then each row with live blocks is crossed over
+             one stretch of ticks, and only blocks in the columns the
+             ball spans during it are tried. Overlapping a block is
+             counted as contact whether or not it bounces the ball, so
+             the answer is never late, only sometimes early.
+*   @return  The ticks, past HORIZON for never.
+*/
+int64_t Simulation::ballContact() const
+{
+	const SimBody& ball = state.ball;
+	fixed speed = fixedMul(BALL_SPEED, state.game_speed);
+	int64_t dx = fixedMul(ball.vx, speed);
+	int64_t dy = fixedMul(ball.vy, speed);
+
+	int64_t soonest = firstWithin(ball.y + BALL_SIZE, dy, state.paddle.y, NO_LIMIT);
+	if (ball.vx < 0)
+	{
+		soonest = std::min(soonest, firstWithin(ball.x, dx, -NO_LIMIT, 1));
+	}
+	else if (ball.vx > 0)
+	{
+		soonest = std::min(soonest, firstWithin(ball.x + BALL_SIZE, dx, FIELD_WIDTH - 1, NO_LIMIT));
+	}
+	if (ball.vy < 0)
+	{
+		soonest = std::min(soonest, firstWithin(ball.y, dy, -NO_LIMIT, 1));
+	}
+
+	for (int row = 0; row < BLOCK_ROWS; row++)
+	{
+		uint32_t live = block_grid.rowMask(row);
+		fixed top = GRID_TOP + row * BLOCK_HEIGHT;
+		int64_t first = 0;
+		int64_t last = std::min(soonest, HORIZON) - 1;
+		if (!live || !narrow(ball.y, dy, top - BALL_SIZE, top + BLOCK_HEIGHT, first, last))
+		{
+			continue;
+		}
+
+		int64_t from = std::min(ball.x + first * dx, ball.x + last * dx);
+		int64_t to = std::max(ball.x + first * dx, ball.x + last * dx);
+		from = std::max(from, (int64_t)-FIELD_WIDTH);
+		to = std::min(to, (int64_t)FIELD_WIDTH * 2);
+		for (uint32_t mask = live & columnSpan((fixed)from, (fixed)(to - from) + BALL_SIZE); mask; mask &= mask - 1)
+		{
+			fixed left = block_x[row * BLOCKS_PER_ROW + countTrailingZeros(mask)];
+			int64_t overlap_first = first;
+			int64_t overlap_last = last;
+			if (narrow(ball.x, dx, left - BALL_SIZE, left + BLOCK_WIDTH, overlap_first, overlap_last))
+			{
+				soonest = std::min(soonest, overlap_first);
+			}
+		}
+	}
+	return soonest;
+}
+
+/**
+*   @brief   Ticks until a laser next makes contact
+*   @details A laser only ever meets blocks in its own column, or
+             leaves the top.
+*   @return  The ticks, past HORIZON for never.
+*/
+int64_t Simulation::laserContact(const SimBody& laser) const
+{
+	int64_t dy = fixedMul(laser.vy, DROP_SPEED);
+	int64_t soonest = firstWithin(laser.y, dy, -NO_LIMIT, 1);
+
+	int column = laserColumn(laser.x);
+	for (int row = 0; column >= 0 && row < BLOCK_ROWS; row++)
+	{
+		if (block_grid.rowMask(row) & (1u << column))
+		{
+			fixed top = GRID_TOP + row * BLOCK_HEIGHT;
+			soonest = std::min(soonest, firstWithin(laser.y, dy, top - LASER_HEIGHT, top + BLOCK_HEIGHT));
+		}
+	}
+	return soonest;
+}
+
+/**
+*   @return  Ticks until a gem or the power up reaches the paddle line,
+             past HORIZON for never.
+*/
+int64_t Simulation::dropContact(const SimBody& drop) const
+{
+	return firstWithin(drop.y + GEM_SIZE, fixedMul(drop.vy, DROP_SPEED), state.paddle.y, NO_LIMIT);
+}
+
+void Simulation::setTelemetry(Telemetry* log)
+{
+	telemetry.log = log;
+}
+
+void Simulation::report(TelemetryEvent event, int index, fixed x, fixed y)
+{
+	if (telemetry.log)
+	{
+		telemetry.log->record(event, state.tick, index, x, y);
+	}
+}
+
+uint64_t Simulation::stateHash() const
+{
+	uint64_t hash = 14695981039346656037ull;
+	fnv1a(hash, &state.tick, sizeof(state.tick));
+	fnv1a(hash, &state.status, sizeof(state.status));
+	fnv1a(hash, &state.score, sizeof(state.score));
+	fnv1a(hash, &state.lives, sizeof(state.lives));
+	fnv1a(hash, &state.no_hit, sizeof(state.no_hit));
+	fnv1a(hash, &state.power_up_shots, sizeof(state.power_up_shots));
+	fnv1a(hash, &state.game_speed, sizeof(state.game_speed));
+	fnv1a(hash, &state.gem_interval, sizeof(state.gem_interval));
+	fnv1a(hash, &state.level, sizeof(state.level));
+
+	hashBody(hash, state.paddle);
+	hashBody(hash, state.ball);
+	hashBody(hash, state.power_up);
+	for (const SimBody& gem : state.gems)
+	{
+		hashBody(hash, gem);
+	}
+	for (const SimBody& laser : state.lasers)
+	{
+		hashBody(hash, laser);
+	}
+
+	fnv1a(hash, state.block_visible, sizeof(state.block_visible));
+	fnv1a(hash, state.block_type, sizeof(state.block_type));
+	fnv1a(hash, state.block_drop, sizeof(state.block_drop));
+	fnv1a(hash, state.gem_visible, sizeof(state.gem_visible));
+	fnv1a(hash, state.laser_visible, sizeof(state.laser_visible));
+	fnv1a(hash, &state.power_up_visible, sizeof(state.power_up_visible));
+	fnv1a(hash, &state.power_up_active, sizeof(state.power_up_active));
+	return hash;
+}
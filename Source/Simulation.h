@@ -0,0 +1,260 @@
+#pragma once
+#include <cstdint>
+
+#include "BlockGrid.h"
+#include "Constants.h"
+#include "ContactQueue.h"
+#include "Fixed.h"
+#include "LevelGenerator.h"
+#include "Telemetry.h"
+
+/**
+*  Outcome of the current game in the simulation.
+*/
+enum class SimStatus : int32_t
+{
+	PLAYING = 0,
+	WON = 1,
+	LOST = 2
+};
+
+/**
+*  A moving object in the simulation.
+*  Positions are the top-left corner in logical playfield units.
+*  Velocities are unit-ish directions that are scaled by the object's
+*  speed each tick, exactly like the float game objects.
+*/
+struct SimBody
+{
+	fixed x = 0;
+	fixed y = 0;
+	fixed vx = 0;
+	fixed vy = 0;
+};
+
+/**
+*  The complete gameplay state.
+*  Everything needed to continue a game from this point lives here and
+*  nothing in it points elsewhere, so it can be copied, hashed or diffed
+*  as plain memory.
+*/
+struct SimState
+{
+	uint32_t tick = 0;
+	SimStatus status = SimStatus::PLAYING;
+	int32_t score = 0;
+	int32_t lives = 0;
+	int32_t no_hit = 0;
+	int32_t power_up_shots = 0;
+	fixed game_speed = FIXED_ONE;
+	int32_t gem_interval = 0;  /**< Every nth block destroyed drops a gem, 0 to use block_drop. */
+	int32_t level = 0;         /**< Levels cleared so far in this game. */
+
+	SimBody paddle;
+	SimBody ball;
+	SimBody power_up;
+	SimBody gems[MAX_GEMS];
+	SimBody lasers[MAX_LASERS];
+
+	uint8_t block_visible[MAX_BLOCKS] = {};
+	uint8_t block_type[MAX_BLOCKS] = {};  /**< BlockType of each block. */
+	uint8_t block_drop[MAX_BLOCKS] = {};  /**< BlockDrop of each block. */
+	uint8_t gem_visible[MAX_GEMS] = {};
+	uint8_t laser_visible[MAX_LASERS] = {};
+	uint8_t power_up_visible = 0;
+	uint8_t power_up_active = 0;
+};
+
+/**
+*  Player input for a single simulation tick.
+*/
+struct SimInput
+{
+	fixed paddle_axis = 0;  /**< -1 full left, 0 stopped, 1 full right. */
+	bool paddle_tracking = false;  /**< Centre the paddle on paddle_target instead. */
+	fixed paddle_target = 0;       /**< Playfield x, e.g. under the mouse. */
+	bool fire = false;      /**< Fire a laser if the power up is active. */
+};
+
+/**
+*  Deterministic fixed point Breakout simulation.
+*  Runs the same rules as BreakoutGame's float update but in 16.16 integer
+*  units on a resolution independent playfield (PLAYFIELD_WIDTH by
+*  PLAYFIELD_HEIGHT) at a fixed tick rate. Screen space only comes into
+*  it when the game maps the state onto its sprites for rendering, so two
+*  runs fed the same inputs produce bit-identical states on any machine.
+*  It has no dependency on the renderer and can be run headless.
+*/
+class Simulation
+{
+public:
+	/**
+	*  Object sizes in logical units.
+	*  Derived from the proportions BreakoutGame::init uses for sprites.
+	*/
+	static constexpr fixed PADDLE_WIDTH  = toFixed(120);
+	static constexpr fixed PADDLE_HEIGHT = toFixed(24);
+	static constexpr fixed BALL_SIZE     = toFixed(24);
+	static constexpr fixed BLOCK_WIDTH   = toFixed(66);
+	static constexpr fixed BLOCK_HEIGHT  = toFixed(28);
+	static constexpr fixed GEM_SIZE      = toFixed(28);
+	static constexpr fixed LASER_WIDTH   = toFixed(8);
+	static constexpr fixed LASER_HEIGHT  = toFixed(28);
+
+	/**
+	*  Speeds in logical units per tick.
+	*  The float game uses 0.45 and 0.5 of the window height per second,
+	*  the window being 1.25x the field. Drops scale DROP_SPEED by their
+	*  fall rate.
+	*/
+	static constexpr fixed PADDLE_SPEED  = fixedRatio(450, SIM_TICK_RATE);
+	static constexpr fixed BALL_SPEED    = fixedRatio(500, SIM_TICK_RATE);
+	static constexpr fixed DROP_SPEED    = fixedRatio(450, SIM_TICK_RATE);
+	static constexpr fixed GEM_FALL      = fixedRatio(1, 2);
+	static constexpr fixed POWER_UP_FALL = fixedRatio(45, 100);
+
+	Simulation() = default;
+
+	/**
+	*  Resets the state and lays out the classic blocks for a new game.
+	*/
+	void newGame();
+
+	/**
+	*  Resets the state and lays out a level for a new game.
+	*  @param [in] level At most BLOCKS_PER_ROW by BLOCK_ROWS; only read
+	*              while laying out.
+	*/
+	void newGame(const LevelLayout& level);
+
+	/**
+	*  Lays out the next level of a run, keeping the score, lives and
+	*  speed, counting the level cleared, and serves the ball again.
+	*  @param [in] level As for newGame.
+	*/
+	void nextLevel(const LevelLayout& level);
+
+	/**
+	*  Advances the simulation by one tick (1 / SIM_TICK_RATE seconds).
+	*  Does nothing once the game has been won or lost.
+	*  @param [in] input The player's input for this tick.
+	*/
+	void step(const SimInput& input);
+
+	/**
+	*  Runs the ticks before the next contact in one go.
+	*  Between contacts every mover travels in a straight line, so the
+	*  tick each next reaches a wall, a block or the paddle line is
+	*  worked out from where it is and kept in a queue, and the ticks
+	*  before the soonest are one jump along every line. The state is
+	*  exactly what stepping them one at a time would leave. A contact
+	*  only invalidates the predictions of the movers it changed, and of
+	*  the ball and lasers when a block dies.
+	*  @param [in] input Held for every tick; firing is never coasted.
+	*  @param [in] max_ticks The most to run.
+	*  @return The ticks run, 0 if the next step makes contact.
+	*/
+	uint32_t coast(const SimInput& input, uint32_t max_ticks);
+
+	/**
+	*  Returns the current state.
+	*  @return The state after the last tick.
+	*/
+	const SimState& getState() const;
+
+	/**
+	*  Replaces the current state, e.g. to restore a saved one.
+	*  @param [in] new_state The state to continue from.
+	*/
+	void setState(const SimState& new_state);
+
+	fixed blockX(int index) const;
+	fixed blockY(int index) const;
+
+	/**
+	*  Returns the occupancy index of the live blocks.
+	*  Always agrees with the state's block_visible flags.
+	*/
+	const BlockGrid& getBlockGrid() const;
+
+	/**
+	*  Finds the column a laser at x would travel up.
+	*  @param [in] x The laser's left edge.
+	*  @return The column, or -1 if it would pass between two.
+	*/
+	static int laserColumn(fixed x);
+
+	/**
+	*  Hashes the gameplay state.
+	*  Two simulations that agree on this have identical states, which makes
+	*  it cheap to compare runs across machines or builds.
+	*  @return A 64-bit FNV-1a hash of every state field.
+	*/
+	uint64_t stateHash() const;
+
+	/**
+	*  Reports gameplay events to a telemetry log.
+	*  The log belongs to this simulation rather than its state: copies
+	*  made to look ahead, like the autopilot's, start without one, so
+	*  only the game actually being played is recorded.
+	*  @param [in] log The log to record to, nullptr to stop.
+	*/
+	void setTelemetry(Telemetry* log);
+
+private:
+	struct TelemetrySink
+	{
+		TelemetrySink() = default;
+		TelemetrySink(const TelemetrySink&) {}
+		TelemetrySink& operator=(const TelemetrySink&) { return *this; }
+
+		Telemetry* log = nullptr;
+	};
+
+	void wallCollision();
+	void blockCollision();
+	void paddleCollision();
+	void integrate(const SimInput& input);
+	void serveBall();
+	void layOut(const LevelLayout& level);
+	void destroyBlock(int index);
+	void laserCandidates(const SimBody& laser, uint32_t* candidates) const;
+	void releaseGem(int index);
+	void releasePowerUp(int index);
+	void shootLaser();
+	void report(TelemetryEvent event, int index, fixed x, fixed y);
+
+	/**
+	*  What a mover's scheduled contact was predicted from. It holds for
+	*  as long as the mover is still on that line at that speed and, for
+	*  the ball and lasers, no block has died since.
+	*/
+	struct Prediction
+	{
+		bool valid = false;
+		uint32_t tick = 0;
+		uint32_t block_changes = 0;
+		fixed speed = 0;
+		uint8_t visible = 0;
+		SimBody body;
+	};
+
+	// the ball, the power up, the gems, then the lasers
+	static constexpr int CONTACT_MOVERS = 2 + MAX_GEMS + MAX_LASERS;
+
+	void scheduleContacts();
+	void forgetContacts();
+	int64_t ballContact() const;
+	int64_t laserContact(const SimBody& laser) const;
+	int64_t dropContact(const SimBody& drop) const;
+
+	SimState state;
+	fixed block_x[MAX_BLOCKS] = {};
+	fixed block_y[MAX_BLOCKS] = {};
+	BlockGrid block_grid;
+	TelemetrySink telemetry;
+
+	Prediction predictions[CONTACT_MOVERS];
+	ContactQueue<CONTACT_MOVERS> contacts;
+	uint32_t block_changes = 0;  /**< Blocks destroyed, so predictions can tell. */
+};
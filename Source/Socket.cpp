@@ -0,0 +1,211 @@
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "Socket.h"
+
+namespace
+{
+#ifdef _WIN32
+	using native_socket = SOCKET;
+	constexpr int SEND_FLAGS = 0;
+
+	/**
+	*  Initialises Winsock on first use and shuts it down at exit.
+	*/
+	struct WinsockSession
+	{
+		bool ready = false;
+		WinsockSession()
+		{
+			WSADATA data;
+			ready = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+		}
+		~WinsockSession()
+		{
+			if (ready)
+			{
+				WSACleanup();
+			}
+		}
+	};
+
+	bool startup()
+	{
+		static WinsockSession session;
+		return session.ready;
+	}
+
+	bool wouldBlock()
+	{
+		int error = WSAGetLastError();
+		return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+	}
+
+	bool setNonBlocking(native_socket s)
+	{
+		u_long mode = 1;
+		return ioctlsocket(s, FIONBIO, &mode) == 0;
+	}
+#else
+	using native_socket = int;
+	constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+
+	bool startup()
+	{
+		return true;
+	}
+
+	bool wouldBlock()
+	{
+		return errno == EWOULDBLOCK || errno == EAGAIN || errno == EINPROGRESS;
+	}
+
+	bool setNonBlocking(native_socket s)
+	{
+		int flags = fcntl(s, F_GETFL, 0);
+		return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+	}
+#endif
+
+	native_socket native(intptr_t handle)
+	{
+		return (native_socket)handle;
+	}
+
+	/**
+	*  Small state updates should go out immediately rather than wait
+	*  to be coalesced.
+	*/
+	void setNoDelay(native_socket s)
+	{
+		int on = 1;
+		setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));
+	}
+
+	sockaddr_in loopback(int port)
+	{
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_port = htons((uint16_t)port);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		return address;
+	}
+}
+
+intptr_t socketListen(int port)
+{
+	if (!startup())
+	{
+		return INVALID_SOCKET_HANDLE;
+	}
+
+	native_socket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if ((intptr_t)s == INVALID_SOCKET_HANDLE)
+	{
+		return INVALID_SOCKET_HANDLE;
+	}
+
+	int reuse = 1;
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	sockaddr_in address = loopback(port);
+	if (bind(s, (const sockaddr*)&address, sizeof(address)) != 0 ||
+		listen(s, SOMAXCONN) != 0 || !setNonBlocking(s))
+	{
+		socketClose((intptr_t)s);
+		return INVALID_SOCKET_HANDLE;
+	}
+	return (intptr_t)s;
+}
+
+intptr_t socketAccept(intptr_t listener)
+{
+	native_socket s = accept(native(listener), nullptr, nullptr);
+	if ((intptr_t)s == INVALID_SOCKET_HANDLE)
+	{
+		return INVALID_SOCKET_HANDLE;
+	}
+	if (!setNonBlocking(s))
+	{
+		socketClose((intptr_t)s);
+		return INVALID_SOCKET_HANDLE;
+	}
+	setNoDelay(s);
+	return (intptr_t)s;
+}
+
+intptr_t socketConnect(const char* host, int port)
+{
+	if (!startup())
+	{
+		return INVALID_SOCKET_HANDLE;
+	}
+
+	native_socket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if ((intptr_t)s == INVALID_SOCKET_HANDLE)
+	{
+		return INVALID_SOCKET_HANDLE;
+	}
+
+	sockaddr_in address = loopback(port);
+	if (host && inet_pton(AF_INET, host, &address.sin_addr) != 1)
+	{
+		socketClose((intptr_t)s);
+		return INVALID_SOCKET_HANDLE;
+	}
+	if (connect(s, (const sockaddr*)&address, sizeof(address)) != 0 ||
+		!setNonBlocking(s))
+	{
+		socketClose((intptr_t)s);
+		return INVALID_SOCKET_HANDLE;
+	}
+	setNoDelay(s);
+	return (intptr_t)s;
+}
+
+int socketSend(intptr_t socket, const uint8_t* data, size_t size)
+{
+	int sent = (int)send(native(socket), (const char*)data, (int)size, SEND_FLAGS);
+	if (sent < 0)
+	{
+		return wouldBlock() ? 0 : -1;
+	}
+	return sent;
+}
+
+int socketReceive(intptr_t socket, uint8_t* data, size_t size)
+{
+	int received = (int)recv(native(socket), (char*)data, (int)size, 0);
+	if (received < 0)
+	{
+		return wouldBlock() ? 0 : -1;
+	}
+	if (received == 0)
+	{
+		return -1;
+	}
+	return received;
+}
+
+void socketClose(intptr_t socket)
+{
+	if (socket == INVALID_SOCKET_HANDLE)
+	{
+		return;
+	}
+#ifdef _WIN32
+	closesocket(native(socket));
+#else
+	close(native(socket));
+#endif
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/*! \file Socket.h
+@brief   Minimal non-blocking TCP sockets.
+@details Thin wrappers over Winsock and BSD sockets so the networking
+         code above them is platform agnostic. Every socket returned is
+         already in non-blocking mode. Handles are stored as intptr_t so
+         callers do not need the platform headers.
+*/
+
+constexpr intptr_t INVALID_SOCKET_HANDLE = -1;
+
+/**
+*   @brief   Opens a listening socket on the loopback interface.
+*   @param   [in] port The port to listen on.
+*   @return  The socket, or INVALID_SOCKET_HANDLE on failure.
+*/
+intptr_t socketListen(int port);
+
+/**
+*   @brief   Accepts a pending connection, if there is one.
+*   @return  The new socket, or INVALID_SOCKET_HANDLE if none is waiting.
+*/
+intptr_t socketAccept(intptr_t listener);
+
+/**
+*   @brief   Connects to a listening socket.
+*   @details The connect itself blocks; the socket is non-blocking after.
+*   @return  The socket, or INVALID_SOCKET_HANDLE on failure.
+*/
+intptr_t socketConnect(const char* host, int port);
+
+/**
+*   @brief   Sends as much of a buffer as the socket will take right now.
+*   @return  Bytes sent (0 if the send buffer is full) or -1 on error.
+*/
+int socketSend(intptr_t socket, const uint8_t* data, size_t size);
+
+/**
+*   @brief   Receives whatever has arrived, without waiting.
+*   @return  Bytes received (0 if nothing is waiting) or -1 on error or
+             when the other end has closed the connection.
+*/
+int socketReceive(intptr_t socket, uint8_t* data, size_t size);
+
+void socketClose(intptr_t socket);
@@ -0,0 +1,910 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <Engine/Input.h>
+
+#include "AssetBundle.h"
+#include "AssetLoader.h"
+#include "Assets.h"
+#include "CampaignLevels.h"
+#include "Constants.h"
+#include "FrameCapture.h"
+#include "LevelGenerator.h"
+#include "SoftwareRenderer.h"
+
+namespace
+{
+	/**
+	*  Printable ASCII, space to tilde, 8x8. A byte a row from the top,
+	*  the lowest bit the leftmost pixel; the last row is for descenders,
+	*  so the baseline sits under row 6. Public domain (font8x8_basic).
+	*/
+	constexpr uint8_t FONT[95][8] =
+	{
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // space
+		{ 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 },  // !
+		{ 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // "
+		{ 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 },  // #
+		{ 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 },  // $
+		{ 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 },  // %
+		{ 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 },  // &
+		{ 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 },  // '
+		{ 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 },  // (
+		{ 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 },  // )
+		{ 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 },  // *
+		{ 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 },  // +
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 },  // ,
+		{ 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 },  // -
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 },  // .
+		{ 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 },  // /
+		{ 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 },  // 0
+		{ 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 },  // 1
+		{ 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 },  // 2
+		{ 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 },  // 3
+		{ 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 },  // 4
+		{ 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 },  // 5
+		{ 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 },  // 6
+		{ 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 },  // 7
+		{ 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 },  // 8
+		{ 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 },  // 9
+		{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 },  // :
+		{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 },  // ;
+		{ 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 },  // <
+		{ 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 },  // =
+		{ 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 },  // >
+		{ 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 },  // ?
+		{ 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 },  // @
+		{ 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 },  // A
+		{ 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 },  // B
+		{ 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 },  // C
+		{ 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 },  // D
+		{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 },  // E
+		{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 },  // F
+		{ 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 },  // G
+		{ 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 },  // H
+		{ 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  // I
+		{ 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 },  // J
+		{ 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 },  // K
+		{ 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 },  // L
+		{ 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 },  // M
+		{ 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 },  // N
+		{ 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 },  // O
+		{ 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 },  // P
+		{ 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 },  // Q
+		{ 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 },  // R
+		{ 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 },  // S
+		{ 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  // T
+		{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 },  // U
+		{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },  // V
+		{ 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 },  // W
+		{ 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 },  // X
+		{ 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 },  // Y
+		{ 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 },  // Z
+		{ 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 },  // [
+		{ 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 },  // backslash
+		{ 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 },  // ]
+		{ 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 },  // ^
+		{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF },  // _
+		{ 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 },  // `
+		{ 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 },  // a
+		{ 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 },  // b
+		{ 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 },  // c
+		{ 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 },  // d
+		{ 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 },  // e
+		{ 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 },  // f
+		{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F },  // g
+		{ 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 },  // h
+		{ 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  // i
+		{ 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E },  // j
+		{ 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 },  // k
+		{ 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  // l
+		{ 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 },  // m
+		{ 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 },  // n
+		{ 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 },  // o
+		{ 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F },  // p
+		{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 },  // q
+		{ 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 },  // r
+		{ 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 },  // s
+		{ 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 },  // t
+		{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 },  // u
+		{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },  // v
+		{ 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 },  // w
+		{ 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 },  // x
+		{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F },  // y
+		{ 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 },  // z
+		{ 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 },  // {
+		{ 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 },  // |
+		{ 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 },  // }
+		{ 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // ~
+	};
+	constexpr int GLYPH_SIZE = 8;
+	constexpr int GLYPH_BASELINE = 7;  /**< Rows above the baseline. */
+
+	uint16_t fixedColour(float value, float scale)
+	{
+		value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+		return (uint16_t)(value * scale + 0.5f);
+	}
+
+	float clampPixel(float x, int low, int high)
+	{
+		return x < (float)low ? (float)low : x > (float)high ? (float)high : x;
+	}
+
+	/**
+	*   @brief   Narrows a span to where a coordinate is in range
+	*   @details The coordinate is start + x * step at pixel x; solving
+				 for the ends of the range in float and rounding to whole
+				 pixels keeps the span's edges where they would fall if
+				 the row were drawn in one piece.
+	*   @return  void
+	*/
+	void clipSpan(float start, float step, float low, float high, int& first, int& last)
+	{
+		if (first >= last)
+		{
+			return;
+		}
+		if (step == 0.0f)
+		{
+			if (start < low || start >= high)
+			{
+				last = first;
+			}
+			return;
+		}
+
+		float to_low = (low - start) / step;
+		float to_high = (high - start) / step;
+		int begin, end;
+		if (step > 0.0f)
+		{
+			begin = (int)std::ceil(clampPixel(to_low, first, last));
+			end = (int)std::ceil(clampPixel(to_high, first, last));
+		}
+		else
+		{
+			begin = (int)std::floor(clampPixel(to_high, first - 1, last)) + 1;
+			end = (int)std::floor(clampPixel(to_low, first - 1, last)) + 1;
+		}
+		first = std::max(first, begin);
+		last = std::min(last, end);
+	}
+}
+
+SoftwareTexture::SoftwareTexture(const Image& image)
+	: ASGE::Texture2D(image.width, image.height)
+{
+	setFormat(RGBA);
+	texels.assign((size_t)(image.width + 1) * (image.height + 1) * 4, 0);
+	setData(const_cast<uint8_t*>(image.pixels.data()));
+}
+
+void SoftwareTexture::setData(void* data)
+{
+	const uint8_t* source = static_cast<const uint8_t*>(data);
+	size_t row = (size_t)dims[0] * 4;
+	for (unsigned int y = 0; y < dims[1]; y++)
+	{
+		std::memcpy(&texels[y * (row + 4)], source + y * row, row);
+	}
+	repeatEdges();
+}
+
+void* SoftwareTexture::getData()
+{
+	return texels.data();
+}
+
+const uint8_t* SoftwareTexture::getTexels() const
+{
+	return texels.data();
+}
+
+int SoftwareTexture::getPitch() const
+{
+	return (int)dims[0] + 1;
+}
+
+void SoftwareTexture::repeatEdges()
+{
+	if (dims[0] == 0 || dims[1] == 0)
+	{
+		return;
+	}
+
+	size_t pitch = ((size_t)dims[0] + 1) * 4;
+	for (unsigned int y = 0; y < dims[1]; y++)
+	{
+		uint8_t* row = &texels[y * pitch];
+		std::memcpy(row + (size_t)dims[0] * 4, row + ((size_t)dims[0] - 1) * 4, 4);
+	}
+	std::memcpy(&texels[dims[1] * pitch], &texels[(dims[1] - 1) * pitch], pitch);
+}
+
+SoftwareSprite::SoftwareSprite(SoftwareRenderer& renderer)
+	: renderer(renderer)
+{
+	flip_flags = NORMAL;
+}
+
+/**
+*   @brief   Loads the sprite's texture
+*   @details Like the GL sprite, the sprite takes the texture's size and
+			 shows all of it until told otherwise.
+*   @return  True if the texture loaded.
+*/
+bool SoftwareSprite::loadTexture(const std::string& path)
+{
+	std::shared_ptr<SoftwareTexture> loaded = renderer.loadTexture(path);
+	if (!loaded)
+	{
+		return false;
+	}
+
+	texture = loaded;
+	dims[0] = src_rect[2] = (float)texture->getWidth();
+	dims[1] = src_rect[3] = (float)texture->getHeight();
+	src_rect[0] = src_rect[1] = 0.0f;
+	return true;
+}
+
+const ASGE::Texture2D* SoftwareSprite::getTexture() const
+{
+	return texture.get();
+}
+
+/**
+*   @brief   Constructor
+*   @details ASGE has no render library for a CPU renderer, so it
+			 reports none.
+*/
+SoftwareRenderer::SoftwareRenderer()
+	: ASGE::Renderer(ASGE::Renderer::RenderLib::INVALID)
+{
+}
+
+void SoftwareRenderer::setJobSystem(JobSystem* job_system)
+{
+	jobs = job_system;
+}
+
+void SoftwareRenderer::setVectorised(bool vectorise)
+{
+	vectorised = vectorise;
+}
+
+void SoftwareRenderer::setCapture(FrameCapture* frame_capture)
+{
+	capture = frame_capture;
+}
+
+bool SoftwareRenderer::init(int width, int height, ASGE::Renderer::WindowMode mode)
+{
+	if (width <= 0 || height <= 0)
+	{
+		return false;
+	}
+
+	window_mode = mode;
+	framebuffer.width = width;
+	framebuffer.height = height;
+	framebuffer.pixels.assign((size_t)width * height * 4, 255);
+	tiles_x = (width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	tiles_y = (height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+	tile_commands.assign((size_t)tiles_x * tiles_y, std::vector<int>());
+	return true;
+}
+
+bool SoftwareRenderer::exit()
+{
+	commands.clear();
+	tile_commands.clear();
+	textures.clear();
+	framebuffer = Image();
+	tiles_x = tiles_y = 0;
+	return true;
+}
+
+void SoftwareRenderer::setClearColour(ASGE::Colour rgb)
+{
+	cls = rgb;
+}
+
+/**
+*   @brief   Loads a font
+*   @details Text always uses the built in font.
+*   @return  0, the only font.
+*/
+int SoftwareRenderer::loadFont(const char*, int)
+{
+	return 0;
+}
+
+void SoftwareRenderer::setFont(int)
+{
+}
+
+const ASGE::Font& SoftwareRenderer::getActiveFont() const
+{
+	return font;
+}
+
+void SoftwareRenderer::setDefaultTextColour(const ASGE::Colour& colour)
+{
+	default_text_colour = colour;
+}
+
+void SoftwareRenderer::setSpriteMode(ASGE::SpriteSortMode mode)
+{
+	sort_mode = mode;
+}
+
+void SoftwareRenderer::setWindowedMode(ASGE::Renderer::WindowMode mode)
+{
+	window_mode = mode;
+}
+
+void SoftwareRenderer::setWindowTitle(const char*)
+{
+}
+
+/**
+*   @brief   Starts a frame
+*   @details The clear happens tile by tile as the frame is drawn, while
+			 each tile is in the cache anyway.
+*   @return  void
+*/
+void SoftwareRenderer::preRender()
+{
+	commands.clear();
+}
+
+/**
+*   @brief   Draws the frame
+*   @details Commands are binned to the tiles they touch, then the tiles
+			 are shared out as jobs; no two tiles write the same pixel.
+*   @return  void
+*/
+void SoftwareRenderer::postRender()
+{
+	if (framebuffer.pixels.empty())
+	{
+		return;
+	}
+
+	sortCommands();
+	binCommands();
+
+	int tiles = tiles_x * tiles_y;
+	if (jobs)
+	{
+		graph.clear();
+		graph.addStage(tiles, 1, [this](int begin, int end)
+		{
+			for (int tile = begin; tile < end; tile++)
+			{
+				drawTile(tile);
+			}
+		});
+		jobs->run(graph);
+	}
+	else
+	{
+		for (int tile = 0; tile < tiles; tile++)
+		{
+			drawTile(tile);
+		}
+	}
+}
+
+void SoftwareRenderer::swapBuffers()
+{
+	if (capture)
+	{
+		capture->submit(framebuffer);
+	}
+}
+
+/**
+*   @brief   Queues a sprite
+*   @details Works out the sprite's bounds on screen and the mapping from
+			 a pixel back to the texel it shows: the pixel is rotated
+			 back about the sprite's centre, then scaled from the
+			 sprite's size to its source rectangle, mirrored if flipped.
+*   @return  void
+*/
+void SoftwareRenderer::renderSprite(const ASGE::Sprite& sprite, float z_order)
+{
+	const SoftwareTexture* texture = static_cast<const SoftwareTexture*>(sprite.getTexture());
+	float width = sprite.width() * sprite.scale();
+	float height = sprite.height() * sprite.scale();
+	if (!texture || width <= 0.0f || height <= 0.0f || sprite.opacity() <= 0.0f)
+	{
+		return;
+	}
+
+	float cosine = std::cos(sprite.rotationInRadians());
+	float sine = std::sin(sprite.rotationInRadians());
+	float centre_x = sprite.xPos() + width * 0.5f;
+	float centre_y = sprite.yPos() + height * 0.5f;
+	float extent_x = (std::fabs(cosine) * width + std::fabs(sine) * height) * 0.5f;
+	float extent_y = (std::fabs(sine) * width + std::fabs(cosine) * height) * 0.5f;
+
+	Command command;
+	command.kind = SPRITE;
+	command.left = std::max(0, (int)std::floor(centre_x - extent_x));
+	command.top = std::max(0, (int)std::floor(centre_y - extent_y));
+	command.right = std::min(framebuffer.width, (int)std::ceil(centre_x + extent_x));
+	command.bottom = std::min(framebuffer.height, (int)std::ceil(centre_y + extent_y));
+	if (command.left >= command.right || command.top >= command.bottom)
+	{
+		return;
+	}
+
+	const float* src = sprite.srcRect();
+	std::memcpy(command.src, src, sizeof(command.src));
+	float scale_u = src[2] / width * (sprite.isFlippedOnX() ? -1.0f : 1.0f);
+	float scale_v = src[3] / height * (sprite.isFlippedOnY() ? -1.0f : 1.0f);
+	float middle_u = src[0] + src[2] * 0.5f;
+	float middle_v = src[1] + src[3] * 0.5f;
+	command.u_x = scale_u * cosine;
+	command.u_y = scale_u * sine;
+	command.u_0 = middle_u - scale_u * (cosine * centre_x + sine * centre_y);
+	command.v_x = -scale_v * sine;
+	command.v_y = scale_v * cosine;
+	command.v_0 = middle_v - scale_v * (cosine * centre_y - sine * centre_x);
+	command.u_low = src[0];
+	command.u_high = src[0] + src[2];
+	command.v_low = src[1];
+	command.v_high = src[1] + src[3];
+
+	ASGE::Colour tint = sprite.colour();
+	command.colour[0] = fixedColour(tint.r, 256.0f);
+	command.colour[1] = fixedColour(tint.g, 256.0f);
+	command.colour[2] = fixedColour(tint.b, 256.0f);
+	command.colour[3] = fixedColour(sprite.opacity(), 256.0f);
+	command.texture = texture;
+	command.z_order = z_order;
+	command.order = (int)commands.size();
+	commands.push_back(command);
+}
+
+/**
+*   @brief   Queues text
+*   @details One command per character, so a tile only draws the
+			 characters it holds. As with the GL renderer, y is the
+			 baseline.
+*   @return  void
+*/
+void SoftwareRenderer::renderText(const std::string str, int x, int y, float scale,
+	const ASGE::Colour& colour, float z_order)
+{
+	float size = scale * RASTER_GLYPH_SCALE;
+	if (size <= 0.0f)
+	{
+		return;
+	}
+
+	Command command;
+	command.kind = GLYPH;
+	command.glyph_size = size;
+	command.glyph_y = (float)y - GLYPH_BASELINE * size;
+	command.colour[0] = fixedColour(colour.r, 255.0f);
+	command.colour[1] = fixedColour(colour.g, 255.0f);
+	command.colour[2] = fixedColour(colour.b, 255.0f);
+	command.colour[3] = 256;
+	command.z_order = z_order;
+	command.top = std::max(0, (int)std::floor(command.glyph_y));
+	command.bottom = std::min(framebuffer.height, (int)std::ceil(command.glyph_y + GLYPH_SIZE * size));
+
+	float cursor = (float)x;
+	for (char character : str)
+	{
+		float next = cursor + GLYPH_SIZE * size;
+		if (character > ' ' && character <= '~')
+		{
+			command.character = (uint8_t)character;
+			command.glyph_x = cursor;
+			command.left = std::max(0, (int)std::floor(cursor));
+			command.right = std::min(framebuffer.width, (int)std::ceil(next));
+			if (command.left < command.right && command.top < command.bottom)
+			{
+				command.order = (int)commands.size();
+				commands.push_back(command);
+			}
+		}
+		cursor = next;
+	}
+}
+
+std::unique_ptr<ASGE::Input> SoftwareRenderer::inputPtr()
+{
+	return nullptr;
+}
+
+std::unique_ptr<ASGE::Sprite> SoftwareRenderer::createUniqueSprite()
+{
+	return std::unique_ptr<ASGE::Sprite>(new SoftwareSprite(*this));
+}
+
+ASGE::Sprite* SoftwareRenderer::createRawSprite()
+{
+	return new SoftwareSprite(*this);
+}
+
+std::shared_ptr<SoftwareTexture> SoftwareRenderer::loadTexture(const std::string& path)
+{
+	auto cached = textures.find(path);
+	if (cached != textures.end())
+	{
+		return cached->second;
+	}
+
+	std::ifstream in(path, std::ios::binary);
+	if (in.fail())
+	{
+		return nullptr;
+	}
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	Image image;
+	std::string error;
+	if (!decodePng(bytes, image, error))
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<SoftwareTexture> texture = std::make_shared<SoftwareTexture>(image);
+	textures[path] = texture;
+	return texture;
+}
+
+/**
+*   @brief   Loads the manifest's textures
+*   @details The files are read and decoded across an AssetLoader's
+			 workers; this thread only pads each image out into a
+			 texture as it is handed back.
+*   @return  true if every texture loaded.
+*/
+bool SoftwareRenderer::loadAssets(const AssetBundle& bundle)
+{
+	AssetLoader loader;
+	loader.startDecoding(0, bundle);
+	loader.finish();
+
+	bool loaded = true;
+	for (int i = 0; i < NUM_ASSETS; i++)
+	{
+		Image image;
+		if (!loader.takeImage(i, image))
+		{
+			loaded = false;
+			continue;
+		}
+		textures[assetPath(ASSETS[i].name)] = std::make_shared<SoftwareTexture>(image);
+	}
+	return loaded;
+}
+
+const Image& SoftwareRenderer::getFramebuffer() const
+{
+	return framebuffer;
+}
+
+int SoftwareRenderer::getTileCount() const
+{
+	return tiles_x * tiles_y;
+}
+
+int SoftwareRenderer::getCommandCount() const
+{
+	return (int)commands.size();
+}
+
+/**
+*   @brief   Orders the queue for the sort mode
+*   @details Deferred and immediate draw in the order things were
+			 queued. The others group by texture, as the GL renderer
+			 does to save state changes, and the z-order modes sort by
+			 depth first.
+*   @return  void
+*/
+void SoftwareRenderer::sortCommands()
+{
+	if (sort_mode == ASGE::SpriteSortMode::IMMEDIATE || sort_mode == ASGE::SpriteSortMode::DEFERRED)
+	{
+		return;
+	}
+
+	ASGE::SpriteSortMode mode = sort_mode;
+	std::sort(commands.begin(), commands.end(), [mode](const Command& a, const Command& b)
+	{
+		if (a.z_order != b.z_order && mode != ASGE::SpriteSortMode::TEXTURE)
+		{
+			return mode == ASGE::SpriteSortMode::BACK_TO_FRONT ?
+				a.z_order < b.z_order : a.z_order > b.z_order;
+		}
+		if (a.texture != b.texture)
+		{
+			return std::less<const SoftwareTexture*>()(a.texture, b.texture);
+		}
+		return a.order < b.order;
+	});
+}
+
+void SoftwareRenderer::binCommands()
+{
+	for (std::vector<int>& tile : tile_commands)
+	{
+		tile.clear();
+	}
+	for (int i = 0; i < (int)commands.size(); i++)
+	{
+		const Command& command = commands[i];
+		for (int y = command.top / RASTER_TILE_SIZE; y <= (command.bottom - 1) / RASTER_TILE_SIZE; y++)
+		{
+			for (int x = command.left / RASTER_TILE_SIZE; x <= (command.right - 1) / RASTER_TILE_SIZE; x++)
+			{
+				tile_commands[(size_t)y * tiles_x + x].push_back(i);
+			}
+		}
+	}
+}
+
+void SoftwareRenderer::drawTile(int tile)
+{
+	int left = (tile % tiles_x) * RASTER_TILE_SIZE;
+	int top = (tile / tiles_x) * RASTER_TILE_SIZE;
+	int right = std::min(left + RASTER_TILE_SIZE, framebuffer.width);
+	int bottom = std::min(top + RASTER_TILE_SIZE, framebuffer.height);
+
+	const uint16_t clear[4] = { fixedColour(cls.r, 255.0f), fixedColour(cls.g, 255.0f),
+		fixedColour(cls.b, 255.0f), 256 };
+	for (int y = top; y < bottom; y++)
+	{
+		uint8_t* row = &framebuffer.pixels[((size_t)y * framebuffer.width + left) * 4];
+		(vectorised ? fillSpan : fillSpanScalar)(row, right - left, clear);
+	}
+
+	for (int index : tile_commands[tile])
+	{
+		const Command& command = commands[index];
+		int clip_left = std::max(left, command.left);
+		int clip_top = std::max(top, command.top);
+		int clip_right = std::min(right, command.right);
+		int clip_bottom = std::min(bottom, command.bottom);
+		if (command.kind == SPRITE)
+		{
+			drawSprite(command, clip_left, clip_top, clip_right, clip_bottom);
+		}
+		else
+		{
+			drawGlyph(command, clip_left, clip_top, clip_right, clip_bottom);
+		}
+	}
+}
+
+void SoftwareRenderer::drawSprite(const Command& command, int left, int top, int right, int bottom)
+{
+	SpanSampler sampler;
+	sampler.texels = command.texture->getTexels();
+	sampler.pitch = command.texture->getPitch();
+	sampler.du = command.u_x;
+	sampler.dv = command.v_x;
+	sampler.min_u = command.src[0];
+	sampler.min_v = command.src[1];
+	sampler.max_u = std::max(command.src[0], command.src[0] + command.src[2] - 1.0f);
+	sampler.max_v = std::max(command.src[1], command.src[1] + command.src[3] - 1.0f);
+	std::memcpy(sampler.tint, command.colour, sizeof(sampler.tint));
+	auto draw = vectorised ? drawSpan : drawSpanScalar;
+
+	for (int y = top; y < bottom; y++)
+	{
+		// where pixel 0's centre of this row maps to
+		float centre_y = (float)y + 0.5f;
+		float row_u = command.u_x * 0.5f + command.u_y * centre_y + command.u_0;
+		float row_v = command.v_x * 0.5f + command.v_y * centre_y + command.v_0;
+		int first = left;
+		int last = right;
+		clipSpan(row_u, command.u_x, command.u_low, command.u_high, first, last);
+		clipSpan(row_v, command.v_x, command.v_low, command.v_high, first, last);
+		if (first >= last)
+		{
+			continue;
+		}
+
+		// the kernels sample with texel centres on whole numbers
+		sampler.u = row_u - 0.5f;
+		sampler.v = row_v - 0.5f;
+		draw(&framebuffer.pixels[(size_t)y * framebuffer.width * 4], first, last - first, sampler);
+	}
+}
+
+/**
+*   @brief   Draws a character
+*   @details Each row of the glyph is drawn as runs of lit pixels, with
+			 a pixel lit when its centre falls inside a lit font pixel.
+*   @return  void
+*/
+void SoftwareRenderer::drawGlyph(const Command& command, int left, int top, int right, int bottom)
+{
+	const uint8_t* glyph = FONT[command.character - ' '];
+	auto fill = vectorised ? fillSpan : fillSpanScalar;
+	float size = command.glyph_size;
+
+	for (int y = top; y < bottom; y++)
+	{
+		int row = (int)(((float)y + 0.5f - command.glyph_y) / size);
+		if (row < 0 || row >= GLYPH_SIZE || glyph[row] == 0)
+		{
+			continue;
+		}
+
+		uint8_t* pixels = &framebuffer.pixels[(size_t)y * framebuffer.width * 4];
+		for (int column = 0; column < GLYPH_SIZE; )
+		{
+			if (!(glyph[row] & (1 << column)))
+			{
+				column++;
+				continue;
+			}
+			int end = column;
+			while (end < GLYPH_SIZE && (glyph[row] & (1 << end)))
+			{
+				end++;
+			}
+			int first = std::max(left, (int)std::ceil(command.glyph_x + column * size - 0.5f));
+			int last = std::min(right, (int)std::ceil(command.glyph_x + end * size - 0.5f));
+			if (first < last)
+			{
+				fill(pixels + (size_t)first * 4, last - first, command.colour);
+			}
+			column = end;
+		}
+	}
+}
+
+/**
+*   @brief   Benchmarks the software renderer.
+*   @details The scene is laid out as layoutSprites lays out gameplay.
+			 The same frames are drawn across the workers, then on one
+			 thread, then with the scalar kernels, and the last frame of
+			 each is compared with the first.
+*   @return  The timings.
+*/
+RasterBenchReport runRasterBenchmark(int width, int height, int frames, JobSystem& jobs, Image& screenshot)
+{
+	using clock = std::chrono::steady_clock;
+
+	RasterBenchReport report;
+	report.width = width;
+	report.height = height;
+	report.frames = frames;
+	report.workers = jobs.getWorkerCount();
+	report.vectorised = rasterKernelsVectorised();
+	report.textures_loaded = true;
+
+	SoftwareRenderer renderer;
+	if (frames <= 0 || !renderer.init(width, height, ASGE::Renderer::WindowMode::WINDOWED))
+	{
+		return report;
+	}
+	renderer.setClearColour(ASGE::COLOURS::BLACK);
+	report.tiles = renderer.getTileCount();
+
+	AssetBundle bundle;
+	bundle.open(ASSET_BUNDLE);
+	report.textures_loaded = renderer.loadAssets(bundle);
+
+	std::vector<std::unique_ptr<ASGE::Sprite>> scene;
+	auto place = [&](const char* asset, float x, float y, float w, float h) -> ASGE::Sprite*
+	{
+		std::unique_ptr<ASGE::Sprite> sprite = renderer.createUniqueSprite();
+		if (!sprite->loadTexture(assetPath(asset)))
+		{
+			report.textures_loaded = false;
+		}
+		sprite->xPos(x);
+		sprite->yPos(y);
+		sprite->width(w);
+		sprite->height(h);
+		scene.push_back(std::move(sprite));
+		return scene.back().get();
+	};
+
+	float area_h = height * GAMEPLAY_HEIGHT;
+	float area_w = area_h * 1.25f;
+	float area_x = (width - area_w) * 0.5f;
+	float area_y = height * 0.09f;
+	place("background", area_x, area_y, area_w, area_h);
+
+	const LevelLayout& level = campaignLevel(0);
+	float cell_w = area_w / level.columns;
+	float block_w = area_w * 0.066f;
+	float block_h = area_h * 0.035f;
+	for (int i = 0; i < level.columns * level.rows; i++)
+	{
+		if (level.types[i] != (uint8_t)BlockType::EMPTY)
+		{
+			place(blockAsset(level.types[i]), area_x + (i % level.columns) * cell_w + (cell_w - block_w) * 0.5f,
+				area_y + area_h * 0.08f + (i / level.columns) * block_h * 1.25f, block_w, block_h);
+		}
+	}
+
+	float paddle_h = area_h * 0.03f;
+	float paddle_w = area_h * 0.15f;
+	place("paddle", area_x + (area_w - paddle_w) * 0.5f, area_y + area_h - paddle_h, paddle_w, paddle_h);
+	for (int i = 0; i < 3; i++)
+	{
+		place("heart", area_x + i * height * 0.045f, height * 0.05f, height * 0.04f, height * 0.04f);
+		place("gem", area_x + area_w * (0.2f + 0.3f * i), area_y + area_h * (0.5f + 0.1f * i), block_h, block_h);
+	}
+	place("power_up", area_x + area_w * 0.6f, area_y + area_h * 0.7f, block_h, block_h);
+	for (int i = 0; i < 2; i++)
+	{
+		place("laser", area_x + area_w * (0.45f + 0.1f * i), area_y + area_h * 0.6f, block_h * 0.5f, block_h);
+	}
+	float ball_size = area_h * 0.03f;
+	ASGE::Sprite* ball = place("ball", 0.0f, 0.0f, ball_size, ball_size);
+
+	auto drawFrame = [&](int frame)
+	{
+		float phase = (float)frame / frames;
+		ball->xPos(area_x + area_w * (0.1f + 0.8f * phase));
+		ball->yPos(area_y + area_h * (0.4f + 0.3f * std::sin(phase * 6.2831853f)));
+		ball->rotationInRadians(phase * 6.2831853f);
+
+		renderer.preRender();
+		for (const std::unique_ptr<ASGE::Sprite>& sprite : scene)
+		{
+			renderer.renderSprite(*sprite);
+		}
+		float text_scale = height * 0.0012f;
+		renderer.renderText("Score: " + std::to_string(frame * 10), (int)area_x, (int)(height * 0.04f),
+			text_scale, ASGE::COLOURS::WHITE);
+		for (int line = 0; line < 12; line++)
+		{
+			renderer.renderText("Frame " + std::to_string(frame) + "  line " + std::to_string(line) +
+				": 16.6 ms  p99 17.1 ms  late 0  workers " + std::to_string(report.workers),
+				(int)(width * 0.01f), (int)(height * (0.19f + 0.02f * line)), text_scale,
+				ASGE::COLOURS::YELLOWGREEN);
+		}
+		renderer.postRender();
+	};
+
+	auto timeFrames = [&](double& worst)
+	{
+		worst = 0.0;
+		clock::duration total = clock::duration::zero();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			auto start = clock::now();
+			drawFrame(frame);
+			clock::duration took = clock::now() - start;
+			total += took;
+			worst = std::max(worst, std::chrono::duration<double, std::milli>(took).count());
+		}
+		return std::chrono::duration<double, std::milli>(total).count() / frames;
+	};
+
+	double worst = 0.0;
+	renderer.setJobSystem(&jobs);
+	report.frame_ms = timeFrames(report.worst_ms);
+	report.commands = renderer.getCommandCount();
+	screenshot = renderer.getFramebuffer();
+
+	renderer.setJobSystem(nullptr);
+	report.single_ms = timeFrames(worst);
+	renderer.setVectorised(false);
+	report.scalar_ms = timeFrames(worst);
+
+	const std::vector<uint8_t>& scalar = renderer.getFramebuffer().pixels;
+	for (size_t i = 0; i < scalar.size(); i += 4)
+	{
+		report.mismatches += std::memcmp(&scalar[i], &screenshot.pixels[i], 4) != 0;
+	}
+	return report;
+}
@@ -0,0 +1,231 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <Engine/Font.h>
+#include <Engine/Renderer.h>
+#include <Engine/Sprite.h>
+#include <Engine/Texture.h>
+
+#include "JobSystem.h"
+#include "Png.h"
+#include "RasterKernels.h"
+
+/*! \file SoftwareRenderer.h
+@brief   An ASGE renderer that draws on the CPU.
+@details For screenshots and machines without a usable GPU. Sprites and
+         text are queued through the usual Renderer calls and drawn by
+         postRender into an RGBA framebuffer, split into tiles of
+         RASTER_TILE_SIZE pixels that run as jobs. Every tile applies
+         the queue in order to its own pixels only, so the frame is the
+         same whatever the tiling or thread count. Sprites are bilinear
+         filtered from their source rectangle and honour position,
+         size, scale, rotation about their centre, flips, tint and
+         opacity; text uses a built in 8x8 font. There is no window and
+         no input: the frame is read back with getFramebuffer, or
+         handed to a FrameCapture by swapBuffers.
+*/
+
+class AssetBundle;
+class FrameCapture;
+class SoftwareRenderer;
+
+/**
+*  A decoded texture. Its rows are one texel wider and it has one row
+*  more than the image, repeating the last column and row, so bilinear
+*  filtering can always read a texel's right and lower neighbours.
+*/
+class SoftwareTexture :
+	public ASGE::Texture2D
+{
+public:
+	explicit SoftwareTexture(const Image& image);
+
+	/**
+	*  Replaces the texels.
+	*  @param [in] data Width * height RGBA texels, unpadded.
+	*/
+	void setData(void* data) override;
+	void* getData() override;
+
+	const uint8_t* getTexels() const;
+	int getPitch() const;   /**< Texels a row. */
+
+private:
+	void repeatEdges();
+
+	std::vector<uint8_t> texels;
+};
+
+/**
+*  A sprite for the software renderer. Textures are shared through the
+*  renderer's cache, so loading one twice decodes it once.
+*/
+class SoftwareSprite :
+	public ASGE::Sprite
+{
+public:
+	explicit SoftwareSprite(SoftwareRenderer& renderer);
+
+	bool loadTexture(const std::string& path) override;
+	const ASGE::Texture2D* getTexture() const override;
+
+private:
+	SoftwareRenderer& renderer;
+	std::shared_ptr<SoftwareTexture> texture;
+};
+
+class SoftwareRenderer :
+	public ASGE::Renderer
+{
+public:
+	SoftwareRenderer();
+
+	/**
+	*  Shares out the tiles; nullptr draws them all on the calling thread.
+	*/
+	void setJobSystem(JobSystem* jobs);
+
+	/**
+	*  Picks the SSE or the scalar kernels, for comparing the two.
+	*/
+	void setVectorised(bool vectorised);
+
+	/**
+	*  Hands every frame to a capture as it is swapped; nullptr stops.
+	*/
+	void setCapture(FrameCapture* capture);
+
+	bool init(int width, int height, ASGE::Renderer::WindowMode mode) override;
+	bool exit() override;
+	void setClearColour(ASGE::Colour rgb) override;
+	int loadFont(const char* font, int pt) override;
+	void setFont(int id) override;
+	const ASGE::Font& getActiveFont() const override;
+	void setDefaultTextColour(const ASGE::Colour& colour) override;
+	void setSpriteMode(ASGE::SpriteSortMode mode) override;
+	void setWindowedMode(ASGE::Renderer::WindowMode mode) override;
+	void setWindowTitle(const char* title) override;
+
+	void preRender() override;
+	void postRender() override;
+	void swapBuffers() override;
+
+	using ASGE::Renderer::renderSprite;
+	using ASGE::Renderer::renderText;
+	void renderSprite(const ASGE::Sprite& sprite, float z_order) override;
+	void renderText(const std::string str, int x, int y, float scale, const ASGE::Colour& colour,
+		float z_order) override;
+
+	std::unique_ptr<ASGE::Input> inputPtr() override;
+	std::unique_ptr<ASGE::Sprite> createUniqueSprite() override;
+	ASGE::Sprite* createRawSprite() override;
+
+	/**
+	*  Loads a texture, or finds it if it was loaded before.
+	*  @return nullptr if it could not be read or decoded.
+	*/
+	std::shared_ptr<SoftwareTexture> loadTexture(const std::string& path);
+
+	/**
+	*  Decodes every texture in the manifest ahead of drawing, on worker
+	*  threads, reading them from the bundle where it holds them. Each is cached under its
+	*  assetPath, so sprites loading that path find it there.
+	*  @return false if any could not be read or decoded.
+	*/
+	bool loadAssets(const AssetBundle& bundle);
+
+	/**
+	*  The last frame drawn, opaque RGBA.
+	*/
+	const Image& getFramebuffer() const;
+	int getTileCount() const;
+	int getCommandCount() const;  /**< Sprites and glyphs queued for the last frame. */
+
+private:
+	enum Kind : uint8_t
+	{
+		SPRITE = 0,
+		GLYPH
+	};
+
+	/**
+	*  Something queued to draw. Bounds are in pixels, clipped to the
+	*  framebuffer, and exclusive on the right and bottom.
+	*/
+	struct Command
+	{
+		Kind kind = SPRITE;
+		int left = 0, top = 0, right = 0, bottom = 0;
+		float z_order = 0.0f;
+		int order = 0;
+
+		// sprites: the texel sampled at a pixel centre is
+		// u = u_x * x + u_y * y + u_0, and likewise v
+		const SoftwareTexture* texture = nullptr;
+		float u_x = 0.0f, u_y = 0.0f, u_0 = 0.0f;
+		float v_x = 0.0f, v_y = 0.0f, v_0 = 0.0f;
+		float u_low = 0.0f, u_high = 0.0f;  /**< Texel range the sprite covers. */
+		float v_low = 0.0f, v_high = 0.0f;
+		float src[4] = {};                  /**< Source rectangle, in texels. */
+
+		// glyphs: the top left of the character cell and its pixel size
+		uint8_t character = 0;
+		float glyph_x = 0.0f, glyph_y = 0.0f, glyph_size = 1.0f;
+
+		uint16_t colour[4] = { 256, 256, 256, 256 };
+	};
+
+	void sortCommands();
+	void binCommands();
+	void drawTile(int tile);
+	void drawSprite(const Command& command, int left, int top, int right, int bottom);
+	void drawGlyph(const Command& command, int left, int top, int right, int bottom);
+
+	Image framebuffer;
+	int tiles_x = 0;
+	int tiles_y = 0;
+	std::vector<Command> commands;
+	std::vector<std::vector<int>> tile_commands;  /**< Per tile, the commands touching it, in order. */
+	JobSystem* jobs = nullptr;
+	JobGraph graph;
+	bool vectorised = true;
+	FrameCapture* capture = nullptr;
+	ASGE::SpriteSortMode sort_mode = ASGE::SpriteSortMode::DEFERRED;
+	std::map<std::string, std::shared_ptr<SoftwareTexture>> textures;
+	ASGE::Font font;
+};
+
+/**
+*  Results of a software renderer benchmark run.
+*/
+struct RasterBenchReport
+{
+	int width = 0;
+	int height = 0;
+	int frames = 0;
+	int tiles = 0;
+	int commands = 0;          /**< Sprites and glyphs a frame. */
+	int workers = 0;
+	double frame_ms = 0.0;     /**< Mean, SSE kernels across the workers. */
+	double worst_ms = 0.0;
+	double single_ms = 0.0;    /**< Mean, SSE kernels on one thread. */
+	double scalar_ms = 0.0;    /**< Mean, scalar kernels on one thread. */
+	bool vectorised = false;
+	bool textures_loaded = false;
+	int mismatches = 0;        /**< Pixels the scalar and SSE frames disagree on. */
+};
+
+/**
+*   @brief   Benchmarks the software renderer.
+*   @details Draws a gameplay frame - background, a campaign level's
+             blocks, paddle, ball, pickups, lives and the text overlay -
+             at the given size, moving the ball each frame.
+*   @param   [in] frames Frames to time in each configuration.
+*   @param   [in] jobs Workers to share the tiles across.
+*   @param   [out] screenshot Receives the last frame drawn.
+*   @return  The timings.
+*/
+RasterBenchReport runRasterBenchmark(int width, int height, int frames, JobSystem& jobs, Image& screenshot);
@@ -0,0 +1,346 @@
+#include <cstring>
+#include <utility>
+
+#include "Spectator.h"
+#include "StateDelta.h"
+
+namespace
+{
+	constexpr size_t STATE_SIZE = sizeof(SimState);
+	constexpr size_t HELLO_SIZE = 8;
+	constexpr size_t MESSAGE_HEADER = 3;
+	const uint8_t MAGIC[4] = { 'B', 'K', 'S', 'P' };
+
+	void putShort(std::vector<uint8_t>& out, size_t value)
+	{
+		out.push_back((uint8_t)(value & 0xff));
+		out.push_back((uint8_t)(value >> 8));
+	}
+
+	size_t getShort(const uint8_t* in)
+	{
+		return in[0] | (in[1] << 8);
+	}
+}
+
+SpectatorServer::~SpectatorServer()
+{
+	stop();
+}
+
+bool SpectatorServer::start(int port)
+{
+	stop();
+	listener = socketListen(port);
+	return listener != INVALID_SOCKET_HANDLE;
+}
+
+void SpectatorServer::stop()
+{
+	while (!viewers.empty())
+	{
+		disconnect(viewers.size() - 1);
+	}
+	socketClose(listener);
+	listener = INVALID_SOCKET_HANDLE;
+	has_state = false;
+}
+
+/**
+*   @brief   Publishes a tick.
+*   @details Encodes one delta against the previously published state and
+             queues it (or a keyframe when one is due) to every viewer
+             that is keeping up.
+*   @return  void
+*/
+void SpectatorServer::publish(const SimState& state)
+{
+	if (listener == INVALID_SOCKET_HANDLE)
+	{
+		return;
+	}
+
+	acceptViewers();
+
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&state);
+	bool keyframe_due = !has_state || ++since_keyframe >= SPECTATOR_KEYFRAME_INTERVAL;
+	delta.clear();
+	if (keyframe_due)
+	{
+		since_keyframe = 0;
+	}
+	else
+	{
+		encodeStateDelta(reinterpret_cast<const uint8_t*>(&last_state),
+			bytes, STATE_SIZE, delta);
+	}
+
+	for (size_t i = viewers.size(); i-- > 0;)
+	{
+		Viewer& viewer = viewers[i];
+		size_t backlog = viewer.pending.size() - viewer.sent;
+
+		if (viewer.resync)
+		{
+			if (backlog == 0)
+			{
+				queue(viewer, SPECTATOR_KEYFRAME, bytes, STATE_SIZE);
+				viewer.resync = false;
+				viewer.stalled_ticks = 0;
+			}
+			else if (++viewer.stalled_ticks > SPECTATOR_STALL_TICKS)
+			{
+				dropped++;
+				disconnect(i);
+				continue;
+			}
+		}
+		else if (backlog > (size_t)SPECTATOR_MAX_BACKLOG)
+		{
+			viewer.resync = true;
+			resyncs++;
+		}
+		else if (keyframe_due)
+		{
+			queue(viewer, SPECTATOR_KEYFRAME, bytes, STATE_SIZE);
+		}
+		else
+		{
+			queue(viewer, SPECTATOR_DELTA, delta.data(), delta.size());
+		}
+
+		if (!flush(viewer))
+		{
+			disconnect(i);
+		}
+	}
+
+	std::memcpy(&last_state, &state, STATE_SIZE);
+	has_state = true;
+}
+
+void SpectatorServer::update()
+{
+	if (listener == INVALID_SOCKET_HANDLE)
+	{
+		return;
+	}
+
+	acceptViewers();
+	for (size_t i = viewers.size(); i-- > 0;)
+	{
+		if (!flush(viewers[i]))
+		{
+			disconnect(i);
+		}
+	}
+}
+
+int SpectatorServer::getViewerCount() const
+{
+	return (int)viewers.size();
+}
+
+long long SpectatorServer::getBytesSent() const
+{
+	return bytes_sent;
+}
+
+int SpectatorServer::getResyncCount() const
+{
+	return resyncs;
+}
+
+int SpectatorServer::getDroppedCount() const
+{
+	return dropped;
+}
+
+void SpectatorServer::acceptViewers()
+{
+	intptr_t socket = socketAccept(listener);
+	while (socket != INVALID_SOCKET_HANDLE)
+	{
+		Viewer viewer;
+		viewer.socket = socket;
+		viewer.pending.insert(viewer.pending.end(), MAGIC, MAGIC + 4);
+		putShort(viewer.pending, SPECTATOR_VERSION);
+		putShort(viewer.pending, STATE_SIZE);
+		viewers.push_back(std::move(viewer));
+
+		socket = socketAccept(listener);
+	}
+}
+
+void SpectatorServer::queue(Viewer& viewer, uint8_t type,
+	const uint8_t* payload, size_t size)
+{
+	viewer.pending.push_back(type);
+	putShort(viewer.pending, size);
+	viewer.pending.insert(viewer.pending.end(), payload, payload + size);
+}
+
+/**
+*   @brief   Sends what the viewer's socket will take.
+*   @details Sent bytes are compacted away once they make up half the
+             queue so the buffer does not creep.
+*   @return  false if the connection has failed.
+*/
+bool SpectatorServer::flush(Viewer& viewer)
+{
+	while (viewer.sent < viewer.pending.size())
+	{
+		int sent = socketSend(viewer.socket, viewer.pending.data() + viewer.sent,
+			viewer.pending.size() - viewer.sent);
+		if (sent < 0)
+		{
+			return false;
+		}
+		if (sent == 0)
+		{
+			break;
+		}
+		viewer.sent += sent;
+		bytes_sent += sent;
+	}
+
+	if (viewer.sent == viewer.pending.size())
+	{
+		viewer.pending.clear();
+		viewer.sent = 0;
+	}
+	else if (viewer.sent > viewer.pending.size() / 2)
+	{
+		viewer.pending.erase(viewer.pending.begin(),
+			viewer.pending.begin() + viewer.sent);
+		viewer.sent = 0;
+	}
+	return true;
+}
+
+void SpectatorServer::disconnect(size_t index)
+{
+	socketClose(viewers[index].socket);
+	viewers.erase(viewers.begin() + index);
+}
+
+SpectatorClient::~SpectatorClient()
+{
+	disconnect();
+}
+
+bool SpectatorClient::connect(const char* host, int port)
+{
+	disconnect();
+	socket = socketConnect(host, port);
+	return socket != INVALID_SOCKET_HANDLE;
+}
+
+void SpectatorClient::disconnect()
+{
+	socketClose(socket);
+	socket = INVALID_SOCKET_HANDLE;
+	incoming.clear();
+	has_hello = false;
+	has_state = false;
+}
+
+bool SpectatorClient::isConnected() const
+{
+	return socket != INVALID_SOCKET_HANDLE;
+}
+
+/**
+*   @brief   Reads and applies the stream.
+*   @details Only complete messages are consumed; a partial one waits in
+             the buffer for the rest to arrive.
+*   @return  true if a new state was produced.
+*/
+bool SpectatorClient::poll(SimState& state)
+{
+	if (!isConnected())
+	{
+		return false;
+	}
+
+	uint8_t chunk[4096];
+	int received = socketReceive(socket, chunk, sizeof(chunk));
+	while (received > 0)
+	{
+		incoming.insert(incoming.end(), chunk, chunk + received);
+		received = socketReceive(socket, chunk, sizeof(chunk));
+	}
+	if (received < 0)
+	{
+		disconnect();
+		return false;
+	}
+
+	size_t read = 0;
+	if (!has_hello)
+	{
+		if (incoming.size() < HELLO_SIZE)
+		{
+			return false;
+		}
+		if (std::memcmp(incoming.data(), MAGIC, 4) != 0 ||
+			getShort(&incoming[4]) != SPECTATOR_VERSION ||
+			getShort(&incoming[6]) != STATE_SIZE)
+		{
+			disconnect();
+			return false;
+		}
+		has_hello = true;
+		read = HELLO_SIZE;
+	}
+
+	bool updated = false;
+	while (incoming.size() - read >= MESSAGE_HEADER)
+	{
+		uint8_t type = incoming[read];
+		size_t size = getShort(&incoming[read + 1]);
+		if (incoming.size() - read - MESSAGE_HEADER < size)
+		{
+			break;
+		}
+		if (!handleMessage(type, &incoming[read + MESSAGE_HEADER], size))
+		{
+			disconnect();
+			return false;
+		}
+		read += MESSAGE_HEADER + size;
+		updated = has_state;
+	}
+	incoming.erase(incoming.begin(), incoming.begin() + read);
+
+	if (updated)
+	{
+		state = current;
+	}
+	return updated;
+}
+
+bool SpectatorClient::handleMessage(uint8_t type, const uint8_t* payload, size_t size)
+{
+	if (type == SPECTATOR_KEYFRAME)
+	{
+		if (size != STATE_SIZE)
+		{
+			return false;
+		}
+		std::memcpy(&current, payload, STATE_SIZE);
+		has_state = true;
+		return true;
+	}
+	if (type == SPECTATOR_DELTA)
+	{
+		// deltas received before the first keyframe have nothing to apply to
+		if (!has_state)
+		{
+			return true;
+		}
+		return applyStateDelta(payload, size,
+			reinterpret_cast<uint8_t*>(&current), STATE_SIZE);
+	}
+	return false;
+}
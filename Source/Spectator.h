@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Simulation.h"
+#include "Socket.h"
+
+/*! \file Spectator.h
+@brief   Live spectator stream of the simulation over local TCP.
+@details On connect the server sends an 8 byte hello: "BKSP", a 16-bit
+         protocol version and the 16-bit size of SimState, so a viewer
+         built against a different layout can refuse the stream. After
+         that every message is a 1 byte type, a 16-bit little endian
+         payload length and the payload. Keyframes carry a whole SimState;
+         deltas carry a StateDelta against the previous message's state.
+*/
+
+constexpr uint16_t SPECTATOR_VERSION = 2;
+constexpr uint8_t  SPECTATOR_KEYFRAME = 1;
+constexpr uint8_t  SPECTATOR_DELTA = 2;
+
+/**
+*  Publishes the simulation to any number of local viewers.
+*  Each tick is encoded once and queued to every viewer. Sockets are
+*  non-blocking and each viewer has its own outgoing queue, so a slow
+*  viewer never holds up the game: once its backlog passes
+*  SPECTATOR_MAX_BACKLOG it stops receiving deltas, and when the backlog
+*  has drained it is sent a fresh keyframe. A viewer that stays stuck for
+*  SPECTATOR_STALL_TICKS is disconnected. Late joiners start from a
+*  keyframe too.
+*/
+class SpectatorServer
+{
+public:
+	SpectatorServer() = default;
+	~SpectatorServer();
+
+	/**
+	*  Starts listening for viewers on the loopback interface.
+	*  @param [in] port The TCP port to listen on.
+	*  @return true if the port could be opened.
+	*/
+	bool start(int port);
+
+	/**
+	*  Disconnects every viewer and closes the listening socket.
+	*/
+	void stop();
+
+	/**
+	*  Queues the state after a tick to every viewer.
+	*  @param [in] state The state to publish.
+	*/
+	void publish(const SimState& state);
+
+	/**
+	*  Accepts new viewers and pushes out queued data. Never blocks.
+	*/
+	void update();
+
+	int getViewerCount() const;
+	long long getBytesSent() const;
+	int getResyncCount() const;
+	int getDroppedCount() const;
+
+private:
+	struct Viewer
+	{
+		intptr_t socket = INVALID_SOCKET_HANDLE;
+		std::vector<uint8_t> pending;
+		size_t sent = 0;
+		bool resync = true;
+		int stalled_ticks = 0;
+	};
+
+	void acceptViewers();
+	void queue(Viewer& viewer, uint8_t type, const uint8_t* payload, size_t size);
+	bool flush(Viewer& viewer);
+	void disconnect(size_t index);
+
+	intptr_t listener = INVALID_SOCKET_HANDLE;
+	std::vector<Viewer> viewers;
+	std::vector<uint8_t> delta;
+	SimState last_state;
+	bool has_state = false;
+	int since_keyframe = 0;
+
+	long long bytes_sent = 0;
+	int resyncs = 0;
+	int dropped = 0;
+};
+
+/**
+*  Receives a spectator stream and rebuilds the simulation state from it.
+*/
+class SpectatorClient
+{
+public:
+	SpectatorClient() = default;
+	~SpectatorClient();
+
+	/**
+	*  Connects to a game's spectator server.
+	*  @param [in] host The IPv4 address of the game.
+	*  @param [in] port The port the game publishes on.
+	*  @return true if connected.
+	*/
+	bool connect(const char* host, int port);
+	void disconnect();
+	bool isConnected() const;
+
+	/**
+	*  Reads everything that has arrived and applies it.
+	*  A malformed stream disconnects the client.
+	*  @param [out] state Receives the latest state if there is a new one.
+	*  @return true if state was updated.
+	*/
+	bool poll(SimState& state);
+
+private:
+	bool handleMessage(uint8_t type, const uint8_t* payload, size_t size);
+
+	intptr_t socket = INVALID_SOCKET_HANDLE;
+	std::vector<uint8_t> incoming;
+	bool has_hello = false;
+	bool has_state = false;
+	SimState current;
+};
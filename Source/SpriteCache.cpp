@@ -0,0 +1,190 @@
+#include "SpriteCache.h"
+
+SpriteCache::SpriteCache()
+{
+	for (int i = 0; i < NUM_ASSETS; i++)
+	{
+		files[i] = i;
+	}
+}
+
+void SpriteCache::setBudget(size_t bytes)
+{
+	budget = bytes;
+}
+
+size_t SpriteCache::getBudget() const
+{
+	return budget;
+}
+
+void SpriteCache::beginFrame()
+{
+	frame++;
+}
+
+void SpriteCache::shareFile(int asset, int owner)
+{
+	if (asset >= 0 && asset < NUM_ASSETS && owner >= 0 && owner < NUM_ASSETS)
+	{
+		files[asset] = files[owner];
+	}
+}
+
+int SpriteCache::fileOf(int asset) const
+{
+	return asset >= 0 && asset < NUM_ASSETS ? files[asset] : asset;
+}
+
+void SpriteCache::startLevel()
+{
+	for (Texture& texture : textures)
+	{
+		texture.needed = false;
+	}
+}
+
+bool SpriteCache::use(int asset)
+{
+	if (asset < 0 || asset >= NUM_ASSETS)
+	{
+		return true;
+	}
+
+	asset = files[asset];
+	Texture& texture = textures[asset];
+	texture.last_used = frame;
+	texture.needed = true;
+	if (texture.state == HELD)
+	{
+		return true;
+	}
+
+	if (texture.stalled != frame)
+	{
+		texture.stalled = frame;
+		stalls++;
+	}
+	if (texture.state == EVICTED)
+	{
+		texture.state = RELOADING;
+		reloads.push_back(asset);
+		reload_count++;
+	}
+	return false;
+}
+
+/**
+*   @brief   Records an upload
+*   @details Sprites sharing a file share the one texture, so loading
+			 it again only replaces its size.
+*   @return  void
+*/
+void SpriteCache::loaded(int asset, size_t bytes)
+{
+	if (asset < 0 || asset >= NUM_ASSETS)
+	{
+		return;
+	}
+
+	Texture& texture = textures[files[asset]];
+	if (texture.state == HELD)
+	{
+		held_bytes -= texture.bytes;
+	}
+	texture.state = HELD;
+	texture.bytes = bytes;
+	texture.last_used = frame;
+	held_bytes += bytes;
+}
+
+bool SpriteCache::isHeld(int asset) const
+{
+	return asset >= 0 && asset < NUM_ASSETS && textures[files[asset]].state == HELD;
+}
+
+bool SpriteCache::isReloading(int asset) const
+{
+	return asset >= 0 && asset < NUM_ASSETS && textures[files[asset]].state == RELOADING;
+}
+
+void SpriteCache::takeReloads(std::vector<int>& assets)
+{
+	assets.clear();
+	assets.swap(reloads);
+}
+
+/**
+*   @brief   Evicts down to the budget
+*   @details A plain scan for the oldest candidate each time; there are
+			 no more files than the manifest lists textures, and nothing
+			 is evicted at all while they fit.
+*   @return  How many files were evicted.
+*/
+int SpriteCache::evict(std::vector<int>& victims)
+{
+	victims.clear();
+	int evicted = 0;
+	while (held_bytes > budget)
+	{
+		int oldest = -1;
+		for (int i = 0; i < NUM_ASSETS; i++)
+		{
+			const Texture& texture = textures[i];
+			if (texture.state == HELD && !texture.needed &&
+				(oldest < 0 || texture.last_used < textures[oldest].last_used))
+			{
+				oldest = i;
+			}
+		}
+		if (oldest < 0)
+		{
+			break;
+		}
+
+		Texture& texture = textures[oldest];
+		texture.state = EVICTED;
+		held_bytes -= texture.bytes;
+		texture.bytes = 0;
+		for (int i = 0; i < NUM_ASSETS; i++)
+		{
+			if (files[i] == oldest)
+			{
+				victims.push_back(i);
+			}
+		}
+		evicted++;
+		evictions++;
+	}
+	return evicted;
+}
+
+size_t SpriteCache::getHeldBytes() const
+{
+	return held_bytes;
+}
+
+int SpriteCache::getHeldCount() const
+{
+	int count = 0;
+	for (const Texture& texture : textures)
+	{
+		count += texture.state == HELD;
+	}
+	return count;
+}
+
+long long SpriteCache::getEvictions() const
+{
+	return evictions;
+}
+
+long long SpriteCache::getReloads() const
+{
+	return reload_count;
+}
+
+long long SpriteCache::getReloadStalls() const
+{
+	return stalls;
+}
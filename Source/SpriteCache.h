@@ -0,0 +1,122 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Assets.h"
+
+/**
+*  Caps the sprite objects the game holds, not video memory.
+*  ASGE caches every GL texture it loads and has no call to free one, so
+*  evicting only releases the sprites showing a texture; the engine keeps
+*  the texture itself. The budget is on the size of the files the held
+*  sprites show, each counted once: the textures on an atlas page share
+*  it, so they are tracked, kept and evicted together.
+*  Each file records whether sprites hold it, its size and the frame it
+*  was last drawn. Whatever is drawn during a level is needed by it and
+*  is never evicted until the next level starts; once the files held
+*  pass the budget the least recently drawn of the rest are released
+*  until they fit. A texture drawn while released counts a reload stall
+*  and is queued for the loader, and whatever uses it is skipped until
+*  the reload lands rather than waiting on the disk. Only the main
+*  thread may use it.
+*/
+class SpriteCache
+{
+public:
+	SpriteCache();
+
+	void setBudget(size_t bytes);
+	size_t getBudget() const;
+
+	/**
+	*  Moves on a frame; call before anything is drawn in it.
+	*/
+	void beginFrame();
+
+	/**
+	*  Puts an asset in the same file as another, as the textures on one
+	*  atlas page are. Each asset starts in a file of its own.
+	*  @param [in] asset Index into ASSETS.
+	*  @param [in] owner The asset whose entry stands for the file; it
+	*              must be in a file of its own.
+	*/
+	void shareFile(int asset, int owner);
+
+	/**
+	*  The asset standing for the file an asset is in.
+	*/
+	int fileOf(int asset) const;
+
+	/**
+	*  Forgets what the last level needed, leaving it to be evicted.
+	*/
+	void startLevel();
+
+	/**
+	*  Notes a texture being drawn this frame.
+	*  @param [in] asset Index into ASSETS, or -1 for none.
+	*  @return false if no sprite is held for it and it cannot be drawn; a reload
+	*          is queued the first time.
+	*/
+	bool use(int asset);
+
+	/**
+	*  Records a sprite as showing a texture.
+	*  @param [in] bytes Size of the texture's whole file, e.g. the page
+	*              for a texture in the atlas.
+	*/
+	void loaded(int asset, size_t bytes);
+
+	bool isHeld(int asset) const;
+	bool isReloading(int asset) const;
+
+	/**
+	*  Hands over the reloads queued since the last call.
+	*  @param [out] assets Receives the asset standing for each file;
+	*              cleared first.
+	*/
+	void takeReloads(std::vector<int>& assets);
+
+	/**
+	*  Evicts the least recently drawn files the level does not need
+	*  until the ones held fit the budget, or nothing else can go.
+	*  @param [out] victims Receives every asset in the files evicted,
+	*               whose sprites are to be released; cleared first.
+	*  @return How many files were evicted.
+	*/
+	int evict(std::vector<int>& victims);
+
+	size_t getHeldBytes() const;  /**< Of the files sprites hold, not video memory. */
+	int getHeldCount() const;     /**< Files sprites hold. */
+	long long getEvictions() const;   /**< Files whose sprites were released. */
+	long long getReloads() const;
+	long long getReloadStalls() const;  /**< Frames a texture was wanted but not held, per texture. */
+
+private:
+	enum State : uint8_t
+	{
+		EVICTED = 0,
+		RELOADING,
+		HELD
+	};
+
+	struct Texture
+	{
+		State state = EVICTED;
+		bool needed = false;
+		size_t bytes = 0;
+		uint64_t last_used = 0;
+		uint64_t stalled = 0;  /**< Last frame a stall was counted. */
+	};
+
+	Texture textures[NUM_ASSETS];  /**< By the asset standing for each file. */
+	int files[NUM_ASSETS];         /**< Per asset, the asset standing for its file. */
+	std::vector<int> reloads;
+	size_t budget = SIZE_MAX;  /**< Unlimited until set. */
+	size_t held_bytes = 0;
+	uint64_t frame = 0;
+	long long evictions = 0;
+	long long reload_count = 0;
+	long long stalls = 0;
+};
@@ -0,0 +1,74 @@
+#include "StateDelta.h"
+
+namespace
+{
+	void putRun(std::vector<uint8_t>& out, size_t value)
+	{
+		out.push_back((uint8_t)(value & 0xff));
+		out.push_back((uint8_t)(value >> 8));
+	}
+
+	size_t getRun(const uint8_t* in)
+	{
+		return in[0] | (in[1] << 8);
+	}
+}
+
+void encodeStateDelta(const uint8_t* previous, const uint8_t* current,
+	size_t size, std::vector<uint8_t>& out)
+{
+	size_t i = 0;
+	while (i < size)
+	{
+		size_t skip = i;
+		while (i < size && previous[i] == current[i])
+		{
+			i++;
+		}
+		if (i == size)
+		{
+			break;
+		}
+		size_t start = i;
+		while (i < size && previous[i] != current[i])
+		{
+			i++;
+		}
+
+		putRun(out, start - skip);
+		putRun(out, i - start);
+		for (size_t j = start; j < i; j++)
+		{
+			out.push_back(previous[j] ^ current[j]);
+		}
+	}
+}
+
+bool applyStateDelta(const uint8_t* delta, size_t delta_size,
+	uint8_t* state, size_t size)
+{
+	const uint8_t* in = delta;
+	const uint8_t* end = delta + delta_size;
+	size_t position = 0;
+	while (in < end)
+	{
+		if (end - in < 4)
+		{
+			return false;
+		}
+		position += getRun(in);
+		size_t length = getRun(in + 2);
+		in += 4;
+		if ((size_t)(end - in) < length || position + length > size)
+		{
+			return false;
+		}
+		for (size_t j = 0; j < length; j++)
+		{
+			state[position + j] ^= in[j];
+		}
+		position += length;
+		in += length;
+	}
+	return true;
+}
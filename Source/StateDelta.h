@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*! \file StateDelta.h
+@brief   Byte level deltas between two snapshots of the same struct.
+@details A delta is a series of runs: a 16-bit count of unchanged bytes,
+         a 16-bit count of changed bytes, then the changed bytes XORed with
+         their previous values. Applying a delta XORs them back in. Used by
+         the rewind buffer and the spectator stream, where only a few dozen
+         bytes of the simulation state change each tick.
+*/
+
+/**
+*   @brief   Appends the delta from previous to current onto out.
+*   @param   [in] previous The older snapshot.
+*   @param   [in] current The newer snapshot.
+*   @param   [in] size The size of both snapshots in bytes, under 64KB.
+*   @param   [out] out The buffer the encoded delta is appended to.
+*/
+void encodeStateDelta(const uint8_t* previous, const uint8_t* current,
+	size_t size, std::vector<uint8_t>& out);
+
+/**
+*   @brief   Applies an encoded delta to a snapshot in place.
+*   @details Deltas that would write outside the snapshot are rejected,
+             so this is safe to use on data received from elsewhere.
+*   @return  false if the delta is malformed. The snapshot may then be
+             partially updated.
+*/
+bool applyStateDelta(const uint8_t* delta, size_t delta_size,
+	uint8_t* state, size_t size);
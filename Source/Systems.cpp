@@ -0,0 +1,220 @@
+#include <chrono>
+#include <memory>
+
+#include "JobSystem.h"
+#include "Systems.h"
+
+namespace
+{
+	constexpr float BENCH_STEP = 1.f / 60.f;
+
+	// a stand in for an engine sprite: the position sits among the rest
+	// of the sprite's state, which a move drags into the cache with it
+	struct BenchSprite
+	{
+		float x = 0.f;
+		float y = 0.f;
+		float width = 0.f;
+		float height = 0.f;
+		float state[20] = {};
+	};
+
+	struct BenchSpriteComponent
+	{
+		BenchSprite* sprite = nullptr;
+	};
+
+	// laid out as GameObject was: the velocity inline, the position two
+	// pointers away
+	struct BenchObject
+	{
+		BenchSpriteComponent* sprite_component = nullptr;
+		float velocity_x = 0.f;
+		float velocity_y = 0.f;
+		float speed = 0.f;
+		bool visible = true;
+	};
+
+	uint32_t nextRandom(uint32_t& state)
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	float randomUnit(uint32_t& state)
+	{
+		return (float)(nextRandom(state) % 2001) / 1000.f - 1.f;
+	}
+
+	Entity spawnDebris(EntityWorld& world, uint32_t& random)
+	{
+		Entity debris = world.create(componentMask<Transform, Velocity, Lifetime>());
+		world.get<Transform>(debris).x = (float)(nextRandom(random) % 1000);
+		Velocity& velocity = world.get<Velocity>(debris);
+		velocity.x = randomUnit(random);
+		velocity.y = randomUnit(random);
+		velocity.speed = 300.f;
+		world.get<Lifetime>(debris).seconds = (float)(1 + nextRandom(random) % 60) * BENCH_STEP;
+		return debris;
+	}
+
+	double nanoseconds(std::chrono::steady_clock::duration time)
+	{
+		return std::chrono::duration<double, std::nano>(time).count();
+	}
+}
+
+void moveEntities(EntityWorld& world, float seconds, int first_chunk, int end_chunk)
+{
+	world.forEachIn<Transform, Velocity>(first_chunk, end_chunk,
+		[seconds](Transform& transform, const Velocity& velocity)
+	{
+		transform.x += velocity.x * velocity.speed * seconds;
+		transform.y += velocity.y * velocity.speed * seconds;
+	});
+}
+
+int expireLifetimes(EntityWorld& world, float seconds, std::vector<Entity>& expired)
+{
+	expired.clear();
+	world.forEachEntity<Lifetime>([seconds, &expired](Entity entity, Lifetime& lifetime)
+	{
+		lifetime.seconds -= seconds;
+		if (lifetime.seconds <= 0.f)
+		{
+			expired.push_back(entity);
+		}
+	});
+
+	// destroying moves entities about, so it waits until the walk is over
+	for (Entity entity : expired)
+	{
+		world.destroy(entity);
+	}
+	return (int)expired.size();
+}
+
+/**
+*   @brief   Benchmarks the entity world.
+*   @details A quarter each of blocks, moving objects, pickups and
+			 debris, created interleaved as a level would create them.
+*   @return  The timings.
+*/
+EntityBenchReport runEntityBenchmark(int entities, int ticks, JobSystem& jobs)
+{
+	using clock = std::chrono::steady_clock;
+	EntityBenchReport report;
+	report.entities = entities;
+	report.ticks = ticks;
+
+	EntityWorld world;
+	std::vector<Entity> moving;
+	std::vector<BenchObject> objects;
+	std::vector<std::unique_ptr<BenchSpriteComponent>> components;
+	std::vector<std::unique_ptr<BenchSprite>> sprites;
+	uint32_t random = 1;
+	for (int i = 0; i < entities; i++)
+	{
+		Entity entity;
+		switch (i % 4)
+		{
+		case 0:
+			entity = world.create(componentMask<Transform, Collider, Drawable>());
+			break;
+		case 1:
+			entity = world.create(componentMask<Transform, Velocity, Collider, Drawable>());
+			break;
+		case 2:
+			entity = world.create(componentMask<Transform, Velocity, Collider, Drawable, Pickup>());
+			break;
+		default:
+			spawnDebris(world, random);
+			continue;
+		}
+
+		Transform& transform = world.get<Transform>(entity);
+		transform.x = (float)(i % 1000);
+		transform.y = (float)(i / 1000);
+		if (i % 4 == 0)
+		{
+			continue;
+		}
+		Velocity& velocity = world.get<Velocity>(entity);
+		velocity.x = randomUnit(random);
+		velocity.y = randomUnit(random);
+		velocity.speed = 300.f;
+		moving.push_back(entity);
+
+		// each object's parts allocated apart, as loading sprites did
+		BenchObject object;
+		components.emplace_back(new BenchSpriteComponent());
+		sprites.emplace_back(new BenchSprite());
+		object.sprite_component = components.back().get();
+		object.sprite_component->sprite = sprites.back().get();
+		object.sprite_component->sprite->x = transform.x;
+		object.sprite_component->sprite->y = transform.y;
+		object.velocity_x = velocity.x;
+		object.velocity_y = velocity.y;
+		object.speed = velocity.speed;
+		objects.push_back(object);
+	}
+	report.archetypes = world.getArchetypeCount();
+	report.chunk_bytes = world.memoryUsage();
+
+	auto start = clock::now();
+	for (int tick = 0; tick < ticks; tick++)
+	{
+		moveEntities(world, BENCH_STEP);
+	}
+	report.move_ns = nanoseconds(clock::now() - start) / ((double)entities * ticks);
+
+	JobGraph graph;
+	graph.addStage(world.countChunks<Transform, Velocity>(), 1, [&world](int begin, int end)
+	{
+		moveEntities(world, BENCH_STEP, begin, end);
+	});
+	start = clock::now();
+	for (int tick = 0; tick < ticks; tick++)
+	{
+		jobs.run(graph);
+	}
+	report.jobs_move_ns = nanoseconds(clock::now() - start) / ((double)entities * ticks);
+
+	start = clock::now();
+	for (int tick = 0; tick < ticks * 2; tick++)
+	{
+		for (BenchObject& object : objects)
+		{
+			BenchSprite* sprite = object.sprite_component->sprite;
+			sprite->x += object.velocity_x * object.speed * BENCH_STEP;
+			sprite->y += object.velocity_y * object.speed * BENCH_STEP;
+		}
+	}
+	// the objects do not include the debris the world moved as well
+	report.object_move_ns = nanoseconds(clock::now() - start) / ((double)objects.size() * ticks * 2);
+
+	for (size_t i = 0; i < moving.size(); i++)
+	{
+		const Transform& transform = world.get<Transform>(moving[i]);
+		const BenchSprite* sprite = objects[i].sprite_component->sprite;
+		report.mismatches += transform.x != sprite->x || transform.y != sprite->y;
+	}
+
+	std::vector<Entity> expired;
+	start = clock::now();
+	for (int tick = 0; tick < ticks; tick++)
+	{
+		int dead = expireLifetimes(world, BENCH_STEP, expired);
+		for (int i = 0; i < dead; i++)
+		{
+			spawnDebris(world, random);
+		}
+		report.churned += dead;
+	}
+	report.churn_us = nanoseconds(clock::now() - start) / 1000.0 / ticks;
+	report.mismatches += (int)world.size() != entities;
+	return report;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+
+#include "EntityWorld.h"
+
+class JobSystem;
+
+/*! \file Systems.h
+@brief   Systems that run over the entity world.
+@details Each works on whatever has the components it needs, so a new
+         kind of object picks them up without any new loop.
+*/
+
+/**
+*   @brief   Moves everything with a velocity
+*   @param   [in] world The entities.
+*   @param   [in] seconds The step.
+*   @param   [in] first_chunk First of the chunks to move, see
+             EntityWorld::forEachIn.
+*   @param   [in] end_chunk One past the last.
+*   @return  void
+*/
+void moveEntities(EntityWorld& world, float seconds, int first_chunk = 0,
+	int end_chunk = 0x7fffffff);
+
+/**
+*   @brief   Counts lifetimes down and destroys what has run out
+*   @param   [in] world The entities.
+*   @param   [in] seconds The step.
+*   @param   [out] expired Scratch space for the dead; cleared first.
+*   @return  How many were destroyed.
+*/
+int expireLifetimes(EntityWorld& world, float seconds, std::vector<Entity>& expired);
+
+/**
+*  Results of an entity benchmark run. Times are per entity per tick.
+*/
+struct EntityBenchReport
+{
+	int entities = 0;
+	int ticks = 0;
+	int archetypes = 0;
+	size_t chunk_bytes = 0;
+	double move_ns = 0.0;         /**< moveEntities over every chunk. */
+	double jobs_move_ns = 0.0;    /**< The same, a chunk per job. */
+	double object_move_ns = 0.0;  /**< Objects holding their position in a heap allocated sprite. */
+	double churn_us = 0.0;        /**< A tick of expiring and respawning debris, in total. */
+	int churned = 0;              /**< Debris destroyed and respawned over the run. */
+	int mismatches = 0;           /**< Positions the world and the objects disagree on. */
+};
+
+/**
+*   @brief   Benchmarks the entity world.
+*   @details Fills a world with a mix of static blocks, moving objects,
+             pickups and short lived debris and times moving it, then
+             moves the same objects laid out the way GameObject held
+             them, a sprite component and a sprite allocated apart from
+             each object, and checks both end up in the same place.
+             Finally debris is expired and respawned every tick.
+*   @param   [in] entities How many entities.
+*   @param   [in] ticks How many steps of each.
+*   @param   [in] jobs Runs the chunk per job moves.
+*   @return  The timings.
+*/
+EntityBenchReport runEntityBenchmark(int entities, int ticks, JobSystem& jobs);
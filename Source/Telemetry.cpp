@@ -0,0 +1,292 @@
+#include <cstring>
+
+#include "Telemetry.h"
+
+namespace
+{
+	const char MAGIC[4] = { 'B', 'K', 'T', 'L' };
+	constexpr uint32_t VERSION = 1;
+	constexpr uint64_t RING_MASK = TELEMETRY_RING_RECORDS - 1;
+
+	struct TelemetryHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t record_size;
+		uint32_t sequence;
+	};
+
+	static_assert((TELEMETRY_RING_RECORDS & RING_MASK) == 0,
+		"telemetry rings hold a power of two records");
+	static_assert(sizeof(TelemetryHeader) == 16, "telemetry header is 16 bytes");
+	static_assert(sizeof(TelemetryRecord) == 24, "telemetry records are 24 bytes");
+
+	// each log gets an id so a thread's cached ring is never used with
+	// a different log, even one that reuses a destroyed log's address
+	std::atomic<uint64_t> next_log_id{ 1 };
+
+	struct ThreadRing
+	{
+		uint64_t log = 0;
+		void* ring = nullptr;
+	};
+	thread_local ThreadRing thread_ring;
+}
+
+Telemetry::~Telemetry()
+{
+	stop();
+}
+
+/**
+*   @brief   Starts logging.
+*   @details Opens the first file and starts the thread that drains the
+             rings into it.
+*   @return  false if the file could not be opened.
+*/
+bool Telemetry::start(const std::string& prefix)
+{
+	stop();
+
+	if (!id)
+	{
+		id = next_log_id++;
+	}
+	file_prefix = prefix;
+	if (!openFile())
+	{
+		return false;
+	}
+
+	start_time = std::chrono::steady_clock::now();
+	running.store(true, std::memory_order_release);
+	drainer = std::thread(&Telemetry::run, this);
+	return true;
+}
+
+void Telemetry::stop()
+{
+	if (!drainer.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		running = false;
+	}
+	wake.notify_all();
+	drainer.join();
+	file.close();
+}
+
+bool Telemetry::isRunning() const
+{
+	return running.load(std::memory_order_relaxed);
+}
+
+/**
+*   @brief   Records an event.
+*   @details The hot path: the producer only touches its own ring and
+             only rereads the drain thread's tail when its cached copy
+             says the ring is full.
+*   @return  void
+*/
+void Telemetry::record(TelemetryEvent event, uint32_t tick, int index, fixed x, fixed y)
+{
+	if (!running.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	Ring* ring = threadRing();
+	uint64_t head = ring->head.load(std::memory_order_relaxed);
+	if (head - ring->cached_tail >= TELEMETRY_RING_RECORDS)
+	{
+		ring->cached_tail = ring->tail.load(std::memory_order_acquire);
+		if (head - ring->cached_tail >= TELEMETRY_RING_RECORDS)
+		{
+			// only this thread writes the counter, so no locked add is needed
+			ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1,
+				std::memory_order_relaxed);
+			return;
+		}
+	}
+
+	TelemetryRecord& entry = ring->records[head & RING_MASK];
+	entry.time_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start_time).count();
+	entry.tick = tick;
+	entry.event = (uint8_t)event;
+	entry.reserved = 0;
+	entry.index = (uint16_t)index;
+	entry.x = x;
+	entry.y = y;
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+uint64_t Telemetry::getRecordedCount() const
+{
+	return recorded.load(std::memory_order_relaxed);
+}
+
+uint64_t Telemetry::getDroppedCount() const
+{
+	return dropped.load(std::memory_order_relaxed);
+}
+
+uint64_t Telemetry::getWrittenCount() const
+{
+	return written.load(std::memory_order_relaxed);
+}
+
+int Telemetry::getFileSequence() const
+{
+	return file_sequence.load(std::memory_order_relaxed);
+}
+
+/**
+*   @brief   Finds the calling thread's ring.
+*   @details A thread's first event allocates its ring and registers it,
+             which is the only time recording takes a lock.
+*   @return  The ring to record into.
+*/
+Telemetry::Ring* Telemetry::threadRing()
+{
+	if (thread_ring.log != id)
+	{
+		std::unique_ptr<Ring> ring(new Ring());
+		thread_ring.log = id;
+		thread_ring.ring = ring.get();
+
+		std::lock_guard<std::mutex> lock(rings_mutex);
+		rings.push_back(std::move(ring));
+	}
+	return static_cast<Ring*>(thread_ring.ring);
+}
+
+/**
+*   @brief   Drain thread
+*   @details Wakes every TELEMETRY_DRAIN_MS and drains, and drains once
+             more on the way out so nothing recorded before stop is lost.
+*   @return  void
+*/
+void Telemetry::run()
+{
+	std::unique_lock<std::mutex> lock(wake_mutex);
+	while (running)
+	{
+		wake.wait_for(lock, std::chrono::milliseconds(TELEMETRY_DRAIN_MS),
+			[this]() { return !running; });
+
+		lock.unlock();
+		drain();
+		lock.lock();
+	}
+}
+
+/**
+*   @brief   Writes out every ring.
+*   @details The ring list is only locked long enough to copy it, so a
+             slow disk never holds up a thread registering its ring.
+             Rings live until the log is destroyed, so the copies stay
+             valid.
+*   @return  void
+*/
+void Telemetry::drain()
+{
+	std::vector<Ring*> pending;
+	{
+		std::lock_guard<std::mutex> lock(rings_mutex);
+		for (const std::unique_ptr<Ring>& ring : rings)
+		{
+			pending.push_back(ring.get());
+		}
+	}
+
+	uint64_t recorded_total = 0;
+	uint64_t dropped_total = 0;
+	for (Ring* ring : pending)
+	{
+		uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+		uint64_t head = ring->head.load(std::memory_order_acquire);
+		while (tail != head)
+		{
+			// the records up to the end of the buffer, then any wrapped ones
+			uint64_t first = tail & RING_MASK;
+			uint64_t count = head - tail;
+			if (count > TELEMETRY_RING_RECORDS - first)
+			{
+				count = TELEMETRY_RING_RECORDS - first;
+			}
+			writeRecords(&ring->records[first], (size_t)count);
+			tail += count;
+		}
+		ring->tail.store(tail, std::memory_order_release);
+
+		recorded_total += head;
+		dropped_total += ring->dropped.load(std::memory_order_relaxed);
+	}
+	file.flush();
+
+	recorded.store(recorded_total, std::memory_order_relaxed);
+	dropped.store(dropped_total, std::memory_order_relaxed);
+}
+
+/**
+*   @brief   Appends records to the current file.
+*   @details Moves on to the next file whenever the current one is full,
+             so a file always holds whole records.
+*   @return  void
+*/
+void Telemetry::writeRecords(const TelemetryRecord* records, size_t count)
+{
+	while (count > 0)
+	{
+		size_t space = (TELEMETRY_FILE_BYTES - file_bytes) / sizeof(TelemetryRecord);
+		if (space == 0)
+		{
+			openFile();
+			continue;
+		}
+
+		size_t batch = count < space ? count : space;
+		file.write(reinterpret_cast<const char*>(records), batch * sizeof(TelemetryRecord));
+		file_bytes += batch * sizeof(TelemetryRecord);
+		if (file.good())
+		{
+			written += batch;
+		}
+		records += batch;
+		count -= batch;
+	}
+}
+
+/**
+*   @brief   Opens the next file.
+*   @details Files are reused in turn once TELEMETRY_FILES have been
+             written, so the log never takes more than
+             TELEMETRY_FILES * TELEMETRY_FILE_BYTES of disk.
+*   @return  false if the file could not be opened.
+*/
+bool Telemetry::openFile()
+{
+	file.close();
+	file.clear();
+
+	int sequence = next_sequence++;
+	std::string path = file_prefix + "_" +
+		std::to_string(sequence % TELEMETRY_FILES) + ".bin";
+	file.open(path, std::ios::binary | std::ios::trunc);
+
+	TelemetryHeader header = {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.record_size = sizeof(TelemetryRecord);
+	header.sequence = (uint32_t)sequence;
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	file_bytes = sizeof(header);
+	file_sequence = sequence;
+	return file.good();
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Constants.h"
+#include "Fixed.h"
+
+/*! \file Telemetry.h
+@brief   Binary gameplay telemetry.
+@details A telemetry file is a 16 byte header ("BKTL", version, record
+         size, file sequence number) followed by fixed size records.
+         Files are named <prefix>_<n>.bin and reused in turn, so the
+         sequence number orders them. All integers are little endian.
+*/
+
+/**
+*  Gameplay events the simulation reports.
+*/
+enum class TelemetryEvent : uint8_t
+{
+	BLOCK_DESTROYED = 1,     /**< index: block, x/y: block position. */
+	GEM_CAUGHT = 2,          /**< index: gem slot, x/y: gem position. */
+	GEM_MISSED = 3,          /**< index: gem slot, x/y: gem position. */
+	POWER_UP_COLLECTED = 4,  /**< x/y: power up position. */
+	LASER_FIRED = 5,         /**< index: laser slot, x/y: laser position. */
+	LIFE_LOST = 6,           /**< index: lives left, x/y: ball position. */
+	SPEED_STEP = 7           /**< index: blocks destroyed, x: new game speed. */
+};
+
+/**
+*  One event as it is stored in the ring and written to file.
+*  Positions are 16.16 logical playfield units.
+*/
+struct TelemetryRecord
+{
+	uint64_t time_ns;  /**< Since the log was started. */
+	uint32_t tick;     /**< Simulation tick the event happened on. */
+	uint8_t event;
+	uint8_t reserved;
+	uint16_t index;
+	int32_t x;
+	int32_t y;
+};
+
+/**
+*  Low overhead event log.
+*  Each thread that records gets its own single producer ring, so
+*  recording an event is a couple of loads, a 24 byte store and a release
+*  store: no locks and no system calls. A background thread drains every
+*  ring to disk a few times a second. If a ring fills before it is
+*  drained the event is counted as dropped rather than blocking the game.
+*/
+class Telemetry
+{
+public:
+	Telemetry() = default;
+	~Telemetry();
+
+	Telemetry(const Telemetry&) = delete;
+	Telemetry& operator=(const Telemetry&) = delete;
+
+	/**
+	*  Starts the drain thread.
+	*  @param [in] prefix Path and name the files are written under.
+	*  @return false if the first file could not be opened.
+	*/
+	bool start(const std::string& prefix);
+
+	/**
+	*  Writes out everything recorded so far and stops the drain thread.
+	*  Events recorded after this are ignored.
+	*/
+	void stop();
+
+	bool isRunning() const;
+
+	/**
+	*  Records an event from the calling thread.
+	*  Does nothing unless the log has been started.
+	*  @param [in] event What happened.
+	*  @param [in] tick The simulation tick it happened on.
+	*  @param [in] index The block, slot or count the event refers to.
+	*  @param [in] x,y Where it happened, or the event's values.
+	*/
+	void record(TelemetryEvent event, uint32_t tick, int index, fixed x, fixed y);
+
+	/**
+	*  Event totals, brought up to date each time the rings are drained.
+	*/
+	uint64_t getRecordedCount() const;
+	uint64_t getDroppedCount() const;
+	uint64_t getWrittenCount() const;
+	int getFileSequence() const;
+
+private:
+	/**
+	*  A single producer, single consumer ring.
+	*  head and tail count records since the ring was made; the producer
+	*  and drain thread each own one and only read the other's, so they
+	*  are padded onto separate cache lines. Padding rather than alignas
+	*  keeps the ring allocatable with plain new.
+	*/
+	struct Ring
+	{
+		TelemetryRecord records[TELEMETRY_RING_RECORDS];
+		std::atomic<uint64_t> head{ 0 };
+		uint64_t cached_tail = 0;
+		std::atomic<uint64_t> dropped{ 0 };
+		char padding[64];
+		std::atomic<uint64_t> tail{ 0 };
+	};
+
+	Ring* threadRing();
+	void run();
+	void drain();
+	void writeRecords(const TelemetryRecord* records, size_t count);
+	bool openFile();
+
+	std::string file_prefix;
+	std::ofstream file;
+	size_t file_bytes = 0;
+	int next_sequence = 0;
+	std::atomic<int> file_sequence{ 0 };
+
+	std::mutex rings_mutex;
+	std::vector<std::unique_ptr<Ring>> rings;
+	uint64_t id = 0;
+
+	std::thread drainer;
+	std::mutex wake_mutex;
+	std::condition_variable wake;
+	std::atomic<bool> running{ false };
+
+	// totals as of the last drain, so reading them never waits on it
+	std::atomic<uint64_t> recorded{ 0 };
+	std::atomic<uint64_t> dropped{ 0 };
+	std::atomic<uint64_t> written{ 0 };
+	std::chrono::steady_clock::time_point start_time;
+};
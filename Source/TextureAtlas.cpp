@@ -0,0 +1,414 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "Constants.h"
+#include "Png.h"
+#include "TextureAtlas.h"
+
+namespace
+{
+	constexpr int VERSION = 1;
+
+	/**
+	*  A stretch of the skyline: the top of what is packed across
+	*  [x, x + width).
+	*/
+	struct SkylineNode
+	{
+		int x;
+		int y;
+		int width;
+	};
+
+	struct Page
+	{
+		std::vector<SkylineNode> skyline;
+		int used_width = 0;
+		int used_height = 0;
+	};
+
+	struct Placed
+	{
+		const AssetEntry* asset;
+		Image image;
+		AtlasRegion region;
+	};
+
+	int nextPowerOfTwo(int value)
+	{
+		int power = 1;
+		while (power < value)
+		{
+			power <<= 1;
+		}
+		return power;
+	}
+
+	/**
+	*   @brief   How low a rectangle can sit on the skyline
+	*   @details The rectangle's left edge goes at the start of the node,
+				 and it rests on the highest node it spans.
+	*   @return  Its top, or -1 if it would leave the page.
+	*/
+	int fitAt(const std::vector<SkylineNode>& skyline, size_t index, int width, int height)
+	{
+		if (skyline[index].x + width > ATLAS_PAGE_SIZE)
+		{
+			return -1;
+		}
+
+		int y = 0;
+		int remaining = width;
+		for (size_t i = index; remaining > 0; i++)
+		{
+			y = std::max(y, skyline[i].y);
+			if (y + height > ATLAS_PAGE_SIZE)
+			{
+				return -1;
+			}
+			remaining -= skyline[i].width;
+		}
+		return y;
+	}
+
+	/**
+	*   @brief   Places a rectangle on a page
+	*   @details Bottom left: of every spot along the skyline, the one
+				 leaving the rectangle's bottom highest, then furthest left.
+				 The skyline is then raised under it, swallowing the nodes
+				 it covers, and level neighbours are merged.
+	*   @return  false if there is no room.
+	*/
+	bool place(Page& page, int width, int height, int& x, int& y)
+	{
+		size_t best = SIZE_MAX;
+		int best_bottom = 0;
+		for (size_t i = 0; i < page.skyline.size(); i++)
+		{
+			int top = fitAt(page.skyline, i, width, height);
+			if (top >= 0 && (best == SIZE_MAX || top + height < best_bottom))
+			{
+				best = i;
+				best_bottom = top + height;
+			}
+		}
+		if (best == SIZE_MAX)
+		{
+			return false;
+		}
+
+		x = page.skyline[best].x;
+		y = best_bottom - height;
+
+		SkylineNode raised = { x, best_bottom, width };
+		page.skyline.insert(page.skyline.begin() + best, raised);
+		for (size_t i = best + 1; i < page.skyline.size(); )
+		{
+			SkylineNode& node = page.skyline[i];
+			int covered = x + width - node.x;
+			if (covered <= 0)
+			{
+				break;
+			}
+			if (covered < node.width)
+			{
+				node.x += covered;
+				node.width -= covered;
+				break;
+			}
+			page.skyline.erase(page.skyline.begin() + i);
+		}
+		for (size_t i = 0; i + 1 < page.skyline.size(); )
+		{
+			if (page.skyline[i].y == page.skyline[i + 1].y)
+			{
+				page.skyline[i].width += page.skyline[i + 1].width;
+				page.skyline.erase(page.skyline.begin() + i + 1);
+			}
+			else
+			{
+				i++;
+			}
+		}
+
+		page.used_width = std::max(page.used_width, x + width);
+		page.used_height = std::max(page.used_height, best_bottom);
+		return true;
+	}
+
+	/**
+	*   @brief   Copies a texture onto its page
+	*   @details The padding around it repeats its outermost pixels, so a
+				 sample that strays past the edge gets the texture's own
+				 colour rather than its neighbour's.
+	*   @return  void
+	*/
+	void blit(const Image& source, const AtlasRegion& region, Image& page)
+	{
+		for (int y = -ATLAS_PADDING; y < region.height + ATLAS_PADDING; y++)
+		{
+			int from_y = std::min(std::max(y, 0), region.height - 1);
+			uint8_t* row = &page.pixels[((size_t)(region.y + y) * page.width + region.x) * 4];
+			for (int x = -ATLAS_PADDING; x < region.width + ATLAS_PADDING; x++)
+			{
+				int from_x = std::min(std::max(x, 0), region.width - 1);
+				std::memcpy(row + (ptrdiff_t)x * 4,
+					&source.pixels[((size_t)from_y * source.width + from_x) * 4], 4);
+			}
+		}
+	}
+
+	std::string pageFile(int page)
+	{
+		return "Textures/atlas" + std::to_string(page) + ".png";
+	}
+}
+
+/**
+*   @brief   Reads the index
+*   @details Every line is checked as it is read, and any fault throws
+			 the whole atlas away: a partial one would draw the wrong
+			 part of a page, which is worse than no atlas at all.
+*   @return  true if the atlas can be used.
+*/
+bool TextureAtlas::load(const std::string& directory)
+{
+	clear();
+
+	std::ifstream in(directory + "/" + ATLAS_INDEX);
+	if (in.fail())
+	{
+		return false;
+	}
+
+	std::string line;
+	std::getline(in, line);
+	std::istringstream header(line);
+	std::string magic;
+	int version = 0;
+	if (!(header >> magic >> version) || magic != "atlas" || version != VERSION)
+	{
+		return false;
+	}
+
+	while (std::getline(in, line))
+	{
+		std::istringstream fields(line);
+		std::string kind;
+		if (!(fields >> kind))
+		{
+			continue;
+		}
+
+		if (kind == "page")
+		{
+			int number = 0, width = 0, height = 0;
+			std::string file;
+			if (!(fields >> number >> file >> width >> height) || number != (int)pages.size())
+			{
+				clear();
+				return false;
+			}
+			pages.push_back(file);
+		}
+		else if (kind == "region")
+		{
+			Entry entry;
+			AtlasRegion& region = entry.region;
+			if (!(fields >> entry.name >> region.page >> region.x >> region.y >> region.width >> region.height) ||
+				region.page < 0 || region.page >= (int)pages.size() || region.width <= 0 || region.height <= 0)
+			{
+				clear();
+				return false;
+			}
+			regions.push_back(entry);
+		}
+		else
+		{
+			clear();
+			return false;
+		}
+	}
+
+	if (pages.empty())
+	{
+		return false;
+	}
+	resource_dir = directory;
+	return true;
+}
+
+void TextureAtlas::clear()
+{
+	resource_dir.clear();
+	pages.clear();
+	regions.clear();
+}
+
+bool TextureAtlas::isLoaded() const
+{
+	return !pages.empty();
+}
+
+bool TextureAtlas::find(const char* name, AtlasRegion& region) const
+{
+	for (const Entry& entry : regions)
+	{
+		if (entry.name == name)
+		{
+			region = entry.region;
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string TextureAtlas::getPagePath(int page) const
+{
+	if (page < 0 || page >= (int)pages.size())
+	{
+		return std::string();
+	}
+	return resource_dir + "/" + pages[page];
+}
+
+int TextureAtlas::getPageCount() const
+{
+	return (int)pages.size();
+}
+
+/**
+*   @brief   Packs textures into an atlas
+*   @details Tallest first keeps the skyline flat, and each texture goes
+			 on the first page with room, so a new page is only started
+			 when none of the others can take it.
+*   @return  true if the atlas was written.
+*/
+bool packAtlas(const std::string& resource_dir, const AssetEntry* entries, int count,
+	AtlasPackReport& report, std::string& error)
+{
+	report = AtlasPackReport();
+
+	std::vector<Placed> placed(count);
+	for (int i = 0; i < count; i++)
+	{
+		std::string source = resource_dir + "/" + entries[i].source;
+		std::ifstream in(source, std::ios::binary);
+		if (in.fail())
+		{
+			error = "could not read " + source;
+			return false;
+		}
+		std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)),
+			std::istreambuf_iterator<char>());
+		std::string reason;
+		if (!decodePng(bytes, placed[i].image, reason))
+		{
+			error = source + ": " + reason;
+			return false;
+		}
+		placed[i].asset = &entries[i];
+	}
+
+	std::vector<Placed*> order;
+	for (Placed& texture : placed)
+	{
+		order.push_back(&texture);
+	}
+	std::stable_sort(order.begin(), order.end(), [](const Placed* a, const Placed* b)
+	{
+		if (a->image.height != b->image.height)
+		{
+			return a->image.height > b->image.height;
+		}
+		return a->image.width > b->image.width;
+	});
+
+	std::vector<Page> pages;
+	for (Placed* texture : order)
+	{
+		int width = texture->image.width + ATLAS_PADDING * 2;
+		int height = texture->image.height + ATLAS_PADDING * 2;
+		if (width > ATLAS_PAGE_SIZE || height > ATLAS_PAGE_SIZE)
+		{
+			error = std::string(texture->asset->source) + " does not fit on a page";
+			return false;
+		}
+
+		int x = 0, y = 0;
+		size_t number = 0;
+		while (number < pages.size() && !place(pages[number], width, height, x, y))
+		{
+			number++;
+		}
+		if (number == pages.size())
+		{
+			Page page;
+			page.skyline.push_back({ 0, 0, ATLAS_PAGE_SIZE });
+			pages.push_back(page);
+			place(pages.back(), width, height, x, y);
+		}
+
+		AtlasRegion& region = texture->region;
+		region.page = (int)number;
+		region.x = x + ATLAS_PADDING;
+		region.y = y + ATLAS_PADDING;
+		region.width = texture->image.width;
+		region.height = texture->image.height;
+	}
+
+	std::ostringstream index;
+	index << "atlas " << VERSION << "\n";
+	for (size_t number = 0; number < pages.size(); number++)
+	{
+		Image page;
+		page.width = nextPowerOfTwo(pages[number].used_width);
+		page.height = nextPowerOfTwo(pages[number].used_height);
+		page.pixels.assign((size_t)page.width * page.height * 4, 0);
+		for (const Placed& texture : placed)
+		{
+			if (texture.region.page == (int)number)
+			{
+				blit(texture.image, texture.region, page);
+			}
+		}
+
+		std::vector<uint8_t> bytes;
+		encodePng(page, bytes);
+		std::string file = pageFile((int)number);
+		std::ofstream out(resource_dir + "/" + file, std::ios::binary | std::ios::trunc);
+		out.write((const char*)bytes.data(), bytes.size());
+		if (out.fail())
+		{
+			error = "could not write " + resource_dir + "/" + file;
+			return false;
+		}
+
+		index << "page " << number << " " << file << " " << page.width << " " << page.height << "\n";
+		report.page_pixels += (long long)page.width * page.height;
+	}
+	for (const Placed& texture : placed)
+	{
+		const AtlasRegion& region = texture.region;
+		index << "region " << texture.asset->name << " " << region.page << " " << region.x << " " <<
+			region.y << " " << region.width << " " << region.height << "\n";
+		report.texture_pixels += (long long)region.width * region.height;
+	}
+
+	// the index goes last, so a failed run never leaves one pointing at missing pages
+	std::string index_path = resource_dir + "/" + ATLAS_INDEX;
+	std::ofstream out(index_path, std::ios::trunc);
+	out << index.str();
+	if (out.fail())
+	{
+		error = "could not write " + index_path;
+		return false;
+	}
+
+	report.textures = count;
+	report.pages = (int)pages.size();
+	return true;
+}
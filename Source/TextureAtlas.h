@@ -0,0 +1,104 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Assets.h"
+
+/*! \file TextureAtlas.h
+@brief   Texture atlas index and the offline packer that writes it.
+@details The packer puts every texture in the manifest onto as few
+         pages as it can and writes each page as a PNG next to a text
+         index, ATLAS_INDEX under the resources directory:
+
+             atlas 1
+             page <page> <file> <width> <height>
+             region <name> <page> <x> <y> <width> <height>
+
+         Files are relative to the resources directory and rectangles
+         are in pixels from a page's top left. A sprite showing a region
+         loads its page and sets the region as its source rectangle, so
+         everything on a page draws from one texture.
+*/
+
+/**
+*  Where a texture sits in the atlas.
+*/
+struct AtlasRegion
+{
+	int page = 0;
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+/**
+*  The atlas index, read once at startup.
+*/
+class TextureAtlas
+{
+public:
+	TextureAtlas() = default;
+
+	/**
+	*  Reads the index.
+	*  @param [in] resource_dir The directory holding ATLAS_INDEX.
+	*  @return false if there is no atlas or its index is damaged, in
+	*          which case every texture loads from its own file.
+	*/
+	bool load(const std::string& resource_dir);
+	void clear();
+	bool isLoaded() const;
+
+	/**
+	*  Finds a texture by its logical name.
+	*  @return false if the atlas does not hold it.
+	*/
+	bool find(const char* name, AtlasRegion& region) const;
+
+	/**
+	*  The path to load a page's texture from.
+	*/
+	std::string getPagePath(int page) const;
+	int getPageCount() const;
+
+private:
+	struct Entry
+	{
+		std::string name;
+		AtlasRegion region;
+	};
+
+	std::string resource_dir;
+	std::vector<std::string> pages;
+	std::vector<Entry> regions;
+};
+
+/**
+*  What a packing run produced.
+*/
+struct AtlasPackReport
+{
+	int textures = 0;
+	int pages = 0;
+	long long texture_pixels = 0;  /**< Pixels of the textures themselves. */
+	long long page_pixels = 0;     /**< Pixels of the pages written. */
+};
+
+/**
+*   @brief   Packs textures into an atlas.
+*   @details This is the offline packer. The textures are decoded and
+             placed tallest first with a skyline bottom left packer,
+             each surrounded by ATLAS_PADDING pixels of its own edge so
+             filtering never picks up a neighbour. A page that does not
+             fill ATLAS_PAGE_SIZE is cropped to the next power of two.
+*   @param   [in] resource_dir Directory the entries' sources are under;
+             the pages and index are written there too.
+*   @param   [in] entries The textures to pack.
+*   @param   [in] count How many entries there are.
+*   @param   [out] report What was packed.
+*   @param   [out] error Describes what went wrong on failure.
+*   @return  true if the atlas was written.
+*/
+bool packAtlas(const std::string& resource_dir, const AssetEntry* entries, int count,
+	AtlasPackReport& report, std::string& error);
@@ -0,0 +1,258 @@
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "AabbTree.h"
+#include "JobSystem.h"
+#include "TreeBenchmark.h"
+
+namespace
+{
+	// blocks are smaller than the game's so a hundred thousand still fit
+	// in the range the tree's fixed point maths allows
+	constexpr fixed CELL_WIDTH = toFixed(10);
+	constexpr fixed CELL_HEIGHT = toFixed(5);
+	constexpr fixed BENCH_BLOCK_WIDTH = toFixed(8);
+	constexpr fixed BENCH_BLOCK_HEIGHT = toFixed(4);
+	constexpr fixed BENCH_BALL_SIZE = toFixed(3);
+
+	constexpr fixed SLIDE_RANGE = toFixed(3);
+	constexpr int SLIDE_PERIOD = 240;
+	constexpr fixed ORBIT_RADIUS = fixedRatio(3, 2);
+	constexpr int ORBIT_STEPS = 128;
+
+	// blocks moved per job
+	constexpr int INTEGRATE_BATCH = 2048;
+
+	struct Layout
+	{
+		int columns = 0;
+		int rows = 0;
+		fixed width = 0;
+		fixed height = 0;
+		fixed orbit_x[ORBIT_STEPS] = {};
+		fixed orbit_y[ORBIT_STEPS] = {};
+	};
+
+	uint32_t nextRandom(uint32_t& state)
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	/**
+	*  Where block index is on tick. Every fourth row stands still, odd
+	*  rows slide and the rest orbit their cells.
+	*/
+	Aabb blockAt(const Layout& layout, int index, int tick)
+	{
+		int row = index / layout.columns;
+		int column = index % layout.columns;
+
+		Aabb box;
+		box.left = column * CELL_WIDTH + (CELL_WIDTH - BENCH_BLOCK_WIDTH) / 2;
+		box.top = row * CELL_HEIGHT + (CELL_HEIGHT - BENCH_BLOCK_HEIGHT) / 2;
+		if (row % 2 == 1)
+		{
+			int period = SLIDE_PERIOD + (row * 7) % 120;
+			int phase = (tick + row * 13) % period;
+			int distance = phase < period / 2 ? phase : period - phase;
+			box.left += SLIDE_RANGE * 2 * distance / period - SLIDE_RANGE / 2;
+		}
+		else if (row % 4 == 2)
+		{
+			int step = (tick + column * 5) % ORBIT_STEPS;
+			box.left += layout.orbit_x[step];
+			box.top += layout.orbit_y[step];
+		}
+		box.right = box.left + BENCH_BLOCK_WIDTH;
+		box.bottom = box.top + BENCH_BLOCK_HEIGHT;
+		return box;
+	}
+
+	bool touches(const Aabb& a, const Aabb& b)
+	{
+		return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+	}
+
+	bool underLaser(const Aabb& box, fixed x, fixed y)
+	{
+		return box.left < x && x < box.right && box.bottom <= y;
+	}
+
+	double microseconds(std::chrono::steady_clock::duration time)
+	{
+		return std::chrono::duration<double, std::micro>(time).count();
+	}
+}
+
+TreeBenchReport runTreeBenchmark(int blocks, int ticks, uint32_t seed, JobSystem& jobs)
+{
+	TreeBenchReport report;
+	report.blocks = blocks;
+	report.ticks = ticks;
+	report.workers = jobs.getWorkerCount();
+
+	Layout layout;
+	layout.columns = (int)std::ceil(std::sqrt(blocks * 2.0));
+	layout.rows = (blocks + layout.columns - 1) / layout.columns;
+	layout.width = layout.columns * CELL_WIDTH;
+	layout.height = layout.rows * CELL_HEIGHT;
+	for (int i = 0; i < ORBIT_STEPS; i++)
+	{
+		double angle = i * 6.283185307179586 / ORBIT_STEPS;
+		layout.orbit_x[i] = (fixed)(std::cos(angle) * ORBIT_RADIUS);
+		layout.orbit_y[i] = (fixed)(std::sin(angle) * ORBIT_RADIUS);
+	}
+
+	AabbTree tree;
+	std::vector<Aabb> boxes(blocks);
+	std::vector<int> proxies(blocks);
+	for (int i = 0; i < blocks; i++)
+	{
+		boxes[i] = blockAt(layout, i, 0);
+		proxies[i] = tree.createProxy(boxes[i], i);
+	}
+
+	uint32_t random = seed ? seed : 1;
+	int64_t reinserts = 0;
+	std::chrono::steady_clock::duration tick_time{};
+	std::chrono::steady_clock::duration update_time{};
+	std::chrono::steady_clock::duration tree_time{};
+	std::chrono::steady_clock::duration brute_time{};
+
+	// what each stage hands on to the next, reset every tick
+	int tick = 0;
+	std::vector<Aabb> previous(blocks);
+	Aabb ball;
+	fixed laser_x[MAX_LASERS];
+	fixed laser_y = layout.height + CELL_HEIGHT;
+	int tree_ball_hits = 0;
+	fixed tree_laser_hits[MAX_LASERS];
+	std::chrono::steady_clock::time_point tick_start;
+	std::chrono::steady_clock::time_point broadphase_end;
+
+	JobGraph graph;
+	int integrate = graph.addStage(blocks, INTEGRATE_BATCH, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			boxes[i] = blockAt(layout, i, tick);
+		}
+	});
+
+	// the tree is not thread safe to modify, so the broadphase is one job
+	int broadphase = graph.addStage(1, 1, [&](int, int)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < blocks; i++)
+		{
+			reinserts += tree.moveProxy(proxies[i], boxes[i],
+				boxes[i].left - previous[i].left, boxes[i].top - previous[i].top);
+		}
+		broadphase_end = std::chrono::steady_clock::now();
+		update_time += broadphase_end - start;
+	});
+	graph.addDependency(broadphase, integrate);
+
+	// one job for the ball's query and one for each laser's ray cast
+	int narrowphase = graph.addStage(1 + MAX_LASERS, 1, [&](int begin, int end)
+	{
+		for (int query = begin; query < end; query++)
+		{
+			if (query == 0)
+			{
+				tree.query(ball, [&](int proxy)
+				{
+					tree_ball_hits += touches(boxes[tree.getUserData(proxy)], ball);
+					return true;
+				});
+				continue;
+			}
+
+			int j = query - 1;
+			fixed nearest = -1;
+			tree.rayCast(laser_x[j], laser_y, laser_x[j], 0, [&](int proxy)
+			{
+				const Aabb& box = boxes[tree.getUserData(proxy)];
+				if (!underLaser(box, laser_x[j], laser_y) || box.bottom <= nearest)
+				{
+					return FIXED_ONE;
+				}
+				nearest = box.bottom;
+				fixed fraction = fixedDiv(laser_y - box.bottom, laser_y);
+				return fraction > 0 ? fraction : 1;
+			});
+			tree_laser_hits[j] = nearest;
+		}
+	});
+	graph.addDependency(narrowphase, broadphase);
+
+	// checks the tree's answers by scanning every block
+	int events = graph.addStage(1, 1, [&](int, int)
+	{
+		auto start = std::chrono::steady_clock::now();
+		tree_time += start - broadphase_end;
+		tick_time += start - tick_start;
+
+		int brute_ball_hits = 0;
+		for (const Aabb& box : boxes)
+		{
+			brute_ball_hits += touches(box, ball);
+		}
+		fixed brute_laser_hits[MAX_LASERS];
+		for (int j = 0; j < MAX_LASERS; j++)
+		{
+			fixed nearest = -1;
+			for (const Aabb& box : boxes)
+			{
+				if (underLaser(box, laser_x[j], laser_y) && box.bottom > nearest)
+				{
+					nearest = box.bottom;
+				}
+			}
+			brute_laser_hits[j] = nearest;
+		}
+		brute_time += std::chrono::steady_clock::now() - start;
+
+		report.hits += brute_ball_hits;
+		report.mismatches += tree_ball_hits != brute_ball_hits;
+		for (int j = 0; j < MAX_LASERS; j++)
+		{
+			report.hits += brute_laser_hits[j] >= 0;
+			report.mismatches += tree_laser_hits[j] != brute_laser_hits[j];
+		}
+	});
+	graph.addDependency(events, narrowphase);
+
+	for (tick = 1; tick <= ticks; tick++)
+	{
+		previous.swap(boxes);
+		ball.left = (fixed)(nextRandom(random) % (uint32_t)(layout.width - BENCH_BALL_SIZE));
+		ball.top = (fixed)(nextRandom(random) % (uint32_t)(layout.height + CELL_HEIGHT));
+		ball.right = ball.left + BENCH_BALL_SIZE;
+		ball.bottom = ball.top + BENCH_BALL_SIZE;
+		for (fixed& x : laser_x)
+		{
+			x = (fixed)(nextRandom(random) % (uint32_t)layout.width);
+		}
+		tree_ball_hits = 0;
+
+		tick_start = std::chrono::steady_clock::now();
+		jobs.run(graph);
+	}
+
+	if (ticks > 0)
+	{
+		report.tick_us = microseconds(tick_time) / ticks;
+		report.tree_update_us = microseconds(update_time) / ticks;
+		report.tree_query_us = microseconds(tree_time) / ticks;
+		report.brute_query_us = microseconds(brute_time) / ticks;
+		report.reinserts = (double)reinserts / ticks;
+	}
+	report.height = tree.getHeight();
+	return report;
+}
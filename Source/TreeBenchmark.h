@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+class JobSystem;
+
+/**
+*  Results of a dynamic AABB tree benchmark run.
+*  Times are per tick, in microseconds.
+*/
+struct TreeBenchReport
+{
+	int blocks = 0;
+	int ticks = 0;
+	int workers = 0;              /**< Job system workers the ticks were spread over. */
+	double tick_us = 0.0;         /**< A whole tick: moving the blocks, the tree update and the tree queries. */
+	double tree_update_us = 0.0;  /**< Moving every block in the tree. */
+	double tree_query_us = 0.0;   /**< The ball and laser queries through the tree. */
+	double brute_query_us = 0.0;  /**< The same queries scanning every block. */
+	double reinserts = 0.0;       /**< Blocks per tick that left their fat box. */
+	int height = 0;
+	int64_t hits = 0;
+	int mismatches = 0;           /**< Queries where the tree and scan disagreed. */
+};
+
+/**
+*   @brief   Benchmarks the dynamic AABB tree against a brute force scan.
+*   @details Lays out a grid of blocks in which most rows slide from side
+             to side or have their blocks orbit, the kind of layout that
+             moves every block every tick. Each tick the blocks move and
+             one ball box query and MAX_LASERS laser ray casts are run,
+             both through the tree and by scanning every block, and the
+             answers are compared. A tick is a job graph of four stages:
+             integrate (moving the blocks, split across the workers),
+             broadphase (the tree update), narrowphase (the queries, one
+             job each) and events (the brute force check).
+*   @param   [in] blocks How many blocks to lay out.
+*   @param   [in] ticks How many ticks to run.
+*   @param   [in] seed Seeds where the ball and lasers are placed.
+*   @param   [in] jobs Runs each tick's stages.
+*   @return  The timings.
+*/
+TreeBenchReport runTreeBenchmark(int blocks, int ticks, uint32_t seed, JobSystem& jobs);
@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+*  Lock-free triple buffer for one writer and one reader.
+*  The writer fills back() and publishes it; the reader takes the newest
+*  published slot with update() and reads it through front(). Publishing
+*  and taking are each one atomic exchange of a slot index, so neither
+*  side ever waits on the other: a slow reader skips whatever it missed
+*  and a stalled writer leaves the reader on the last value.
+*  The writer gets back a slot holding old data after each publish and
+*  must rewrite all of it.
+*/
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	/**
+	*  Writer side: the slot to fill next.
+	*/
+	T& back()
+	{
+		return slots[back_index];
+	}
+
+	/**
+	*  Writer side: hands the filled slot to the reader.
+	*/
+	void publish()
+	{
+		back_index = middle.exchange((uint8_t)(back_index | FRESH),
+			std::memory_order_acq_rel) & INDEX;
+	}
+
+	/**
+	*  Reader side: moves to the newest published slot.
+	*  @return false if nothing was published since the last call.
+	*/
+	bool update()
+	{
+		if (!(middle.load(std::memory_order_relaxed) & FRESH))
+		{
+			return false;
+		}
+		front_index = middle.exchange(front_index, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+
+	/**
+	*  Reader side: the slot taken by the last update.
+	*/
+	const T& front() const
+	{
+		return slots[front_index];
+	}
+
+private:
+	static constexpr uint8_t INDEX = 3;
+	static constexpr uint8_t FRESH = 4;
+
+	T slots[3];
+	uint8_t back_index = 0;
+	std::atomic<uint8_t> middle{ 1 };
+	uint8_t front_index = 2;
+};
@@ -1,14 +1,530 @@
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
 #include <Engine/Platform.h>
+#include "AssetBundle.h"
+#include "Audio.h"
+#include "Autopilot.h"
+#include "FrameCapture.h"
 #include "Game.h"
+#include "JobSystem.h"
+#include "Leaderboard.h"
+#include "LevelGenerator.h"
+#include "Png.h"
+#include "SoftwareRenderer.h"
+#include "Systems.h"
+#include "TextureAtlas.h"
+#include "TreeBenchmark.h"
+
+/**
+*   @brief   Splits the command line into arguments
+*   @details Arguments are separated by spaces unless quoted, so paths
+			 with spaces in them can be passed.
+*   @param   command_line The command line.
+*   @return  The arguments.
+*/
+std::vector<std::string> splitArgs(const std::string& command_line)
+{
+	std::vector<std::string> args;
+	std::string arg;
+	bool quoted = false;
+	bool any = false;
+	for (char c : command_line)
+	{
+		if (c == '"')
+		{
+			quoted = !quoted;
+			any = true;
+		}
+		else if (c == ' ' && !quoted)
+		{
+			if (any)
+			{
+				args.push_back(arg);
+			}
+			arg.clear();
+			any = false;
+		}
+		else
+		{
+			arg += c;
+			any = true;
+		}
+	}
+	if (any)
+	{
+		args.push_back(arg);
+	}
+	return args;
+}
+
+/**
+*   @brief   Reads a numeric argument
+*   @param   args The arguments.
+*   @param   index Which argument to read.
+*   @return  Its value, 0 when it is missing or not a number.
+*/
+long long numberArg(const std::vector<std::string>& args, size_t index)
+{
+	return index < args.size() ? atoll(args[index].c_str()) : 0;
+}
+
+/**
+*   @brief   Headless soak run
+*   @details Plays games on the autopilot without opening a window and
+			 writes the totals to Soak_results.txt.
+*   @param   games How many games to play.
+*   @return  void
+*/
+void soak(int games)
+{
+	SoakReport report = runSoak(games, GetTickCount(), SOAK_MAX_TICKS);
+
+	std::ofstream outFile;
+	outFile.open("Soak_results.txt");
+	if (!outFile.fail())
+	{
+		outFile << "games: " << report.games << std::endl;
+		outFile << "won: " << report.won << std::endl;
+		outFile << "lost: " << report.lost << std::endl;
+		outFile << "timed out: " << report.timed_out << std::endl;
+		outFile << "ticks: " << report.ticks << std::endl;
+		outFile << "top game speed: " << fixedToFloat(report.top_game_speed) << std::endl;
+		outFile << "games with every laser out: " << report.full_laser_games << std::endl;
+		outFile << "seconds: " << report.seconds << std::endl;
+		outFile << "games per minute: " <<
+			(report.seconds > 0.0 ? report.games * 60.0 / report.seconds : 0.0) << std::endl;
+		outFile.close();
+	}
+}
+
+/**
+*   @brief   Dynamic AABB tree benchmark
+*   @details Runs the tree against a brute force scan at 1k, 10k and 100k
+			 moving blocks, each inline and then across the job system's
+			 workers, and writes the timings to Tree_benchmark.txt.
+*   @param   ticks How many ticks to run each size for.
+*   @return  void
+*/
+void treeBenchmark(int ticks)
+{
+	std::ofstream outFile;
+	outFile.open("Tree_benchmark.txt");
+	if (outFile.fail())
+	{
+		return;
+	}
+
+	// each size runs once on this thread alone and once across the workers
+	JobSystem inline_jobs;
+	inline_jobs.start(0);
+	JobSystem jobs;
+	jobs.start(-1);
+
+	const int sizes[] = { 1000, 10000, 100000 };
+	for (int blocks : sizes)
+	{
+		uint32_t seed = GetTickCount();
+		TreeBenchReport serial = runTreeBenchmark(blocks, ticks, seed, inline_jobs);
+		TreeBenchReport report = runTreeBenchmark(blocks, ticks, seed, jobs);
+		outFile << "blocks: " << report.blocks << "  ticks: " << report.ticks << std::endl;
+		outFile << "  tick: " << serial.tick_us << " us inline, " << report.tick_us <<
+			" us on " << report.workers << " workers" << std::endl;
+		outFile << "  tree update: " << report.tree_update_us << " us/tick  (" <<
+			report.reinserts << " reinserts/tick, height " << report.height << ")" << std::endl;
+		outFile << "  tree queries: " << report.tree_query_us << " us/tick" << std::endl;
+		outFile << "  brute force queries: " << report.brute_query_us << " us/tick" << std::endl;
+		outFile << "  hits: " << report.hits << "  mismatches: " << report.mismatches << std::endl;
+	}
+	outFile.close();
+}
+
+/**
+*   @brief   Bulk level generation
+*   @details Generates and validates a run of seeds across the job
+			 system's workers and writes the results to
+			 Level_generation.txt. The checksum is order independent, so
+			 runs on different machines can be compared directly.
+*   @param   levels How many seeds to generate.
+*   @return  void
+*/
+void levelGeneration(long long levels)
+{
+	std::ofstream outFile;
+	outFile.open("Level_generation.txt");
+	if (outFile.fail())
+	{
+		return;
+	}
+
+	JobSystem jobs;
+	jobs.start(-1);
+	LevelBatchReport report = runLevelBatch(1, levels, jobs);
+	outFile << "levels: " << report.levels << "  workers: " << report.workers << std::endl;
+	outFile << "invalid: " << report.invalid << "  unstable: " << report.unstable << std::endl;
+	outFile << "checksum: " << std::hex << report.checksum << std::dec << std::endl;
+	outFile << "seconds: " << report.seconds << "  levels per second: " <<
+		(report.seconds > 0.0 ? report.levels / report.seconds : 0.0) << std::endl;
+	outFile << "100 x 100 level: " << report.large_level_us << " us" << std::endl;
+	outFile.close();
+}
+
+/**
+*   @brief   Audio mixer benchmark
+*   @details Mixes AUDIO_BENCH_VOICES voices flat out with the vectorised
+			 and scalar kernels, writes the timings to
+			 Audio_benchmark.txt and the vectorised mix to
+			 Audio_benchmark.wav so it can be listened to.
+*   @param   seconds How much sound to mix.
+*   @return  void
+*/
+void audioBenchmark(int seconds)
+{
+	std::ofstream outFile;
+	outFile.open("Audio_benchmark.txt");
+	if (outFile.fail())
+	{
+		return;
+	}
+
+	WavFileOutput wav("Audio_benchmark.wav");
+	AudioBenchReport report = runAudioBenchmark(seconds, AUDIO_BENCH_VOICES, wav);
+	outFile << "voices: " << report.voices << "  blocks: " << report.blocks << " of " <<
+		AUDIO_BLOCK_FRAMES << " frames" << std::endl;
+	outFile << "vectorised: " << report.vector_us << " us/block" <<
+		(report.vectorised ? "" : " (not compiled in, same as scalar)") << std::endl;
+	outFile << "scalar: " << report.scalar_us << " us/block" << std::endl;
+	outFile << "real time budget: " << report.block_us << " us/block  (" <<
+		(report.vector_us > 0.0 ? report.block_us / report.vector_us : 0.0) << "x real time)" << std::endl;
+	outFile << "stolen: " << report.stolen << "  dropped: " << report.dropped << std::endl;
+	outFile.close();
+}
+
+/**
+*   @brief   Leaderboard benchmark
+*   @details Ranks entries random scores, then writes, compacts and
+			 reloads them through a scratch log, and writes the timings
+			 to Leaderboard_benchmark.txt.
+*   @param   entries How many scores.
+*   @return  void
+*/
+void leaderboardBenchmark(long long entries)
+{
+	std::ofstream outFile;
+	outFile.open("Leaderboard_benchmark.txt");
+	if (outFile.fail())
+	{
+		return;
+	}
+
+	LeaderboardBenchReport report = runLeaderboardBenchmark(entries, 1, "Leaderboard_benchmark.log");
+	outFile << "entries: " << report.entries << "  tree height: " << report.height <<
+		"  tree bytes: " << report.tree_bytes << std::endl;
+	outFile << "insert: " << report.insert_ns << " ns  rank: " << report.rank_ns << " ns" << std::endl;
+	outFile << "top 100: " << report.top_us << " us  100 from the middle: " << report.range_us <<
+		" us" << std::endl;
+	outFile << "flushed append: " << report.append_ns << " ns" << std::endl;
+	outFile << "compact: " << report.compact_seconds << " s  load: " << report.load_seconds <<
+		" s  log bytes: " << report.log_bytes << std::endl;
+	outFile << "mismatches: " << report.mismatches << std::endl;
+	outFile.close();
+}
+
+/**
+*   @brief   Entity component system benchmark
+*   @details Moves a world of mixed entities and the same objects laid
+			 out as GameObject held them, churns short lived debris, and
+			 writes the timings to Entity_benchmark.txt.
+*   @param   entities How many entities.
+*   @return  void
+*/
+void entityBenchmark(int entities)
+{
+	std::ofstream outFile;
+	outFile.open("Entity_benchmark.txt");
+	if (outFile.fail())
+	{
+		return;
+	}
+
+	JobSystem jobs;
+	jobs.start(-1);
+	EntityBenchReport report = runEntityBenchmark(entities, ENTITY_BENCH_TICKS, jobs);
+	outFile << "entities: " << report.entities << "  ticks: " << report.ticks << "  archetypes: " <<
+		report.archetypes << "  chunk bytes: " << report.chunk_bytes << std::endl;
+	outFile << "move: " << report.move_ns << " ns/entity, " << report.jobs_move_ns << " ns/entity on " <<
+		jobs.getWorkerCount() << " workers" << std::endl;
+	outFile << "heap allocated objects: " << report.object_move_ns << " ns/object" << std::endl;
+	outFile << "debris churn: " << report.churn_us << " us/tick  (" << report.churned << " respawned)" << std::endl;
+	outFile << "mismatches: " << report.mismatches << std::endl;
+	outFile.close();
+}
+
+/**
+*   @brief   Software renderer benchmark
+*   @details Draws gameplay frames at the benchmark resolution on the
+			 job system's workers and writes the timings to
+			 Raster_benchmark.txt, with the last frame saved as
+			 Raster_benchmark.png.
+*   @param   frames How many frames to draw.
+*   @return  void
+*/
+void rasterBenchmark(int frames)
+{
+	std::ofstream outFile;
+	outFile.open("Raster_benchmark.txt");
+	if (outFile.fail())
+	{
+		return;
+	}
+
+	JobSystem jobs;
+	jobs.start(-1);
+	Image screenshot;
+	RasterBenchReport report = runRasterBenchmark(RASTER_BENCH_WIDTH, RASTER_BENCH_HEIGHT, frames, jobs, screenshot);
+	outFile << report.width << "x" << report.height << "  frames: " << report.frames << "  tiles: " <<
+		report.tiles << "  draws: " << report.commands << "  textures: " <<
+		(report.textures_loaded ? "loaded" : "missing") << std::endl;
+	outFile << "frame: " << report.frame_ms << " ms (worst " << report.worst_ms << " ms) on " <<
+		report.workers << " workers, " << (report.frame_ms > 0.0 ? 1000.0 / report.frame_ms : 0.0) <<
+		" fps" << std::endl;
+	outFile << "one thread: " << report.single_ms << " ms  scalar kernels: " << report.scalar_ms <<
+		" ms  (SSE " << (report.vectorised ? "on" : "off") << ")" << std::endl;
+	outFile << "mismatches: " << report.mismatches << std::endl;
+	outFile.close();
+
+	std::vector<uint8_t> png;
+	encodePng(screenshot, png);
+	std::ofstream image("Raster_benchmark.png", std::ios::binary | std::ios::trunc);
+	image.write((const char*)png.data(), png.size());
+}
+
+/**
+*   @brief   Records gameplay
+*   @details Captures the autopilot playing through the software renderer
+			 and writes the capture's counts and timings to
+			 Record_results.txt. Export the capture to view it.
+*   @param   frames How many frames to capture.
+*   @param   path The capture file.
+*   @return  void
+*/
+void record(int frames, const std::string& path)
+{
+	std::ofstream outFile;
+	outFile.open("Record_results.txt");
+	if (outFile.fail())
+	{
+		return;
+	}
+
+	JobSystem jobs;
+	jobs.start(-1);
+	RecordReport report = recordGameplay(frames, path, jobs);
+	outFile << report.width << "x" << report.height << "  frames: " << report.frames << "  textures: " <<
+		(report.textures_loaded ? "loaded" : "missing") << std::endl;
+	outFile << "submitted: " << report.submitted << "  written: " << report.written << "  dropped: " <<
+		report.dropped << "  failed: " << report.failed << std::endl;
+	outFile << "bytes: " << report.bytes << "  (" << (report.written ? report.bytes / report.written : 0) <<
+		" a frame)" << std::endl;
+	outFile << "draw: " << report.frame_ms << " ms  swap: " << report.submit_ms << " ms (worst " <<
+		report.worst_submit_ms << " ms)  drain: " << report.drain_ms << " ms" << std::endl;
+	outFile.close();
+}
+
+/**
+*   @brief   Exports a capture
+*   @details Writes the capture out as a PNG sequence and what was found,
+			 or why it failed, to Export_results.txt.
+*   @param   path The capture file.
+*   @param   directory Where the images go.
+*   @return  True if every frame was written.
+*/
+bool exportFrames(const std::string& path, const std::string& directory)
+{
+	CaptureExportReport report;
+	std::string error;
+	bool exported = exportCapture(path, directory, report, error);
+
+	std::ofstream outFile;
+	outFile.open("Export_results.txt");
+	if (!outFile.fail())
+	{
+		outFile << report.records << " frames, " << report.images << " images (" << report.filled <<
+			" dropped frames repeated)" << std::endl;
+		if (!exported)
+		{
+			outFile << "export failed: " << error << std::endl;
+		}
+		outFile.close();
+	}
+	return exported;
+}
+
+/**
+*   @brief   Packs the asset bundle
+*   @details Run by the post-build step. The game has no console, so the
+			 result goes to Pack_results.txt for when the build fails.
+*   @param   resource_dir Directory the manifest's sources are under.
+*   @param   bundle The bundle to write.
+*   @return  True if the bundle was written.
+*/
+bool pack(const std::string& resource_dir, const std::string& bundle)
+{
+	std::string error;
+	bool packed = packAssets(resource_dir, ASSETS, NUM_ASSETS, bundle, error);
+
+	std::ofstream outFile;
+	outFile.open("Pack_results.txt");
+	if (!outFile.fail())
+	{
+		if (packed)
+		{
+			outFile << "packed " << NUM_ASSETS << " assets into " << bundle << std::endl;
+		}
+		else
+		{
+			outFile << "pack failed: " << error << std::endl;
+		}
+		outFile.close();
+	}
+	return packed;
+}
+
+/**
+*   @brief   Packs the texture atlas
+*   @details Run by the post-build step on the copied resources, and
+			 writes how well the pages were filled, or why packing
+			 failed, to Atlas_results.txt.
+*   @param   resource_dir Directory the manifest's sources are under;
+			 the pages and index are written there too.
+*   @return  True if the atlas was written.
+*/
+bool buildAtlas(const std::string& resource_dir)
+{
+	AtlasPackReport report;
+	std::string error;
+	bool packed = packAtlas(resource_dir, ASSETS, NUM_ASSETS, report, error);
+
+	std::ofstream outFile;
+	outFile.open("Atlas_results.txt");
+	if (!outFile.fail())
+	{
+		if (packed)
+		{
+			outFile << report.textures << " textures on " << report.pages << " pages, " <<
+				(int)(100 * report.texture_pixels / report.page_pixels) << "% used" << std::endl;
+		}
+		else
+		{
+			outFile << "atlas failed: " << error << std::endl;
+		}
+		outFile.close();
+	}
+	return packed;
+}
 
 int WINAPI WinMain(
 	HINSTANCE hInstance, 
 	HINSTANCE hPrevInstance, 
 	PSTR pScmdline, int iCmdshow)
 {
+	// modes are picked by the first argument, their parameters follow it
+	std::vector<std::string> arg_list = splitArgs(pScmdline ? pScmdline : "");
+	std::string mode = arg_list.empty() ? "" : arg_list[0];
+	if (mode == "-soak")
+	{
+		int games = (int)numberArg(arg_list, 1);
+		soak(games > 0 ? games : SOAK_GAMES);
+		return 0;
+	}
+
+	if (mode == "-treebench")
+	{
+		int ticks = (int)numberArg(arg_list, 1);
+		treeBenchmark(ticks > 0 ? ticks : TREE_BENCH_TICKS);
+		return 0;
+	}
+
+	if (mode == "-audiobench")
+	{
+		int seconds = (int)numberArg(arg_list, 1);
+		audioBenchmark(seconds > 0 ? seconds : AUDIO_BENCH_SECONDS);
+		return 0;
+	}
+
+	if (mode == "-levelgen")
+	{
+		long long levels = numberArg(arg_list, 1);
+		levelGeneration(levels > 0 ? levels : LEVEL_BATCH_COUNT);
+		return 0;
+	}
+
+	if (mode == "-leaderbench")
+	{
+		long long entries = numberArg(arg_list, 1);
+		leaderboardBenchmark(entries > 0 ? entries : LEADERBOARD_BENCH_ENTRIES);
+		return 0;
+	}
+
+	if (mode == "-ecsbench")
+	{
+		int entities = (int)numberArg(arg_list, 1);
+		entityBenchmark(entities > 0 ? entities : ENTITY_BENCH_ENTITIES);
+		return 0;
+	}
+
+	if (mode == "-rasterbench")
+	{
+		int frames = (int)numberArg(arg_list, 1);
+		rasterBenchmark(frames > 0 ? frames : RASTER_BENCH_FRAMES);
+		return 0;
+	}
+
+	// offline packer, run by the post-build step: -pack [resources] [bundle]
+	if (mode == "-pack")
+	{
+		std::string resource_dir = arg_list.size() > 1 ? arg_list[1] : RESOURCE_DIR;
+		std::string bundle = arg_list.size() > 2 ? arg_list[2] : ASSET_BUNDLE;
+		return pack(resource_dir, bundle) ? 0 : 1;
+	}
+
+	// offline atlas packer, run by the post-build step: -atlas [resources]
+	if (mode == "-atlas")
+	{
+		std::string resource_dir = arg_list.size() > 1 ? arg_list[1] : RESOURCE_DIR;
+		return buildAtlas(resource_dir) ? 0 : 1;
+	}
+
+	// gameplay capture: -record [frames] [file], then -export file [directory] for a PNG sequence
+	if (mode == "-record")
+	{
+		int frames = (int)numberArg(arg_list, 1);
+		record(frames > 0 ? frames : RECORD_FRAMES, arg_list.size() > 2 ? arg_list[2] : "Gameplay.cap");
+		return 0;
+	}
+	if (mode == "-export")
+	{
+		std::string path = arg_list.size() > 1 ? arg_list[1] : "Gameplay.cap";
+		std::string directory = arg_list.size() > 2 ? arg_list[2] : ".";
+		return exportFrames(path, directory) ? 0 : 1;
+	}
+
 	BreakoutGame* game = new BreakoutGame;
+	// anything else runs the game, with its options in any order
+	for (size_t i = 0; i < arg_list.size(); i++)
+	{
+		if (arg_list[i] == "-spectate")
+		{
+			game->spectate();
+		}
+		else if (arg_list[i] == "-spritebudget")
+		{
+			int kilobytes = (int)numberArg(arg_list, i + 1);
+			game->setSpriteBudget((size_t)(kilobytes > 0 ? kilobytes : SPRITE_BUDGET_KB) * 1024);
+		}
+	}
 	if (game->init())
 	{
 		game->run();